@@ -0,0 +1,46 @@
+-- Bits of files.flags (FILE record header)
+CREATE TABLE IF NOT EXISTS file_record_flags (
+    flag INTEGER PRIMARY KEY,
+    name TEXT NOT NULL
+);
+
+INSERT OR IGNORE INTO file_record_flags (flag, name) VALUES
+    (1, 'IN_USE'),
+    (2, 'DIRECTORY'),
+    (4, 'EXTENSION'),
+    (8, 'SPECIAL_INDEX');
+
+-- Bits of files.file_attributes and file_names.file_attributes
+CREATE TABLE IF NOT EXISTS file_attribute_flags (
+    flag INTEGER PRIMARY KEY,
+    name TEXT NOT NULL
+);
+
+INSERT OR IGNORE INTO file_attribute_flags (flag, name) VALUES
+    (1,         'READONLY'),
+    (2,         'HIDDEN'),
+    (4,         'SYSTEM'),
+    (32,        'ARCHIVE'),
+    (64,        'DEVICE'),
+    (128,       'NORMAL'),
+    (256,       'TEMPORARY'),
+    (512,       'SPARSE_FILE'),
+    (1024,      'REPARSE_POINT'),
+    (2048,      'COMPRESSED'),
+    (4096,      'OFFLINE'),
+    (8192,      'NOT_CONTENT_INDEXED'),
+    (16384,     'ENCRYPTED'),
+    (268435456, 'DIRECTORY'),
+    (536870912, 'INDEX_VIEW');
+
+-- file_names.namespace
+CREATE TABLE IF NOT EXISTS file_name_namespaces (
+    namespace INTEGER PRIMARY KEY,
+    name TEXT NOT NULL
+);
+
+INSERT OR IGNORE INTO file_name_namespaces (namespace, name) VALUES
+    (0, 'POSIX'),
+    (1, 'WIN32'),
+    (2, 'DOS'),
+    (3, 'WIN32_AND_DOS');
@@ -0,0 +1,20 @@
+-- Full-text search over every file name and its record's path, e.g.
+--   SELECT name, path FROM file_names_fts WHERE file_names_fts MATCH 'invoice*';
+-- The index is external-content: the text stays in file_names and files.
+-- No prefix indexes: they double the build time, and prefix queries are
+-- served from the term index without them.
+-- Optional; skipped when SQLite is built without FTS5.
+
+CREATE VIEW IF NOT EXISTS file_name_paths AS
+    SELECT n.name_id, n.name, f.path
+    FROM file_names n
+    JOIN files f ON f.record_number = n.record_number;
+
+CREATE VIRTUAL TABLE IF NOT EXISTS file_names_fts USING fts5(
+    name,
+    path,
+    content = 'file_name_paths',
+    content_rowid = 'name_id'
+);
+
+INSERT INTO file_names_fts(file_names_fts) VALUES ('rebuild');
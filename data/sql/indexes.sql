@@ -0,0 +1,29 @@
+-- Run once the tables are loaded: sorting every key at the end is far
+-- cheaper than maintaining the indexes row by row during the load.
+
+-- Directory listings: children of a record without touching the table
+CREATE INDEX IF NOT EXISTS idx_files_parent ON files(parent_record_number, name, in_use, is_directory);
+CREATE INDEX IF NOT EXISTS idx_files_size ON files(size, in_use);
+
+-- Time ranges; the rowid (record_number) rides along in every index
+CREATE INDEX IF NOT EXISTS idx_files_si_creation ON files(si_creation_time);
+CREATE INDEX IF NOT EXISTS idx_files_si_modification ON files(si_modification_time);
+CREATE INDEX IF NOT EXISTS idx_files_si_access ON files(si_access_time);
+CREATE INDEX IF NOT EXISTS idx_files_si_entry ON files(si_entry_time);
+CREATE INDEX IF NOT EXISTS idx_files_fn_creation ON files(fn_creation_time);
+CREATE INDEX IF NOT EXISTS idx_files_fn_modification ON files(fn_modification_time);
+
+CREATE INDEX IF NOT EXISTS idx_files_security ON files(security_id);
+CREATE INDEX IF NOT EXISTS idx_files_deleted ON files(record_number) WHERE in_use = 0;
+
+CREATE UNIQUE INDEX IF NOT EXISTS idx_file_names_record ON file_names(record_number, name_index);
+CREATE INDEX IF NOT EXISTS idx_file_names_parent ON file_names(parent_record_number, name, record_number);
+CREATE INDEX IF NOT EXISTS idx_file_names_name ON file_names(name COLLATE NOCASE, record_number);
+
+CREATE INDEX IF NOT EXISTS idx_data_streams_named ON data_streams(name, record_number) WHERE name <> '';
+CREATE INDEX IF NOT EXISTS idx_attribute_list_segment ON attribute_list_entries(segment_record_number);
+
+INSERT OR REPLACE INTO security_ids (security_id, file_count)
+    SELECT security_id, COUNT(*) FROM files WHERE security_id IS NOT NULL GROUP BY security_id;
+
+PRAGMA optimize;
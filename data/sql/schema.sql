@@ -0,0 +1,159 @@
+-- AnalyzeMFT SQLite schema
+--
+-- One row per MFT record in files, with every $FILE_NAME, $DATA stream and
+-- $ATTRIBUTE_LIST entry in its own table keyed by record_number. Times are
+-- FILETIME ticks (100 ns since 1601-01-01 UTC), NULL when unset; the views
+-- convert them with datetime(t / 10000000 - 11644473600, 'unixepoch').
+--
+-- Tables are loaded first and indexed afterwards by indexes.sql, then
+-- fullText.sql adds an FTS5 index over names and paths when SQLite has it.
+
+CREATE TABLE IF NOT EXISTS files (
+    record_number INTEGER PRIMARY KEY,
+    sequence_number INTEGER NOT NULL,
+    flags INTEGER NOT NULL,                 -- file_record_flags
+    in_use INTEGER NOT NULL,
+    is_directory INTEGER NOT NULL,
+    base_record_number INTEGER,             -- set on extension records
+    hard_link_count INTEGER,
+    parent_record_number INTEGER,
+    parent_sequence_number INTEGER,
+    name TEXT,                              -- the name the CSV output reports
+    path TEXT,
+    size INTEGER,
+    si_creation_time INTEGER,
+    si_modification_time INTEGER,
+    si_access_time INTEGER,
+    si_entry_time INTEGER,
+    fn_creation_time INTEGER,
+    fn_modification_time INTEGER,
+    fn_access_time INTEGER,
+    fn_entry_time INTEGER,
+    file_attributes INTEGER,                -- file_attribute_flags, from $STANDARD_INFORMATION
+    owner_id INTEGER,
+    security_id INTEGER,                    -- security_ids
+    usn INTEGER,
+    attribute_mask INTEGER,                 -- bit (type >> 4) per attribute_types row present
+    object_id TEXT,
+    birth_volume_id TEXT,
+    birth_object_id TEXT,
+    birth_domain_id TEXT,
+    md5 TEXT,
+    sha256 TEXT,
+    sha512 TEXT,
+    crc32 TEXT
+);
+
+-- Every $FILE_NAME attribute: Win32 and DOS names, and one per hard link
+CREATE TABLE IF NOT EXISTS file_names (
+    name_id INTEGER PRIMARY KEY,
+    record_number INTEGER NOT NULL,
+    name_index INTEGER NOT NULL,            -- order within the record
+    namespace INTEGER NOT NULL,             -- file_name_namespaces
+    name TEXT NOT NULL,
+    parent_record_number INTEGER NOT NULL,
+    parent_sequence_number INTEGER NOT NULL,
+    creation_time INTEGER,
+    modification_time INTEGER,
+    access_time INTEGER,
+    entry_time INTEGER,
+    allocated_size INTEGER,
+    real_size INTEGER,
+    file_attributes INTEGER
+);
+
+-- Every $DATA attribute; name is '' for the unnamed stream
+CREATE TABLE IF NOT EXISTS data_streams (
+    record_number INTEGER NOT NULL,
+    stream_index INTEGER NOT NULL,
+    name TEXT NOT NULL,
+    non_resident INTEGER NOT NULL,
+    size INTEGER NOT NULL,
+    allocated_size INTEGER NOT NULL,
+    PRIMARY KEY (record_number, stream_index)
+) WITHOUT ROWID;
+
+CREATE TABLE IF NOT EXISTS attribute_list_entries (
+    record_number INTEGER NOT NULL,
+    entry_index INTEGER NOT NULL,
+    attribute_type INTEGER NOT NULL,        -- attribute_types
+    name TEXT NOT NULL,
+    start_vcn INTEGER NOT NULL,
+    segment_record_number INTEGER NOT NULL, -- record holding the attribute
+    segment_sequence_number INTEGER NOT NULL,
+    PRIMARY KEY (record_number, entry_index)
+) WITHOUT ROWID;
+
+-- Security IDs in use, filled after the load. The descriptors themselves
+-- live in $Secure:$SDS, which is not part of the MFT.
+CREATE TABLE IF NOT EXISTS security_ids (
+    security_id INTEGER PRIMARY KEY,
+    file_count INTEGER NOT NULL
+);
+
+-- The flat table earlier versions wrote, for existing queries
+CREATE VIEW IF NOT EXISTS mft_records AS
+    SELECT record_number,
+           name AS filename,
+           parent_record_number,
+           size AS file_size,
+           is_directory,
+           fn_creation_time AS creation_time,
+           fn_modification_time AS modification_time,
+           fn_access_time AS access_time,
+           fn_entry_time AS entry_time,
+           attribute_mask,
+           flags,
+           sequence_number,
+           object_id, birth_volume_id, birth_object_id, birth_domain_id,
+           md5, sha256, sha512, crc32
+    FROM files;
+
+-- Records no longer in use whose metadata is still in the MFT
+CREATE VIEW IF NOT EXISTS deleted_files AS
+    SELECT record_number, sequence_number, name, path, size, is_directory,
+           datetime(si_modification_time / 10000000 - 11644473600, 'unixepoch') AS si_modified,
+           datetime(fn_creation_time / 10000000 - 11644473600, 'unixepoch') AS fn_created
+    FROM files
+    WHERE in_use = 0 AND base_record_number IS NULL;
+
+-- Named $DATA streams, e.g. Zone.Identifier or hidden payloads
+CREATE VIEW IF NOT EXISTS alternate_data_streams AS
+    SELECT f.record_number, f.path, s.name AS stream, s.size, s.non_resident
+    FROM data_streams s
+    JOIN files f ON f.record_number = s.record_number
+    WHERE s.name <> '';
+
+-- Files reachable under more than one Win32 or POSIX name
+CREATE VIEW IF NOT EXISTS hard_links AS
+    SELECT n.record_number, n.name, n.parent_record_number, p.path AS parent_path
+    FROM file_names n
+    LEFT JOIN files p ON p.record_number = n.parent_record_number
+    WHERE n.namespace <> 2
+      AND n.record_number IN (
+          SELECT record_number FROM file_names WHERE namespace <> 2
+          GROUP BY record_number HAVING COUNT(*) > 1);
+
+-- $STANDARD_INFORMATION times are set through the Win32 API and
+-- $FILE_NAME times are not: an SI creation time earlier than FN's, or one
+-- with no sub-second part, is the classic sign of a back-dated file
+CREATE VIEW IF NOT EXISTS timestomp_candidates AS
+    SELECT record_number, path,
+           datetime(si_creation_time / 10000000 - 11644473600, 'unixepoch') AS si_created,
+           datetime(fn_creation_time / 10000000 - 11644473600, 'unixepoch') AS fn_created,
+           si_creation_time < fn_creation_time AS si_before_fn,
+           si_creation_time % 10000000 = 0 AS whole_second
+    FROM files
+    WHERE in_use = 1
+      AND (si_creation_time < fn_creation_time OR si_creation_time % 10000000 = 0);
+
+-- One row per timestamp, for sorting into a super-timeline
+CREATE VIEW IF NOT EXISTS timeline AS
+    SELECT record_number, path, 'SI' AS source, 'M' AS event, si_modification_time AS time FROM files WHERE si_modification_time IS NOT NULL
+    UNION ALL SELECT record_number, path, 'SI', 'A', si_access_time FROM files WHERE si_access_time IS NOT NULL
+    UNION ALL SELECT record_number, path, 'SI', 'C', si_entry_time FROM files WHERE si_entry_time IS NOT NULL
+    UNION ALL SELECT record_number, path, 'SI', 'B', si_creation_time FROM files WHERE si_creation_time IS NOT NULL
+    UNION ALL SELECT record_number, path, 'FN', 'M', fn_modification_time FROM files WHERE fn_modification_time IS NOT NULL
+    UNION ALL SELECT record_number, path, 'FN', 'A', fn_access_time FROM files WHERE fn_access_time IS NOT NULL
+    UNION ALL SELECT record_number, path, 'FN', 'C', fn_entry_time FROM files WHERE fn_entry_time IS NOT NULL
+    UNION ALL SELECT record_number, path, 'FN', 'B', fn_creation_time FROM files WHERE fn_creation_time IS NOT NULL;
@@ -3,6 +3,7 @@
 
 #include "cliParser.h"
 #include "../core/mftAnalyzer.h"
+#include "../core/batchAnalyzer.h"
 #include <memory>
 
 class Application {
@@ -15,10 +16,23 @@ public:
 private:
     std::unique_ptr<CliParser> parser;
     std::unique_ptr<MftAnalyzer> analyzer;
+    std::unique_ptr<BatchAnalyzer> batchAnalyzer;
+    std::shared_ptr<CancellationToken> cancellation;
+    std::shared_ptr<const RecordFilter> where;
+    std::shared_ptr<const ParsePlan> plan;
+    OutputCompression compression;
+    OutputSplit split;
     
+    void compileWhere(const CliOptions& options);
+    void selectFields(const CliOptions& options);
+    void selectCompression(const CliOptions& options);
+    void selectSplit(const CliOptions& options);
     bool validateInputs(const CliOptions& options);
     bool initializeAnalyzer(const CliOptions& options);
+    int runBatch(const CliOptions& options);
+    int runQuery(const CliOptions& options);
     void setupSignalHandlers();
+    void restoreSignalHandlers();
     void printBanner() const;
     
     static void signalHandler(int signal);
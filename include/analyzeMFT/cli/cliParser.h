@@ -5,15 +5,47 @@
 #include <vector>
 #include <unordered_map>
 
+// --out FORMAT:PATH
+struct CliOutput {
+    std::string format;
+    std::string path;
+};
+
 struct CliOptions {
     std::string inputFile;
     std::string outputFile;
     std::string exportFormat = "csv";
+    std::string inputList;
+    std::string inputGlob;
+    std::string manifestFile;
+    unsigned jobs = 0;
+    unsigned ioLimit = 0;
+    unsigned rowGroupSize = 0;
+    unsigned sortMemory = 0;        // MB, 0 for the default
+    bool macb = false;              // merge equal timestamps within an attribute
+    bool macbAll = false;           // ... and across $SI and $FN
+    std::string whereExpression;
+    std::string fields;
+    std::string compress;
+    std::string splitOutput;
+    std::string evidenceFile;       // chain-of-custody digests of input and outputs
+    // Further outputs written from the same parse as exportFormat/outputFile
+    std::vector<CliOutput> outputs;
+    
+    // "analyzemft query": predicates answered from the snapshot indexes
+    bool queryMode = false;
+    std::string queryName;
+    std::string queryPath;
+    std::vector<std::string> queryTimes;
+    std::string querySize;
+    unsigned queryLimit = 0;
     int verbosity = 0;
     int debug = 0;
     bool computeHashes = false;
     bool showHelp = false;
     bool showVersion = false;
+    
+    bool isBatchMode() const { return !inputList.empty() || !inputGlob.empty(); }
 };
 
 class CliParser {
@@ -33,6 +65,8 @@ private:
     void initializeOptions();
     bool isValidFormat(const std::string& format) const;
     std::string getOptionValue(const std::string& arg, const std::string& option) const;
+    unsigned parseCount(const std::string& option, const std::string& value) const;
+    CliOutput parseOutput(const std::string& option, const std::string& value) const;
     void validateOptions(const CliOptions& options) const;
 };
 
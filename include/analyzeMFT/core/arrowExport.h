@@ -0,0 +1,77 @@
+#ifndef ANALYZEMFT_ARROWEXPORT_H
+#define ANALYZEMFT_ARROWEXPORT_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "arrowCData.h"
+
+class MftRecord;
+
+// Accumulates parsed records column by column and hands the finished buffers
+// to an Arrow consumer through the C Data Interface without copying them.
+// The batch is a struct array; low-cardinality strings (file type, extension)
+// are dictionary-encoded and timestamps are microseconds since the Unix epoch.
+class ArrowBatchBuilder {
+public:
+    ArrowBatchBuilder();
+
+    void append(const MftRecord& record);
+    size_t size() const { return rowCount; }
+    bool empty() const { return rowCount == 0; }
+
+    // Moves the accumulated buffers into schema/array and resets the builder.
+    // Records without a resolved filepath get a null in that column.
+    void finish(struct ArrowSchema* schema, struct ArrowArray* array);
+
+    static std::vector<std::string> columnNames();
+
+private:
+    struct FixedColumn {
+        std::vector<uint8_t> values;
+        std::vector<uint8_t> validity;
+        int64_t nullCount = 0;
+    };
+
+    struct StringColumn {
+        std::vector<uint8_t> offsets;
+        std::vector<uint8_t> data;
+        std::vector<uint8_t> validity;
+        int64_t nullCount = 0;
+    };
+
+    struct DictionaryColumn {
+        FixedColumn indices;
+        std::vector<std::string> dictionary;
+        std::unordered_map<std::string, int32_t> lookup;
+    };
+
+    size_t rowCount;
+
+    FixedColumn recordNumber;
+    FixedColumn sequenceNumber;
+    FixedColumn flags;
+    FixedColumn inUse;
+    FixedColumn isDirectory;
+    DictionaryColumn fileType;
+    FixedColumn parentRecordNumber;
+    FixedColumn linkCount;
+    FixedColumn fileSize;
+    StringColumn filename;
+    DictionaryColumn extension;
+    StringColumn filepath;
+    FixedColumn times[8];
+    FixedColumn attributeMask;
+
+    void reset();
+
+    template<typename T>
+    static void appendValue(FixedColumn& column, T value);
+    static void appendBit(FixedColumn& column, bool value);
+    static void appendValidity(std::vector<uint8_t>& validity, int64_t& nullCount, size_t row, bool valid);
+    static void appendString(StringColumn& column, const std::string& value, size_t row, bool valid);
+    static void appendDictionary(DictionaryColumn& column, const std::string& value, size_t row, bool valid);
+};
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef ANALYZEMFT_BATCHANALYZER_H
+#define ANALYZEMFT_BATCHANALYZER_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include "cancellationToken.h"
+#include "recordFilter.h"
+#include "parsePlan.h"
+#include "../utils/outputSink.h"
+#include "../writers/fileWriter.h"
+
+// Counting semaphore bounding how many analyses may read from disk at once.
+class IoThrottle {
+public:
+    explicit IoThrottle(unsigned permits);
+
+    void acquire();
+    void release();
+
+private:
+    unsigned available;
+    std::mutex mutex;
+    std::condition_variable condition;
+};
+
+struct BatchJobResult {
+    std::string inputFile;
+    std::string outputFile;
+    std::string status = "pending";
+    std::string error;
+    uint64_t inputSize = 0;
+    uint64_t totalRecords = 0;
+    uint64_t activeRecords = 0;
+    uint64_t directories = 0;
+    uint64_t files = 0;
+    double elapsedSeconds = 0.0;
+};
+
+class BatchAnalyzer {
+public:
+    BatchAnalyzer(const std::vector<std::string>& inputFiles, const std::string& outputDirectory,
+                  int debug = 0, int verbosity = 0, bool computeHashes = false,
+                  const std::string& exportFormat = "csv");
+
+    void setMaxConcurrency(unsigned jobs);
+    void setMaxConcurrentIo(unsigned ioLimit);
+    void setParquetRowGroupSize(size_t rows) { parquetRowGroupSize = rows; }
+    void setSortMemory(size_t bytes) { sortMemory = bytes; }
+    void setMacbCollapse(MacbCollapse mode) { macbCollapse = mode; }
+    void setRecordFilter(std::shared_ptr<const RecordFilter> filter) { where = std::move(filter); }
+    void setParsePlan(std::shared_ptr<const ParsePlan> plan) { this->plan = std::move(plan); }
+    // Compressed outputs get the codec's extension, e.g. $MFT.csv.zst
+    void setCompression(const OutputCompression& codec) { compression = codec; }
+    void setSplit(const OutputSplit& split) { this->split = split; }
+
+    bool analyze();
+    bool writeManifest(const std::string& manifestFile) const;
+    void printSummary() const;
+
+    const std::vector<BatchJobResult>& getResults() const { return results; }
+
+    void setInterruptFlag() { cancellation->cancel(); }
+    bool isInterrupted() const { return cancellation->isCancelled(); }
+    void setCancellationToken(std::shared_ptr<CancellationToken> token);
+
+    static std::vector<std::string> readInputList(const std::string& listFile);
+    static std::string getFormatExtension(const std::string& exportFormat);
+
+private:
+    std::vector<std::string> inputFiles;
+    std::string outputDirectory;
+    int debug;
+    int verbosity;
+    bool computeHashes;
+    std::string exportFormat;
+    unsigned maxConcurrency;
+    unsigned maxConcurrentIo;
+    size_t parquetRowGroupSize = 0;
+    size_t sortMemory = 0;
+    MacbCollapse macbCollapse = MacbCollapse::None;
+    std::shared_ptr<const RecordFilter> where;
+    std::shared_ptr<const ParsePlan> plan;
+    OutputCompression compression;
+    OutputSplit split;
+
+    std::vector<BatchJobResult> results;
+    std::shared_ptr<CancellationToken> cancellation;
+    std::atomic<size_t> nextJob{0};
+    std::atomic<uint64_t> unfinishedBytes{0};   // input bytes of the jobs not yet done
+    // Of maxConcurrency, the threads no running job holds
+    unsigned freeThreads = 0;
+    std::mutex threadsMutex;
+    std::condition_variable threadsFreed;
+    std::shared_ptr<IoThrottle> ioThrottle;
+
+    void assignOutputFiles();
+    void workerLoop(const std::vector<size_t>& schedule);
+    unsigned takeThreads(const BatchJobResult& job);
+    void returnThreads(unsigned threads);
+    void runJob(BatchJobResult& job, unsigned threads);
+    void log(const std::string& message, int level = 0) const;
+};
+
+#endif
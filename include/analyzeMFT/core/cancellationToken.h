@@ -0,0 +1,31 @@
+#ifndef ANALYZEMFT_CANCELLATIONTOKEN_H
+#define ANALYZEMFT_CANCELLATIONTOKEN_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Per-analysis stop request. cancel() is a single lock-free store, so it may
+// be called from another thread or from a signal handler owned by the host.
+class CancellationToken {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CancellationToken();
+
+    void cancel();
+    bool isCancelled() const;
+    bool isDeadlineExceeded() const;
+
+    void setDeadline(Clock::time_point deadline);
+    void setTimeout(std::chrono::milliseconds timeout);
+    void clearDeadline();
+
+private:
+    std::atomic<bool> cancelled;
+    std::atomic<int64_t> deadlineTicks;
+
+    static constexpr int64_t NO_DEADLINE = INT64_MAX;
+};
+
+#endif
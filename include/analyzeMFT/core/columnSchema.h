@@ -0,0 +1,267 @@
+#ifndef ANALYZEMFT_COLUMNSCHEMA_H
+#define ANALYZEMFT_COLUMNSCHEMA_H
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "constants.h"
+#include "mftRecord.h"
+
+// The flat record columns: the CSV, JSON, JSONL, XML and Excel rows, the
+// scalar columns of the SQLite files table and the names --fields takes all
+// come from COLUMNS, one descriptor per CsvColumn, in order. Writers expand
+// the table at compile time,
+//
+//     forEachColumn([&](const ColumnDescriptor& column) {
+//         append(out, column.key, column.type, column.get(*record));
+//     });
+//
+// into one direct, inlinable accessor call per column, so the per-record
+// loop has no switch and no virtual call. A --fields selection is a runtime
+// list, visited through the same descriptors.
+
+// How a column's value is held, and so how each format writes it
+enum class ColumnType : uint8_t {
+    Number,         // unsigned integer
+    Text,           // UTF-8
+    Time,           // FILETIME; text formats write getDateTimeString(), SQLite the ticks
+    Flag,           // "True" or "False"
+    Presence        // "Present" or empty
+};
+
+// A column of one record; the members set follow the column's type
+struct ColumnValue {
+    uint64_t number = 0;
+    std::string_view text;
+    const WindowsTime* time = nullptr;
+    bool flag = false;
+};
+
+struct ColumnDescriptor {
+    size_t id;                      // CsvColumn
+    const char* header;             // CSV header and Excel title: "SI Creation Time"
+    const char* key;                // JSON, JSONL and XML name: "siCreationTime"
+    const char* sqlName;            // column of the SQLite files table, or nullptr
+    ColumnType type;
+    uint32_t attribute;             // attribute decoded for it; 0 for header fields and the Has columns
+    ColumnValue (*get)(const MftRecord& record);
+};
+
+inline ColumnValue numberColumn(uint64_t number) {
+    ColumnValue value;
+    value.number = number;
+    return value;
+}
+
+inline ColumnValue textColumn(std::string_view text) {
+    ColumnValue value;
+    value.text = text;
+    return value;
+}
+
+inline ColumnValue timeColumn(const WindowsTime& time) {
+    ColumnValue value;
+    value.time = &time;
+    return value;
+}
+
+inline ColumnValue flagColumn(bool flag) {
+    ColumnValue value;
+    value.flag = flag;
+    return value;
+}
+
+constexpr const char* fileTypeName(uint16_t flags) {
+    return (flags & FILE_RECORD_IS_DIRECTORY) ? "Directory" :
+           (flags & FILE_RECORD_IS_EXTENSION) ? "Extension" :
+           (flags & FILE_RECORD_HAS_SPECIAL_INDEX) ? "Special Index" : "File";
+}
+
+inline constexpr std::array<ColumnDescriptor, CSV_COLUMN_COUNT> COLUMNS = {{
+    {CSV_RECORD_NUMBER, "Record Number", "recordNumber", "record_number", ColumnType::Number, 0,
+     [](const MftRecord& r) { return numberColumn(r.recordnum); }},
+    {CSV_RECORD_STATUS, "Record Status", "recordStatus", nullptr, ColumnType::Text, 0,
+     [](const MftRecord& r) { return textColumn(r.magic == MFT_RECORD_MAGIC ? "Valid" : "Invalid"); }},
+    {CSV_RECORD_TYPE, "Record Type", "recordType", nullptr, ColumnType::Text, 0,
+     [](const MftRecord& r) { return textColumn((r.flags & FILE_RECORD_IN_USE) ? "In Use" : "Not in Use"); }},
+    {CSV_FILE_TYPE, "File Type", "fileType", nullptr, ColumnType::Text, 0,
+     [](const MftRecord& r) { return textColumn(fileTypeName(r.flags)); }},
+    {CSV_SEQUENCE_NUMBER, "Sequence Number", "sequenceNumber", "sequence_number", ColumnType::Number, 0,
+     [](const MftRecord& r) { return numberColumn(r.seq); }},
+    {CSV_PARENT_RECORD_NUMBER, "Parent Record Number", "parentRecordNumber", "parent_record_number",
+     ColumnType::Number, FILE_NAME_ATTRIBUTE,
+     [](const MftRecord& r) { return numberColumn(r.getParentRecordNum()); }},
+    {CSV_PARENT_SEQUENCE_NUMBER, "Parent Record Sequence Number", "parentSequenceNumber", "parent_sequence_number",
+     ColumnType::Number, FILE_NAME_ATTRIBUTE,
+     [](const MftRecord& r) { return numberColumn(r.parentRef >> 48); }},
+    {CSV_FILENAME, "Filename", "filename", "name", ColumnType::Text, FILE_NAME_ATTRIBUTE,
+     [](const MftRecord& r) { return textColumn(r.filename); }},
+    {CSV_FILEPATH, "Filepath", "filepath", "path", ColumnType::Text, FILE_NAME_ATTRIBUTE,
+     [](const MftRecord& r) { return textColumn(r.filepath); }},
+
+    {CSV_SI_CREATION_TIME, "SI Creation Time", "siCreationTime", "si_creation_time",
+     ColumnType::Time, STANDARD_INFORMATION_ATTRIBUTE,
+     [](const MftRecord& r) { return timeColumn(r.siTimes.crtime); }},
+    {CSV_SI_MODIFICATION_TIME, "SI Modification Time", "siModificationTime", "si_modification_time",
+     ColumnType::Time, STANDARD_INFORMATION_ATTRIBUTE,
+     [](const MftRecord& r) { return timeColumn(r.siTimes.mtime); }},
+    {CSV_SI_ACCESS_TIME, "SI Access Time", "siAccessTime", "si_access_time",
+     ColumnType::Time, STANDARD_INFORMATION_ATTRIBUTE,
+     [](const MftRecord& r) { return timeColumn(r.siTimes.atime); }},
+    {CSV_SI_ENTRY_TIME, "SI Entry Time", "siEntryTime", "si_entry_time",
+     ColumnType::Time, STANDARD_INFORMATION_ATTRIBUTE,
+     [](const MftRecord& r) { return timeColumn(r.siTimes.ctime); }},
+    {CSV_FN_CREATION_TIME, "FN Creation Time", "fnCreationTime", "fn_creation_time",
+     ColumnType::Time, FILE_NAME_ATTRIBUTE,
+     [](const MftRecord& r) { return timeColumn(r.fnTimes.crtime); }},
+    {CSV_FN_MODIFICATION_TIME, "FN Modification Time", "fnModificationTime", "fn_modification_time",
+     ColumnType::Time, FILE_NAME_ATTRIBUTE,
+     [](const MftRecord& r) { return timeColumn(r.fnTimes.mtime); }},
+    {CSV_FN_ACCESS_TIME, "FN Access Time", "fnAccessTime", "fn_access_time",
+     ColumnType::Time, FILE_NAME_ATTRIBUTE,
+     [](const MftRecord& r) { return timeColumn(r.fnTimes.atime); }},
+    {CSV_FN_ENTRY_TIME, "FN Entry Time", "fnEntryTime", "fn_entry_time",
+     ColumnType::Time, FILE_NAME_ATTRIBUTE,
+     [](const MftRecord& r) { return timeColumn(r.fnTimes.ctime); }},
+
+    {CSV_OBJECT_ID, "Object ID", "objectId", "object_id", ColumnType::Text, OBJECT_ID_ATTRIBUTE,
+     [](const MftRecord& r) { return textColumn(r.objectId); }},
+    {CSV_BIRTH_VOLUME_ID, "Birth Volume ID", "birthVolumeId", "birth_volume_id", ColumnType::Text, OBJECT_ID_ATTRIBUTE,
+     [](const MftRecord& r) { return textColumn(r.birthVolumeId); }},
+    {CSV_BIRTH_OBJECT_ID, "Birth Object ID", "birthObjectId", "birth_object_id", ColumnType::Text, OBJECT_ID_ATTRIBUTE,
+     [](const MftRecord& r) { return textColumn(r.birthObjectId); }},
+    {CSV_BIRTH_DOMAIN_ID, "Birth Domain ID", "birthDomainId", "birth_domain_id", ColumnType::Text, OBJECT_ID_ATTRIBUTE,
+     [](const MftRecord& r) { return textColumn(r.birthDomainId); }},
+
+    {CSV_HAS_STANDARD_INFORMATION, "Has Standard Information", "hasStandardInformation", nullptr, ColumnType::Flag, 0,
+     [](const MftRecord& r) { return flagColumn(r.attributeTypes.count(STANDARD_INFORMATION_ATTRIBUTE) != 0); }},
+    {CSV_HAS_ATTRIBUTE_LIST, "Has Attribute List", "hasAttributeList", nullptr, ColumnType::Flag, 0,
+     [](const MftRecord& r) { return flagColumn(r.attributeTypes.count(ATTRIBUTE_LIST_ATTRIBUTE) != 0); }},
+    {CSV_HAS_FILE_NAME, "Has File Name", "hasFileName", nullptr, ColumnType::Flag, 0,
+     [](const MftRecord& r) { return flagColumn(r.attributeTypes.count(FILE_NAME_ATTRIBUTE) != 0); }},
+    {CSV_HAS_VOLUME_NAME, "Has Volume Name", "hasVolumeName", nullptr, ColumnType::Flag, 0,
+     [](const MftRecord& r) { return flagColumn(r.attributeTypes.count(VOLUME_NAME_ATTRIBUTE) != 0); }},
+    {CSV_HAS_VOLUME_INFORMATION, "Has Volume Information", "hasVolumeInformation", nullptr, ColumnType::Flag, 0,
+     [](const MftRecord& r) { return flagColumn(r.attributeTypes.count(VOLUME_INFORMATION_ATTRIBUTE) != 0); }},
+    {CSV_HAS_DATA, "Has Data", "hasData", nullptr, ColumnType::Flag, 0,
+     [](const MftRecord& r) { return flagColumn(r.attributeTypes.count(DATA_ATTRIBUTE) != 0); }},
+    {CSV_HAS_INDEX_ROOT, "Has Index Root", "hasIndexRoot", nullptr, ColumnType::Flag, 0,
+     [](const MftRecord& r) { return flagColumn(r.attributeTypes.count(INDEX_ROOT_ATTRIBUTE) != 0); }},
+    {CSV_HAS_INDEX_ALLOCATION, "Has Index Allocation", "hasIndexAllocation", nullptr, ColumnType::Flag, 0,
+     [](const MftRecord& r) { return flagColumn(r.attributeTypes.count(INDEX_ALLOCATION_ATTRIBUTE) != 0); }},
+    {CSV_HAS_BITMAP, "Has Bitmap", "hasBitmap", nullptr, ColumnType::Flag, 0,
+     [](const MftRecord& r) { return flagColumn(r.attributeTypes.count(BITMAP_ATTRIBUTE) != 0); }},
+    {CSV_HAS_REPARSE_POINT, "Has Reparse Point", "hasReparsePoint", nullptr, ColumnType::Flag, 0,
+     [](const MftRecord& r) { return flagColumn(r.attributeTypes.count(REPARSE_POINT_ATTRIBUTE) != 0); }},
+    {CSV_HAS_EA_INFORMATION, "Has EA Information", "hasEaInformation", nullptr, ColumnType::Flag, 0,
+     [](const MftRecord& r) { return flagColumn(r.attributeTypes.count(EA_INFORMATION_ATTRIBUTE) != 0); }},
+    {CSV_HAS_EA, "Has EA", "hasEa", nullptr, ColumnType::Flag, 0,
+     [](const MftRecord& r) { return flagColumn(r.attributeTypes.count(EA_ATTRIBUTE) != 0); }},
+    {CSV_HAS_LOGGED_UTILITY_STREAM, "Has Logged Utility Stream", "hasLoggedUtilityStream", nullptr, ColumnType::Flag, 0,
+     [](const MftRecord& r) { return flagColumn(r.attributeTypes.count(LOGGED_UTILITY_STREAM_ATTRIBUTE) != 0); }},
+
+    // Attribute list details are not formatted yet
+    {CSV_ATTRIBUTE_LIST_DETAILS, "Attribute List Details", "attributeListDetails", nullptr,
+     ColumnType::Text, ATTRIBUTE_LIST_ATTRIBUTE,
+     [](const MftRecord&) { return textColumn(""); }},
+    {CSV_SECURITY_DESCRIPTOR, "Security Descriptor", "securityDescriptor", nullptr,
+     ColumnType::Presence, SECURITY_DESCRIPTOR_ATTRIBUTE,
+     [](const MftRecord& r) { return flagColumn(r.securityDescriptor != nullptr); }},
+    {CSV_VOLUME_NAME, "Volume Name", "volumeName", nullptr, ColumnType::Text, VOLUME_NAME_ATTRIBUTE,
+     [](const MftRecord& r) { return textColumn(r.volumeName); }},
+    {CSV_VOLUME_INFORMATION, "Volume Information", "volumeInformation", nullptr,
+     ColumnType::Presence, VOLUME_INFORMATION_ATTRIBUTE,
+     [](const MftRecord& r) { return flagColumn(r.volumeInfo != nullptr); }},
+    {CSV_DATA_ATTRIBUTE, "Data Attribute", "dataAttribute", nullptr, ColumnType::Presence, DATA_ATTRIBUTE,
+     [](const MftRecord& r) { return flagColumn(r.dataAttribute != nullptr); }},
+    {CSV_INDEX_ROOT, "Index Root", "indexRoot", nullptr, ColumnType::Presence, INDEX_ROOT_ATTRIBUTE,
+     [](const MftRecord& r) { return flagColumn(r.indexRoot != nullptr); }},
+    {CSV_INDEX_ALLOCATION, "Index Allocation", "indexAllocation", nullptr,
+     ColumnType::Presence, INDEX_ALLOCATION_ATTRIBUTE,
+     [](const MftRecord& r) { return flagColumn(r.indexAllocation != nullptr); }},
+    {CSV_BITMAP, "Bitmap", "bitmap", nullptr, ColumnType::Presence, BITMAP_ATTRIBUTE,
+     [](const MftRecord& r) { return flagColumn(r.bitmap != nullptr); }},
+    {CSV_REPARSE_POINT, "Reparse Point", "reparsePoint", nullptr, ColumnType::Presence, REPARSE_POINT_ATTRIBUTE,
+     [](const MftRecord& r) { return flagColumn(r.reparsePoint != nullptr); }},
+    {CSV_EA_INFORMATION, "EA Information", "eaInformation", nullptr, ColumnType::Presence, EA_INFORMATION_ATTRIBUTE,
+     [](const MftRecord& r) { return flagColumn(r.eaInformation != nullptr); }},
+    {CSV_EA, "EA", "ea", nullptr, ColumnType::Presence, EA_ATTRIBUTE,
+     [](const MftRecord& r) { return flagColumn(r.ea != nullptr); }},
+    {CSV_LOGGED_UTILITY_STREAM, "Logged Utility Stream", "loggedUtilityStream", nullptr,
+     ColumnType::Presence, LOGGED_UTILITY_STREAM_ATTRIBUTE,
+     [](const MftRecord& r) { return flagColumn(r.loggedUtilityStream != nullptr); }},
+
+    // Empty unless computed, either at parse time or when loaded from a snapshot
+    {CSV_MD5, "MD5", "md5", "md5", ColumnType::Text, 0,
+     [](const MftRecord& r) { return textColumn(r.md5); }},
+    {CSV_SHA256, "SHA256", "sha256", "sha256", ColumnType::Text, 0,
+     [](const MftRecord& r) { return textColumn(r.sha256); }},
+    {CSV_SHA512, "SHA512", "sha512", "sha512", ColumnType::Text, 0,
+     [](const MftRecord& r) { return textColumn(r.sha512); }},
+    {CSV_CRC32, "CRC32", "crc32", "crc32", ColumnType::Text, 0,
+     [](const MftRecord& r) { return textColumn(r.crc32); }},
+
+    {CSV_FILE_SIZE, "File Size", "filesize", "size", ColumnType::Number, FILE_NAME_ATTRIBUTE,
+     [](const MftRecord& r) { return numberColumn(r.filesize); }},
+    {CSV_FLAGS, "Flags", "flags", "flags", ColumnType::Number, 0,
+     [](const MftRecord& r) { return numberColumn(r.flags); }},
+}};
+
+constexpr bool columnsInOrder() {
+    for (size_t i = 0; i < COLUMNS.size(); ++i) {
+        if (COLUMNS[i].id != i) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(columnsInOrder(), "COLUMNS lists every CsvColumn, in CsvColumn order");
+
+template <typename Visit, size_t... Columns>
+inline void forEachColumn(Visit&& visit, std::index_sequence<Columns...>) {
+    (visit(COLUMNS[Columns]), ...);
+}
+
+// Calls visit(COLUMNS[i]) for every column in order, unrolled
+template <typename Visit>
+inline void forEachColumn(Visit&& visit) {
+    forEachColumn(visit, std::make_index_sequence<CSV_COLUMN_COUNT>());
+}
+
+// The selected columns in their order, or all of them, unrolled, when none are
+template <typename Visit>
+inline void forEachColumn(const std::vector<size_t>& selected, Visit&& visit) {
+    if (selected.empty()) {
+        forEachColumn(visit);
+        return;
+    }
+    for (size_t column : selected) {
+        visit(COLUMNS[column]);
+    }
+}
+
+// The value as text: what CSV, JSON, XML and Excel write. Numbers are
+// formatted into `digits`; the rest points into the record or a literal.
+inline std::string_view columnText(ColumnType type, const ColumnValue& value, char (&digits)[20]) {
+    switch (type) {
+        case ColumnType::Number: {
+            auto result = std::to_chars(digits, digits + sizeof(digits), value.number);
+            return std::string_view(digits, static_cast<size_t>(result.ptr - digits));
+        }
+        case ColumnType::Text:
+            return value.text;
+        case ColumnType::Time:
+            return value.time->getDateTimeString();
+        case ColumnType::Flag:
+            return value.flag ? "True" : "False";
+        case ColumnType::Presence:
+            return value.flag ? "Present" : "";
+    }
+    return {};
+}
+
+#endif
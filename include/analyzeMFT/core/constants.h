@@ -70,19 +70,22 @@ constexpr size_t MFT_RECORD_FILE_REFERENCE_OFFSET = 32;
 constexpr size_t MFT_RECORD_NEXT_ATTRIBUTE_ID_OFFSET = 40;
 constexpr size_t MFT_RECORD_RECORD_NUMBER_OFFSET = 44;
 
-const std::vector<std::string> CSV_HEADER = {
-    "Record Number", "Record Status", "Record Type", "File Type", "Sequence Number",
-    "Parent Record Number", "Parent Record Sequence Number", "Filename", "Filepath",
-    "SI Creation Time", "SI Modification Time", "SI Access Time", "SI Entry Time",
-    "FN Creation Time", "FN Modification Time", "FN Access Time", "FN Entry Time",
-    "Object ID", "Birth Volume ID", "Birth Object ID", "Birth Domain ID",
-    "Has Standard Information", "Has Attribute List", "Has File Name", "Has Volume Name",
-    "Has Volume Information", "Has Data", "Has Index Root", "Has Index Allocation",
-    "Has Bitmap", "Has Reparse Point", "Has EA Information", "Has EA",
-    "Has Logged Utility Stream", "Attribute List Details", "Security Descriptor",
-    "Volume Name", "Volume Information", "Data Attribute", "Index Root",
-    "Index Allocation", "Bitmap", "Reparse Point", "EA Information", "EA",
-    "Logged Utility Stream", "MD5", "SHA256", "SHA512", "CRC32"
+// The flat output columns, in CSV order; columnSchema.h describes each one
+enum CsvColumn : size_t {
+    CSV_RECORD_NUMBER, CSV_RECORD_STATUS, CSV_RECORD_TYPE, CSV_FILE_TYPE, CSV_SEQUENCE_NUMBER,
+    CSV_PARENT_RECORD_NUMBER, CSV_PARENT_SEQUENCE_NUMBER, CSV_FILENAME, CSV_FILEPATH,
+    CSV_SI_CREATION_TIME, CSV_SI_MODIFICATION_TIME, CSV_SI_ACCESS_TIME, CSV_SI_ENTRY_TIME,
+    CSV_FN_CREATION_TIME, CSV_FN_MODIFICATION_TIME, CSV_FN_ACCESS_TIME, CSV_FN_ENTRY_TIME,
+    CSV_OBJECT_ID, CSV_BIRTH_VOLUME_ID, CSV_BIRTH_OBJECT_ID, CSV_BIRTH_DOMAIN_ID,
+    CSV_HAS_STANDARD_INFORMATION, CSV_HAS_ATTRIBUTE_LIST, CSV_HAS_FILE_NAME, CSV_HAS_VOLUME_NAME,
+    CSV_HAS_VOLUME_INFORMATION, CSV_HAS_DATA, CSV_HAS_INDEX_ROOT, CSV_HAS_INDEX_ALLOCATION,
+    CSV_HAS_BITMAP, CSV_HAS_REPARSE_POINT, CSV_HAS_EA_INFORMATION, CSV_HAS_EA,
+    CSV_HAS_LOGGED_UTILITY_STREAM, CSV_ATTRIBUTE_LIST_DETAILS, CSV_SECURITY_DESCRIPTOR,
+    CSV_VOLUME_NAME, CSV_VOLUME_INFORMATION, CSV_DATA_ATTRIBUTE, CSV_INDEX_ROOT,
+    CSV_INDEX_ALLOCATION, CSV_BITMAP, CSV_REPARSE_POINT, CSV_EA_INFORMATION, CSV_EA,
+    CSV_LOGGED_UTILITY_STREAM, CSV_MD5, CSV_SHA256, CSV_SHA512, CSV_CRC32,
+    CSV_FILE_SIZE, CSV_FLAGS,
+    CSV_COLUMN_COUNT
 };
 
 #endif
\ No newline at end of file
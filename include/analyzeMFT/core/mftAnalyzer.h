@@ -10,6 +10,20 @@
 #include <future>
 #include <vector>
 #include "mftRecord.h"
+#include "mftReader.h"
+#include "cancellationToken.h"
+#include "arrowCData.h"
+#include "../utils/outputSink.h"
+#include "../writers/fileWriter.h"
+
+class IoThrottle;
+class CsvWriter;
+class JsonlWriter;
+class ExcelWriter;
+class ParquetWriter;
+class SqliteWriter;
+class TimelineWriter;
+class SnapshotWriter;
 
 struct AnalysisStats {
     std::atomic<uint64_t> totalRecords{0};
@@ -30,12 +44,56 @@ public:
     
     ~MftAnalyzer();
     
+    // Writes another format from the same parse. Each output then gets its
+    // own writer thread, and all of them share the parsed records.
+    void addOutput(const std::string& exportFormat, const std::string& outputFile);
+    
     bool analyze();
+    // Parses the whole MFT into a single Arrow record batch instead of writing output.
+    bool exportArrow(struct ArrowSchema* schema, struct ArrowArray* array);
     void cleanup();
     void printStatistics() const;
     
-    void setInterruptFlag() { interruptFlag = true; }
-    bool isInterrupted() const { return interruptFlag; }
+    // Writes already-parsed records in one of the whole-file formats; a
+    // projected plan restricts the csv, json, jsonl, xml and parquet columns,
+    // and csv, json, jsonl and xml are formatted on `threads` threads.
+    // Compression applies to the text formats: csv, json, jsonl, xml, body
+    // and timeline; collapse to body and timeline. A digest is filled for
+    // every format but sqlite. Cancelling stops a "shm:" output
+    // waiting for its consumer.
+    static bool writeRecords(const std::vector<const MftRecord*>& records, const std::string& outputFile,
+                             const std::string& exportFormat, const ParsePlan* plan = nullptr,
+                             unsigned threads = 1, const OutputCompression& compression = OutputCompression(),
+                             MacbCollapse collapse = MacbCollapse::None, OutputDigest* digest = nullptr,
+                             const CancellationToken* cancellation = nullptr);
+    static bool supportsCompression(const std::string& exportFormat);
+    static bool isRecordFormat(const std::string& exportFormat);
+    static bool supportsFieldSelection(const std::string& exportFormat);
+    
+    void setInterruptFlag() { cancellation->cancel(); }
+    bool isInterrupted() const { return cancellation->isCancelled(); }
+    
+    void setCancellationToken(std::shared_ptr<CancellationToken> token);
+    std::shared_ptr<CancellationToken> getCancellationToken() const { return cancellation; }
+    
+    void setIoThrottle(std::shared_ptr<IoThrottle> throttle) { ioThrottle = std::move(throttle); }
+    void setThreadCount(unsigned threads) { threadCount = threads > 0 ? threads : 1; }
+    void setParquetRowGroupSize(size_t rows) { parquetRowGroupSize = rows; }
+    // Memory for sorting timeline events before runs spill to disk; 0 for the default
+    void setSortMemory(size_t bytes) { sortMemory = bytes; }
+    // Merges equal body and timeline timestamps into MACB lines
+    void setMacbCollapse(MacbCollapse mode) { macbCollapse = mode; }
+    void setRecordFilter(std::shared_ptr<const RecordFilter> filter) { where = std::move(filter); }
+    void setParsePlan(std::shared_ptr<const ParsePlan> plan);
+    // Compresses text output on setThreadCount() threads
+    void setCompression(const OutputCompression& codec) { compression = codec; }
+    // Parts roll over on the output's writer thread while parsing goes on
+    void setSplit(const OutputSplit& split) { this->split = split; }
+    // After the outputs, writes a JSON record of the input's and every
+    // output file's SHA-256 with the statistics. The digests are taken as
+    // the bytes stream through the reader and the output sinks.
+    void setEvidenceManifest(const std::string& path) { evidenceFile = path; }
+    const AnalysisStats& getStatistics() const { return stats; }
 
 private:
     std::string mftFile;
@@ -45,26 +103,105 @@ private:
     bool computeHashes;
     std::string exportFormat;
     
-    std::atomic<bool> interruptFlag{false};
-    std::unordered_map<uint32_t, std::unique_ptr<MftRecord>> mftRecords;
+    std::shared_ptr<CancellationToken> cancellation;
     AnalysisStats stats;
     
-    std::unique_ptr<std::ofstream> csvFile;
-    std::unique_ptr<std::ostream> csvWriter;
+    // Records [begin, end) of a parsed batch
+    struct Slice {
+        std::shared_ptr<const RecordBatch> batch;
+        size_t begin;
+        size_t end;
+    };
+    // A finished part of a split output
+    struct Part {
+        std::string file;
+        uint64_t records;
+        uint32_t firstRecord;
+        uint32_t lastRecord;
+        uint64_t bytes;
+        std::string sha256;
+    };
+    // One export of the parse and the writer of its format, if it streams
+    struct Output {
+        std::string format;
+        std::string path;
+        std::string file;               // path, or the current part when splitting
+        std::unique_ptr<OutputSink> sink;       // the file csv and jsonl stream into
+        std::unique_ptr<CsvWriter> csvWriter;   // formats the rows sink streams
+        std::unique_ptr<JsonlWriter> jsonlWriter;
+        std::unique_ptr<ParquetWriter> parquetWriter;
+        std::unique_ptr<SqliteWriter> sqliteWriter;
+        std::unique_ptr<ExcelWriter> excelWriter;
+        std::unique_ptr<TimelineWriter> timelineWriter;
+        std::unique_ptr<SnapshotWriter> snapshotWriter;
+        // Of the file just closed, when its writer hashed it
+        OutputDigest digest;
+        // Records not yet written by a format that writes all at once
+        std::vector<Slice> pending;
+        
+        uint64_t partRecords = 0;
+        uint64_t partLimit = 0;
+        uint32_t firstRecord = 0;
+        uint32_t lastRecord = 0;
+        std::vector<Part> parts;
+    };
+    struct BatchQueue;
     
+    // outputs[0] is exportFormat to outputFile
+    std::vector<Output> outputs;
+    OutputSplit split;
+    size_t parquetRowGroupSize = 0;
+    size_t sortMemory = 0;
+    MacbCollapse macbCollapse = MacbCollapse::None;
+    
+    std::string evidenceFile;
+    std::string startTime;
+    std::string inputSha256;        // taken by the reader, if it read the whole input
+    uint64_t inputBytes = 0;
+    
+    std::shared_ptr<IoThrottle> ioThrottle;
+    std::shared_ptr<const RecordFilter> where;
+    std::shared_ptr<const ParsePlan> plan;
+    unsigned threadCount = 1;
+    OutputCompression compression;
+    
+    MftReaderOptions makeReaderOptions() const;
+    const std::vector<size_t>& csvColumns() const;
+    void updateStatistics(const MftRecord& record);
     bool processMft();
-    std::vector<uint8_t> readRecord(std::ifstream& file);
-    bool initializeCsvWriter();
-    bool writeCsvBlock();
-    bool writeRemainingRecords();
+    bool initializeOutput(Output& output);
+    bool openSink(Output& output, uint64_t bytesPerRecord);
+    bool initializeCsvWriter(Output& output);
+    bool initializeJsonlWriter(Output& output);
+    bool initializeParquetWriter(Output& output);
+    bool initializeSqliteWriter(Output& output);
+    bool initializeExcelWriter(Output& output);
+    bool initializeSnapshotWriter(Output& output);
+    bool initializeTimelineWriter(Output& output);
+    bool writeBlock(Output& output, const std::shared_ptr<const RecordBatch>& batch);
+    bool partFull(const Output& output) const;
+    // Text formats written through a sink end the slice early, by moving
+    // slice.end, once the part has reached the --split-output size
+    bool writeSlice(Output& output, Slice& slice);
+    bool writeCsvBlock(Output& output, Slice& slice);
+    bool writeJsonlBlock(Output& output, Slice& slice);
+    bool writeParquetBlock(Output& output, const Slice& slice);
+    bool writeSqliteBlock(Output& output, const Slice& slice);
+    bool writeExcelBlock(Output& output, const Slice& slice);
+    bool writeSnapshotBlock(Output& output, const Slice& slice);
+    bool writeTimelineBlock(Output& output, const Slice& slice);
     bool writeOutput();
-    std::string buildFilepath(const MftRecord* record) const;
+    bool finishOutput(Output& output);
+    bool closeOutput(Output& output);
+    void startPart(Output& output);
+    bool nextPart(Output& output);
+    bool recordPart(Output& output);
+    bool writePartManifest(const Output& output) const;
+    bool hashOutputs() const { return split.enabled() || !evidenceFile.empty(); }
+    OutputDigest digestOf(const Output& output) const;
+    bool writeEvidenceManifest();
     
     void log(const std::string& message, int level = 0) const;
-    void setupInterruptHandler();
-    
-    static void signalHandler(int signal);
-    static MftAnalyzer* currentInstance;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,176 @@
+#ifndef ANALYZEMFT_MFTREADER_H
+#define ANALYZEMFT_MFTREADER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <cstdint>
+#include "mftRecord.h"
+#include "pathResolver.h"
+#include "cancellationToken.h"
+#include "snapshot.h"
+#include "recordFilter.h"
+#include "parsePlan.h"
+#include "../utils/hashCalc.h"
+#include "../utils/workerPool.h"
+
+class IoThrottle;
+
+// Projection flags; the values match the MFT_FIELD_* flags of the C API.
+constexpr uint32_t READER_FIELD_NAMES      = 0x0001;
+constexpr uint32_t READER_FIELD_PATHS      = 0x0002;
+constexpr uint32_t READER_FIELD_SI_TIMES   = 0x0004;
+constexpr uint32_t READER_FIELD_FN_TIMES   = 0x0008;
+constexpr uint32_t READER_FIELD_OBJECT_IDS = 0x0010;
+constexpr uint32_t READER_FIELD_HASHES     = 0x0020;
+constexpr uint32_t READER_FIELD_DEFAULT    = READER_FIELD_NAMES | READER_FIELD_PATHS |
+                                             READER_FIELD_SI_TIMES | READER_FIELD_FN_TIMES;
+constexpr uint32_t READER_FIELD_ALL        = 0x003F;
+
+struct MftReaderOptions {
+    // Either a file path or a caller-owned buffer that outlives the reader
+    std::string inputFile;
+    const uint8_t* buffer = nullptr;
+    size_t bufferSize = 0;
+
+    size_t recordSize = MFT_RECORD_SIZE;
+    size_t batchSize = 1024;
+    unsigned threads = 1;
+    uint32_t fields = READER_FIELD_DEFAULT;
+    int debug = 0;
+    // Copy each accepted record's raw bytes into RecordBatch::rawRecords
+    bool keepRawRecords = false;
+    // Decode records completely on the parsing threads (MftRecord::decodeAll)
+    // so that several threads can read each batch
+    bool sharedRecords = false;
+    // SHA-256 the input as it is read, for getInputSha256()
+    bool hashInput = false;
+
+    // Records for which this returns false are dropped from the batch
+    std::function<bool(const MftRecord&)> filter;
+    // Compiled --where expression, checked while each record is parsed
+    std::shared_ptr<const RecordFilter> where;
+    // Attributes to decode eagerly; null decodes every attribute. The --where
+    // expression and MftRecord's accessors decode what they read regardless.
+    std::shared_ptr<const ParsePlan> plan;
+
+    std::shared_ptr<CancellationToken> cancellation;
+    std::shared_ptr<IoThrottle> ioThrottle;
+};
+
+struct RecordBatch {
+    std::vector<std::unique_ptr<MftRecord>> records;
+    // Position of the batch's first raw record in the input
+    uint64_t firstRecordIndex = 0;
+    // recordSize bytes per entry of records, when keepRawRecords is set
+    std::vector<uint8_t> rawRecords;
+
+    size_t size() const { return records.size(); }
+    bool empty() const { return records.empty(); }
+};
+
+// Reads and parses an MFT without producing any output. Paths are resolved
+// from an index built on open, so every batch carries complete filepaths.
+// An .amft snapshot given as inputFile is read from its columns instead of
+// being parsed again.
+//
+//     MftReader reader;
+//     for (auto& batch : reader.batches(options)) { ... }
+class MftReader {
+public:
+    class BatchIterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = RecordBatch;
+        using difference_type = std::ptrdiff_t;
+        using pointer = RecordBatch*;
+        using reference = RecordBatch&;
+
+        BatchIterator() : reader(nullptr) {}
+        explicit BatchIterator(MftReader* reader);
+
+        RecordBatch& operator*() const { return reader->currentBatch; }
+        RecordBatch* operator->() const { return &reader->currentBatch; }
+        BatchIterator& operator++();
+
+        bool operator==(const BatchIterator& other) const { return reader == other.reader; }
+        bool operator!=(const BatchIterator& other) const { return reader != other.reader; }
+
+    private:
+        MftReader* reader;
+    };
+
+    class BatchRange {
+    public:
+        explicit BatchRange(MftReader* reader) : reader(reader) {}
+        BatchIterator begin() const { return reader ? BatchIterator(reader) : BatchIterator(); }
+        BatchIterator end() const { return BatchIterator(); }
+
+    private:
+        MftReader* reader;
+    };
+
+    MftReader();
+
+    // Opens the source and returns the batches; an empty range on failure,
+    // with getLastError() describing why.
+    BatchRange batches(const MftReaderOptions& options);
+
+    bool open(const MftReaderOptions& options);
+    bool nextBatch(RecordBatch& batch);
+    void close();
+    void setBatchSize(size_t size) { options.batchSize = size > 0 ? size : 1024; }
+
+    const MftReaderOptions& getOptions() const { return options; }
+    const PathResolver& getPaths() const { return paths; }
+    const std::string& getLastError() const { return lastError; }
+    bool isSnapshot() const { return snapshotRow != SNAPSHOT_NONE; }
+    uint64_t getRecordsRead() const { return recordsRead; }
+    uint64_t getParseErrors() const { return parseErrors; }
+    bool isCancelled() const { return options.cancellation && options.cancellation->isCancelled(); }
+    // With hashInput, the SHA-256 of every input byte once the input has
+    // been read to the end; empty until then, and for snapshots
+    std::string getInputSha256() const { return inputHashed ? inputHash.hexDigest() : std::string(); }
+    uint64_t getInputSize() const { return inputHash.size(); }
+
+private:
+    MftReaderOptions options;
+    std::ifstream file;
+    size_t bufferOffset;
+    bool opened;
+
+    PathResolver paths;
+    // options.plan, or the attributes-only plan of the path prepass
+    ParsePlan parsePlan;
+    std::vector<uint8_t> chunk;
+    RecordBatch currentBatch;
+    // options.threads - 1 parsing threads; the reading thread is the last one
+    std::unique_ptr<WorkerPool> workers;
+
+    static constexpr uint64_t SNAPSHOT_NONE = UINT64_MAX;
+    Snapshot snapshot;
+    uint64_t snapshotRow;
+
+    uint64_t recordsRead;
+    uint64_t parseErrors;
+    std::string lastError;
+
+    // Input offset of the next read; the hash covers [0, inputHash.size())
+    uint64_t readOffset;
+    Sha256Stream inputHash;
+    bool inputHashed;
+
+    size_t readChunk(size_t maxRecords);
+    void hashRead(const uint8_t* data, uint64_t offset, size_t size, bool atEnd);
+    void rewind();
+    void parseChunk(size_t count, std::vector<std::unique_ptr<MftRecord>>& parsed);
+    void parseRange(size_t first, size_t last, std::vector<std::unique_ptr<MftRecord>>& parsed) const;
+    bool indexPaths();
+    bool nextSnapshotBatch(RecordBatch& batch);
+    bool needsPathFilter() const { return options.where && options.where->uses(FILTER_FIELD_PATH); }
+};
+
+#endif
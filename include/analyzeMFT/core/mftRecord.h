@@ -2,6 +2,7 @@
 #ifndef ANALYZEMFT_MFTRECORD_H
 #define ANALYZEMFT_MFTRECORD_H
 
+#include <array>
 #include <vector>
 #include <string>
 #include <unordered_set>
@@ -10,6 +11,9 @@
 #include "winTime.h"
 #include "constants.h"
 
+class RecordFilter;
+class ParsePlan;
+
 // Forward declarations - moved from individual files
 struct AttributeListEntry {
     uint32_t type;
@@ -90,14 +94,88 @@ struct LoggedUtilityStream {
     bool valid;
 };
 
+// One attribute header, recorded by the constructor's walk over the record
+struct AttributeEntry {
+    uint32_t type;
+    uint32_t length;
+    uint16_t offset;
+    uint16_t nameOffset;    // relative to the attribute
+    uint8_t nameLength;     // in UTF-16 code units
+    bool nonResident;
+};
+
+struct StandardInformation {
+    WindowsTime crtime;
+    WindowsTime mtime;
+    WindowsTime atime;
+    WindowsTime ctime;
+    uint32_t fileAttributes = 0;
+    // NTFS 3.0+ fields, valid when `extended` is set
+    uint32_t ownerId = 0;
+    uint32_t securityId = 0;
+    uint64_t usn = 0;
+    bool extended = false;
+    bool present = false;
+};
+
+struct FileNameInfo {
+    uint64_t parentRef = 0;
+    WindowsTime crtime;
+    WindowsTime mtime;
+    WindowsTime atime;
+    WindowsTime ctime;
+    uint64_t allocatedSize = 0;
+    uint64_t realSize = 0;
+    uint32_t fileAttributes = 0;
+    uint8_t nameSpace = 0;
+    std::string name;
+    
+    uint64_t parentRecordNumber() const { return parentRef & 0x0000FFFFFFFFFFFF; }
+};
+
+struct DataStream {
+    std::string name;       // empty for the unnamed stream
+    bool nonResident = false;
+    uint64_t size = 0;
+    uint64_t allocatedSize = 0;
+};
+
 class MftRecord {
 public:
-    MftRecord(const std::vector<uint8_t>& rawRecord, bool computeHashes = false, int debugLevel = 0);
+    // An empty record whose fields are filled in by the caller
+    MftRecord();
+    // With a filter, parsing stops as soon as the fields decoded so far rule
+    // the record out; isRejected() then reports true. With a plan, only the
+    // attributes it names are decoded.
+    MftRecord(const std::vector<uint8_t>& rawRecord, bool computeHashes = false, int debugLevel = 0,
+              const RecordFilter* filter = nullptr, const ParsePlan* plan = nullptr);
     
     std::vector<std::string> toCsv() const;
+    std::vector<std::string> toCsv(const std::vector<size_t>& columns) const;
+    // Value of one CsvColumn as the text formats write it
+    std::string getColumn(size_t column) const;
     void computeHashes();
     std::string getFileType() const;
     uint64_t getParentRecordNum() const;
+    bool isRejected() const { return rejected; }
+    
+    // Attribute headers in record order, up to MAX_INLINE_ATTRIBUTES
+    static constexpr size_t MAX_INLINE_ATTRIBUTES = 32;
+    size_t getAttributeCount() const { return attributeEntries; }
+    const AttributeEntry& getAttribute(size_t index) const { return attributeTable[index]; }
+    
+    // Decoded from the attribute table on first use and cached, independent of
+    // the parse plan. Records not parsed from raw bytes (e.g. loaded from a
+    // snapshot) report the flat fields below instead.
+    const StandardInformation& standardInformation() const;
+    const std::vector<FileNameInfo>& fileNames() const;
+    const std::vector<DataStream>& dataStreams() const;
+    // The $FILE_NAME the flat fields report: the last one in the record
+    const FileNameInfo* fileName() const;
+    // Fills every cache the const accessors fill on first use, including the
+    // formatted timestamps, so the record can then be read from several
+    // threads at once
+    void decodeAll() const;
     
     uint32_t magic;
     uint16_t updOff;
@@ -113,6 +191,7 @@ public:
     uint16_t nextAttrid;
     uint32_t recordnum;
     std::string filename;
+    std::string filepath;
     
     struct {
         WindowsTime crtime;
@@ -158,14 +237,38 @@ private:
     std::vector<uint8_t> rawRecord;
     int debugLevel;
     bool computeHashesFlag;
+    const RecordFilter* filter;
+    const ParsePlan* plan;
+    bool rejected;
+    
+    std::array<AttributeEntry, MAX_INLINE_ATTRIBUTES> attributeTable;
+    uint8_t attributeEntries;
+    size_t attributeOverflow;      // first attribute past the table, 0 if none
+    bool attributesIndexed;
+    
+    static constexpr uint8_t DECODED_STANDARD_INFORMATION = 0x01;
+    static constexpr uint8_t DECODED_FILE_NAMES = 0x02;
+    static constexpr uint8_t DECODED_DATA_STREAMS = 0x04;
+    mutable uint8_t decoded;
+    mutable StandardInformation standardInformationCache;
+    mutable std::vector<FileNameInfo> fileNameCache;
+    mutable std::vector<DataStream> dataStreamCache;
+    
+    static constexpr uint32_t MAX_ATTRIBUTES = 100; // Safety limit
     
+    bool passesFilter(uint32_t knownFields) const;
+    bool readAttributeHeader(size_t offset, uint32_t& attrType, uint32_t& attrLen) const;
+    void buildAttributeTable();
+    bool residentContent(const AttributeEntry& entry, size_t minimumLength, size_t& contentOffset) const;
+    bool decodeStandardInformation(const AttributeEntry& entry, StandardInformation& info) const;
+    bool decodeFileName(const AttributeEntry& entry, FileNameInfo& info) const;
+    DataStream decodeDataStream(const AttributeEntry& entry) const;
     bool applyFixupArray();
     bool validateFixupArray() const;
     void log(const std::string& message, int level) const;
     void parseRecord();
     void parseAttributes();
-    void parseSiAttribute(size_t offset);
-    void parseFnAttribute(size_t offset);
+    void decodeAttribute(uint32_t attrType, size_t offset);
     void parseObjectIdAttribute(size_t offset);
     void parseAttributeList(size_t offset);
     void parseSecurityDescriptor(size_t offset);
@@ -0,0 +1,52 @@
+#ifndef ANALYZEMFT_PARSEPLAN_H
+#define ANALYZEMFT_PARSEPLAN_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "constants.h"
+
+// Bit of an attribute type in ParsePlan's attribute mask; types are multiples of 0x10
+constexpr uint32_t attributeBit(uint32_t type) { return type < 0x200 ? 1u << (type >> 4) : 0; }
+constexpr uint32_t PARSE_ALL_ATTRIBUTES = 0xFFFFFFFF;
+
+// The output columns selected with --fields and the work needed to fill
+// them: which attributes MftRecord decodes, and whether paths and hashes are
+// computed. The default plan selects every column and parses everything.
+//
+//     ParsePlan plan;
+//     plan.selectColumns("record_number,filename,si_creation_time", error);
+//     // decodes $FILE_NAME and $STANDARD_INFORMATION only; no paths, no hashes
+class ParsePlan {
+public:
+    ParsePlan();
+
+    // Plan that decodes only the given attributes and outputs nothing, for prepasses
+    static ParsePlan attributesOnly(uint32_t attributes);
+
+    // Comma-separated CSV header names, their snake_case keys or the JSON
+    // names ("siCreationTime"), in output order
+    bool selectColumns(const std::string& list, std::string& error);
+
+    bool isProjected() const { return projected; }
+    const std::vector<size_t>& getColumns() const { return columns; }
+    bool selects(size_t column) const;
+
+    bool decodes(uint32_t attributeType) const { return (attributes & attributeBit(attributeType)) != 0; }
+    uint32_t getAttributes() const { return attributes; }
+    bool needsPaths() const { return paths; }
+    bool needsHashes() const { return hashes; }
+
+    // "SI Creation Time" -> "si_creation_time"
+    static const std::string& columnKey(size_t column);
+
+private:
+    std::vector<size_t> columns;
+    uint64_t columnMask;
+    uint32_t attributes;
+    bool paths;
+    bool hashes;
+    bool projected;
+};
+
+#endif
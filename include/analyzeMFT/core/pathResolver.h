@@ -0,0 +1,38 @@
+#ifndef ANALYZEMFT_PATHRESOLVER_H
+#define ANALYZEMFT_PATHRESOLVER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class MftRecord;
+
+// Directory index of (parent, name) per record number used to rebuild full
+// paths independently of the order in which records are parsed or written.
+class PathResolver {
+public:
+    PathResolver();
+
+    void addRecord(uint32_t recordNumber, uint64_t parentRecordNumber, const std::string& name);
+    void addRecord(const MftRecord& record);
+    bool contains(uint32_t recordNumber) const;
+    size_t size() const { return recordCount; }
+    void clear();
+
+    std::string resolve(uint32_t recordNumber) const;
+
+private:
+    struct Entry {
+        uint64_t parent = 0;
+        std::string name;
+        bool present = false;
+    };
+
+    std::vector<Entry> entries;
+    size_t recordCount;
+
+    static constexpr uint32_t ROOT_RECORD_NUMBER = 5;
+    static constexpr int MAX_PATH_DEPTH = 255;
+};
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef ANALYZEMFT_QUERYINDEX_H
+#define ANALYZEMFT_QUERYINDEX_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "snapshot.h"
+#include "../utils/mappedFile.h"
+
+// Secondary indexes over an .amft snapshot, persisted as <snapshot>.idx:
+//   - trigram posting lists over lower-cased filenames and filepaths
+//   - row permutations sorted by each of the 8 SI/FN timestamps
+//   - a row permutation sorted by file size
+// Posting lists hold snapshot row numbers in ascending order.
+
+constexpr char QUERY_INDEX_MAGIC[8] = {'A', 'M', 'F', 'T', 'I', 'D', 'X', '\0'};
+constexpr uint32_t QUERY_INDEX_VERSION = 1;
+
+enum QueryIndexSectionId : uint32_t {
+    QUERY_SECTION_NAME_KEYS = 1,
+    QUERY_SECTION_NAME_OFFSETS,
+    QUERY_SECTION_NAME_POSTINGS,
+    QUERY_SECTION_PATH_KEYS,
+    QUERY_SECTION_PATH_OFFSETS,
+    QUERY_SECTION_PATH_POSTINGS,
+    QUERY_SECTION_TIME_ORDER,           // SNAPSHOT_TIME_COUNT permutations of recordCount rows
+    QUERY_SECTION_SIZE_ORDER
+};
+
+struct QueryIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t sectionCount;
+    uint64_t recordCount;
+    uint64_t snapshotCreated;           // must match the snapshot's createdTime
+    uint64_t directoryOffset;
+};
+
+// Inclusive range; FILETIMEs for time filters, bytes for the size filter
+struct QueryRange {
+    uint64_t min = 0;
+    uint64_t max = UINT64_MAX;
+};
+
+struct TimeFilter {
+    int field = SNAPSHOT_TIME_SI_CREATION;
+    QueryRange range;
+};
+
+struct MftQuery {
+    std::string nameContains;           // case-insensitive substrings
+    std::string pathContains;
+    std::vector<TimeFilter> times;
+    bool filterSize = false;
+    QueryRange size;
+    size_t limit = 0;                   // 0 returns every match
+
+    // "si-created=2023-01-01..2023-02-01"; either bound may be omitted
+    static bool parseTimeFilter(const std::string& spec, TimeFilter& filter);
+    // "1M..", "..4096", "10K..2G"
+    static bool parseSizeRange(const std::string& spec, QueryRange& range);
+};
+
+class QueryIndex {
+public:
+    QueryIndex();
+
+    static std::string indexPathFor(const std::string& snapshotPath) { return snapshotPath + ".idx"; }
+
+    static bool build(const Snapshot& snapshot, const std::string& path, std::string& error);
+    bool open(const std::string& path, const Snapshot& snapshot);
+    void close();
+
+    // Snapshot rows matching every predicate of the query, ascending
+    std::vector<uint32_t> search(const MftQuery& query) const;
+
+    const std::string& getLastError() const { return lastError; }
+
+private:
+    struct TrigramIndex {
+        const uint32_t* keys = nullptr;
+        const uint64_t* offsets = nullptr;
+        const uint32_t* postings = nullptr;
+        uint64_t keyCount = 0;
+        uint64_t postingCount = 0;
+    };
+
+    struct Span {
+        const uint32_t* rows;
+        size_t count;
+    };
+
+    MappedFile file;
+    const Snapshot* snapshot;
+    const QueryIndexHeader* header;
+    TrigramIndex names;
+    TrigramIndex paths;
+    const uint32_t* timeOrders;
+    const uint32_t* sizeOrder;
+    std::string lastError;
+
+    const uint8_t* findSection(uint32_t id, uint64_t elementSize, uint64_t& count);
+    bool lookupTrigrams(const TrigramIndex& index, const std::string& needle, std::vector<Span>& spans) const;
+    Span timeSpan(const TimeFilter& filter) const;
+    Span sizeSpan(const QueryRange& range) const;
+    bool matches(const MftQuery& query, uint32_t row) const;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef ANALYZEMFT_RECORDFILTER_H
+#define ANALYZEMFT_RECORDFILTER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class MftRecord;
+
+// Groups of record fields, in the order the parser makes them available.
+constexpr uint32_t FILTER_FIELD_HEADER     = 0x01;   // record number, sequence, links, flags
+constexpr uint32_t FILTER_FIELD_ATTRIBUTES = 0x02;   // attribute presence
+constexpr uint32_t FILTER_FIELD_NAME       = 0x04;   // $FILE_NAME: name, extension, parent, size, FN times
+constexpr uint32_t FILTER_FIELD_SI_TIMES   = 0x08;   // $STANDARD_INFORMATION times
+constexpr uint32_t FILTER_FIELD_PATH       = 0x10;
+constexpr uint32_t FILTER_FIELDS_PARSED    = 0x0F;   // everything MftRecord decodes itself
+constexpr uint32_t FILTER_FIELDS_ALL       = 0x1F;
+
+// A --where expression compiled to a postfix predicate program, e.g.
+//
+//     inuse and not dir and ext in (ps1, exe, dll)
+//       and si.created >= 2024-03-01 and path startswith '\Windows\'
+//
+// The program can be evaluated while a record is only partly parsed: tests
+// on fields that are not known yet yield Unknown, and and/or/not follow
+// three-valued logic, so False means the record can be dropped immediately.
+class RecordFilter {
+public:
+    enum class Result : uint8_t { False, True, Unknown };
+
+    RecordFilter();
+
+    bool compile(const std::string& expression);
+    const std::string& getLastError() const { return lastError; }
+    const std::string& getExpression() const { return expression; }
+
+    Result evaluate(const MftRecord& record, uint32_t knownFields) const;
+    bool accepts(const MftRecord& record) const { return evaluate(record, FILTER_FIELDS_ALL) == Result::True; }
+
+    // Union of the field groups the expression reads
+    uint32_t getFields() const { return fields; }
+    bool uses(uint32_t group) const { return (fields & group) != 0; }
+
+private:
+    enum class Field : uint8_t {
+        RecordNumber, Sequence, LinkCount, Flags, InUse, Deleted, Directory, File,
+        Name, Extension, Parent, Size,
+        SiCreated, SiModified, SiAccessed, SiChanged,
+        FnCreated, FnModified, FnAccessed, FnChanged,
+        Path, HasAttribute
+    };
+
+    enum class Op : uint8_t {
+        Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual,
+        Contains, StartsWith, EndsWith, In, IsTrue
+    };
+
+    struct Test {
+        Field field;
+        Op op;
+        uint32_t group;
+        uint64_t first = 0;                 // numbers, FILETIMEs, attribute types;
+        uint64_t last = 0;                  // dates cover [first, last]
+        std::string text;                   // lower-cased
+        std::vector<std::string> strings;
+        std::vector<uint64_t> numbers;
+    };
+
+    struct Instruction {
+        enum Kind : uint8_t { Push, And, Or, Not } kind;
+        uint32_t test;
+    };
+
+    struct Token {
+        enum Kind { End, Word, String, LParen, RParen, Comma, Operator } kind;
+        std::string text;
+    };
+
+    static constexpr size_t MAX_STACK = 64;
+
+    std::string expression;
+    std::vector<Test> tests;
+    std::vector<Instruction> program;
+    uint32_t fields;
+    std::string lastError;
+
+    // Parser state, only used by compile()
+    std::vector<Token> tokens;
+    size_t position;
+
+    bool tokenize(const std::string& text);
+    const Token& peek() const { return tokens[position]; }
+    bool acceptKeyword(const char* keyword);
+    // depth counts the parentheses and nots around the current term
+    bool parseOr(size_t depth);
+    bool parseAnd(size_t depth);
+    bool parseUnary(size_t depth);
+    bool parsePrimary(size_t depth);
+    bool parseValue(Field field, const std::string& text, Test& test);
+    bool fail(const std::string& message);
+
+    Result evaluateTest(const Test& test, const MftRecord& record) const;
+};
+
+#endif
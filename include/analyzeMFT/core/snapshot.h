@@ -0,0 +1,225 @@
+#ifndef ANALYZEMFT_SNAPSHOT_H
+#define ANALYZEMFT_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <cstdint>
+#include "mftRecord.h"
+#include "../utils/mappedFile.h"
+
+// .amft snapshot: one parse of an MFT stored as memory-mappable columns.
+//
+// Layout (all integers little-endian, every section 64-byte aligned):
+//   SnapshotHeader | raw records | fixed-width columns | string heap |
+//   string offsets | sort permutations | source path | section directory
+//
+// The header points at the section directory, which lists every section by
+// id, so readers can skip sections they do not know and new ones can be
+// added without bumping the version.
+
+constexpr char SNAPSHOT_MAGIC[8] = {'A', 'M', 'F', 'T', 'S', 'N', 'A', 'P'};
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+constexpr uint32_t SNAPSHOT_FLAG_HASHES = 0x0001;
+
+enum SnapshotSectionId : uint32_t {
+    SNAPSHOT_SECTION_RAW_RECORDS = 1,
+    SNAPSHOT_SECTION_RAW_OFFSETS,
+    SNAPSHOT_SECTION_RECORD_NUMBER,
+    SNAPSHOT_SECTION_SEQUENCE,
+    SNAPSHOT_SECTION_FLAGS,
+    SNAPSHOT_SECTION_LINK_COUNT,
+    SNAPSHOT_SECTION_MAGIC,
+    SNAPSHOT_SECTION_LSN,
+    SNAPSHOT_SECTION_BASE_REFERENCE,
+    SNAPSHOT_SECTION_PARENT_REFERENCE,
+    SNAPSHOT_SECTION_FILE_SIZE,
+    SNAPSHOT_SECTION_ATTRIBUTE_MASK,
+    SNAPSHOT_SECTION_DETAIL_MASK,
+    SNAPSHOT_SECTION_TIMES,             // 8 FILETIMEs per record, see SnapshotTime
+    SNAPSHOT_SECTION_STRING_HEAP,
+    SNAPSHOT_SECTION_STRING_OFFSETS,    // (records + 1) offsets per SnapshotString column
+    SNAPSHOT_SECTION_ORDER_SI_CREATION,
+    SNAPSHOT_SECTION_ORDER_SI_MODIFICATION,
+    SNAPSHOT_SECTION_ORDER_PATH,
+    SNAPSHOT_SECTION_SOURCE_PATH
+};
+
+enum SnapshotTime {
+    SNAPSHOT_TIME_SI_CREATION = 0,
+    SNAPSHOT_TIME_SI_MODIFICATION,
+    SNAPSHOT_TIME_SI_ACCESS,
+    SNAPSHOT_TIME_SI_ENTRY,
+    SNAPSHOT_TIME_FN_CREATION,
+    SNAPSHOT_TIME_FN_MODIFICATION,
+    SNAPSHOT_TIME_FN_ACCESS,
+    SNAPSHOT_TIME_FN_ENTRY,
+    SNAPSHOT_TIME_COUNT
+};
+
+enum SnapshotString {
+    SNAPSHOT_STRING_FILENAME = 0,
+    SNAPSHOT_STRING_FILEPATH,
+    SNAPSHOT_STRING_VOLUME_NAME,
+    SNAPSHOT_STRING_OBJECT_ID,
+    SNAPSHOT_STRING_BIRTH_VOLUME_ID,
+    SNAPSHOT_STRING_BIRTH_OBJECT_ID,
+    SNAPSHOT_STRING_BIRTH_DOMAIN_ID,
+    SNAPSHOT_STRING_MD5,
+    SNAPSHOT_STRING_SHA256,
+    SNAPSHOT_STRING_SHA512,
+    SNAPSHOT_STRING_CRC32,
+    SNAPSHOT_STRING_COUNT
+};
+
+enum class SnapshotOrder { SiCreation, SiModification, Path };
+
+struct SnapshotStatistics {
+    uint64_t activeRecords;
+    uint64_t directories;
+    uint64_t files;
+    uint64_t totalFileSize;
+    uint64_t minSiCreation;
+    uint64_t maxSiCreation;
+    uint64_t minSiModification;
+    uint64_t maxSiModification;
+    uint64_t createdTime;      // FILETIME of snapshot creation
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t recordCount;
+    uint32_t recordSize;
+    uint32_t flags;
+    uint64_t directoryOffset;
+    uint32_t sectionCount;
+    uint32_t reserved;
+    SnapshotStatistics stats;
+};
+
+struct SnapshotSectionEntry {
+    uint32_t id;
+    uint32_t elementSize;
+    uint64_t offset;
+    uint64_t length;
+};
+
+// Builds a snapshot in one pass. Raw records are streamed to disk as they
+// arrive; the columns are kept in memory until close().
+class SnapshotWriter {
+public:
+    SnapshotWriter();
+    ~SnapshotWriter();
+
+    bool open(const std::string& path, size_t recordSize, const std::string& sourcePath);
+    bool append(const MftRecord& record, const uint8_t* rawRecord);
+    bool close();
+
+    const std::string& getLastError() const { return lastError; }
+
+private:
+    std::ofstream file;
+    uint64_t fileOffset;
+    size_t recordSize;
+    std::string sourcePath;
+    std::string lastError;
+
+    SnapshotHeader header;
+    std::vector<SnapshotSectionEntry> sections;
+    uint64_t rawSectionOffset;
+
+    std::vector<uint64_t> rawOffsets;
+    std::vector<uint32_t> recordNumbers;
+    std::vector<uint16_t> sequences;
+    std::vector<uint16_t> flags;
+    std::vector<uint16_t> linkCounts;
+    std::vector<uint32_t> magics;
+    std::vector<uint64_t> lsns;
+    std::vector<uint64_t> baseReferences;
+    std::vector<uint64_t> parentReferences;
+    std::vector<uint64_t> fileSizes;
+    std::vector<uint32_t> attributeMasks;
+    std::vector<uint16_t> detailMasks;
+    std::vector<uint64_t> times;
+    // One heap per string column, concatenated on close()
+    std::vector<char> stringHeaps[SNAPSHOT_STRING_COUNT];
+    std::vector<uint64_t> stringOffsets[SNAPSHOT_STRING_COUNT];
+
+    bool writeBytes(const void* data, size_t length);
+    bool align();
+    bool writeSection(uint32_t id, uint32_t elementSize, const void* data, size_t length);
+    template<typename T>
+    bool writeColumn(uint32_t id, const std::vector<T>& values) {
+        return writeSection(id, sizeof(T), values.data(), values.size() * sizeof(T));
+    }
+    bool writeStringHeap(uint64_t length);
+    std::vector<uint32_t> sortByTime(int time) const;
+    std::vector<uint32_t> sortByPath() const;
+};
+
+// Read-only view of a snapshot file. Opening maps the file and validates the
+// section directory; nothing is decoded until a column is accessed.
+class Snapshot {
+public:
+    Snapshot();
+
+    static bool isSnapshotFile(const std::string& path);
+
+    bool open(const std::string& path);
+    void close();
+
+    uint64_t size() const { return header ? header->recordCount : 0; }
+    size_t getRecordSize() const { return header ? header->recordSize : 0; }
+    bool hasHashes() const { return header && (header->flags & SNAPSHOT_FLAG_HASHES); }
+    const SnapshotStatistics& getStatistics() const { return header->stats; }
+    std::string getSourcePath() const;
+    const std::string& getLastError() const { return lastError; }
+
+    uint32_t recordNumber(size_t row) const { return recordNumbers[row]; }
+    uint16_t flags(size_t row) const { return recordFlags[row]; }
+    uint64_t parentRecordNumber(size_t row) const { return parentReferences[row] & 0x0000FFFFFFFFFFFF; }
+    uint64_t fileSize(size_t row) const { return fileSizes[row]; }
+    uint64_t time(size_t row, int which) const { return times[row * SNAPSHOT_TIME_COUNT + which]; }
+    uint32_t attributeMask(size_t row) const { return attributeMasks[row]; }
+
+    std::string string(int column, size_t row) const;
+    const char* stringData(int column, size_t row, size_t& length) const;
+    const uint8_t* rawRecord(size_t row) const;
+    const uint32_t* order(SnapshotOrder sortOrder) const;
+
+    // Rebuilds a record from the columns without decoding the raw bytes
+    std::unique_ptr<MftRecord> loadRecord(size_t row, bool computeHashes = false) const;
+
+private:
+    MappedFile file;
+    const SnapshotHeader* header;
+    std::string lastError;
+
+    const uint8_t* rawRecords;
+    const uint64_t* rawOffsets;
+    const uint32_t* recordNumbers;
+    const uint16_t* sequences;
+    const uint16_t* recordFlags;
+    const uint16_t* linkCounts;
+    const uint32_t* magics;
+    const uint64_t* lsns;
+    const uint64_t* baseReferences;
+    const uint64_t* parentReferences;
+    const uint64_t* fileSizes;
+    const uint32_t* attributeMasks;
+    const uint16_t* detailMasks;
+    const uint64_t* times;
+    const char* stringHeap;
+    uint64_t stringHeapSize;
+    const uint64_t* stringOffsets;
+    const uint32_t* orders[3];
+    const char* sourcePath;
+    uint64_t sourcePathLength;
+
+    const uint8_t* findSection(uint32_t id, uint64_t expectedLength, uint64_t& actualLength);
+};
+
+#endif
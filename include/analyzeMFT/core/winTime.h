@@ -10,19 +10,26 @@ public:
     WindowsTime(uint32_t low, uint32_t high);
     WindowsTime();
     
-    std::string getDateTimeString() const;
+    // Parses "YYYY-MM-DD" or "YYYY-MM-DD[T ]HH:MM:SS[Z]" (UTC) into the first
+    // and last FILETIME tick of the day or second it names.
+    static bool parseTimestamp(const std::string& text, uint64_t& first, uint64_t& last);
+    
+    const std::string& getDateTimeString() const;
     std::time_t getUnixTime() const;
     bool isValid() const;
     
     uint32_t low;
     uint32_t high;
     std::time_t unixTime;
-    std::string dtstr;
     bool valid;
 
 private:
+    // Formatted on first use; most timestamps of a record are never printed
+    mutable std::string dtstr;
+    mutable bool formatted;
+    
     void calculateUnixTime();
-    void formatDateTime();
+    void formatDateTime() const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef ANALYZEMFT_EXTERNALSORTER_H
+#define ANALYZEMFT_EXTERNALSORTER_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+// Sorts lines of text by a 64-bit key in bounded memory. Lines are
+// buffered until memoryLimit is reached, radix-sorted on `threads` threads
+// and spilled to disk as a sorted run; finish() merges the runs into one
+// ordered stream. Nothing touches the disk when everything fits.
+//
+//     ExternalSorter sorter(memoryLimit, threads);
+//     sorter.setRunPrefix(outputFile);
+//     sorter.add(key, line.data(), line.size());     // repeatedly
+//     sorter.finish([&](const char* data, size_t size) { return sink.append(data, size); });
+//
+// The sort is stable: lines with equal keys come out in the order they
+// were added.
+class ExternalSorter {
+public:
+    static constexpr size_t DEFAULT_MEMORY_LIMIT = size_t(512) << 20;
+
+    // Receives the sorted lines in pieces of many lines each
+    using Output = std::function<bool(const char* data, size_t size)>;
+
+    explicit ExternalSorter(size_t memoryLimit = DEFAULT_MEMORY_LIMIT, unsigned threads = 1);
+    ~ExternalSorter();
+
+    ExternalSorter(const ExternalSorter&) = delete;
+    ExternalSorter& operator=(const ExternalSorter&) = delete;
+
+    // Runs are written to <prefix>.run<N>.tmp and deleted once merged
+    void setRunPrefix(const std::string& prefix) { runPrefix = prefix; }
+
+    bool add(uint64_t key, const char* data, size_t size);
+    bool finish(const Output& output);
+
+    size_t getRunCount() const { return runFiles.size(); }
+    const std::string& getLastError() const { return lastError; }
+
+private:
+    struct Item {
+        uint64_t key;
+        uint32_t offset;            // into text
+        uint32_t size;
+    };
+    struct Run;
+
+    size_t memoryLimit;
+    unsigned threads;
+    std::string runPrefix;
+    std::vector<Item> items;
+    std::vector<Item> scratch;
+    std::string text;
+    std::vector<std::string> runFiles;
+    std::string lastError;
+
+    size_t bufferedBytes() const;
+    void sortItems();
+    bool spill();
+    bool mergeRuns(const Output& output);
+    void removeRuns();
+    bool fail(const std::string& message);
+};
+
+#endif
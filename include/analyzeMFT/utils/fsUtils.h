@@ -20,6 +20,7 @@ public:
     static bool createDirectory(const std::string& path);
     static bool createDirectories(const std::string& path);
     static std::vector<std::string> listDirectory(const std::string& path);
+    static std::vector<std::string> globFiles(const std::string& pattern);
     static bool copyFile(const std::string& source, const std::string& destination);
     static bool moveFile(const std::string& source, const std::string& destination);
     static bool deleteFile(const std::string& path);
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include <cstdint>
 
 #ifdef CRC32_HARDWARE
@@ -18,6 +19,8 @@ public:
     std::string calculateSha256(const std::vector<uint8_t>& data);
     std::string calculateSha512(const std::vector<uint8_t>& data);
     std::string calculateCrc32(const std::vector<uint8_t>& data);
+    // SHA-256 of a file's contents, read in pieces; empty if it cannot be read
+    std::string calculateFileSha256(const std::string& path);
     
 private:
     std::string bytesToHex(const std::vector<uint8_t>& bytes);
@@ -27,4 +30,26 @@ private:
     static const uint32_t CRC32_TABLE[256];
 };
 
+// SHA-256 fed piece by piece, for data hashed as it streams past on its way
+// somewhere else; the digest matches calculateFileSha256 of the same bytes
+class Sha256Stream {
+public:
+    Sha256Stream();
+    ~Sha256Stream();
+
+    Sha256Stream(Sha256Stream&&) noexcept;
+    Sha256Stream& operator=(Sha256Stream&&) noexcept;
+
+    void reset();
+    void update(const void* data, size_t size);
+    // Uppercase hex of everything so far; more data may still follow
+    std::string hexDigest() const;
+    uint64_t size() const { return bytes; }
+
+private:
+    struct Context;
+    std::unique_ptr<Context> context;
+    uint64_t bytes;
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef ANALYZEMFT_MAPPEDFILE_H
+#define ANALYZEMFT_MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file. An empty file opens successfully
+// with data() == nullptr and size() == 0.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return opened; }
+    const uint8_t* data() const { return mapping; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* mapping;
+    size_t length;
+    bool opened;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef ANALYZEMFT_OUTPUTSINK_H
+#define ANALYZEMFT_OUTPUTSINK_H
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+class ShmRingWriter;
+class Sha256Stream;
+class CancellationToken;
+
+// --compress setting for the text output formats. Each sink buffer is
+// compressed on its own, as an independent zstd frame or gzip member, so
+// buffers compress in parallel and the concatenation is still one stream
+// to zstd -d, gunzip and friends.
+struct OutputCompression {
+    enum class Codec : uint8_t { None, Gzip, Zstd };
+
+    Codec codec = Codec::None;
+    int level = 0;              // 0 picks the codec's default
+    unsigned threads = 1;       // compression workers
+
+    // "zstd", "zstd:19", "gzip" or "gzip:9"
+    bool parse(const std::string& spec, std::string& error);
+    bool enabled() const { return codec != Codec::None; }
+    // "zst", "gz", or empty when uncompressed
+    const char* extension() const;
+};
+
+// --split-output: each output becomes numbered part files, a new one every
+// `records` records or once a part reaches about `bytes` bytes, plus a
+// <output>.manifest.json listing them
+struct OutputSplit {
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+
+    // "500000" for records, or a size such as "512M" or "2G"
+    bool parse(const std::string& spec, std::string& error);
+    bool enabled() const { return records > 0 || bytes > 0; }
+};
+
+// SHA-256 and size of the bytes an OutputSink wrote, after compression;
+// hashed on the writer thread, so recording them costs no second read
+struct OutputDigest {
+    std::string sha256;         // uppercase hex, empty if the output failed
+    uint64_t bytes = 0;
+};
+
+// Output file written by a dedicated thread. Serializers fill one of a few
+// multi-megabyte buffers while the previous ones are on their way to disk,
+// so formatting and writing overlap instead of alternating:
+//
+//     OutputSink sink;
+//     sink.open(path, estimatedSize);
+//     std::ostream out(&sink);
+//     out << ...;                   // or sink.append(data, size)
+//     if (!sink.close()) { ... sink.getLastError() ... }
+//
+// Full buffers are written with pwrite, or pwritev when several are queued,
+// or through io_uring when built with HAVE_LIBURING. A size estimate
+// preallocates the file; close() trims it to what was written. flush() on
+// the stream does not force a write: data is handed off as buffers fill
+// and at close(). With compression, buffers go through a pool of
+// compression threads first and are written in their original order.
+// A "shm:NAME" path publishes the blocks to a shared-memory ring for a
+// consumer on the same host instead (see shmRing.h).
+class OutputSink : public std::streambuf {
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 4 * 1024 * 1024;
+    static constexpr size_t DEFAULT_BUFFER_COUNT = 3;
+
+    explicit OutputSink(size_t bufferSize = DEFAULT_BUFFER_SIZE, size_t bufferCount = DEFAULT_BUFFER_COUNT);
+    ~OutputSink() override;
+
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+
+    // Takes effect at the next open()
+    void setCompression(const OutputCompression& compression) { this->compression = compression; }
+    // Hashes the output as it is written and fills *digest at close(); null
+    // turns hashing off. Takes effect at the next open()
+    void setDigest(OutputDigest* digest) { this->digest = digest; }
+    // Stops a "shm:" output waiting for its consumer once the token is
+    // cancelled. Takes effect at the next open()
+    void setCancellation(const CancellationToken* token) { cancellation = token; }
+
+    // Creates or truncates the file, or creates the ring for a "shm:NAME"
+    // path; expectedSize > 0 preallocates that much
+    bool open(const std::string& path, uint64_t expectedSize = 0);
+    bool append(const char* data, size_t size);
+    bool append(const std::string& text) { return append(text.data(), text.size()); }
+    // Writes what is buffered, waits for the worker threads and closes the file
+    bool close();
+
+    bool isOpen() const { return opened; }
+    bool hasFailed() const { return failed.load(); }
+    // Bytes passed in so far, before compression, including those still in
+    // the current buffer
+    uint64_t bytesWritten() const { return committed + static_cast<uint64_t>(pptr() - pbase()); }
+    const std::string& getLastError() const { return lastError; }
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize size) override;
+    int sync() override { return failed.load() ? -1 : 0; }
+
+private:
+    // A handed-off buffer; blocks are queued in file order
+    struct Block {
+        size_t buffer;
+        size_t size;
+        bool claimed;               // taken by a compression thread
+        bool done;                  // ready to be written
+    };
+
+    size_t bufferSize;
+    size_t bufferCount;
+    OutputCompression compression;
+    std::vector<std::vector<char>> buffers;
+    std::vector<std::vector<char>> compressed;  // output per buffer, when compressing
+    std::vector<size_t> compressedSize;
+    size_t current;
+    uint64_t committed;             // bytes handed off so far
+    uint64_t fileOffset;            // bytes written to the file; writer thread only
+
+    std::deque<size_t> freeBuffers;
+    std::deque<Block> blocks;
+    std::mutex mutex;
+    std::condition_variable blockQueued;
+    std::condition_variable blockDone;
+    std::condition_variable bufferFree;
+    std::thread writer;
+    std::vector<std::thread> compressors;
+    bool stopping;
+    std::atomic<bool> failed;
+    std::string lastError;
+    bool opened;
+
+#ifdef _WIN32
+    void* fileHandle;
+#else
+    int fd;
+#endif
+#ifdef HAVE_LIBURING
+    struct Ring;
+    std::unique_ptr<Ring> ring;     // null when the kernel refuses io_uring
+#endif
+    std::unique_ptr<ShmRingWriter> sharedRing;  // set instead of a file for "shm:" paths
+    OutputDigest* digest;
+    std::unique_ptr<Sha256Stream> hash;         // writer thread only
+    const CancellationToken* cancellation;
+
+    struct Compressor;
+
+    bool openFile(const std::string& path, uint64_t expectedSize);
+    void closeFile();
+    bool handOff();
+    void runWriter();
+    void runCompressor();
+    bool compressBuffer(size_t buffer, size_t size, Compressor& state);
+    bool writeBlocks(const std::vector<Block>& batch);
+    bool publishBlocks(const std::vector<Block>& batch);
+    const char* blockData(const Block& block) const;
+    size_t blockSize(const Block& block) const;
+    void fail(const std::string& message);
+};
+
+#endif
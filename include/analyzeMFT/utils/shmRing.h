@@ -0,0 +1,164 @@
+#ifndef ANALYZEMFT_SHMRING_H
+#define ANALYZEMFT_SHMRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+class CancellationToken;
+
+// Output to "shm:NAME": a single-producer, single-consumer ring buffer in
+// the POSIX shared memory object /NAME, so a process on the same host reads
+// the export straight from memory, with no file and no pipe in between.
+//
+// Layout: a 192-byte ShmRingHeader, then `capacity` bytes of data (a power
+// of two). The producer owns `head`, the consumer owns `tail`; both are byte
+// counts that only grow, and position p sits at data[p % capacity]. Data
+// between tail and head is a sequence of messages, each an 8-byte
+// ShmRingMessage header followed by its payload, padded to 8 bytes:
+//
+//   - The producer writes a message, then publishes it by storing the new
+//     head with release ordering. It never writes past tail + capacity, so
+//     a consumer that stops reading stops the producer: that is the
+//     backpressure, there is no other flow control.
+//   - The consumer loads head with acquire ordering, reads the messages
+//     before it and stores the new tail with release ordering once it is
+//     done with them; only then may the producer reuse the space.
+//   - A message never wraps around the end of the data. When the rest of
+//     the data area is too short, the producer writes a WRAP message there
+//     and continues at the start.
+//   - The concatenated DATA payloads are the output file's bytes. Without
+//     compression each message ends at a line break, so every CSV, JSONL,
+//     body and timeline message holds whole records; with it, each is one
+//     independent zstd frame or gzip member.
+//
+// The producer creates the object and sets `version` last. It finishes by
+// setting state to FINISHED and waits until the consumer has read
+// everything or detached, then removes the name. Neither side blocks in the
+// kernel: waits poll with a short backoff, and each side checks that the
+// other's process is still alive. A producer waiting for a consumer that
+// never attaches is only stopped by its cancellation token.
+//
+//     ShmRingReader ring;
+//     if (!ring.open("shm:mft", 10000)) { ... ring.getLastError() ... }
+//     std::string_view message;
+//     while (ring.next(message)) {
+//         index(message);           // valid until the next call
+//     }
+//     if (ring.hasFailed()) { ... }
+
+struct ShmRingHeader {
+    static constexpr char MAGIC[8] = {'A', 'M', 'F', 'T', 'R', 'I', 'N', 'G'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t FLAG_LINES = 1;           // messages end at line breaks
+    static constexpr uint32_t FLAG_COMPRESSED = 2;      // payloads are zstd frames or gzip members
+
+    enum State : uint32_t { OPEN = 0, FINISHED = 1, FAILED = 2 };
+
+    char magic[8];
+    std::atomic<uint32_t> version;              // 0 until the rest of the header is written
+    uint32_t flags;
+    uint64_t capacity;
+    int32_t producerPid;
+    uint8_t reserved[36];
+
+    alignas(64) std::atomic<uint64_t> head;     // bytes published
+    std::atomic<uint32_t> state;
+    alignas(64) std::atomic<uint64_t> tail;     // bytes released
+    std::atomic<int32_t> consumerPid;           // 0 before a consumer attaches, -1 after it detaches
+};
+
+struct ShmRingMessage {
+    static constexpr uint32_t DATA = 1;
+    static constexpr uint32_t WRAP = 2;         // skip to the start of the data area
+
+    uint32_t size;                              // payload bytes
+    uint32_t kind;
+};
+
+static_assert(sizeof(ShmRingHeader) == 192, "ring header layout is part of the protocol");
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "ring counters must be lock-free to share across processes");
+
+// The producer side, used by OutputSink
+class ShmRingWriter {
+public:
+    static constexpr uint64_t DEFAULT_CAPACITY = 64ull * 1024 * 1024;
+
+    ShmRingWriter();
+    ~ShmRingWriter();
+
+    ShmRingWriter(const ShmRingWriter&) = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+    // "shm:NAME" or "shm:/NAME"
+    static bool isRingPath(const std::string& path);
+
+    // Replaces any stale object of that name
+    bool create(const std::string& path, uint32_t flags, uint64_t capacity = DEFAULT_CAPACITY);
+    // Blocks while the ring is full
+    bool write(const char* data, size_t size);
+    // Publishes what is left, marks the end of the stream and waits for the
+    // consumer to read it
+    bool finish();
+    // Tells the consumer the output is incomplete
+    void abort();
+    // Once the token is cancelled, waiting for the consumer fails the
+    // output; null waits for as long as the consumer is alive
+    void setCancellation(const CancellationToken* token) { cancellation = token; }
+
+    const std::string& getLastError() const { return lastError; }
+
+private:
+    ShmRingHeader* header;
+    char* data;
+    uint64_t capacity;
+    size_t mappedSize;
+    std::string name;
+    std::string carry;                  // the unfinished line, with FLAG_LINES
+    std::string lastError;
+    const CancellationToken* cancellation;
+
+    bool publish(const char* first, size_t firstSize, const char* second, size_t secondSize);
+    bool reserve(uint64_t bytes, uint64_t& position);
+    bool consumerGone() const;
+    bool cancelled() const;
+    void release();
+};
+
+// The consumer side
+class ShmRingReader {
+public:
+    ShmRingReader();
+    ~ShmRingReader();
+
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    // Waits up to timeoutMs for the producer to create the ring
+    bool open(const std::string& path, unsigned timeoutMs = 0);
+    // The next message, valid until the next call; false at the end of the
+    // stream, or on failure when hasFailed() says so
+    bool next(std::string_view& message);
+    // Detaches; a producer that has not finished then fails its output
+    void close();
+
+    uint32_t getFlags() const { return header ? header->flags : 0; }
+    bool hasFailed() const { return failed; }
+    const std::string& getLastError() const { return lastError; }
+
+private:
+    ShmRingHeader* header;
+    const char* data;
+    uint64_t capacity;
+    size_t mappedSize;
+    uint64_t position;                  // our tail, published on the next call
+    bool failed;
+    std::string lastError;
+
+    bool fail(const std::string& message);
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef ANALYZEMFT_SNAPPY_H
+#define ANALYZEMFT_SNAPPY_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Snappy block-format compressor (no framing), as used for Parquet pages.
+// Only compression is needed by the writers, so no decoder is provided.
+class Snappy {
+public:
+    static std::vector<uint8_t> compress(const uint8_t* input, size_t length);
+    static std::vector<uint8_t> compress(const std::vector<uint8_t>& input) {
+        return compress(input.data(), input.size());
+    }
+
+private:
+    static void compressBlock(const uint8_t* input, size_t length, std::vector<uint8_t>& output);
+    static void emitLiteral(const uint8_t* literal, size_t length, std::vector<uint8_t>& output);
+    static void emitCopy(size_t offset, size_t length, std::vector<uint8_t>& output);
+};
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <codecvt>
 #include <locale>
 
@@ -19,10 +20,16 @@ public:
     static bool endsWith(const std::string& str, const std::string& suffix);
     static std::string replace(const std::string& str, const std::string& from, const std::string& to);
     static std::string escapeForCsv(const std::string& str);
+    // Appends str as the inside of a JSON string literal. Runs without
+    // quotes, backslashes or control characters are copied through whole.
+    static void appendJsonEscaped(std::string& out, const char* str, size_t size);
+    static void appendJsonEscaped(std::string& out, const std::string& str) { appendJsonEscaped(out, str.data(), str.size()); }
     static std::string sanitizeFilename(const std::string& filename);
+    // "4096", "10K", "2MB", "1g": binary multiples, case-insensitive
+    static bool parseByteSize(const std::string& str, uint64_t& bytes);
     
 private:
-    static std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+    static std::wstring_convert<std::codecvt_utf8<wchar_t>>& converter();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef ANALYZEMFT_WORKERPOOL_H
+#define ANALYZEMFT_WORKERPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <cstddef>
+
+// Threads started once and reused for every run(), so work handed out per
+// batch does not pay for creating and joining threads each time. The caller
+// of run() works on its own tasks too, so a pool of N threads runs N + 1
+// tasks at once.
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned threads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(threads.size()); }
+
+    // Calls task(i) for every i below count and returns once all are done.
+    // Several threads may call run() at once.
+    void run(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    struct Job {
+        const std::function<void(size_t)>* task;
+        size_t count;
+        std::atomic<size_t> next{0};
+        size_t finished = 0;    // guarded by mutex
+    };
+
+    std::vector<std::thread> threads;
+    std::deque<std::shared_ptr<Job>> jobs;
+    std::mutex mutex;
+    std::condition_variable jobAdded;
+    std::condition_variable jobFinished;
+    bool stopping;
+
+    void workerLoop();
+    void work(Job& job);
+};
+
+#endif
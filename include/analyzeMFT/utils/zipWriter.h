@@ -0,0 +1,76 @@
+#ifndef ANALYZEMFT_ZIPWRITER_H
+#define ANALYZEMFT_ZIPWRITER_H
+
+#include "outputSink.h"
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Streaming ZIP archive writer. Entries are written front to back with a
+// data descriptor after each one, so nothing is seeked, buffered or known
+// in advance:
+//
+//     ZipWriter zip;
+//     zip.open(path);
+//     zip.beginEntry("a.xml");
+//     zip.write(text);              // or writeCompressed() pieces
+//     zip.endEntry();
+//     if (!zip.close()) { ... zip.getLastError() ... }
+//
+// Entry data is raw deflate when built with HAVE_ZLIB, stored otherwise.
+// Each write() is compressed on its own and ends on a byte boundary, so
+// pieces compressed on other threads by compress() can be appended in any
+// size and the concatenation is one deflate stream. Archive offsets past
+// 4 GiB switch the central directory to ZIP64. An entry that may itself
+// pass 4 GiB is begun as `large`: its local header carries a ZIP64 extra
+// field and its data descriptor 64-bit sizes, whatever size it ends up.
+class ZipWriter {
+public:
+    ZipWriter();
+
+    ZipWriter(const ZipWriter&) = delete;
+    ZipWriter& operator=(const ZipWriter&) = delete;
+
+    bool open(const std::string& path);
+    bool beginEntry(const std::string& name, bool large = false);
+    bool write(const char* data, size_t size);
+    bool write(const std::string& text) { return write(text.data(), text.size()); }
+    // Appends a piece made by compress(): `rawSize` input bytes with CRC-32 `crc`
+    bool writeCompressed(const char* data, size_t size, uint32_t crc, uint64_t rawSize);
+    bool endEntry();
+    // Writes the central directory and closes the file
+    bool close();
+
+    const std::string& getLastError() const { return lastError; }
+    // Hashes the archive as it is written; see OutputSink::setDigest
+    void setDigest(OutputDigest* digest) { sink.setDigest(digest); }
+
+    // Compresses `size` bytes into out, ready for writeCompressed(), and
+    // returns their CRC-32. Safe to call from any thread.
+    static uint32_t compress(const char* data, size_t size, std::string& out);
+
+private:
+    struct Entry {
+        std::string name;
+        uint16_t method;
+        bool zip64;                 // written with ZIP64 sizes
+        uint32_t crc;
+        uint64_t compressedSize;
+        uint64_t size;
+        uint64_t offset;            // of the local header
+    };
+
+    OutputSink sink;
+    std::vector<Entry> entries;
+    bool inEntry;
+    uint64_t offset;                // bytes written so far
+    std::string piece;
+    std::string lastError;
+
+    bool append(const std::string& bytes);
+    bool writeCentralDirectory();
+    bool fail(const std::string& message);
+};
+
+#endif
@@ -3,18 +3,30 @@
 
 #include "fileWriter.h"
 
+// mactime body file: one line per $STANDARD_INFORMATION and one per
+// $FILE_NAME, the latter marked "($FILE_NAME)" as fls does, each with its
+// own access, modification, change and birth times. mactime sorts the
+// lines and derives the MACB flags.
+//
+// The lines already carry one attribute's four times each, so only
+// MacbCollapse::All changes the output: the $FILE_NAME line is left out
+// when its times are the same as the $STANDARD_INFORMATION ones.
 class BodyWriter : public FileWriter {
 public:
     BodyWriter();
     
     bool write(const std::vector<const MftRecord*>& records, const std::string& outputFile) override;
+    void setCollapse(MacbCollapse mode) { collapse = mode; }
 
 protected:
     bool writeRecord(std::ostream& stream, const MftRecord* record) override;
 
 private:
-    std::string formatBodyEntry(const MftRecord* record, const WindowsTime& time, char macb) const;
-    void writeTimeEntry(std::ostream& stream, const MftRecord* record, const WindowsTime& time, char macb);
+    MacbCollapse collapse = MacbCollapse::None;
+    
+    std::string formatBodyEntry(const MftRecord* record, const std::string& name, uint64_t size,
+                                const WindowsTime& atime, const WindowsTime& mtime,
+                                const WindowsTime& ctime, const WindowsTime& crtime) const;
 };
 
 #endif
\ No newline at end of file
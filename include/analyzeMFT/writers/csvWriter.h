@@ -8,22 +8,28 @@
 class CsvWriter : public FileWriter {
 public:
     CsvWriter(char delimiter = ',', bool includeHeader = true);
-    
+
     bool write(const std::vector<const MftRecord*>& records, const std::string& outputFile) override;
-    
+
     void setDelimiter(char delimiter);
     void setIncludeHeader(bool include);
 
+    // The header line, and one row with every field quoted; MftAnalyzer
+    // streams its CSV output through these too
+    void appendHeader(std::string& out) const;
+    void appendRecord(std::string& out, const MftRecord* record) const;
+
 protected:
     bool writeHeader(std::ostream& stream) override;
     bool writeRecord(std::ostream& stream, const MftRecord* record) override;
+    std::unique_ptr<FileWriter> chunkWriter(size_t firstIndex) const override;
 
 private:
     char delimiter;
     bool includeHeader;
-    
-    std::string escapeCsvField(const std::string& field) const;
-    void writeField(std::ostream& stream, const std::string& field, bool isLast = false);
+    std::string line;
+
+    void appendQuoted(std::string& out, std::string_view field) const;
 };
 
-#endif
\ No newline at end of file
+#endif
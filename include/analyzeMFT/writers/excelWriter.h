@@ -2,25 +2,58 @@
 #define ANALYZEMFT_EXCELWRITER_H
 
 #include "fileWriter.h"
+#include "../utils/zipWriter.h"
 
+// XLSX workbook streamed straight into its ZIP container: rows are
+// formatted and deflated in chunks, on `threads` threads, and written as
+// they are ready, so memory use does not grow with the record count.
+// Record numbers are numeric cells, enumerated values such as "In Use" or
+// "True" come from a fixed shared-string table, and all other text is
+// stored inline. A sheet that reaches Excel's row limit continues on the
+// next one, "MFT (2)" and so on, each with its own header row.
+//
+// Records can be fed batch by batch through open()/writeBatch()/close().
+// The sheets are written as the rows arrive; the workbook parts that list
+// them, and the filter ranges that depend on their row counts, follow at
+// close(), which ZIP's central directory allows.
 class ExcelWriter : public FileWriter {
 public:
+    // Excel's limit, header row included
+    static constexpr size_t MAX_SHEET_ROWS = 1048576;
+
     ExcelWriter();
     ~ExcelWriter();
-    
+
     bool write(const std::vector<const MftRecord*>& records, const std::string& outputFile) override;
 
+    bool open(const std::string& outputFile);
+    bool writeBatch(const std::vector<const MftRecord*>& records);
+    bool close();
+
 protected:
     bool writeRecord(std::ostream& stream, const MftRecord* record) override;
 
 private:
-    struct ExcelImpl;
-    std::unique_ptr<ExcelImpl> impl;
-    
-    bool initializeWorkbook();
-    bool finalizeWorkbook();
-    bool writeExcelHeader();
-    bool writeExcelRecord(const MftRecord* record, int row);
+    enum class CellKind : uint8_t { Number, Shared, Text };
+
+    ZipWriter zip;
+    std::vector<size_t> columns;
+    std::vector<std::string> cellPrefixes;     // `<c r="B` for each output column
+    std::vector<CellKind> cellKinds;
+    size_t nextRow;
+    size_t sheetCount;                          // sheets begun
+    size_t sheetRecords;                        // records in the last one
+    size_t recordCount;
+    bool sheetOpen;
+
+    void prepareColumns();
+    bool writePackageParts();
+    bool beginSheet();
+    bool writeRows(const MftRecord* const* records, size_t count);
+    bool endSheet();
+    void appendRow(std::string& out, const MftRecord* record, size_t row) const;
+
+    static std::string sheetName(size_t sheet);
 };
 
-#endif
\ No newline at end of file
+#endif
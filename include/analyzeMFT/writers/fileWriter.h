@@ -3,14 +3,52 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include "../core/mftRecord.h"
+#include "../utils/outputSink.h"
+
+class CancellationToken;
+
+// How the body and timeline writers merge equal timestamps of a record
+enum class MacbCollapse {
+    None,           // one event per timestamp
+    Attribute,      // equal times within $SI or within $FN share one event
+    All             // equal times share one event across $SI and $FN too
+};
 
 class FileWriter {
 public:
     virtual ~FileWriter() = default;
     virtual bool write(const std::vector<const MftRecord*>& records, const std::string& outputFile) = 0;
     
+    // Restricts output to these CsvColumn columns, in this order; empty writes the full record
+    void setColumns(const std::vector<size_t>& columns) { selectedColumns = columns; }
+    // Formatting threads for writers that support it; the output is identical at any count
+    void setThreads(unsigned count) { threads = count > 0 ? count : 1; }
+    // Compresses the output file as it is written
+    void setCompression(const OutputCompression& compression) { this->compression = compression; }
+    // Hashes the output file as it is written, into *digest; SQLite, which
+    // writes through its own pager, leaves it empty
+    void setDigest(OutputDigest* digest) { this->digest = digest; }
+    // Lets a "shm:" output stop waiting for its consumer when cancelled
+    void setCancellation(const CancellationToken* token) { cancellation = token; }
+    
 protected:
+    std::vector<size_t> selectedColumns;
+    unsigned threads = 1;
+    OutputCompression compression;
+    OutputDigest* digest = nullptr;
+    const CancellationToken* cancellation = nullptr;
+    
+    bool isColumnSelected(size_t column) const;
+    
+    // Writes every record through writeRecord(). Writers that return a
+    // chunk writer format chunks of records on `threads` threads.
+    bool writeRecords(std::ostream& stream, const std::vector<const MftRecord*>& records);
+    // Independent copy of this writer in the state it would be in just before
+    // writing records[firstIndex]; null keeps writeRecords() serial
+    virtual std::unique_ptr<FileWriter> chunkWriter(size_t /*firstIndex*/) const { return nullptr; }
+
     virtual bool writeHeader(std::ostream& stream) { return true; }
     virtual bool writeRecord(std::ostream& stream, const MftRecord* record) = 0;
     virtual bool writeFooter(std::ostream& stream) { return true; }
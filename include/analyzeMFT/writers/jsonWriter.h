@@ -16,15 +16,15 @@ protected:
     bool writeHeader(std::ostream& stream) override;
     bool writeRecord(std::ostream& stream, const MftRecord* record) override;
     bool writeFooter(std::ostream& stream) override;
+    std::unique_ptr<FileWriter> chunkWriter(size_t firstIndex) const override;
 
 private:
     bool prettyPrint;
     int indentLevel;
     bool firstRecord;
+    std::string object;
     
-    std::string escapeJsonString(const std::string& str) const;
     std::string getIndent() const;
-    void writeJsonField(std::ostream& stream, const std::string& key, const std::string& value, bool isLast = false);
     void writeJsonObject(std::ostream& stream, const MftRecord* record);
 };
 
@@ -0,0 +1,28 @@
+#ifndef ANALYZEMFT_JSONLWRITER_H
+#define ANALYZEMFT_JSONLWRITER_H
+
+#include "fileWriter.h"
+#include <memory>
+
+// Newline-delimited JSON: one compact object per record, per line, with no
+// enclosing array, so the output can be streamed, split at any line and fed
+// to bulk loaders. Keys match JsonWriter; numeric fields are JSON numbers.
+class JsonlWriter : public FileWriter {
+public:
+    JsonlWriter();
+    
+    bool write(const std::vector<const MftRecord*>& records, const std::string& outputFile) override;
+    
+    // One record's line, with its line break; MftAnalyzer streams its JSONL
+    // output through this too
+    void appendRecord(std::string& out, const MftRecord* record) const;
+
+protected:
+    bool writeRecord(std::ostream& stream, const MftRecord* record) override;
+    std::unique_ptr<FileWriter> chunkWriter(size_t firstIndex) const override;
+
+private:
+    std::string line;
+};
+
+#endif
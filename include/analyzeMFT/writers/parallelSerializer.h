@@ -0,0 +1,35 @@
+#ifndef ANALYZEMFT_PARALLELSERIALIZER_H
+#define ANALYZEMFT_PARALLELSERIALIZER_H
+
+#include <ostream>
+#include <string>
+#include <functional>
+#include <cstddef>
+
+// Formats a run of records on worker threads and writes the pieces in
+// record order. The range [0, count) is cut into fixed-size chunks; each
+// worker formats whole chunks into a private buffer and the calling thread
+// writes finished chunks to the stream as soon as all earlier ones are out.
+// Chunk boundaries depend only on the record count, never on the thread
+// count, so the formatter sees the same ranges either way.
+class ParallelSerializer {
+public:
+    static constexpr size_t DEFAULT_CHUNK_RECORDS = 2048;
+
+    // Appends the text for records [begin, end) to out; false aborts the run.
+    // Called concurrently for different ranges.
+    using FormatRange = std::function<bool(std::string& out, size_t begin, size_t end)>;
+    // Receives each finished chunk, in order, on the calling thread
+    using WriteChunk = std::function<bool(const std::string& text)>;
+
+    explicit ParallelSerializer(unsigned threads = 1, size_t chunkRecords = DEFAULT_CHUNK_RECORDS);
+
+    bool write(std::ostream& stream, size_t count, const FormatRange& format);
+    bool write(size_t count, const FormatRange& format, const WriteChunk& writeChunk);
+
+private:
+    unsigned threads;
+    size_t chunkRecords;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef ANALYZEMFT_PARQUETWRITER_H
+#define ANALYZEMFT_PARQUETWRITER_H
+
+#include "fileWriter.h"
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Writes Apache Parquet without external libraries. Records are buffered
+// column-wise and flushed as one row group every rowGroupSize rows, so the
+// writer can be fed batch by batch through open()/writeBatch()/close().
+//
+// Encodings: record status, file type and extension are dictionary-encoded;
+// record numbers and timestamps use DELTA_BINARY_PACKED; everything else is
+// PLAIN. Pages are Snappy-compressed unless compression is disabled.
+class ParquetWriter : public FileWriter {
+public:
+    static constexpr size_t DEFAULT_ROW_GROUP_SIZE = 128 * 1024;
+
+    explicit ParquetWriter(size_t rowGroupSize = DEFAULT_ROW_GROUP_SIZE, bool compress = true);
+    ~ParquetWriter();
+
+    bool write(const std::vector<const MftRecord*>& records, const std::string& outputFile) override;
+
+    bool open(const std::string& outputFile);
+    bool writeBatch(const std::vector<const MftRecord*>& records);
+    bool close();
+
+    void setRowGroupSize(size_t rows);
+    void setCompression(bool enabled);
+
+    enum class Encoding { Plain, Dictionary, Delta };
+
+    // Page encodings: the RLE / bit-packing hybrid for definition levels and
+    // dictionary indices of width bits, and DELTA_BINARY_PACKED
+    static void encodeHybrid(const std::vector<uint64_t>& values, int width, std::vector<uint8_t>& output);
+    static void encodeDelta(const std::vector<int64_t>& values, std::vector<uint8_t>& output);
+
+protected:
+    bool writeRecord(std::ostream& stream, const MftRecord* record) override;
+
+private:
+    struct Column {
+        std::string name;
+        int physicalType;
+        int convertedType;
+        bool optional;
+        Encoding encoding;
+
+        // Non-null values only; definition levels mark the nulls
+        std::vector<int64_t> ints;
+        std::vector<std::string> strings;
+        std::vector<uint8_t> definitionLevels;
+        int64_t nullCount = 0;
+    };
+
+    struct ColumnChunkInfo {
+        int64_t fileOffset = 0;
+        int64_t dataPageOffset = 0;
+        int64_t dictionaryPageOffset = -1;
+        int64_t uncompressedSize = 0;
+        int64_t compressedSize = 0;
+        int64_t valueCount = 0;
+        int64_t nullCount = 0;
+        bool hasMinMax = false;
+        int64_t minValue = 0;
+        int64_t maxValue = 0;
+    };
+
+    struct RowGroupInfo {
+        std::vector<ColumnChunkInfo> columns;
+        int64_t rowCount = 0;
+        int64_t totalByteSize = 0;
+        int64_t fileOffset = 0;
+    };
+
+    size_t rowGroupSize;
+    bool compress;
+
+    std::ofstream file;
+    int64_t fileOffset;
+    std::vector<Column> columns;
+    // Column index for each value appendRecord() produces, -1 when not selected
+    std::vector<int> slots;
+    size_t bufferedRows;
+    int64_t totalRows;
+    std::vector<RowGroupInfo> rowGroups;
+    std::unique_ptr<Sha256Stream> hash;     // set while a digest is wanted
+
+    void initializeColumns();
+    void appendRecord(const MftRecord& record);
+    bool flushRowGroup();
+    bool writeColumnChunk(Column& column, ColumnChunkInfo& info);
+    bool writePage(int pageType, const std::vector<uint8_t>& body, int32_t valueCount,
+                   int encoding, ColumnChunkInfo& info);
+    void encodeValues(const Column& column, std::vector<uint8_t>& output) const;
+    std::vector<uint8_t> serializeFooter() const;
+    bool writeBytes(const uint8_t* data, size_t length);
+};
+
+#endif
@@ -5,25 +5,69 @@
 #include <sqlite3.h>
 #include <memory>
 
+// Loads records into a fresh SQLite database batch by batch through
+// open()/writeBatch()/close(): tables and statements are set up at open(),
+// rows go in one transaction per TRANSACTION_ROWS, and the indexes are
+// built at close(), once all rows are in.
 class SqliteWriter : public FileWriter {
 public:
     SqliteWriter();
     ~SqliteWriter();
     
     bool write(const std::vector<const MftRecord*>& records, const std::string& outputFile) override;
+    
+    bool open(const std::string& outputFile);
+    bool writeBatch(const std::vector<const MftRecord*>& records);
+    bool close();
 
 protected:
     bool writeRecord(std::ostream& stream, const MftRecord* record) override;
 
 private:
+    // Rows per transaction during the load
+    static constexpr size_t TRANSACTION_ROWS = 1 << 20;
+    // Largest multi-row INSERT: 999 parameters is the limit of older
+    // SQLite builds
+    static constexpr int MAX_PARAMETERS = 999;
+    static constexpr size_t MAX_BATCH_ROWS = 64;
+    
+    // An INSERT target, prepared for one row and for batchRows rows
+    struct Table {
+        int columns = 0;
+        size_t batchRows = 1;
+        sqlite3_stmt* single = nullptr;
+        sqlite3_stmt* batch = nullptr;
+    };
+    
+    // A row of a per-record child table: item `index` of `record`
+    struct ChildRow {
+        const MftRecord* record;
+        uint32_t index;
+    };
+    
     sqlite3* database;
-    sqlite3_stmt* insertStatement;
+    size_t transactionRows;         // rows inserted since the last COMMIT
+    Table files;
+    Table fileNames;
+    Table dataStreams;
+    Table attributeListEntries;
+    std::vector<ChildRow> childRows;
     
     bool openDatabase(const std::string& filename);
+    bool beginBulkLoad();
     bool createTables();
+    bool checkFilesTable();
     bool prepareStatements();
-    bool insertRecord(const MftRecord* record);
-    bool executeSqlScript(const std::string& scriptPath);
+    bool prepareTable(Table& table, const std::string& insertSql, int columns);
+    bool insertRecords(const MftRecord* const* records, size_t count);
+    // Inserts `count` rows, bindRow(statement, firstParameter, row) binding each
+    template <typename BindRow>
+    bool insertRows(Table& table, size_t count, BindRow bindRow);
+    void bindFile(sqlite3_stmt* statement, int first, const MftRecord* record) const;
+    bool createIndexes();
+    bool execute(const char* sql);
+    bool executeSqlScript(const std::string& scriptName);
+    void finalizeTable(Table& table);
     void closeDatabase();
     
     std::string getSqlScriptPath(const std::string& scriptName) const;
@@ -0,0 +1,60 @@
+#ifndef ANALYZEMFT_TIMELINEWRITER_H
+#define ANALYZEMFT_TIMELINEWRITER_H
+
+#include "fileWriter.h"
+#include "../utils/externalSorter.h"
+#include <memory>
+
+// Super-timeline: one line for every valid $STANDARD_INFORMATION and
+// $FILE_NAME timestamp, in time order across the whole MFT:
+//
+//     unixtime|$SI|MODIFY|||||name|record||||
+//
+// Events are ordered by their full FILETIME, so the order holds within a
+// second too. They go through an ExternalSorter, so the writer can be fed
+// batch by batch through open()/writeBatch()/close(), and a timeline that
+// does not fit in the memory limit is sorted in runs spilled next to the
+// output file and merged.
+//
+// With setCollapse(), equal timestamps of a record share one line whose
+// event field holds mactime-style MACB flags, "M.C." for a time that is
+// both the modification and the MFT change time:
+//
+//     unixtime|$SI|M.CB|||||name|record||||
+//
+// Times are compared as full FILETIMEs. MacbCollapse::All also merges
+// $SI and $FN times, and such lines have the source "$SI+$FN".
+class TimelineWriter : public FileWriter {
+public:
+    TimelineWriter();
+    ~TimelineWriter();
+
+    bool write(const std::vector<const MftRecord*>& records, const std::string& outputFile) override;
+
+    bool open(const std::string& outputFile);
+    bool writeBatch(const std::vector<const MftRecord*>& records);
+    bool close();
+
+    // Memory for buffered events before a sorted run goes to disk
+    void setMemoryLimit(size_t bytes) { memoryLimit = bytes; }
+    void setCollapse(MacbCollapse mode) { collapse = mode; }
+
+protected:
+    // Unsorted: the record's events in attribute order
+    bool writeRecord(std::ostream& stream, const MftRecord* record) override;
+
+private:
+    size_t memoryLimit;
+    MacbCollapse collapse = MacbCollapse::None;
+    std::string outputFile;
+    std::unique_ptr<ExternalSorter> sorter;
+    std::string line;
+
+    // Calls addEvent(time, line) for each of the record's events
+    template <typename AddEvent>
+    void formatEvents(const MftRecord* record, AddEvent addEvent);
+    void formatTimelineEntry(std::string& entry, const MftRecord* record, const std::string& name,
+                             const WindowsTime& time, const char* source, const char* eventType) const;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define ANALYZEMFT_XMLWRITER_H
 
 #include "fileWriter.h"
+#include <string_view>
 
 class XmlWriter : public FileWriter {
 public:
@@ -15,14 +16,15 @@ protected:
     bool writeHeader(std::ostream& stream) override;
     bool writeRecord(std::ostream& stream, const MftRecord* record) override;
     bool writeFooter(std::ostream& stream) override;
+    std::unique_ptr<FileWriter> chunkWriter(size_t firstIndex) const override;
 
 private:
     bool prettyPrint;
     int indentLevel;
     
-    std::string escapeXmlString(const std::string& str) const;
+    std::string escapeXmlString(std::string_view str) const;
     std::string getIndent() const;
-    void writeXmlElement(std::ostream& stream, const std::string& tag, const std::string& value);
+    void writeXmlElement(std::ostream& stream, const char* tag, std::string_view value);
     void writeRecordElement(std::ostream& stream, const MftRecord* record);
 };
 
@@ -2,25 +2,31 @@
 #define canalyzemft_H
 
 #include "version.h"
-#include "../src/core/constants.h"
-#include "../src/core/mftRecord.h"
-#include "../src/core/mftAnalyzer.h"
-#include "../src/core/winTime.h"
-#include "../src/utils/hashCalc.h"
-#include "../src/utils/stringUtils.h"
-#include "../src/utils/logger.h"
-#include "../src/utils/memUtils.h"
-#include "../src/utils/fsUtils.h"
-#include "../src/writers/fileWriter.h"
-#include "../src/writers/csvWriter.h"
-#include "../src/writers/jsonWriter.h"
-#include "../src/writers/xmlWriter.h"
-#include "../src/writers/excelWriter.h"
-#include "../src/writers/sqliteWriter.h"
-#include "../src/writers/bodyWriter.h"
-#include "../src/writers/timelineWriter.h"
-#include "../src/cli/cliParser.h"
-#include "../src/cli/app.h"
+#include <stddef.h>
+#include <stdint.h>
+#include "analyzeMFT/core/arrowCData.h"
+
+#ifdef __cplusplus
+#include "analyzeMFT/core/constants.h"
+#include "analyzeMFT/core/mftRecord.h"
+#include "analyzeMFT/core/mftAnalyzer.h"
+#include "analyzeMFT/core/winTime.h"
+#include "analyzeMFT/utils/hashCalc.h"
+#include "analyzeMFT/utils/stringUtils.h"
+#include "analyzeMFT/utils/logger.h"
+#include "analyzeMFT/utils/memUtils.h"
+#include "analyzeMFT/utils/fsUtils.h"
+#include "analyzeMFT/writers/fileWriter.h"
+#include "analyzeMFT/writers/csvWriter.h"
+#include "analyzeMFT/writers/jsonWriter.h"
+#include "analyzeMFT/writers/xmlWriter.h"
+#include "analyzeMFT/writers/excelWriter.h"
+#include "analyzeMFT/writers/sqliteWriter.h"
+#include "analyzeMFT/writers/bodyWriter.h"
+#include "analyzeMFT/writers/timelineWriter.h"
+#include "analyzeMFT/cli/cliParser.h"
+#include "analyzeMFT/cli/app.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -39,8 +45,119 @@ int analyzeMft(const AnalyzeOptions* options);
 const char* getVersion();
 const char* getSupportedFormats();
 
+/*
+ * Parses options->inputFile into one Arrow C Data Interface struct batch
+ * (see ArrowBatchBuilder for the columns). The caller owns the results and
+ * must call their release callbacks. Returns 0 on success, -1 on error.
+ */
+int analyzeMftToArrow(const AnalyzeOptions* options, struct ArrowSchema* schema, struct ArrowArray* array);
+
+/*
+ * Streaming record access without an intermediate output file.
+ *
+ * Projection flags select which fields are produced; anything not requested
+ * is left zero/NULL and its derived work (UTF-8 names, path reconstruction,
+ * hashing, GUID formatting) is skipped. MFT_FIELD_PATHS makes the open call
+ * index every record's name and parent once so paths are complete from the
+ * first batch on.
+ */
+#define MFT_FIELD_NAMES       0x0001u
+#define MFT_FIELD_PATHS       0x0002u
+#define MFT_FIELD_SI_TIMES    0x0004u
+#define MFT_FIELD_FN_TIMES    0x0008u
+#define MFT_FIELD_OBJECT_IDS  0x0010u
+#define MFT_FIELD_HASHES      0x0020u
+#define MFT_FIELD_DEFAULT     (MFT_FIELD_NAMES | MFT_FIELD_PATHS | MFT_FIELD_SI_TIMES | MFT_FIELD_FN_TIMES)
+#define MFT_FIELD_ALL         0x003Fu
+
+typedef struct MftHandle MftHandle;
+
+/*
+ * One parsed record. Timestamps are raw FILETIME values (100ns ticks since
+ * 1601-01-01 UTC, 0 when absent). attributeMask has bit (type >> 4) set for
+ * every attribute type present, e.g. bit 3 for $FILE_NAME (0x30).
+ * String pointers are borrowed from the handle and stay valid until the next
+ * mftNextBatch() or mftClose() call on it.
+ */
+typedef struct {
+    uint64_t recordNumber;
+    uint64_t parentRecordNumber;
+    uint64_t baseReference;
+    uint64_t logSequenceNumber;
+    uint64_t fileSize;
+    uint64_t siCreationTime;
+    uint64_t siModificationTime;
+    uint64_t siAccessTime;
+    uint64_t siEntryTime;
+    uint64_t fnCreationTime;
+    uint64_t fnModificationTime;
+    uint64_t fnAccessTime;
+    uint64_t fnEntryTime;
+    uint32_t attributeMask;
+    uint16_t sequenceNumber;
+    uint16_t flags;
+    uint16_t linkCount;
+    uint8_t validSignature;
+    uint8_t reserved;
+    const char* filename;
+    const char* filepath;
+    const char* objectId;
+    const char* birthVolumeId;
+    const char* birthObjectId;
+    const char* birthDomainId;
+    const char* md5;
+    const char* sha256;
+    const char* sha512;
+    const char* crc32;
+} MftRecordInfo;
+
+/* Both return NULL on failure; mftLastError(NULL) then describes the reason. */
+MftHandle* mftOpenFile(const char* path, uint32_t fields);
+/* The buffer is borrowed and must outlive the handle. */
+MftHandle* mftOpenBuffer(const void* data, size_t size, uint32_t fields);
+
+/*
+ * Decodes up to maxRecords records (0 selects a default batch size).
+ * Returns 1 and fills records and count when records were produced, 0 at the end
+ * of the input and -1 on error.
+ */
+int mftNextBatch(MftHandle* handle, size_t maxRecords, const MftRecordInfo** records, size_t* count);
+/*
+ * Same as mftNextBatch but exports the batch as an Arrow struct array. The
+ * buffers are owned by the returned schema/array, not by the handle, so they
+ * outlive later calls until released. Returns 1, 0 or -1 like mftNextBatch.
+ */
+int mftNextArrowBatch(MftHandle* handle, size_t maxRecords, struct ArrowSchema* schema, struct ArrowArray* array);
+const char* mftLastError(const MftHandle* handle);
+void mftClose(MftHandle* handle);
+
+/*
+ * Consumer side of "-o shm:NAME": reads the export from the shared-memory
+ * ring another process is writing on this host (see shmRing.h for the
+ * protocol). The ring holds a fixed amount of data, so the producer waits
+ * whenever this side falls behind.
+ */
+typedef struct MftRing MftRing;
+
+/*
+ * name is "shm:NAME" as given to -o. Waits up to timeoutMs for the producer
+ * to create the ring. Returns NULL on failure; mftRingLastError(NULL) then
+ * describes the reason.
+ */
+MftRing* mftRingOpen(const char* name, unsigned timeoutMs);
+/*
+ * Returns 1 with the next message in data and size, 0 at the end of the
+ * output and -1 on error, e.g. when the producer failed. Messages from
+ * uncompressed output end at a line break; compressed ones are whole zstd
+ * frames or gzip members. The message stays valid until the next call.
+ */
+int mftRingNext(MftRing* ring, const void** data, size_t* size);
+const char* mftRingLastError(const MftRing* ring);
+/* Detaching before the end makes the producer fail its output. */
+void mftRingClose(MftRing* ring);
+
 #ifdef __cplusplus
 }
 #endif
 
-#endif
\ No newline at end of file
+#endif
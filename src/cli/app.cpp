@@ -1,18 +1,41 @@
 #include "../../include/analyzeMFT/cli/app.h"
 #include "../utils/logger.h"
 #include "../utils/fsUtils.h"
+#include "../utils/shmRing.h"
+#include "../core/snapshot.h"
+#include "../core/queryIndex.h"
 #include "../../include/version.h"
 #include <iostream>
+#include <chrono>
 #include <csignal>
 
+namespace {
+
+MacbCollapse macbCollapse(const CliOptions& options) {
+    if (options.macbAll) return MacbCollapse::All;
+    return options.macb ? MacbCollapse::Attribute : MacbCollapse::None;
+}
+
+std::string outputList(const CliOptions& options) {
+    std::string list = options.outputFile;
+    for (const auto& output : options.outputs) {
+        list += ", " + output.path;
+    }
+    return list;
+}
+
+}
+
 Application* Application::currentInstance = nullptr;
 
-Application::Application() : parser(std::make_unique<CliParser>()) {
+Application::Application()
+    : parser(std::make_unique<CliParser>()), cancellation(std::make_shared<CancellationToken>()) {
     currentInstance = this;
     setupSignalHandlers();
 }
 
 Application::~Application() {
+    restoreSignalHandlers();
     currentInstance = nullptr;
 }
 
@@ -32,6 +55,21 @@ int Application::run(int argc, char* argv[]) {
             return 0;
         }
         
+        compileWhere(options);
+        selectFields(options);
+        selectCompression(options);
+        selectSplit(options);
+        
+        if (options.queryMode) {
+            Logger::getInstance().setVerbosityLevel(std::max(options.verbosity, options.debug));
+            return runQuery(options);
+        }
+        
+        if (options.isBatchMode()) {
+            Logger::getInstance().setVerbosityLevel(std::max(options.verbosity, options.debug));
+            return runBatch(options);
+        }
+        
         if (!validateInputs(options)) {
             return 1;
         }
@@ -47,8 +85,17 @@ int Application::run(int argc, char* argv[]) {
             return 1;
         }
         
+        if (analyzer->isInterrupted()) {
+            std::cout << "\nAnalysis interrupted. Partial results written to " << outputList(options) << std::endl;
+            analyzer->printStatistics();
+            return 130;
+        }
+        
         analyzer->printStatistics();
-        std::cout << "Analysis complete. Results written to " << options.outputFile << std::endl;
+        std::cout << "Analysis complete. Results written to " << outputList(options) << std::endl;
+        if (!options.evidenceFile.empty()) {
+            std::cout << "Evidence manifest written to " << options.evidenceFile << std::endl;
+        }
         
         return 0;
         
@@ -70,22 +117,74 @@ bool Application::validateInputs(const CliOptions& options) {
         return false;
     }
     
-    std::string outputDir = FileSystemUtils::getDirname(options.outputFile);
-    if (!FileSystemUtils::fileExists(outputDir)) {
-        if (!FileSystemUtils::createDirectories(outputDir)) {
-            std::cerr << "Error: Cannot create output directory '" << outputDir << "'." << std::endl;
+    std::vector<std::string> outputFiles = {options.outputFile};
+    for (const auto& output : options.outputs) {
+        outputFiles.push_back(output.path);
+    }
+    for (const auto& outputFile : outputFiles) {
+        if (ShmRingWriter::isRingPath(outputFile)) {
+            continue;
+        }
+        std::string outputDir = FileSystemUtils::getDirname(outputFile);
+        if (!FileSystemUtils::fileExists(outputDir)) {
+            if (!FileSystemUtils::createDirectories(outputDir)) {
+                std::cerr << "Error: Cannot create output directory '" << outputDir << "'." << std::endl;
+                return false;
+            }
+        }
+        
+        if (FileSystemUtils::fileExists(outputFile) && !FileSystemUtils::isWritable(outputFile)) {
+            std::cerr << "Error: Cannot write to output file '" << outputFile << "'." << std::endl;
             return false;
         }
     }
     
-    if (FileSystemUtils::fileExists(options.outputFile) && !FileSystemUtils::isWritable(options.outputFile)) {
-        std::cerr << "Error: Cannot write to output file '" << options.outputFile << "'." << std::endl;
-        return false;
-    }
-    
     return true;
 }
 
+void Application::compileWhere(const CliOptions& options) {
+    if (options.whereExpression.empty()) {
+        return;
+    }
+    auto filter = std::make_shared<RecordFilter>();
+    if (!filter->compile(options.whereExpression)) {
+        throw std::runtime_error("Invalid --where expression: " + filter->getLastError());
+    }
+    where = std::move(filter);
+}
+
+void Application::selectFields(const CliOptions& options) {
+    if (options.fields.empty()) {
+        return;
+    }
+    auto selected = std::make_shared<ParsePlan>();
+    std::string error;
+    if (!selected->selectColumns(options.fields, error)) {
+        throw std::runtime_error("Invalid --fields list: " + error);
+    }
+    plan = std::move(selected);
+}
+
+void Application::selectCompression(const CliOptions& options) {
+    if (options.compress.empty()) {
+        return;
+    }
+    std::string error;
+    if (!compression.parse(options.compress, error)) {
+        throw std::runtime_error("Invalid --compress value: " + error);
+    }
+}
+
+void Application::selectSplit(const CliOptions& options) {
+    if (options.splitOutput.empty()) {
+        return;
+    }
+    std::string error;
+    if (!split.parse(options.splitOutput, error)) {
+        throw std::runtime_error("Invalid --split-output value: " + error);
+    }
+}
+
 bool Application::initializeAnalyzer(const CliOptions& options) {
     try {
         analyzer = std::make_unique<MftAnalyzer>(
@@ -96,6 +195,21 @@ bool Application::initializeAnalyzer(const CliOptions& options) {
             options.computeHashes,
             options.exportFormat
         );
+        for (const auto& output : options.outputs) {
+            analyzer->addOutput(output.format, output.path);
+        }
+        analyzer->setCancellationToken(cancellation);
+        if (options.jobs > 0) {
+            analyzer->setThreadCount(options.jobs);
+        }
+        analyzer->setParquetRowGroupSize(options.rowGroupSize);
+        analyzer->setSortMemory(size_t(options.sortMemory) << 20);
+        analyzer->setMacbCollapse(macbCollapse(options));
+        analyzer->setRecordFilter(where);
+        analyzer->setParsePlan(plan);
+        analyzer->setCompression(compression);
+        analyzer->setSplit(split);
+        analyzer->setEvidenceManifest(options.evidenceFile);
         return true;
     } catch (const std::exception& e) {
         std::cerr << "Error initializing analyzer: " << e.what() << std::endl;
@@ -103,15 +217,188 @@ bool Application::initializeAnalyzer(const CliOptions& options) {
     }
 }
 
+int Application::runBatch(const CliOptions& options) {
+    std::vector<std::string> inputs;
+    if (!options.inputList.empty()) {
+        inputs = BatchAnalyzer::readInputList(options.inputList);
+    }
+    if (!options.inputGlob.empty()) {
+        std::vector<std::string> matched = FileSystemUtils::globFiles(options.inputGlob);
+        inputs.insert(inputs.end(), matched.begin(), matched.end());
+    }
+    
+    if (inputs.empty()) {
+        std::cerr << "Error: No input MFT files found for batch analysis." << std::endl;
+        return 1;
+    }
+    
+    if (FileSystemUtils::fileExists(options.outputFile) && !FileSystemUtils::isDirectory(options.outputFile)) {
+        std::cerr << "Error: Batch output '" << options.outputFile << "' must be a directory." << std::endl;
+        return 1;
+    }
+    
+    batchAnalyzer = std::make_unique<BatchAnalyzer>(
+        inputs,
+        options.outputFile,
+        options.debug,
+        options.verbosity,
+        options.computeHashes,
+        options.exportFormat
+    );
+    if (options.jobs > 0) {
+        batchAnalyzer->setMaxConcurrency(options.jobs);
+    }
+    batchAnalyzer->setMaxConcurrentIo(options.ioLimit);
+    batchAnalyzer->setParquetRowGroupSize(options.rowGroupSize);
+    batchAnalyzer->setSortMemory(size_t(options.sortMemory) << 20);
+    batchAnalyzer->setMacbCollapse(macbCollapse(options));
+    batchAnalyzer->setRecordFilter(where);
+    batchAnalyzer->setParsePlan(plan);
+    batchAnalyzer->setCompression(compression);
+    batchAnalyzer->setSplit(split);
+    batchAnalyzer->setCancellationToken(cancellation);
+    
+    bool success = batchAnalyzer->analyze();
+    batchAnalyzer->printSummary();
+    
+    std::string manifestFile = options.manifestFile.empty()
+        ? FileSystemUtils::joinPath(options.outputFile, "manifest.json")
+        : options.manifestFile;
+    if (!batchAnalyzer->writeManifest(manifestFile)) {
+        std::cerr << "Error: Cannot write batch manifest '" << manifestFile << "'." << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Batch analysis complete. Manifest written to " << manifestFile << std::endl;
+    return success ? 0 : 1;
+}
+
+int Application::runQuery(const CliOptions& options) {
+    if (!FileSystemUtils::fileExists(options.inputFile)) {
+        std::cerr << "Error: Input file '" << options.inputFile << "' does not exist." << std::endl;
+        return 1;
+    }
+    if (!options.outputFile.empty() && !MftAnalyzer::isRecordFormat(options.exportFormat)) {
+        std::cerr << "Error: Query results cannot be written as " << options.exportFormat << "." << std::endl;
+        return 1;
+    }
+    
+    MftQuery query;
+    query.nameContains = options.queryName;
+    query.pathContains = options.queryPath;
+    // With --where the limit applies after the expression has been checked
+    query.limit = where ? 0 : options.queryLimit;
+    for (const auto& spec : options.queryTimes) {
+        TimeFilter filter;
+        if (!MftQuery::parseTimeFilter(spec, filter)) {
+            throw std::runtime_error("Invalid --time filter '" + spec + "'");
+        }
+        query.times.push_back(filter);
+    }
+    if (!options.querySize.empty()) {
+        if (!MftQuery::parseSizeRange(options.querySize, query.size)) {
+            throw std::runtime_error("Invalid --size range '" + options.querySize + "'");
+        }
+        query.filterSize = true;
+    }
+    
+    // Raw MFTs are parsed once into a snapshot that later queries reuse
+    std::string snapshotPath = options.inputFile;
+    if (!Snapshot::isSnapshotFile(snapshotPath)) {
+        snapshotPath = options.inputFile + ".amft";
+        if (!Snapshot::isSnapshotFile(snapshotPath)) {
+            std::cout << "Creating snapshot " << snapshotPath << std::endl;
+            MftAnalyzer builder(options.inputFile, snapshotPath, options.debug, options.verbosity,
+                                options.computeHashes, "amft");
+            builder.setCancellationToken(cancellation);
+            if (options.jobs > 0) {
+                builder.setThreadCount(options.jobs);
+            }
+            if (!builder.analyze() || builder.isInterrupted()) {
+                FileSystemUtils::deleteFile(snapshotPath);
+                std::cerr << "Error: Cannot create snapshot '" << snapshotPath << "'." << std::endl;
+                return 1;
+            }
+        }
+    }
+    
+    Snapshot snapshot;
+    if (!snapshot.open(snapshotPath)) {
+        std::cerr << "Error: " << snapshot.getLastError() << std::endl;
+        return 1;
+    }
+    
+    QueryIndex index;
+    std::string indexPath = QueryIndex::indexPathFor(snapshotPath);
+    if (!index.open(indexPath, snapshot)) {
+        std::cout << "Building index " << indexPath << std::endl;
+        std::string error;
+        if (!QueryIndex::build(snapshot, indexPath, error) || !index.open(indexPath, snapshot)) {
+            std::cerr << "Error: " << (error.empty() ? index.getLastError() : error) << std::endl;
+            return 1;
+        }
+    }
+    
+    auto started = std::chrono::steady_clock::now();
+    std::vector<uint32_t> rows = index.search(query);
+    if (where) {
+        std::vector<uint32_t> accepted;
+        for (uint32_t row : rows) {
+            if (options.queryLimit > 0 && accepted.size() >= options.queryLimit) {
+                break;
+            }
+            if (where->accepts(*snapshot.loadRecord(row, false))) {
+                accepted.push_back(row);
+            }
+        }
+        rows.swap(accepted);
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started);
+    std::cout << rows.size() << " matching records (" << elapsed.count() << " ms)" << std::endl;
+    
+    if (options.outputFile.empty()) {
+        for (uint32_t row : rows) {
+            std::cout << snapshot.recordNumber(row) << "\t" << snapshot.string(SNAPSHOT_STRING_FILEPATH, row) << "\n";
+        }
+        return 0;
+    }
+    
+    std::vector<std::unique_ptr<MftRecord>> matches;
+    std::vector<const MftRecord*> records;
+    matches.reserve(rows.size());
+    records.reserve(rows.size());
+    bool computeHashes = plan ? plan->needsHashes() : options.computeHashes;
+    for (uint32_t row : rows) {
+        matches.push_back(snapshot.loadRecord(row, computeHashes));
+        records.push_back(matches.back().get());
+    }
+    
+    unsigned threads = options.jobs > 0 ? options.jobs : 1;
+    OutputCompression codec = compression;
+    codec.threads = threads;
+    if (!MftAnalyzer::writeRecords(records, options.outputFile, options.exportFormat, plan.get(), threads, codec,
+                                   macbCollapse(options), nullptr, cancellation.get())) {
+        std::cerr << "Error: Cannot write query results to '" << options.outputFile << "'." << std::endl;
+        return 1;
+    }
+    std::cout << "Query results written to " << options.outputFile << std::endl;
+    return 0;
+}
+
 void Application::setupSignalHandlers() {
     std::signal(SIGINT, signalHandler);
     std::signal(SIGTERM, signalHandler);
 }
 
+void Application::restoreSignalHandlers() {
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+}
+
 void Application::signalHandler(int signal) {
-    if (currentInstance && currentInstance->analyzer) {
-        std::cout << "\nReceived interrupt signal. Cleaning up..." << std::endl;
-        currentInstance->analyzer->setInterruptFlag();
+    // Only async-signal-safe work here: the analyzers poll the token and log on their own thread
+    if (currentInstance && currentInstance->cancellation) {
+        currentInstance->cancellation->cancel();
     }
 }
 
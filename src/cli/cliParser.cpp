@@ -1,5 +1,6 @@
 #include "cliParser.h"
 #include "../include/version.h"
+#include "../utils/shmRing.h"
 #include <iostream>
 #include <algorithm>
 #include <stdexcept>
@@ -9,19 +10,42 @@ CliParser::CliParser() {
 }
 
 void CliParser::initializeOptions() {
-    supportedFormats = {"csv", "json", "xml", "excel", "sqlite", "body", "timeline", "tsk"};
+    supportedFormats = {"csv", "json", "jsonl", "xml", "excel", "sqlite", "body", "timeline", "tsk", "parquet", "amft"};
     
     longOptions = {
         {"--file", "inputFile"},
         {"--output", "outputFile"},
+        {"--input-list", "inputList"},
+        {"--input-glob", "inputGlob"},
+        {"--manifest", "manifestFile"},
+        {"--jobs", "jobs"},
+        {"--io-limit", "ioLimit"},
         {"--csv", "csv"},
         {"--json", "json"},
+        {"--jsonl", "jsonl"},
         {"--xml", "xml"},
         {"--excel", "excel"},
         {"--sqlite", "sqlite"},
         {"--body", "body"},
         {"--timeline", "timeline"},
         {"--tsk", "tsk"},
+        {"--parquet", "parquet"},
+        {"--row-group-size", "rowGroupSize"},
+        {"--sort-memory", "sortMemory"},
+        {"--macb", "macb"},
+        {"--macb-all", "macbAll"},
+        {"--amft", "amft"},
+        {"--where", "whereExpression"},
+        {"--fields", "fields"},
+        {"--compress", "compress"},
+        {"--out", "outputs"},
+        {"--split-output", "splitOutput"},
+        {"--evidence", "evidenceFile"},
+        {"--name", "queryName"},
+        {"--path", "queryPath"},
+        {"--time", "queryTimes"},
+        {"--size", "querySize"},
+        {"--limit", "queryLimit"},
         {"--hash", "computeHashes"},
         {"--help", "showHelp"},
         {"--version", "showVersion"}
@@ -30,6 +54,7 @@ void CliParser::initializeOptions() {
     shortOptions = {
         {'f', "inputFile"},
         {'o', "outputFile"},
+        {'j', "jobs"},
         {'H', "computeHashes"},
         {'v', "verbosity"},
         {'d', "debug"},
@@ -43,7 +68,9 @@ CliOptions CliParser::parse(int argc, char* argv[]) {
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         
-        if (arg == "--help" || arg == "-h") {
+        if (i == 1 && arg == "query") {
+            options.queryMode = true;
+        } else if (arg == "--help" || arg == "-h") {
             options.showHelp = true;
         } else if (arg == "--version") {
             options.showVersion = true;
@@ -59,8 +86,58 @@ CliOptions CliParser::parse(int argc, char* argv[]) {
             } else {
                 throw std::runtime_error("Option " + arg + " requires a value");
             }
+        } else if (arg == "--input-list" || arg == "--input-glob" || arg == "--manifest" ||
+                   arg == "--jobs" || arg == "-j" || arg == "--io-limit" || arg == "--row-group-size" ||
+                   arg == "--sort-memory" || arg == "--where" || arg == "--fields" || arg == "--compress" || arg == "--out" ||
+                   arg == "--split-output" || arg == "--evidence" || arg == "--name" || arg == "--path" || arg == "--time" || arg == "--size" || arg == "--limit") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Option " + arg + " requires a value");
+            }
+            std::string value = argv[++i];
+            if (arg == "--input-list") {
+                options.inputList = value;
+            } else if (arg == "--input-glob") {
+                options.inputGlob = value;
+            } else if (arg == "--manifest") {
+                options.manifestFile = value;
+            } else if (arg == "--io-limit") {
+                options.ioLimit = parseCount(arg, value);
+            } else if (arg == "--row-group-size") {
+                options.rowGroupSize = parseCount(arg, value);
+            } else if (arg == "--sort-memory") {
+                options.sortMemory = parseCount(arg, value);
+            } else if (arg == "--where") {
+                options.whereExpression = value;
+            } else if (arg == "--fields") {
+                options.fields = value;
+            } else if (arg == "--compress") {
+                options.compress = value;
+            } else if (arg == "--out") {
+                options.outputs.push_back(parseOutput(arg, value));
+            } else if (arg == "--split-output") {
+                options.splitOutput = value;
+            } else if (arg == "--evidence") {
+                options.evidenceFile = value;
+            } else if (arg == "--name") {
+                options.queryName = value;
+            } else if (arg == "--path") {
+                options.queryPath = value;
+            } else if (arg == "--time") {
+                options.queryTimes.push_back(value);
+            } else if (arg == "--size") {
+                options.querySize = value;
+            } else if (arg == "--limit") {
+                options.queryLimit = parseCount(arg, value);
+            } else {
+                options.jobs = parseCount(arg, value);
+            }
         } else if (arg == "--hash" || arg == "-H") {
             options.computeHashes = true;
+        } else if (arg == "--macb") {
+            options.macb = true;
+        } else if (arg == "--macb-all") {
+            options.macb = true;
+            options.macbAll = true;
         } else if (arg == "-v") {
             options.verbosity++;
         } else if (arg == "-d") {
@@ -76,6 +153,42 @@ CliOptions CliParser::parse(int argc, char* argv[]) {
                 options.inputFile = value;
             } else if (key == "--output" || key == "-o") {
                 options.outputFile = value;
+            } else if (key == "--input-list") {
+                options.inputList = value;
+            } else if (key == "--input-glob") {
+                options.inputGlob = value;
+            } else if (key == "--manifest") {
+                options.manifestFile = value;
+            } else if (key == "--jobs" || key == "-j") {
+                options.jobs = parseCount(key, value);
+            } else if (key == "--io-limit") {
+                options.ioLimit = parseCount(key, value);
+            } else if (key == "--row-group-size") {
+                options.rowGroupSize = parseCount(key, value);
+            } else if (key == "--sort-memory") {
+                options.sortMemory = parseCount(key, value);
+            } else if (key == "--where") {
+                options.whereExpression = value;
+            } else if (key == "--fields") {
+                options.fields = value;
+            } else if (key == "--compress") {
+                options.compress = value;
+            } else if (key == "--out") {
+                options.outputs.push_back(parseOutput(key, value));
+            } else if (key == "--split-output") {
+                options.splitOutput = value;
+            } else if (key == "--evidence") {
+                options.evidenceFile = value;
+            } else if (key == "--name") {
+                options.queryName = value;
+            } else if (key == "--path") {
+                options.queryPath = value;
+            } else if (key == "--time") {
+                options.queryTimes.push_back(value);
+            } else if (key == "--size") {
+                options.querySize = value;
+            } else if (key == "--limit") {
+                options.queryLimit = parseCount(key, value);
             }
         } else if (arg.substr(0, 1) == "-" && arg.length() > 1) {
             throw std::runtime_error("Unknown option: " + arg);
@@ -88,6 +201,13 @@ CliOptions CliParser::parse(int argc, char* argv[]) {
         }
     }
     
+    // Without -o the first --out is the main output
+    if (options.outputFile.empty() && !options.outputs.empty() && !options.isBatchMode() && !options.queryMode) {
+        options.exportFormat = options.outputs.front().format;
+        options.outputFile = options.outputs.front().path;
+        options.outputs.erase(options.outputs.begin());
+    }
+    
     validateOptions(options);
     return options;
 }
@@ -97,17 +217,140 @@ void CliParser::validateOptions(const CliOptions& options) const {
         return;
     }
     
-    if (options.inputFile.empty()) {
-        throw std::runtime_error("Input file is required. Use -f or --file to specify an MFT file.");
-    }
-    
-    if (options.outputFile.empty()) {
-        throw std::runtime_error("Output file is required. Use -o or --output to specify an output file.");
+    if (options.queryMode) {
+        if (options.isBatchMode()) {
+            throw std::runtime_error("query cannot be combined with --input-list or --input-glob.");
+        }
+        if (options.inputFile.empty()) {
+            throw std::runtime_error("Input file is required. Use -f or --file to specify an MFT or .amft snapshot.");
+        }
+    } else if (options.isBatchMode()) {
+        if (!options.inputFile.empty()) {
+            throw std::runtime_error("--file cannot be combined with --input-list or --input-glob.");
+        }
+        if (options.outputFile.empty()) {
+            throw std::runtime_error("Output directory is required in batch mode. Use -o or --output to specify it.");
+        }
+    } else {
+        if (options.inputFile.empty()) {
+            throw std::runtime_error("Input file is required. Use -f or --file to specify an MFT file.");
+        }
+        
+        if (options.outputFile.empty()) {
+            throw std::runtime_error("Output file is required. Use -o or --output to specify an output file.");
+        }
     }
     
     if (!isValidFormat(options.exportFormat)) {
         throw std::runtime_error("Unsupported export format: " + options.exportFormat);
     }
+    
+    if (!options.outputs.empty()) {
+        if (options.queryMode || options.isBatchMode()) {
+            throw std::runtime_error(std::string("--out cannot be used with ") +
+                                     (options.queryMode ? "query." : "--input-list or --input-glob."));
+        }
+        for (size_t i = 0; i < options.outputs.size(); ++i) {
+            const std::string& path = options.outputs[i].path;
+            bool repeated = path == options.outputFile;
+            for (size_t j = 0; j < i; ++j) {
+                repeated = repeated || path == options.outputs[j].path;
+            }
+            if (repeated) {
+                throw std::runtime_error("Output file " + path + " is given more than once.");
+            }
+        }
+    }
+    
+    if (!options.splitOutput.empty() && options.queryMode) {
+        throw std::runtime_error("--split-output cannot be used with query.");
+    }
+    
+    if (!options.evidenceFile.empty() && (options.queryMode || options.isBatchMode())) {
+        throw std::runtime_error(std::string("--evidence cannot be used with ") +
+                                 (options.queryMode ? "query." : "--input-list or --input-glob."));
+    }
+    
+    // A shared-memory ring carries one stream of text
+    std::vector<CliOutput> targets = {{options.exportFormat, options.outputFile}};
+    targets.insert(targets.end(), options.outputs.begin(), options.outputs.end());
+    for (const auto& target : targets) {
+        if (target.path.compare(0, 4, "shm:") != 0) {
+            continue;
+        }
+        if (!ShmRingWriter::isRingPath(target.path)) {
+            throw std::runtime_error("Shared-memory output needs shm:NAME, got '" + target.path + "'");
+        }
+        if (options.isBatchMode()) {
+            throw std::runtime_error("Shared-memory output cannot be used with --input-list or --input-glob.");
+        }
+        if (!options.splitOutput.empty()) {
+            throw std::runtime_error("--split-output cannot be used with shared-memory output.");
+        }
+        static const std::vector<std::string> streamed = {"csv", "json", "jsonl", "xml", "body", "timeline"};
+        if (std::find(streamed.begin(), streamed.end(), target.format) == streamed.end()) {
+            throw std::runtime_error("Shared-memory output cannot be used with " + target.format + " output.");
+        }
+    }
+    
+    // Options for some formats only need one output of such a format
+    std::vector<std::string> formats = {options.exportFormat};
+    for (const auto& output : options.outputs) {
+        formats.push_back(output.format);
+    }
+    auto requireFormat = [&](const std::string& option, std::initializer_list<const char*> accepted) {
+        std::string names;
+        for (const auto& format : formats) {
+            if (std::find(accepted.begin(), accepted.end(), format) != accepted.end()) {
+                return;
+            }
+            names += names.empty() ? format : ", " + format;
+        }
+        throw std::runtime_error(option + " cannot be used with " + names + " output.");
+    };
+    
+    if (!options.fields.empty()) {
+        requireFormat("--fields", {"csv", "json", "jsonl", "xml", "excel", "parquet"});
+    }
+    
+    if (!options.compress.empty()) {
+        requireFormat("--compress", {"csv", "json", "jsonl", "xml", "body", "timeline"});
+    }
+    
+    if (options.macb) {
+        requireFormat(options.macbAll ? "--macb-all" : "--macb", {"body", "timeline"});
+        // Body lines already hold one attribute's times each, so only --macb-all changes them
+        if (!options.macbAll && std::find(formats.begin(), formats.end(), "body") != formats.end()) {
+            throw std::runtime_error("--macb does not change body output; use --macb-all to leave out "
+                                     "repeated $FILE_NAME lines.");
+        }
+    }
+}
+
+CliOutput CliParser::parseOutput(const std::string& option, const std::string& value) const {
+    size_t colon = value.find(':');
+    if (colon == std::string::npos || colon + 1 == value.size()) {
+        throw std::runtime_error("Option " + option + " requires FORMAT:PATH, got '" + value + "'");
+    }
+    CliOutput output;
+    output.format = value.substr(0, colon);
+    output.path = value.substr(colon + 1);
+    if (!isValidFormat(output.format)) {
+        throw std::runtime_error("Unsupported export format: " + output.format);
+    }
+    return output;
+}
+
+unsigned CliParser::parseCount(const std::string& option, const std::string& value) const {
+    try {
+        size_t consumed = 0;
+        unsigned long count = std::stoul(value, &consumed);
+        if (consumed == value.size()) {
+            return static_cast<unsigned>(count);
+        }
+    } catch (const std::exception&) {
+    }
+    throw std::runtime_error("Option " + option + " requires a non-negative integer, got '" + value + "'");
 }
 
 bool CliParser::isValidFormat(const std::string& format) const {
@@ -123,12 +366,73 @@ void CliParser::printHelp() const {
     std::cout << "Export Format Options:\n";
     std::cout << "  --csv                    Export as CSV (default)\n";
     std::cout << "  --json                   Export as JSON\n";
+    std::cout << "  --jsonl                  Export as newline-delimited JSON, one object per line\n";
     std::cout << "  --xml                    Export as XML\n";
-    std::cout << "  --excel                  Export as Excel\n";
+    std::cout << "  --excel                  Export as an Excel .xlsx workbook, a new sheet every\n";
+    std::cout << "                           1,048,575 records\n";
     std::cout << "  --sqlite                 Export as SQLite database\n";
     std::cout << "  --body                   Export as body file (for mactime)\n";
-    std::cout << "  --timeline               Export as TSK timeline\n";
-    std::cout << "  --tsk                    Export as TSK bodyfile format\n\n";
+    std::cout << "  --timeline               Export a time-sorted timeline of every $SI and $FN timestamp\n";
+    std::cout << "  --sort-memory MB         Memory for sorting timeline events; larger timelines are\n";
+    std::cout << "                           sorted in runs on disk next to the output (default: 512)\n";
+    std::cout << "  --macb                   Merge a record's equal $SI or $FN timeline times into one\n";
+    std::cout << "                           line with MACB flags, e.g. M.CB (timeline only)\n";
+    std::cout << "  --macb-all               As --macb, also merging equal $SI and $FN times; body\n";
+    std::cout << "                           files leave out $FILE_NAME lines that repeat the $SI times\n";
+    std::cout << "  --tsk                    Export as TSK bodyfile format\n";
+    std::cout << "  --parquet                Export as Apache Parquet\n";
+    std::cout << "  --row-group-size N       Rows per Parquet row group (default: 131072)\n";
+    std::cout << "  --amft                   Save a reusable .amft snapshot; pass it back with -f to\n";
+    std::cout << "                           export other formats without re-parsing the MFT\n";
+    std::cout << "  --compress CODEC[:LEVEL] Compress csv, json, jsonl, xml, body or timeline output as\n";
+    std::cout << "                           it is written: zstd (levels 1-22) or gzip (1-9), on --jobs\n";
+    std::cout << "                           threads.\n";
+    std::cout << "                           Batch outputs get a .zst or .gz suffix\n";
+    std::cout << "  --out FORMAT:PATH        Also write FORMAT to PATH from the same parse; repeat for more\n";
+    std::cout << "                           outputs, each written on its own thread. Without -o the\n";
+    std::cout << "                           first --out is the main output. --fields, --compress and\n";
+    std::cout << "                           --macb apply to the outputs whose format takes them\n";
+    std::cout << "  -o shm:NAME              Stream csv, json, jsonl, xml, body or timeline output into the\n";
+    std::cout << "                           shared-memory ring /NAME for a reader on this host (see\n";
+    std::cout << "                           mftRingOpen); the export waits while the reader is behind\n";
+    std::cout << "  --split-output N|SIZE    Write each output as numbered parts (mft.00001.csv, ...) of\n";
+    std::cout << "                           N records or about SIZE bytes (e.g. 512M, 2G), each a\n";
+    std::cout << "                           complete file, listed with record ranges and SHA-256\n";
+    std::cout << "                           checksums in <output>.manifest.json\n";
+    std::cout << "  --evidence FILE          Write the SHA-256 of the input and of every output file, with\n";
+    std::cout << "                           the statistics, to the JSON file FILE. The digests are taken\n";
+    std::cout << "                           while the data is read and written, not by reading it again\n\n";
+    std::cout << "Filter Options:\n";
+    std::cout << "  --fields LIST            Output only these columns, comma-separated CSV header names,\n";
+    std::cout << "                           snake_case keys or JSON names (e.g. record_number,filename,siCreationTime);\n";
+    std::cout << "                           attributes, paths and hashes no column needs are skipped.\n";
+    std::cout << "                           csv, json, jsonl, xml, excel and parquet output only\n";
+    std::cout << "  --where EXPR             Only output records matching EXPR, checked while parsing, e.g.\n";
+    std::cout << "                           \"inuse and not dir and ext in (ps1,dll) and si.created >= 2024-03-01\"\n";
+    std::cout << "                           Fields: record seq links flags inuse deleted dir file name ext\n";
+    std::cout << "                           parent size path si.created|modified|accessed|changed fn.*\n";
+    std::cout << "                           has(si|fn|data|attrlist|objectid|reparse|...); operators:\n";
+    std::cout << "                           = != < <= > >= contains startswith endswith in (...);\n";
+    std::cout << "                           combine with and/or/not (&& || !) and parentheses\n\n";
+    std::cout << "Batch Options:\n";
+    std::cout << "  --input-list FILE        Analyze every MFT listed in FILE (one path per line)\n";
+    std::cout << "  --input-glob PATTERN     Analyze every MFT matching PATTERN or inside a directory\n";
+    std::cout << "  -j, --jobs N             Maximum MFT files analyzed concurrently (default: CPU count),\n";
+    std::cout << "                           sharing N threads by input size;\n";
+    std::cout << "                           for a single file, the number of parsing and formatting threads\n";
+    std::cout << "  --io-limit N             Maximum analyses reading from disk at once (default: unlimited)\n";
+    std::cout << "  --manifest FILE          Batch summary manifest (default: <output>/manifest.json)\n";
+    std::cout << "                           In batch mode -o names the output directory\n\n";
+    std::cout << "Query Mode (analyzemft query -f <mft_or_amft> [-o <output_file>] ...):\n";
+    std::cout << "  --name TEXT              Filename contains TEXT (case-insensitive)\n";
+    std::cout << "  --path TEXT              Full path contains TEXT (case-insensitive)\n";
+    std::cout << "  --time FIELD=FROM..TO    Timestamp window; FIELD is si-|fn- followed by created,\n";
+    std::cout << "                           modified, accessed or changed; bounds are YYYY-MM-DD or\n";
+    std::cout << "                           YYYY-MM-DDTHH:MM:SS and either may be omitted (repeatable)\n";
+    std::cout << "  --size MIN..MAX          File size range, with optional K/M/G/T suffix\n";
+    std::cout << "  --limit N                Stop after N matches\n";
+    std::cout << "                           A raw MFT is first saved as <input>.amft; indexes are kept\n";
+    std::cout << "                           in <snapshot>.idx and reused by later queries\n\n";
     std::cout << "Other Options:\n";
     std::cout << "  -H, --hash               Compute hashes (MD5, SHA256, SHA512, CRC32)\n";
     std::cout << "  -v                       Increase output verbosity (can be used multiple times)\n";
@@ -139,6 +443,10 @@ void CliParser::printHelp() const {
     std::cout << "  analyzemft -f mft.raw -o output.csv\n";
     std::cout << "  analyzemft -f mft.raw -o output.json --json -H -v\n";
     std::cout << "  analyzemft --file mft.raw --output analysis.sqlite --sqlite --hash\n";
+    std::cout << "  analyzemft -f mft.raw -o mft.amft --amft && analyzemft -f mft.amft -o out.json --json\n";
+    std::cout << "  analyzemft -f mft.raw --out csv:mft.csv --out body:mft.body --out sqlite:case.db\n";
+    std::cout << "  analyzemft query -f mft.amft --name .ps1 --time si-created=2024-03-01..2024-03-07\n";
+    std::cout << "  analyzemft --input-list mfts.txt -o results/ --jobs 16 --io-limit 4\n";
 }
 
 void CliParser::printVersion() const {
@@ -0,0 +1,348 @@
+#include "arrowExport.h"
+#include "mftRecord.h"
+#include "../utils/stringUtils.h"
+#include <cstring>
+#include <memory>
+
+namespace {
+
+// 100ns ticks between 1601-01-01 and 1970-01-01
+constexpr uint64_t FILETIME_UNIX_EPOCH = 116444736000000000ULL;
+
+const char* const TIME_COLUMN_NAMES[8] = {
+    "si_creation_time", "si_modification_time", "si_access_time", "si_entry_time",
+    "fn_creation_time", "fn_modification_time", "fn_access_time", "fn_entry_time"
+};
+
+struct ExportedArray {
+    std::vector<std::vector<uint8_t>> storage;
+    std::vector<const void*> buffers;
+    std::vector<ArrowArray*> children;
+    ArrowArray* dictionary = nullptr;
+};
+
+struct ExportedSchema {
+    std::string format;
+    std::string name;
+    std::vector<ArrowSchema*> children;
+    ArrowSchema* dictionary = nullptr;
+};
+
+void releaseArray(ArrowArray* array) {
+    auto* exported = static_cast<ExportedArray*>(array->private_data);
+    for (ArrowArray* child : exported->children) {
+        if (child->release) {
+            child->release(child);
+        }
+        delete child;
+    }
+    if (exported->dictionary) {
+        if (exported->dictionary->release) {
+            exported->dictionary->release(exported->dictionary);
+        }
+        delete exported->dictionary;
+    }
+    delete exported;
+    array->release = nullptr;
+}
+
+void releaseSchema(ArrowSchema* schema) {
+    auto* exported = static_cast<ExportedSchema*>(schema->private_data);
+    for (ArrowSchema* child : exported->children) {
+        if (child->release) {
+            child->release(child);
+        }
+        delete child;
+    }
+    if (exported->dictionary) {
+        if (exported->dictionary->release) {
+            exported->dictionary->release(exported->dictionary);
+        }
+        delete exported->dictionary;
+    }
+    delete exported;
+    schema->release = nullptr;
+}
+
+ArrowSchema* makeSchema(const std::string& format, const std::string& name, bool nullable) {
+    auto* exported = new ExportedSchema();
+    exported->format = format;
+    exported->name = name;
+
+    auto* schema = new ArrowSchema();
+    schema->format = exported->format.c_str();
+    schema->name = exported->name.c_str();
+    schema->metadata = nullptr;
+    schema->flags = nullable ? ARROW_FLAG_NULLABLE : 0;
+    schema->n_children = 0;
+    schema->children = nullptr;
+    schema->dictionary = nullptr;
+    schema->release = releaseSchema;
+    schema->private_data = exported;
+    return schema;
+}
+
+// Takes ownership of the given buffers; an empty validity bitmap is exported as null.
+ArrowArray* makeArray(int64_t length, int64_t nullCount, std::vector<std::vector<uint8_t>> buffers) {
+    auto* exported = new ExportedArray();
+    exported->storage = std::move(buffers);
+    for (size_t i = 0; i < exported->storage.size(); ++i) {
+        bool omitValidity = i == 0 && nullCount == 0;
+        exported->buffers.push_back(omitValidity ? nullptr : exported->storage[i].data());
+    }
+
+    auto* array = new ArrowArray();
+    array->length = length;
+    array->null_count = nullCount;
+    array->offset = 0;
+    array->n_buffers = static_cast<int64_t>(exported->buffers.size());
+    array->n_children = 0;
+    array->buffers = exported->buffers.data();
+    array->children = nullptr;
+    array->dictionary = nullptr;
+    array->release = releaseArray;
+    array->private_data = exported;
+    return array;
+}
+
+}
+
+ArrowBatchBuilder::ArrowBatchBuilder() : rowCount(0) {
+    reset();
+}
+
+std::vector<std::string> ArrowBatchBuilder::columnNames() {
+    std::vector<std::string> names = {
+        "record_number", "sequence_number", "flags", "in_use", "is_directory", "file_type",
+        "parent_record_number", "link_count", "file_size", "filename", "extension", "filepath"
+    };
+    for (const char* name : TIME_COLUMN_NAMES) {
+        names.push_back(name);
+    }
+    names.push_back("attribute_mask");
+    return names;
+}
+
+void ArrowBatchBuilder::reset() {
+    rowCount = 0;
+    recordNumber = FixedColumn();
+    sequenceNumber = FixedColumn();
+    flags = FixedColumn();
+    inUse = FixedColumn();
+    isDirectory = FixedColumn();
+    fileType = DictionaryColumn();
+    parentRecordNumber = FixedColumn();
+    linkCount = FixedColumn();
+    fileSize = FixedColumn();
+    filename = StringColumn();
+    extension = DictionaryColumn();
+    filepath = StringColumn();
+    for (auto& column : times) {
+        column = FixedColumn();
+    }
+    attributeMask = FixedColumn();
+
+    int32_t zero = 0;
+    filename.offsets.resize(sizeof(zero));
+    std::memcpy(filename.offsets.data(), &zero, sizeof(zero));
+    filepath.offsets = filename.offsets;
+}
+
+template<typename T>
+void ArrowBatchBuilder::appendValue(FixedColumn& column, T value) {
+    size_t position = column.values.size();
+    column.values.resize(position + sizeof(T));
+    std::memcpy(column.values.data() + position, &value, sizeof(T));
+}
+
+void ArrowBatchBuilder::appendBit(FixedColumn& column, bool value) {
+    size_t row = column.validity.size();
+    column.validity.push_back(0);
+    if (column.values.size() * 8 <= row) {
+        column.values.push_back(0);
+    }
+    if (value) {
+        column.values[row / 8] |= static_cast<uint8_t>(1u << (row % 8));
+    }
+}
+
+void ArrowBatchBuilder::appendValidity(std::vector<uint8_t>& validity, int64_t& nullCount, size_t row, bool valid) {
+    if (validity.size() * 8 <= row) {
+        validity.push_back(0);
+    }
+    if (valid) {
+        validity[row / 8] |= static_cast<uint8_t>(1u << (row % 8));
+    } else {
+        nullCount++;
+    }
+}
+
+void ArrowBatchBuilder::appendString(StringColumn& column, const std::string& value, size_t row, bool valid) {
+    appendValidity(column.validity, column.nullCount, row, valid);
+    if (valid) {
+        column.data.insert(column.data.end(), value.begin(), value.end());
+    }
+    int32_t end = static_cast<int32_t>(column.data.size());
+    size_t position = column.offsets.size();
+    column.offsets.resize(position + sizeof(end));
+    std::memcpy(column.offsets.data() + position, &end, sizeof(end));
+}
+
+void ArrowBatchBuilder::appendDictionary(DictionaryColumn& column, const std::string& value, size_t row, bool valid) {
+    appendValidity(column.indices.validity, column.indices.nullCount, row, valid);
+    int32_t index = 0;
+    if (valid) {
+        auto it = column.lookup.find(value);
+        if (it == column.lookup.end()) {
+            index = static_cast<int32_t>(column.dictionary.size());
+            column.dictionary.push_back(value);
+            column.lookup.emplace(value, index);
+        } else {
+            index = it->second;
+        }
+    }
+    appendValue(column.indices, index);
+}
+
+void ArrowBatchBuilder::append(const MftRecord& record) {
+    size_t row = rowCount;
+
+    appendValue<uint64_t>(recordNumber, record.recordnum);
+    appendValue<uint16_t>(sequenceNumber, record.seq);
+    appendValue<uint16_t>(flags, record.flags);
+    appendBit(inUse, (record.flags & FILE_RECORD_IN_USE) != 0);
+    appendBit(isDirectory, (record.flags & FILE_RECORD_IS_DIRECTORY) != 0);
+    appendDictionary(fileType, record.getFileType(), row, true);
+    appendValue<uint64_t>(parentRecordNumber, record.getParentRecordNum());
+    appendValue<uint16_t>(linkCount, record.link);
+    appendValue<uint64_t>(fileSize, record.filesize);
+    appendString(filename, record.filename, row, !record.filename.empty());
+
+    std::string fileExtension;
+    size_t dot = record.filename.find_last_of('.');
+    if (!(record.flags & FILE_RECORD_IS_DIRECTORY) && dot != std::string::npos && dot + 1 < record.filename.size()) {
+        fileExtension = StringUtils::toLower(record.filename.substr(dot + 1));
+    }
+    appendDictionary(extension, fileExtension, row, !fileExtension.empty());
+    appendString(filepath, record.filepath, row, !record.filepath.empty());
+
+    const WindowsTime* recordTimes[8] = {
+        &record.siTimes.crtime, &record.siTimes.mtime, &record.siTimes.atime, &record.siTimes.ctime,
+        &record.fnTimes.crtime, &record.fnTimes.mtime, &record.fnTimes.atime, &record.fnTimes.ctime
+    };
+    for (int i = 0; i < 8; ++i) {
+        uint64_t filetime = (static_cast<uint64_t>(recordTimes[i]->high) << 32) | recordTimes[i]->low;
+        bool valid = filetime != 0;
+        appendValidity(times[i].validity, times[i].nullCount, row, valid);
+        int64_t micros = valid ? (static_cast<int64_t>(filetime - FILETIME_UNIX_EPOCH)) / 10 : 0;
+        appendValue<int64_t>(times[i], micros);
+    }
+
+    uint32_t mask = 0;
+    for (uint32_t type : record.attributeTypes) {
+        if ((type >> 4) < 32) {
+            mask |= 1u << (type >> 4);
+        }
+    }
+    appendValue<uint32_t>(attributeMask, mask);
+
+    rowCount++;
+}
+
+void ArrowBatchBuilder::finish(ArrowSchema* schema, ArrowArray* array) {
+    int64_t length = static_cast<int64_t>(rowCount);
+
+    std::vector<ArrowSchema*> childSchemas;
+    std::vector<ArrowArray*> childArrays;
+
+    auto addFixed = [&](const char* name, const char* format, FixedColumn& column, bool nullable) {
+        childSchemas.push_back(makeSchema(format, name, nullable));
+        std::vector<std::vector<uint8_t>> buffers;
+        buffers.push_back(std::move(column.validity));
+        buffers.push_back(std::move(column.values));
+        childArrays.push_back(makeArray(length, column.nullCount, std::move(buffers)));
+    };
+
+    auto addBoolean = [&](const char* name, FixedColumn& column) {
+        childSchemas.push_back(makeSchema("b", name, false));
+        std::vector<std::vector<uint8_t>> buffers;
+        buffers.push_back(std::vector<uint8_t>());
+        buffers.push_back(std::move(column.values));
+        childArrays.push_back(makeArray(length, 0, std::move(buffers)));
+    };
+
+    auto addString = [&](const char* name, StringColumn& column) {
+        childSchemas.push_back(makeSchema("u", name, true));
+        std::vector<std::vector<uint8_t>> buffers;
+        buffers.push_back(std::move(column.validity));
+        buffers.push_back(std::move(column.offsets));
+        buffers.push_back(std::move(column.data));
+        childArrays.push_back(makeArray(length, column.nullCount, std::move(buffers)));
+    };
+
+    auto addDictionary = [&](const char* name, DictionaryColumn& column) {
+        ArrowSchema* indexSchema = makeSchema("i", name, true);
+        indexSchema->dictionary = makeSchema("u", "", false);
+        static_cast<ExportedSchema*>(indexSchema->private_data)->dictionary = indexSchema->dictionary;
+        childSchemas.push_back(indexSchema);
+
+        std::vector<uint8_t> offsets(sizeof(int32_t) * (column.dictionary.size() + 1));
+        std::vector<uint8_t> data;
+        int32_t end = 0;
+        std::memcpy(offsets.data(), &end, sizeof(end));
+        for (size_t i = 0; i < column.dictionary.size(); ++i) {
+            data.insert(data.end(), column.dictionary[i].begin(), column.dictionary[i].end());
+            end = static_cast<int32_t>(data.size());
+            std::memcpy(offsets.data() + sizeof(int32_t) * (i + 1), &end, sizeof(end));
+        }
+        std::vector<std::vector<uint8_t>> dictionaryBuffers;
+        dictionaryBuffers.push_back(std::vector<uint8_t>());
+        dictionaryBuffers.push_back(std::move(offsets));
+        dictionaryBuffers.push_back(std::move(data));
+        ArrowArray* dictionaryArray = makeArray(static_cast<int64_t>(column.dictionary.size()), 0,
+                                                std::move(dictionaryBuffers));
+
+        std::vector<std::vector<uint8_t>> buffers;
+        buffers.push_back(std::move(column.indices.validity));
+        buffers.push_back(std::move(column.indices.values));
+        ArrowArray* indexArray = makeArray(length, column.indices.nullCount, std::move(buffers));
+        indexArray->dictionary = dictionaryArray;
+        static_cast<ExportedArray*>(indexArray->private_data)->dictionary = dictionaryArray;
+        childArrays.push_back(indexArray);
+    };
+
+    addFixed("record_number", "L", recordNumber, false);
+    addFixed("sequence_number", "S", sequenceNumber, false);
+    addFixed("flags", "S", flags, false);
+    addBoolean("in_use", inUse);
+    addBoolean("is_directory", isDirectory);
+    addDictionary("file_type", fileType);
+    addFixed("parent_record_number", "L", parentRecordNumber, false);
+    addFixed("link_count", "S", linkCount, false);
+    addFixed("file_size", "L", fileSize, false);
+    addString("filename", filename);
+    addDictionary("extension", extension);
+    addString("filepath", filepath);
+    for (int i = 0; i < 8; ++i) {
+        addFixed(TIME_COLUMN_NAMES[i], "tsu:UTC", times[i], true);
+    }
+    addFixed("attribute_mask", "I", attributeMask, false);
+
+    std::unique_ptr<ArrowSchema> root(makeSchema("+s", "", false));
+    auto* rootSchemaData = static_cast<ExportedSchema*>(root->private_data);
+    rootSchemaData->children = childSchemas;
+    root->n_children = static_cast<int64_t>(childSchemas.size());
+    root->children = rootSchemaData->children.data();
+    *schema = *root;
+
+    std::vector<std::vector<uint8_t>> rootBuffers;
+    rootBuffers.push_back(std::vector<uint8_t>());
+    std::unique_ptr<ArrowArray> rootArray(makeArray(length, 0, std::move(rootBuffers)));
+    auto* rootArrayData = static_cast<ExportedArray*>(rootArray->private_data);
+    rootArrayData->children = childArrays;
+    rootArray->n_children = static_cast<int64_t>(childArrays.size());
+    rootArray->children = rootArrayData->children.data();
+    *array = *rootArray;
+
+    reset();
+}
@@ -0,0 +1,342 @@
+#include "batchAnalyzer.h"
+#include "mftAnalyzer.h"
+#include "../utils/fsUtils.h"
+#include "../utils/stringUtils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+IoThrottle::IoThrottle(unsigned permits) : available(std::max(1u, permits)) {
+}
+
+void IoThrottle::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [this] { return available > 0; });
+    available--;
+}
+
+void IoThrottle::release() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        available++;
+    }
+    condition.notify_one();
+}
+
+BatchAnalyzer::BatchAnalyzer(const std::vector<std::string>& inputFiles, const std::string& outputDirectory,
+                             int debug, int verbosity, bool computeHashes,
+                             const std::string& exportFormat)
+    : inputFiles(inputFiles), outputDirectory(outputDirectory), debug(debug), verbosity(verbosity),
+      computeHashes(computeHashes), exportFormat(exportFormat),
+      maxConcurrency(std::max(1u, std::thread::hardware_concurrency())), maxConcurrentIo(0),
+      cancellation(std::make_shared<CancellationToken>()) {
+}
+
+void BatchAnalyzer::setMaxConcurrency(unsigned jobs) {
+    maxConcurrency = std::max(1u, jobs);
+}
+
+void BatchAnalyzer::setMaxConcurrentIo(unsigned ioLimit) {
+    maxConcurrentIo = ioLimit;
+}
+
+void BatchAnalyzer::setCancellationToken(std::shared_ptr<CancellationToken> token) {
+    cancellation = token ? std::move(token) : std::make_shared<CancellationToken>();
+}
+
+void BatchAnalyzer::log(const std::string& message, int level) const {
+    if (level <= debug || level <= verbosity) {
+        std::cout << message << std::endl;
+    }
+}
+
+std::vector<std::string> BatchAnalyzer::readInputList(const std::string& listFile) {
+    std::ifstream file(listFile);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open input list: " + listFile);
+    }
+
+    std::vector<std::string> inputs;
+    std::string line;
+    while (std::getline(file, line)) {
+        line = StringUtils::trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        inputs.push_back(line);
+    }
+    return inputs;
+}
+
+std::string BatchAnalyzer::getFormatExtension(const std::string& exportFormat) {
+    if (exportFormat == "excel") return "xlsx";
+    if (exportFormat == "sqlite") return "db";
+    if (exportFormat == "timeline") return "txt";
+    if (exportFormat == "tsk") return "body";
+    return exportFormat;
+}
+
+void BatchAnalyzer::assignOutputFiles() {
+    std::unordered_map<std::string, int> nameCounts;
+    std::string extension = getFormatExtension(exportFormat);
+    if (compression.enabled()) {
+        extension += std::string(".") + compression.extension();
+    }
+
+    results.clear();
+    results.reserve(inputFiles.size());
+
+    for (const auto& input : inputFiles) {
+        BatchJobResult job;
+        job.inputFile = input;
+        job.inputSize = FileSystemUtils::getFileSize(input);
+
+        // Collected MFTs are usually all called "$MFT"; keep outputs distinct
+        std::string base = StringUtils::sanitizeFilename(FileSystemUtils::getBasename(input));
+        int count = ++nameCounts[base];
+        if (count > 1) {
+            base += "_" + std::to_string(count);
+        }
+        job.outputFile = FileSystemUtils::joinPath(outputDirectory, base + "." + extension);
+
+        results.push_back(job);
+    }
+}
+
+bool BatchAnalyzer::analyze() {
+    if (!FileSystemUtils::createDirectories(outputDirectory)) {
+        log("Error: Cannot create output directory: " + outputDirectory, 0);
+        return false;
+    }
+
+    assignOutputFiles();
+
+    if (maxConcurrentIo > 0) {
+        ioThrottle = std::make_shared<IoThrottle>(maxConcurrentIo);
+    }
+
+    // Largest inputs first so a big MFT never ends up as the lone straggler
+    std::vector<size_t> schedule(results.size());
+    for (size_t i = 0; i < schedule.size(); ++i) {
+        schedule[i] = i;
+    }
+    std::stable_sort(schedule.begin(), schedule.end(), [this](size_t a, size_t b) {
+        return results[a].inputSize > results[b].inputSize;
+    });
+
+    unfinishedBytes = 0;
+    for (const auto& job : results) {
+        unfinishedBytes += job.inputSize;
+    }
+    freeThreads = maxConcurrency;
+
+    unsigned workerCount = static_cast<unsigned>(std::min<size_t>(maxConcurrency, schedule.size()));
+    log("Analyzing " + std::to_string(results.size()) + " MFT files with " +
+        std::to_string(workerCount) + " workers", 0);
+
+    nextJob = 0;
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&BatchAnalyzer::workerLoop, this, std::cref(schedule));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    return std::all_of(results.begin(), results.end(), [](const BatchJobResult& job) {
+        return job.status == "ok";
+    });
+}
+
+void BatchAnalyzer::workerLoop(const std::vector<size_t>& schedule) {
+    while (true) {
+        size_t index = nextJob.fetch_add(1);
+        if (index >= schedule.size()) {
+            break;
+        }
+
+        BatchJobResult& job = results[schedule[index]];
+        if (cancellation->isCancelled()) {
+            job.status = "cancelled";
+        } else {
+            unsigned threads = takeThreads(job);
+            runJob(job, threads);
+            returnThreads(threads);
+        }
+        unfinishedBytes -= job.inputSize;
+    }
+}
+
+// A job asks for the share of maxConcurrency its input is of the bytes still
+// to be analyzed, and gets as much of that as the jobs already running have
+// left free, waiting for at least one thread. One large MFT takes every
+// thread and many small ones take one each, and the jobs running at once
+// never hold more than maxConcurrency between them.
+unsigned BatchAnalyzer::takeThreads(const BatchJobResult& job) {
+    unsigned wanted = 1;
+    uint64_t remaining = unfinishedBytes.load();
+    if (remaining > 0) {
+        double share = static_cast<double>(job.inputSize) / static_cast<double>(remaining);
+        wanted = std::max(1u, std::min(maxConcurrency, static_cast<unsigned>(maxConcurrency * share + 0.5)));
+    }
+
+    std::unique_lock<std::mutex> lock(threadsMutex);
+    threadsFreed.wait(lock, [this] { return freeThreads > 0; });
+    unsigned taken = std::min(wanted, freeThreads);
+    freeThreads -= taken;
+    return taken;
+}
+
+void BatchAnalyzer::returnThreads(unsigned threads) {
+    {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        freeThreads += threads;
+    }
+    threadsFreed.notify_all();
+}
+
+void BatchAnalyzer::runJob(BatchJobResult& job, unsigned threads) {
+    auto start = std::chrono::steady_clock::now();
+    log("Starting analysis of " + job.inputFile + " on " + std::to_string(threads) + " threads", 1);
+
+    if (!FileSystemUtils::isReadable(job.inputFile)) {
+        job.status = "failed";
+        job.error = "Cannot read input file";
+        return;
+    }
+
+    try {
+        MftAnalyzer analyzer(job.inputFile, job.outputFile, debug, verbosity, computeHashes, exportFormat);
+        analyzer.setThreadCount(threads);
+        analyzer.setIoThrottle(ioThrottle);
+        analyzer.setCancellationToken(cancellation);
+        analyzer.setParquetRowGroupSize(parquetRowGroupSize);
+        analyzer.setSortMemory(sortMemory);
+        analyzer.setMacbCollapse(macbCollapse);
+        analyzer.setRecordFilter(where);
+        analyzer.setParsePlan(plan);
+        analyzer.setCompression(compression);
+        analyzer.setSplit(split);
+
+        bool success = analyzer.analyze();
+
+        const AnalysisStats& stats = analyzer.getStatistics();
+        job.totalRecords = stats.totalRecords.load();
+        job.activeRecords = stats.activeRecords.load();
+        job.directories = stats.directories.load();
+        job.files = stats.files.load();
+
+        if (analyzer.isInterrupted()) {
+            job.status = "cancelled";
+        } else if (success) {
+            job.status = "ok";
+        } else {
+            job.status = "failed";
+            job.error = "Analysis failed";
+        }
+    } catch (const std::exception& e) {
+        job.status = "failed";
+        job.error = e.what();
+    }
+
+    job.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    log("Finished " + job.inputFile + " (" + job.status + ")", 0);
+}
+
+static std::string escapeManifestString(const std::string& str) {
+    std::string escaped;
+    for (char c : str) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 32) {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned char>(c));
+                    escaped += buffer;
+                } else {
+                    escaped += c;
+                }
+                break;
+        }
+    }
+    return escaped;
+}
+
+bool BatchAnalyzer::writeManifest(const std::string& manifestFile) const {
+    std::ofstream file(manifestFile);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    size_t succeeded = std::count_if(results.begin(), results.end(), [](const BatchJobResult& job) {
+        return job.status == "ok";
+    });
+
+    file << "{\n";
+    file << "  \"exportFormat\": \"" << escapeManifestString(exportFormat) << "\",\n";
+    file << "  \"inputs\": " << results.size() << ",\n";
+    file << "  \"succeeded\": " << succeeded << ",\n";
+    file << "  \"failed\": " << (results.size() - succeeded) << ",\n";
+    file << "  \"jobs\": [";
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BatchJobResult& job = results[i];
+        file << (i == 0 ? "\n" : ",\n");
+        file << "    {\n";
+        file << "      \"input\": \"" << escapeManifestString(job.inputFile) << "\",\n";
+        file << "      \"output\": \"" << escapeManifestString(job.outputFile) << "\",\n";
+        file << "      \"status\": \"" << job.status << "\",\n";
+        if (!job.error.empty()) {
+            file << "      \"error\": \"" << escapeManifestString(job.error) << "\",\n";
+        }
+        file << "      \"inputSize\": " << job.inputSize << ",\n";
+        file << "      \"totalRecords\": " << job.totalRecords << ",\n";
+        file << "      \"activeRecords\": " << job.activeRecords << ",\n";
+        file << "      \"directories\": " << job.directories << ",\n";
+        file << "      \"files\": " << job.files << ",\n";
+        file << "      \"elapsedSeconds\": " << std::fixed << std::setprecision(3) << job.elapsedSeconds << "\n";
+        file << "    }";
+    }
+
+    file << (results.empty() ? "]\n" : "\n  ]\n");
+    file << "}\n";
+    return file.good();
+}
+
+void BatchAnalyzer::printSummary() const {
+    uint64_t totalRecords = 0;
+    size_t succeeded = 0;
+    for (const auto& job : results) {
+        totalRecords += job.totalRecords;
+        if (job.status == "ok") {
+            succeeded++;
+        }
+    }
+
+    std::cout << "\nBatch Analysis Summary:" << std::endl;
+    std::cout << "Inputs: " << results.size() << std::endl;
+    std::cout << "Succeeded: " << succeeded << std::endl;
+    std::cout << "Failed or cancelled: " << (results.size() - succeeded) << std::endl;
+    std::cout << "Total records processed: " << totalRecords << std::endl;
+
+    for (const auto& job : results) {
+        if (job.status != "ok") {
+            std::cout << "  " << job.status << ": " << job.inputFile;
+            if (!job.error.empty()) {
+                std::cout << " (" << job.error << ")";
+            }
+            std::cout << std::endl;
+        }
+    }
+}
@@ -1,7 +1,107 @@
-#include "../../include/canalyemft.h"
-#include "../src/core/mftAnalyzer.h"
+#include "../../include/canalyzemft.h"
+#include "mftAnalyzer.h"
+#include "mftReader.h"
+#include "arrowExport.h"
+#include "../utils/shmRing.h"
+#include <cstring>
 #include <memory>
 #include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t DEFAULT_BATCH_RECORDS = 1024;
+
+thread_local std::string lastOpenError;
+
+uint64_t toFiletime(const WindowsTime& time) {
+    return (static_cast<uint64_t>(time.high) << 32) | time.low;
+}
+
+const char* borrow(const std::string& value) {
+    return value.empty() ? nullptr : value.c_str();
+}
+
+}
+
+static_assert(MFT_FIELD_NAMES == READER_FIELD_NAMES && MFT_FIELD_PATHS == READER_FIELD_PATHS &&
+              MFT_FIELD_SI_TIMES == READER_FIELD_SI_TIMES && MFT_FIELD_FN_TIMES == READER_FIELD_FN_TIMES &&
+              MFT_FIELD_OBJECT_IDS == READER_FIELD_OBJECT_IDS && MFT_FIELD_HASHES == READER_FIELD_HASHES,
+              "C API field flags must match the reader's");
+
+struct MftHandle {
+    uint32_t fields = MFT_FIELD_DEFAULT;
+
+    MftReader reader;
+    RecordBatch batch;
+    std::vector<MftRecordInfo> infos;
+    std::string lastError;
+
+    bool open(MftReaderOptions options) {
+        options.fields = fields;
+        options.batchSize = DEFAULT_BATCH_RECORDS;
+        if (!reader.open(options)) {
+            lastOpenError = reader.getLastError();
+            return false;
+        }
+        return true;
+    }
+
+    void fillInfo(const MftRecord& record, MftRecordInfo& info) const {
+        std::memset(&info, 0, sizeof(info));
+
+        info.recordNumber = record.recordnum;
+        info.parentRecordNumber = record.getParentRecordNum();
+        info.baseReference = record.baseRef;
+        info.logSequenceNumber = record.lsn;
+        info.fileSize = record.filesize;
+        info.sequenceNumber = record.seq;
+        info.flags = record.flags;
+        info.linkCount = record.link;
+        info.validSignature = record.magic == MFT_RECORD_MAGIC ? 1 : 0;
+
+        for (uint32_t type : record.attributeTypes) {
+            if ((type >> 4) < 32) {
+                info.attributeMask |= 1u << (type >> 4);
+            }
+        }
+
+        if (fields & MFT_FIELD_SI_TIMES) {
+            info.siCreationTime = toFiletime(record.siTimes.crtime);
+            info.siModificationTime = toFiletime(record.siTimes.mtime);
+            info.siAccessTime = toFiletime(record.siTimes.atime);
+            info.siEntryTime = toFiletime(record.siTimes.ctime);
+        }
+        if (fields & MFT_FIELD_FN_TIMES) {
+            info.fnCreationTime = toFiletime(record.fnTimes.crtime);
+            info.fnModificationTime = toFiletime(record.fnTimes.mtime);
+            info.fnAccessTime = toFiletime(record.fnTimes.atime);
+            info.fnEntryTime = toFiletime(record.fnTimes.ctime);
+        }
+        if (fields & MFT_FIELD_NAMES) {
+            info.filename = borrow(record.filename);
+        }
+        if (fields & MFT_FIELD_PATHS) {
+            info.filepath = borrow(record.filepath);
+        }
+        if (fields & MFT_FIELD_OBJECT_IDS) {
+            info.objectId = borrow(record.objectId);
+            info.birthVolumeId = borrow(record.birthVolumeId);
+            info.birthObjectId = borrow(record.birthObjectId);
+            info.birthDomainId = borrow(record.birthDomainId);
+        }
+        if (fields & MFT_FIELD_HASHES) {
+            info.md5 = borrow(record.md5);
+            info.sha256 = borrow(record.sha256);
+            info.sha512 = borrow(record.sha512);
+            info.crc32 = borrow(record.crc32);
+        }
+    }
+};
+
+struct MftRing {
+    ShmRingReader reader;
+};
 
 extern "C" {
 
@@ -9,7 +109,7 @@ int analyzeMft(const AnalyzeOptions* options) {
     if (!options) {
         return -1;
     }
-    
+
     try {
         std::unique_ptr<MftAnalyzer> analyzer = std::make_unique<MftAnalyzer>(
             options->inputFile ? options->inputFile : "",
@@ -19,7 +119,7 @@ int analyzeMft(const AnalyzeOptions* options) {
             options->computeHashes != 0,
             options->exportFormat ? options->exportFormat : "csv"
         );
-        
+
         if (analyzer->analyze()) {
             analyzer->printStatistics();
             return 0;
@@ -31,12 +131,183 @@ int analyzeMft(const AnalyzeOptions* options) {
     }
 }
 
+int analyzeMftToArrow(const AnalyzeOptions* options, struct ArrowSchema* schema, struct ArrowArray* array) {
+    if (!options || !options->inputFile || !schema || !array) {
+        return -1;
+    }
+
+    try {
+        MftAnalyzer analyzer(options->inputFile, "", options->debug, options->verbosity,
+                             options->computeHashes != 0, "arrow");
+        return analyzer.exportArrow(schema, array) ? 0 : -1;
+    } catch (const std::exception& e) {
+        return -1;
+    }
+}
+
 const char* getVersion() {
     return ANALYZEMFT_VERSION_STRING;
 }
 
 const char* getSupportedFormats() {
-    return "csv,json,xml,excel,sqlite,body,timeline,tsk";
+    return "csv,json,jsonl,xml,excel,sqlite,body,timeline,tsk,parquet,amft";
 }
 
-}
\ No newline at end of file
+MftHandle* mftOpenFile(const char* path, uint32_t fields) {
+    if (!path) {
+        lastOpenError = "No input path given";
+        return nullptr;
+    }
+
+    try {
+        auto handle = std::make_unique<MftHandle>();
+        handle->fields = fields;
+
+        MftReaderOptions options;
+        options.inputFile = path;
+        return handle->open(options) ? handle.release() : nullptr;
+    } catch (const std::exception& e) {
+        lastOpenError = e.what();
+        return nullptr;
+    }
+}
+
+MftHandle* mftOpenBuffer(const void* data, size_t size, uint32_t fields) {
+    if (!data && size > 0) {
+        lastOpenError = "No input buffer given";
+        return nullptr;
+    }
+
+    try {
+        auto handle = std::make_unique<MftHandle>();
+        handle->fields = fields;
+
+        // A non-null pointer keeps an empty buffer from being taken for a file source
+        static const uint8_t emptyBuffer = 0;
+        MftReaderOptions options;
+        options.buffer = data ? static_cast<const uint8_t*>(data) : &emptyBuffer;
+        options.bufferSize = size;
+        return handle->open(options) ? handle.release() : nullptr;
+    } catch (const std::exception& e) {
+        lastOpenError = e.what();
+        return nullptr;
+    }
+}
+
+int mftNextBatch(MftHandle* handle, size_t maxRecords, const MftRecordInfo** records, size_t* count) {
+    if (!handle || !records || !count) {
+        return -1;
+    }
+
+    *records = nullptr;
+    *count = 0;
+
+    try {
+        handle->infos.clear();
+        handle->reader.setBatchSize(maxRecords > 0 ? maxRecords : DEFAULT_BATCH_RECORDS);
+        if (!handle->reader.nextBatch(handle->batch)) {
+            if (!handle->reader.getLastError().empty()) {
+                handle->lastError = handle->reader.getLastError();
+                return -1;
+            }
+            return 0;
+        }
+
+        handle->infos.resize(handle->batch.size());
+        for (size_t i = 0; i < handle->batch.size(); ++i) {
+            handle->fillInfo(*handle->batch.records[i], handle->infos[i]);
+        }
+
+        *records = handle->infos.data();
+        *count = handle->infos.size();
+        return 1;
+    } catch (const std::exception& e) {
+        handle->lastError = e.what();
+        return -1;
+    }
+}
+
+int mftNextArrowBatch(MftHandle* handle, size_t maxRecords, struct ArrowSchema* schema, struct ArrowArray* array) {
+    if (!handle || !schema || !array) {
+        return -1;
+    }
+
+    try {
+        handle->reader.setBatchSize(maxRecords > 0 ? maxRecords : DEFAULT_BATCH_RECORDS);
+        if (!handle->reader.nextBatch(handle->batch)) {
+            if (!handle->reader.getLastError().empty()) {
+                handle->lastError = handle->reader.getLastError();
+                return -1;
+            }
+            return 0;
+        }
+
+        ArrowBatchBuilder builder;
+        for (const auto& record : handle->batch.records) {
+            builder.append(*record);
+        }
+        builder.finish(schema, array);
+        return 1;
+    } catch (const std::exception& e) {
+        handle->lastError = e.what();
+        return -1;
+    }
+}
+const char* mftLastError(const MftHandle* handle) {
+    if (!handle) {
+        return lastOpenError.c_str();
+    }
+    return handle->lastError.c_str();
+}
+
+void mftClose(MftHandle* handle) {
+    delete handle;
+}
+
+MftRing* mftRingOpen(const char* name, unsigned timeoutMs) {
+    if (!name) {
+        lastOpenError = "No ring name given";
+        return nullptr;
+    }
+
+    try {
+        auto ring = std::make_unique<MftRing>();
+        if (!ring->reader.open(name, timeoutMs)) {
+            lastOpenError = ring->reader.getLastError();
+            return nullptr;
+        }
+        return ring.release();
+    } catch (const std::exception& e) {
+        lastOpenError = e.what();
+        return nullptr;
+    }
+}
+
+int mftRingNext(MftRing* ring, const void** data, size_t* size) {
+    if (!ring || !data || !size) {
+        return -1;
+    }
+
+    std::string_view message;
+    if (!ring->reader.next(message)) {
+        *data = nullptr;
+        *size = 0;
+        return ring->reader.hasFailed() ? -1 : 0;
+    }
+    *data = message.data();
+    *size = message.size();
+    return 1;
+}
+
+const char* mftRingLastError(const MftRing* ring) {
+    if (!ring) {
+        return lastOpenError.c_str();
+    }
+    return ring->reader.getLastError().c_str();
+}
+
+void mftRingClose(MftRing* ring) {
+    delete ring;
+}
+
+}
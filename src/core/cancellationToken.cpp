@@ -0,0 +1,32 @@
+#include "cancellationToken.h"
+
+CancellationToken::CancellationToken() : cancelled(false), deadlineTicks(NO_DEADLINE) {
+}
+
+void CancellationToken::cancel() {
+    cancelled.store(true, std::memory_order_relaxed);
+}
+
+bool CancellationToken::isCancelled() const {
+    return cancelled.load(std::memory_order_relaxed) || isDeadlineExceeded();
+}
+
+bool CancellationToken::isDeadlineExceeded() const {
+    int64_t deadline = deadlineTicks.load(std::memory_order_relaxed);
+    if (deadline == NO_DEADLINE) {
+        return false;
+    }
+    return Clock::now().time_since_epoch().count() >= deadline;
+}
+
+void CancellationToken::setDeadline(Clock::time_point deadline) {
+    deadlineTicks.store(deadline.time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+void CancellationToken::setTimeout(std::chrono::milliseconds timeout) {
+    setDeadline(Clock::now() + timeout);
+}
+
+void CancellationToken::clearDeadline() {
+    deadlineTicks.store(NO_DEADLINE, std::memory_order_relaxed);
+}
@@ -1,46 +1,134 @@
 #include "mftAnalyzer.h"
+#include "arrowExport.h"
+#include "snapshot.h"
 #include "../writers/csvWriter.h"
 #include "../writers/jsonWriter.h"
+#include "../writers/jsonlWriter.h"
 #include "../writers/xmlWriter.h"
 #include "../writers/excelWriter.h"
 #include "../writers/sqliteWriter.h"
 #include "../writers/bodyWriter.h"
 #include "../writers/timelineWriter.h"
+#include "../writers/parquetWriter.h"
 #include "../utils/logger.h"
+#include "../utils/fsUtils.h"
+#include "../utils/stringUtils.h"
+#include "../utils/hashCalc.h"
 #include "constants.h"
-#include <csignal>
+#include "../../include/version.h"
 #include <iostream>
 #include <algorithm>
 #include <thread>
 #include <chrono>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
 
-MftAnalyzer* MftAnalyzer::currentInstance = nullptr;
+namespace {
+
+// Batches an output's thread may fall behind the reader
+constexpr size_t MAX_QUEUED_BATCHES = 8;
+
+// Part `index` of a split output: mft.csv.zst -> mft.00001.csv.zst
+std::string partFile(const std::string& path, size_t index) {
+   size_t name = path.find_last_of("/\\");
+   name = name == std::string::npos ? 0 : name + 1;
+   size_t extension = path.rfind('.');
+   if (extension != std::string::npos && extension > name) {
+       // A compression suffix stays with the format's extension
+       std::string last = path.substr(extension + 1);
+       size_t previous = path.rfind('.', extension - 1);
+       if ((last == "zst" || last == "gz") && previous != std::string::npos && previous > name) {
+           extension = previous;
+       }
+   } else {
+       extension = path.size();
+   }
+   char number[24];
+   std::snprintf(number, sizeof(number), ".%05zu", index);
+   return path.substr(0, extension) + number + path.substr(extension);
+}
+
+// The current time in UTC as ISO 8601, e.g. 2024-03-01T12:00:00Z
+std::string utcNow() {
+   auto seconds = std::chrono::duration_cast<std::chrono::seconds>(
+       std::chrono::system_clock::now().time_since_epoch()).count();
+   uint64_t filetime = (static_cast<uint64_t>(seconds) + 11644473600ULL) * 10000000ULL;
+   return WindowsTime(static_cast<uint32_t>(filetime), static_cast<uint32_t>(filetime >> 32)).getDateTimeString();
+}
+
+}
+
+// Batches handed from the reader to one output's thread
+struct MftAnalyzer::BatchQueue {
+   std::mutex mutex;
+   std::condition_variable changed;
+   std::deque<std::shared_ptr<const RecordBatch>> batches;
+   bool closed = false;
+   bool failed = false;
+   
+   // Blocks while the output is MAX_QUEUED_BATCHES behind; false once it failed
+   bool push(std::shared_ptr<const RecordBatch> batch) {
+       std::unique_lock<std::mutex> lock(mutex);
+       changed.wait(lock, [&] { return batches.size() < MAX_QUEUED_BATCHES || failed; });
+       if (failed) {
+           return false;
+       }
+       batches.push_back(std::move(batch));
+       changed.notify_all();
+       return true;
+   }
+   
+   // Null once the queue is closed and drained
+   std::shared_ptr<const RecordBatch> pop() {
+       std::unique_lock<std::mutex> lock(mutex);
+       changed.wait(lock, [&] { return !batches.empty() || closed; });
+       if (batches.empty()) {
+           return nullptr;
+       }
+       std::shared_ptr<const RecordBatch> batch = std::move(batches.front());
+       batches.pop_front();
+       changed.notify_all();
+       return batch;
+   }
+   
+   void close() {
+       std::lock_guard<std::mutex> lock(mutex);
+       closed = true;
+       changed.notify_all();
+   }
+   
+   void fail() {
+       std::lock_guard<std::mutex> lock(mutex);
+       failed = true;
+       batches.clear();
+       changed.notify_all();
+   }
+};
 
 MftAnalyzer::MftAnalyzer(const std::string& mftFile, const std::string& outputFile,
                         int debug, int verbosity, bool computeHashes, 
                         const std::string& exportFormat)
    : mftFile(mftFile), outputFile(outputFile), debug(debug), verbosity(verbosity),
-     computeHashes(computeHashes), exportFormat(exportFormat) {
-   
-   currentInstance = this;
-   setupInterruptHandler();
+     computeHashes(computeHashes), exportFormat(exportFormat),
+     cancellation(std::make_shared<CancellationToken>()) {
+   addOutput(exportFormat, outputFile);
 }
 
 MftAnalyzer::~MftAnalyzer() {
    cleanup();
-   currentInstance = nullptr;
 }
 
-void MftAnalyzer::setupInterruptHandler() {
-   std::signal(SIGINT, signalHandler);
-   std::signal(SIGTERM, signalHandler);
+void MftAnalyzer::addOutput(const std::string& exportFormat, const std::string& outputFile) {
+   outputs.emplace_back();
+   outputs.back().format = exportFormat;
+   outputs.back().path = outputFile;
+   outputs.back().file = outputFile;
 }
 
-void MftAnalyzer::signalHandler(int signal) {
-   if (currentInstance) {
-       currentInstance->log("Interrupt received. Cleaning up...", 1);
-       currentInstance->setInterruptFlag();
-   }
+void MftAnalyzer::setCancellationToken(std::shared_ptr<CancellationToken> token) {
+   cancellation = token ? std::move(token) : std::make_shared<CancellationToken>();
 }
 
 void MftAnalyzer::log(const std::string& message, int level) const {
@@ -52,10 +140,15 @@ void MftAnalyzer::log(const std::string& message, int level) const {
 bool MftAnalyzer::analyze() {
    try {
        log("Starting MFT analysis...", 1);
+       startTime = utcNow();
        
-       if (!initializeCsvWriter()) {
-           log("Failed to initialize CSV writer", 0);
-           return false;
+       for (auto& output : outputs) {
+           if (split.enabled()) {
+               startPart(output);
+           }
+           if (!initializeOutput(output)) {
+               return false;
+           }
        }
        
        if (!processMft()) {
@@ -68,6 +161,10 @@ bool MftAnalyzer::analyze() {
            return false;
        }
        
+       if (!evidenceFile.empty() && !writeEvidenceManifest()) {
+           return false;
+       }
+       
        return true;
    } catch (const std::exception& e) {
        log("An unexpected error occurred: " + std::string(e.what()), 0);
@@ -75,139 +172,539 @@ bool MftAnalyzer::analyze() {
    }
 }
 
-bool MftAnalyzer::processMft() {
-   log("Processing MFT file: " + mftFile, 1);
+void MftAnalyzer::setParsePlan(std::shared_ptr<const ParsePlan> plan) {
+   // With --fields, hashes are computed exactly when a hash column is selected
+   if (plan && plan->isProjected()) {
+       computeHashes = plan->needsHashes();
+   }
+   this->plan = std::move(plan);
+}
+
+MftReaderOptions MftAnalyzer::makeReaderOptions() const {
+   MftReaderOptions options;
+   options.inputFile = mftFile;
+   options.threads = threadCount;
+   options.fields = READER_FIELD_ALL;
+   if (!computeHashes) {
+       options.fields &= ~READER_FIELD_HASHES;
+   }
+   auto allOutputs = [&](bool (*accepts)(const std::string&)) {
+       return std::all_of(outputs.begin(), outputs.end(),
+                          [&](const Output& output) { return accepts(output.format); });
+   };
+   // A projected plan only applies when every output can be projected
+   if (plan && allOutputs(supportsFieldSelection)) {
+       if (!plan->needsPaths()) {
+           options.fields &= ~READER_FIELD_PATHS;
+       }
+       options.plan = plan;
+   }
+   // Body and timeline lines only read fileName() and standardInformation(),
+   // which decode on demand
+   if (!plan && allOutputs([](const std::string& format) { return format == "body" || format == "timeline"; })) {
+       static const auto timelinePlan = std::make_shared<const ParsePlan>(ParsePlan::attributesOnly(0));
+       options.plan = timelinePlan;
+       options.fields &= ~READER_FIELD_PATHS;
+   }
+   options.debug = debug;
+   options.keepRawRecords = std::any_of(outputs.begin(), outputs.end(),
+                                        [](const Output& output) { return output.format == "amft"; });
+   // Output threads read the same records at once
+   options.sharedRecords = outputs.size() > 1;
+   options.cancellation = cancellation;
+   options.ioThrottle = ioThrottle;
+   options.where = where;
+   options.hashInput = !evidenceFile.empty();
+   return options;
+}
+
+const std::vector<size_t>& MftAnalyzer::csvColumns() const {
+   static const ParsePlan fullPlan;
+   return plan ? plan->getColumns() : fullPlan.getColumns();
+}
+
+void MftAnalyzer::updateStatistics(const MftRecord& record) {
+   stats.totalRecords++;
+   
+   if (record.flags & FILE_RECORD_IN_USE) {
+       stats.activeRecords++;
+   }
+   if (record.flags & FILE_RECORD_IS_DIRECTORY) {
+       stats.directories++;
+   } else {
+       stats.files++;
+   }
    
-   std::ifstream file(mftFile, std::ios::binary);
-   if (!file.is_open()) {
-       log("Error: Cannot open MFT file: " + mftFile, 0);
+   if (computeHashes) {
+       stats.uniqueMd5.insert(record.md5);
+       stats.uniqueSha256.insert(record.sha256);
+       stats.uniqueSha512.insert(record.sha512);
+       stats.uniqueCrc32.insert(record.crc32);
+   }
+}
+
+bool MftAnalyzer::exportArrow(struct ArrowSchema* schema, struct ArrowArray* array) {
+   if (!schema || !array) {
+       return false;
+   }
+   
+   MftReader reader;
+   if (!reader.open(makeReaderOptions())) {
+       log("Error: " + reader.getLastError(), 0);
        return false;
    }
    
    try {
-       while (!interruptFlag.load()) {
-           std::vector<uint8_t> rawRecord = readRecord(file);
-           if (rawRecord.empty()) {
-               break;
+       ArrowBatchBuilder builder;
+       RecordBatch batch;
+       while (reader.nextBatch(batch)) {
+           for (const auto& record : batch.records) {
+               updateStatistics(*record);
+               builder.append(*record);
            }
-           
-           try {
-               log("Processing record " + std::to_string(stats.totalRecords.load()), 2);
-               
-               auto record = std::make_unique<MftRecord>(rawRecord, computeHashes, debug);
-               
-               stats.totalRecords++;
-               
-               if (record->flags & FILE_RECORD_IN_USE) {
-                   stats.activeRecords++;
-               }
-               if (record->flags & FILE_RECORD_IS_DIRECTORY) {
-                   stats.directories++;
-               } else {
-                   stats.files++;
-               }
-               
-               uint32_t recordNum = record->recordnum;
-               mftRecords[recordNum] = std::move(record);
-               
-               if (debug >= 2) {
-                   log("Processed record " + std::to_string(stats.totalRecords.load()) + 
-                       ": " + mftRecords[recordNum]->filename, 2);
-               } else if (stats.totalRecords.load() % 10000 == 0) {
-                   log("Processed " + std::to_string(stats.totalRecords.load()) + " records...", 1);
-               }
-               
-               if (stats.totalRecords.load() % 1000 == 0) {
-                   if (!writeCsvBlock()) {
-                       log("Failed to write CSV block", 1);
-                       return false;
+       }
+       
+       if (cancellation->isCancelled()) {
+           log("Arrow export cancelled", 1);
+           return false;
+       }
+       
+       builder.finish(schema, array);
+       log("Exported " + std::to_string(stats.totalRecords.load()) + " records to Arrow", 1);
+       return true;
+   } catch (const std::exception& e) {
+       log("Error exporting Arrow batch: " + std::string(e.what()), 0);
+       return false;
+   }
+}
+
+bool MftAnalyzer::processMft() {
+   log("Processing MFT file: " + mftFile, 1);
+   
+   // With several outputs each is written on its own thread from the same
+   // batches, so the parse runs once and the slowest writer sets the pace.
+   // Split outputs get a thread too, so closing a part overlaps parsing.
+   std::vector<std::unique_ptr<BatchQueue>> queues;
+   std::vector<std::thread> writers;
+   if (outputs.size() > 1 || split.enabled()) {
+       for (auto& output : outputs) {
+           queues.push_back(std::make_unique<BatchQueue>());
+           writers.emplace_back([this, &output, &queue = *queues.back()] {
+               while (auto batch = queue.pop()) {
+                   if (!writeBlock(output, batch)) {
+                       queue.fail();
+                       break;
                    }
-                   mftRecords.clear();
                }
-               
-               if (interruptFlag.load()) {
-                   log("Interrupt detected. Stopping processing.", 1);
-                   break;
-               }
-               
-           } catch (const std::exception& e) {
-               log("Error processing record " + std::to_string(stats.totalRecords.load()) + 
-                   ": " + e.what(), 1);
-               continue;
+           });
+       }
+   }
+   
+   bool ok = true;
+   MftReader reader;
+   for (auto& parsed : reader.batches(makeReaderOptions())) {
+       auto batch = std::make_shared<const RecordBatch>(std::move(parsed));
+       for (const auto& record : batch->records) {
+           updateStatistics(*record);
+           if (debug >= 2) {
+               log("Processed record " + std::to_string(record->recordnum) + ": " + record->filename, 2);
            }
        }
        
-   } catch (const std::exception& e) {
-       log("Error reading MFT file: " + std::string(e.what()), 0);
+       if (stats.totalRecords.load() / 10000 != (stats.totalRecords.load() - batch->size()) / 10000) {
+           log("Processed " + std::to_string(stats.totalRecords.load()) + " records...", 1);
+       }
+       
+       if (queues.empty()) {
+           ok = writeBlock(outputs.front(), batch);
+       } else {
+           for (auto& queue : queues) {
+               ok = queue->push(batch) && ok;
+           }
+       }
+       if (!ok) {
+           break;
+       }
+   }
+   
+   for (auto& queue : queues) {
+       queue->close();
+   }
+   for (auto& writer : writers) {
+       writer.join();
+   }
+   // A writer that fails on the last batches leaves nothing for push() to
+   // refuse, so each queue is asked once the threads are done
+   for (size_t i = 0; i < queues.size(); ++i) {
+       if (queues[i]->failed) {
+           log("Error: writing " + outputs[i].format + " output " + outputs[i].path + " failed", 0);
+           ok = false;
+       }
+   }
+   if (!ok) {
        return false;
    }
+   inputSha256 = reader.getInputSha256();
+   inputBytes = reader.getInputSize();
+   
+   if (!reader.getLastError().empty()) {
+       log("Error: " + reader.getLastError(), 0);
+       return false;
+   }
+   
+   if (cancellation->isCancelled()) {
+       log(cancellation->isDeadlineExceeded()
+           ? "Deadline exceeded. Stopping processing."
+           : "Interrupt detected. Stopping processing.", 1);
+   }
+   
+   if (reader.getParseErrors() > 0) {
+       log("Skipped " + std::to_string(reader.getParseErrors()) + " unparseable records", 1);
+   }
    
-   file.close();
    log("MFT processing complete. Total records processed: " + 
        std::to_string(stats.totalRecords.load()), 0);
    
    return true;
 }
 
-std::vector<uint8_t> MftAnalyzer::readRecord(std::ifstream& file) {
-   std::vector<uint8_t> record(MFT_RECORD_SIZE);
-   file.read(reinterpret_cast<char*>(record.data()), MFT_RECORD_SIZE);
+bool MftAnalyzer::initializeOutput(Output& output) {
+   if (!initializeCsvWriter(output)) {
+       log("Failed to initialize CSV writer", 0);
+       return false;
+   }
    
-   if (file.gcount() != MFT_RECORD_SIZE) {
-       return {};
+   if (!initializeJsonlWriter(output)) {
+       log("Failed to initialize JSONL writer", 0);
+       return false;
    }
    
-   return record;
+   if (!initializeParquetWriter(output)) {
+       log("Failed to initialize Parquet writer", 0);
+       return false;
+   }
+   
+   if (!initializeSqliteWriter(output)) {
+       log("Failed to initialize SQLite writer", 0);
+       return false;
+   }
+   
+   if (!initializeExcelWriter(output)) {
+       log("Failed to initialize Excel writer", 0);
+       return false;
+   }
+   
+   if (!initializeSnapshotWriter(output)) {
+       log("Failed to initialize snapshot writer", 0);
+       return false;
+   }
+   
+   if (!initializeTimelineWriter(output)) {
+       log("Failed to initialize timeline writer", 0);
+       return false;
+   }
+   return true;
 }
 
-bool MftAnalyzer::initializeCsvWriter() {
-   if (exportFormat == "csv") {
-       csvFile = std::make_unique<std::ofstream>(outputFile);
-       if (!csvFile->is_open()) {
+bool MftAnalyzer::writeBlock(Output& output, const std::shared_ptr<const RecordBatch>& batch) {
+   if (!split.enabled()) {
+       Slice slice = {batch, 0, batch->size()};
+       return writeSlice(output, slice);
+   }
+   
+   // A batch that crosses a part boundary is written in slices
+   for (size_t begin = 0; begin < batch->size();) {
+       if (partFull(output) && !nextPart(output)) {
+           return false;
+       }
+       size_t end = begin + static_cast<size_t>(std::min<uint64_t>(batch->size() - begin,
+                                                                   output.partLimit - output.partRecords));
+       if (output.partRecords == 0) {
+           output.firstRecord = batch->records[begin]->recordnum;
+       }
+       Slice slice = {batch, begin, end};
+       if (!writeSlice(output, slice)) {
+           return false;
+       }
+       output.lastRecord = batch->records[slice.end - 1]->recordnum;
+       output.partRecords += slice.end - begin;
+       begin = slice.end;
+   }
+   return true;
+}
+
+// Sink outputs know their size as they go; the others are cut by the
+// record count startPart() estimated
+bool MftAnalyzer::partFull(const Output& output) const {
+   if (output.partRecords >= output.partLimit) {
+       return true;
+   }
+   return split.bytes > 0 && output.sink && output.partRecords > 0 && output.sink->bytesWritten() >= split.bytes;
+}
+
+bool MftAnalyzer::writeSlice(Output& output, Slice& slice) {
+   if (output.format == "csv") {
+       if (!writeCsvBlock(output, slice)) {
+           log("Failed to write CSV block", 1);
+           return false;
+       }
+   } else if (output.format == "jsonl") {
+       if (!writeJsonlBlock(output, slice)) {
+           log("Failed to write JSONL block", 1);
+           return false;
+       }
+   } else if (output.format == "parquet") {
+       if (!writeParquetBlock(output, slice)) {
+           log("Failed to write Parquet row group", 1);
+           return false;
+       }
+   } else if (output.format == "sqlite") {
+       if (!writeSqliteBlock(output, slice)) {
+           log("Failed to insert SQLite rows", 1);
+           return false;
+       }
+   } else if (output.format == "excel") {
+       if (!writeExcelBlock(output, slice)) {
+           log("Failed to write Excel rows", 1);
+           return false;
+       }
+   } else if (output.format == "amft") {
+       if (!writeSnapshotBlock(output, slice)) {
+           log("Failed to write snapshot block: " + output.snapshotWriter->getLastError(), 1);
+           return false;
+       }
+   } else if (output.format == "timeline") {
+       if (!writeTimelineBlock(output, slice)) {
+           log("Failed to sort timeline events", 1);
+           return false;
+       }
+   } else {
+       output.pending.push_back(slice);
+   }
+   return true;
+}
+
+// Opens the file a streamed text format writes into, preallocated for the
+// records expected; close() trims what the estimate overshoots
+bool MftAnalyzer::openSink(Output& output, uint64_t bytesPerRecord) {
+   uint64_t expectedRecords = FileSystemUtils::getFileSize(mftFile) / MFT_RECORD_SIZE;
+   if (split.enabled()) {
+       expectedRecords = std::min(expectedRecords, output.partLimit);
+   }
+   uint64_t expectedSize = expectedRecords * bytesPerRecord;
+   if (split.bytes > 0) {
+       expectedSize = std::min(expectedSize, split.bytes);
+   }
+   
+   output.sink = std::make_unique<OutputSink>();
+   OutputCompression codec = compression;
+   codec.threads = threadCount;
+   output.sink->setCompression(codec);
+   output.sink->setDigest(hashOutputs() ? &output.digest : nullptr);
+   output.sink->setCancellation(cancellation.get());
+   if (!output.sink->open(output.file, expectedSize)) {
+       log(output.sink->getLastError(), 0);
+       return false;
+   }
+   return true;
+}
+
+bool MftAnalyzer::initializeCsvWriter(Output& output) {
+   if (output.format == "csv") {
+       // Roughly 16 bytes a field
+       const std::vector<size_t>& columns = csvColumns();
+       if (!openSink(output, columns.size() * 16)) {
            return false;
        }
        
-       for (size_t i = 0; i < CSV_HEADER.size(); ++i) {
-           *csvFile << CSV_HEADER[i];
-           if (i < CSV_HEADER.size() - 1) {
-               *csvFile << ",";
-           }
+       output.csvWriter = std::make_unique<CsvWriter>();
+       if (plan && plan->isProjected()) {
+           output.csvWriter->setColumns(columns);
        }
-       *csvFile << "\n";
-       csvFile->flush();
+       std::string header;
+       output.csvWriter->appendHeader(header);
+       output.sink->append(header);
    }
    return true;
 }
 
-bool MftAnalyzer::writeCsvBlock() {
-   if (exportFormat != "csv" || !csvFile) {
+bool MftAnalyzer::initializeJsonlWriter(Output& output) {
+   if (output.format == "jsonl") {
+       // Roughly 40 bytes a field with its key
+       if (!openSink(output, csvColumns().size() * 40)) {
+           return false;
+       }
+       
+       output.jsonlWriter = std::make_unique<JsonlWriter>();
+       if (plan && plan->isProjected()) {
+           output.jsonlWriter->setColumns(plan->getColumns());
+       }
+   }
+   return true;
+}
+
+bool MftAnalyzer::initializeParquetWriter(Output& output) {
+   if (output.format == "parquet") {
+       output.parquetWriter = std::make_unique<ParquetWriter>();
+       if (parquetRowGroupSize > 0) {
+           output.parquetWriter->setRowGroupSize(parquetRowGroupSize);
+       }
+       if (plan && plan->isProjected()) {
+           output.parquetWriter->setColumns(plan->getColumns());
+       }
+       output.parquetWriter->setDigest(hashOutputs() ? &output.digest : nullptr);
+       return output.parquetWriter->open(output.file);
+   }
+   return true;
+}
+
+bool MftAnalyzer::writeParquetBlock(Output& output, const Slice& slice) {
+   if (!output.parquetWriter) {
        return true;
    }
    
-   log("Writing CSV block. Records in block: " + std::to_string(mftRecords.size()), 2);
+   std::vector<const MftRecord*> records;
+   records.reserve(slice.end - slice.begin);
+   for (size_t i = slice.begin; i < slice.end; ++i) {
+       records.push_back(slice.batch->records[i].get());
+   }
+   return output.parquetWriter->writeBatch(records);
+}
+
+bool MftAnalyzer::initializeSqliteWriter(Output& output) {
+   if (output.format == "sqlite") {
+       output.sqliteWriter = std::make_unique<SqliteWriter>();
+       return output.sqliteWriter->open(output.file);
+   }
+   return true;
+}
+
+bool MftAnalyzer::writeSqliteBlock(Output& output, const Slice& slice) {
+   if (!output.sqliteWriter) {
+       return true;
+   }
+   
+   std::vector<const MftRecord*> records;
+   records.reserve(slice.end - slice.begin);
+   for (size_t i = slice.begin; i < slice.end; ++i) {
+       records.push_back(slice.batch->records[i].get());
+   }
+   return output.sqliteWriter->writeBatch(records);
+}
+
+bool MftAnalyzer::initializeExcelWriter(Output& output) {
+   if (output.format == "excel") {
+       output.excelWriter = std::make_unique<ExcelWriter>();
+       if (plan && plan->isProjected()) {
+           output.excelWriter->setColumns(plan->getColumns());
+       }
+       output.excelWriter->setThreads(threadCount);
+       output.excelWriter->setDigest(hashOutputs() ? &output.digest : nullptr);
+       return output.excelWriter->open(output.file);
+   }
+   return true;
+}
+
+bool MftAnalyzer::writeExcelBlock(Output& output, const Slice& slice) {
+   if (!output.excelWriter) {
+       return true;
+   }
+   
+   std::vector<const MftRecord*> records;
+   records.reserve(slice.end - slice.begin);
+   for (size_t i = slice.begin; i < slice.end; ++i) {
+       records.push_back(slice.batch->records[i].get());
+   }
+   return output.excelWriter->writeBatch(records);
+}
+
+bool MftAnalyzer::initializeSnapshotWriter(Output& output) {
+   if (output.format == "amft") {
+       output.snapshotWriter = std::make_unique<SnapshotWriter>();
+       if (!output.snapshotWriter->open(output.file, MFT_RECORD_SIZE, mftFile)) {
+           log(output.snapshotWriter->getLastError(), 0);
+           return false;
+       }
+   }
+   return true;
+}
+
+bool MftAnalyzer::writeSnapshotBlock(Output& output, const Slice& slice) {
+   if (!output.snapshotWriter) {
+       return true;
+   }
+   
+   const RecordBatch& batch = *slice.batch;
+   for (size_t i = slice.begin; i < slice.end; ++i) {
+       const uint8_t* raw = batch.rawRecords.empty() ? nullptr : batch.rawRecords.data() + i * MFT_RECORD_SIZE;
+       if (!output.snapshotWriter->append(*batch.records[i], raw)) {
+           return false;
+       }
+   }
+   return true;
+}
+
+bool MftAnalyzer::initializeTimelineWriter(Output& output) {
+   if (output.format == "timeline") {
+       // Events are collected batch by batch and sorted at the end
+       output.timelineWriter = std::make_unique<TimelineWriter>();
+       if (sortMemory > 0) {
+           output.timelineWriter->setMemoryLimit(sortMemory);
+       }
+       output.timelineWriter->setThreads(threadCount);
+       output.timelineWriter->setCollapse(macbCollapse);
+       OutputCompression codec = compression;
+       codec.threads = threadCount;
+       output.timelineWriter->setCompression(codec);
+       output.timelineWriter->setDigest(hashOutputs() ? &output.digest : nullptr);
+       output.timelineWriter->setCancellation(cancellation.get());
+       return output.timelineWriter->open(output.file);
+   }
+   return true;
+}
+
+bool MftAnalyzer::writeTimelineBlock(Output& output, const Slice& slice) {
+   if (!output.timelineWriter) {
+       return true;
+   }
+   
+   std::vector<const MftRecord*> records;
+   records.reserve(slice.end - slice.begin);
+   for (size_t i = slice.begin; i < slice.end; ++i) {
+       records.push_back(slice.batch->records[i].get());
+   }
+   return output.timelineWriter->writeBatch(records);
+}
+
+bool MftAnalyzer::writeCsvBlock(Output& output, Slice& slice) {
+   if (!output.sink) {
+       return true;
+   }
+   
+   log("Writing CSV block. Records in block: " + std::to_string(slice.end - slice.begin), 2);
    
    try {
-       for (const auto& pair : mftRecords) {
-           const auto& record = pair.second;
-           std::string filepath = buildFilepath(record.get());
-           
-           std::vector<std::string> csvRow = record->toCsv();
-           csvRow[8] = filepath;  // Set filepath
-           
-           for (size_t i = 0; i < csvRow.size(); ++i) {
-               *csvFile << "\"" << csvRow[i] << "\"";
-               if (i < csvRow.size() - 1) {
-                   *csvFile << ",";
-               }
-           }
-           *csvFile << "\n";
+       // Rows are formatted into one string per block and handed to the sink's
+       // writer thread, which does the disk writes while the next block parses
+       std::string block;
+       uint64_t written = output.sink->bytesWritten();
+       for (size_t index = slice.begin; index < slice.end; ++index) {
+           const MftRecord* record = slice.batch->records[index].get();
+           output.csvWriter->appendRecord(block, record);
            
            if (debug >= 2) {
                log("Wrote record " + std::to_string(record->recordnum) + " to CSV", 2);
            }
+           if (split.bytes > 0 && written + block.size() >= split.bytes) {
+               slice.end = index + 1;
+               break;
+           }
        }
        
-       csvFile->flush();
+       if (!output.sink->append(block)) {
+           log("Error in writeCsvBlock: " + output.sink->getLastError(), 0);
+           return false;
+       }
        log("CSV block written", 2);
        return true;
        
@@ -217,125 +714,347 @@ bool MftAnalyzer::writeCsvBlock() {
    }
 }
 
-bool MftAnalyzer::writeRemainingRecords() {
-   return writeCsvBlock();
+bool MftAnalyzer::writeJsonlBlock(Output& output, Slice& slice) {
+   if (!output.sink) {
+       return true;
+   }
+   
+   std::string block;
+   uint64_t written = output.sink->bytesWritten();
+   for (size_t index = slice.begin; index < slice.end; ++index) {
+       output.jsonlWriter->appendRecord(block, slice.batch->records[index].get());
+       if (split.bytes > 0 && written + block.size() >= split.bytes) {
+           slice.end = index + 1;
+           break;
+       }
+   }
+   if (!output.sink->append(block)) {
+       log("Error in writeJsonlBlock: " + output.sink->getLastError(), 0);
+       return false;
+   }
+   return true;
+}
+
+bool MftAnalyzer::writeOutput() {
+   if (outputs.size() == 1) {
+       return finishOutput(outputs.front());
+   }
+   
+   // Whole-file formats are written from the retained records, each output
+   // on its own thread
+   std::vector<char> finished(outputs.size(), 0);
+   std::vector<std::thread> writers;
+   for (size_t i = 0; i < outputs.size(); ++i) {
+       writers.emplace_back([this, &finished, i] { finished[i] = finishOutput(outputs[i]); });
+   }
+   for (auto& writer : writers) {
+       writer.join();
+   }
+   return std::all_of(finished.begin(), finished.end(), [](char ok) { return ok != 0; });
+}
+
+bool MftAnalyzer::finishOutput(Output& output) {
+   if (!closeOutput(output)) {
+       return false;
+   }
+   return !split.enabled() || (recordPart(output) && writePartManifest(output));
 }
 
-std::string MftAnalyzer::buildFilepath(const MftRecord* record) const {
-   std::vector<std::string> pathParts;
-   const MftRecord* currentRecord = record;
-   int maxDepth = 255;
+bool MftAnalyzer::closeOutput(Output& output) {
+   log("Writing output in " + output.format + " format to " + output.file, 0);
    
-   while (currentRecord && maxDepth > 0) {
-       if (currentRecord->recordnum == 5) {
-           pathParts.insert(pathParts.begin(), "");
-           break;
-       } else if (!currentRecord->filename.empty()) {
-           pathParts.insert(pathParts.begin(), currentRecord->filename);
-       } else {
-           pathParts.insert(pathParts.begin(), "Unknown_" + std::to_string(currentRecord->recordnum));
+   try {
+       if (output.format == "csv" || output.format == "jsonl") {
+           if (output.sink && !output.sink->close()) {
+               log("Error writing " + output.format + " output: " + output.sink->getLastError(), 0);
+               return false;
+           }
+           return true;
+       } else if (output.format == "parquet") {
+           return output.parquetWriter && output.parquetWriter->close();
+       } else if (output.format == "sqlite") {
+           return output.sqliteWriter && output.sqliteWriter->close();
+       } else if (output.format == "excel") {
+           return output.excelWriter && output.excelWriter->close();
+       } else if (output.format == "amft") {
+           return output.snapshotWriter && output.snapshotWriter->close();
+       } else if (output.format == "timeline") {
+           return output.timelineWriter && output.timelineWriter->close();
+       } else if (!isRecordFormat(output.format)) {
+           log("Unsupported export format: " + output.format, 0);
+           return false;
        }
        
-       uint64_t parentRecordNum = currentRecord->getParentRecordNum();
-       
-       if (parentRecordNum == currentRecord->recordnum) {
-           pathParts.insert(pathParts.begin(), "OrphanedFiles");
-           break;
+       // The slices keep their batches alive until the records are written
+       std::vector<Slice> slices = std::move(output.pending);
+       output.pending.clear();
+       std::vector<const MftRecord*> records;
+       for (const auto& slice : slices) {
+           for (size_t i = slice.begin; i < slice.end; ++i) {
+               records.push_back(slice.batch->records[i].get());
+           }
        }
-       
-       auto it = mftRecords.find(static_cast<uint32_t>(parentRecordNum));
-       if (it != mftRecords.end()) {
-           currentRecord = it->second.get();
-       } else {
-           pathParts.insert(pathParts.begin(), "UnknownParent_" + std::to_string(parentRecordNum));
-           break;
+       OutputCompression codec = compression;
+       codec.threads = threadCount;
+       return writeRecords(records, output.file, output.format, plan.get(), threadCount, codec, macbCollapse,
+                           hashOutputs() ? &output.digest : nullptr, cancellation.get());
+   } catch (const std::exception& e) {
+       log("Error writing output: " + std::string(e.what()), 0);
+       return false;
+   }
+}
+
+void MftAnalyzer::startPart(Output& output) {
+   output.file = partFile(output.path, output.parts.size() + 1);
+   output.partRecords = 0;
+   output.partLimit = split.records;
+   if (split.bytes > 0 && (output.format == "csv" || output.format == "jsonl")) {
+       // These stream through a sink, which counts what it takes; partFull()
+       // cuts the part once that reaches SIZE (uncompressed, with --compress)
+       output.partLimit = UINT64_MAX;
+   } else if (split.bytes > 0) {
+       // The other formats are cut by record count, from the bytes a record
+       // took in the parts so far; the first part assumes one MFT record's worth
+       double bytesPerRecord = MFT_RECORD_SIZE;
+       uint64_t bytes = 0;
+       uint64_t records = 0;
+       for (const auto& part : output.parts) {
+           bytes += part.bytes;
+           records += part.records;
        }
-       
-       maxDepth--;
+       if (records > 0 && bytes > 0) {
+           bytesPerRecord = static_cast<double>(bytes) / static_cast<double>(records);
+       }
+       output.partLimit = std::max<uint64_t>(1, static_cast<uint64_t>(static_cast<double>(split.bytes) / bytesPerRecord));
    }
-   
-   if (maxDepth == 0) {
-       pathParts.insert(pathParts.begin(), "DeepPath");
+}
+
+bool MftAnalyzer::nextPart(Output& output) {
+   if (!closeOutput(output) || !recordPart(output)) {
+       return false;
    }
-   
-   std::string result;
-   for (size_t i = 0; i < pathParts.size(); ++i) {
-       result += pathParts[i];
-       if (i < pathParts.size() - 1) {
-           result += "\\";
-       }
+   startPart(output);
+   return initializeOutput(output);
+}
+
+bool MftAnalyzer::recordPart(Output& output) {
+   Part part;
+   part.file = output.file;
+   part.records = output.partRecords;
+   part.firstRecord = output.firstRecord;
+   part.lastRecord = output.lastRecord;
+   OutputDigest digest = digestOf(output);
+   part.bytes = digest.bytes;
+   part.sha256 = digest.sha256;
+   if (part.sha256.empty()) {
+       log("Cannot read back output part " + output.file, 0);
+       return false;
    }
+   output.parts.push_back(std::move(part));
+   return true;
+}
+
+bool MftAnalyzer::writePartManifest(const Output& output) const {
+   std::string manifestFile = output.path + ".manifest.json";
+   std::string text = "{\n  \"exportFormat\": \"";
+   StringUtils::appendJsonEscaped(text, output.format);
+   text += "\",\n  \"output\": \"";
+   StringUtils::appendJsonEscaped(text, output.path);
+   text += "\",\n  \"parts\": [";
+   for (size_t i = 0; i < output.parts.size(); ++i) {
+       const Part& part = output.parts[i];
+       bool empty = part.records == 0;
+       text += i == 0 ? "\n" : ",\n";
+       text += "    {\n      \"file\": \"";
+       StringUtils::appendJsonEscaped(text, FileSystemUtils::getBasename(part.file));
+       text += "\",\n      \"records\": " + std::to_string(part.records);
+       text += ",\n      \"firstRecord\": " + (empty ? std::string("null") : std::to_string(part.firstRecord));
+       text += ",\n      \"lastRecord\": " + (empty ? std::string("null") : std::to_string(part.lastRecord));
+       text += ",\n      \"bytes\": " + std::to_string(part.bytes);
+       text += ",\n      \"sha256\": \"" + part.sha256 + "\"\n    }";
+   }
+   text += output.parts.empty() ? "]\n}\n" : "\n  ]\n}\n";
    
-   return result;
+   std::ofstream file(manifestFile, std::ios::binary | std::ios::trunc);
+   file << text;
+   file.close();
+   if (!file) {
+       log("Cannot write part manifest " + manifestFile, 0);
+       return false;
+   }
+   return true;
 }
 
-bool MftAnalyzer::writeOutput() {
-   log("Writing output in " + exportFormat + " format to " + outputFile, 0);
+// What the output's writer hashed as it wrote, or else a read-back of the
+// file: sqlite and amft are not hashed on the way out
+OutputDigest MftAnalyzer::digestOf(const Output& output) const {
+   if (!output.digest.sha256.empty()) {
+       return output.digest;
+   }
+   OutputDigest digest;
+   digest.sha256 = HashCalculator().calculateFileSha256(output.file);
+   digest.bytes = FileSystemUtils::getFileSize(output.file);
+   return digest;
+}
+
+bool MftAnalyzer::writeEvidenceManifest() {
+   // A snapshot input, or a run interrupted before the end, was not hashed
+   // on the way through
+   if (inputSha256.empty()) {
+       log("Hashing input " + mftFile, 1);
+       inputSha256 = HashCalculator().calculateFileSha256(mftFile);
+       inputBytes = FileSystemUtils::getFileSize(mftFile);
+   }
    
-   try {
-       if (exportFormat == "csv") {
-           return writeRemainingRecords();
-       } else if (exportFormat == "json") {
-           JsonWriter writer;
-           std::vector<const MftRecord*> records;
-           for (const auto& pair : mftRecords) {
-               records.push_back(pair.second.get());
-           }
-           return writer.write(records, outputFile);
-       } else if (exportFormat == "xml") {
-           XmlWriter writer;
-           std::vector<const MftRecord*> records;
-           for (const auto& pair : mftRecords) {
-               records.push_back(pair.second.get());
-           }
-           return writer.write(records, outputFile);
-       } else if (exportFormat == "excel") {
-           ExcelWriter writer;
-           std::vector<const MftRecord*> records;
-           for (const auto& pair : mftRecords) {
-               records.push_back(pair.second.get());
-           }
-           return writer.write(records, outputFile);
-       } else if (exportFormat == "sqlite") {
-           SqliteWriter writer;
-           std::vector<const MftRecord*> records;
-           for (const auto& pair : mftRecords) {
-               records.push_back(pair.second.get());
-           }
-           return writer.write(records, outputFile);
-       } else if (exportFormat == "body") {
-           BodyWriter writer;
-           std::vector<const MftRecord*> records;
-           for (const auto& pair : mftRecords) {
-               records.push_back(pair.second.get());
-           }
-           return writer.write(records, outputFile);
-       } else if (exportFormat == "timeline") {
-           TimelineWriter writer;
-           std::vector<const MftRecord*> records;
-           for (const auto& pair : mftRecords) {
-               records.push_back(pair.second.get());
+   std::string text = "{\n  \"tool\": \"analyzeMFT\",\n  \"version\": \"" ANALYZEMFT_VERSION_STRING "\",\n";
+   text += "  \"started\": \"" + startTime + "\",\n";
+   text += "  \"finished\": \"" + utcNow() + "\",\n";
+   text += "  \"interrupted\": " + std::string(cancellation->isCancelled() ? "true" : "false") + ",\n";
+   text += "  \"input\": {\n    \"file\": \"";
+   StringUtils::appendJsonEscaped(text, mftFile);
+   text += "\",\n    \"bytes\": " + std::to_string(inputBytes);
+   text += ",\n    \"sha256\": \"" + inputSha256 + "\"\n  },\n";
+   text += "  \"statistics\": {\n";
+   text += "    \"totalRecords\": " + std::to_string(stats.totalRecords.load()) + ",\n";
+   text += "    \"activeRecords\": " + std::to_string(stats.activeRecords.load()) + ",\n";
+   text += "    \"directories\": " + std::to_string(stats.directories.load()) + ",\n";
+   text += "    \"files\": " + std::to_string(stats.files.load()) + "\n  },\n";
+   text += "  \"outputs\": [";
+   
+   bool first = true;
+   auto appendFile = [&](const std::string& format, const std::string& file, uint64_t bytes,
+                         const std::string& sha256) {
+       text += first ? "\n    {\n      \"format\": \"" : ",\n    {\n      \"format\": \"";
+       StringUtils::appendJsonEscaped(text, format);
+       text += "\",\n      \"file\": \"";
+       StringUtils::appendJsonEscaped(text, file);
+       text += "\",\n      \"bytes\": " + std::to_string(bytes);
+       text += ",\n      \"sha256\": \"" + sha256 + "\"\n    }";
+       first = false;
+   };
+   for (const auto& output : outputs) {
+       if (split.enabled()) {
+           for (const Part& part : output.parts) {
+               appendFile(output.format, part.file, part.bytes, part.sha256);
            }
-           return writer.write(records, outputFile);
+           // The part manifest is small enough to read back
+           std::string manifestFile = output.path + ".manifest.json";
+           appendFile("manifest", manifestFile, FileSystemUtils::getFileSize(manifestFile),
+                      HashCalculator().calculateFileSha256(manifestFile));
        } else {
-           log("Unsupported export format: " + exportFormat, 0);
-           return false;
+           OutputDigest digest = digestOf(output);
+           appendFile(output.format, output.file, digest.bytes, digest.sha256);
        }
-   } catch (const std::exception& e) {
-       log("Error writing output: " + std::string(e.what()), 0);
+   }
+   text += first ? "]\n}\n" : "\n  ]\n}\n";
+   
+   std::ofstream file(evidenceFile, std::ios::binary | std::ios::trunc);
+   file << text;
+   file.close();
+   if (!file) {
+       log("Cannot write evidence manifest " + evidenceFile, 0);
        return false;
    }
+   return true;
 }
 
-void MftAnalyzer::cleanup() {
-   log("Performing cleanup...", 1);
+bool MftAnalyzer::isRecordFormat(const std::string& exportFormat) {
+   static const char* const formats[] = {"csv", "json", "jsonl", "xml", "excel", "sqlite", "body", "timeline", "parquet"};
+   return std::find(std::begin(formats), std::end(formats), exportFormat) != std::end(formats);
+}
+
+bool MftAnalyzer::supportsFieldSelection(const std::string& exportFormat) {
+   return exportFormat == "csv" || exportFormat == "json" || exportFormat == "jsonl" || exportFormat == "xml" ||
+          exportFormat == "excel" || exportFormat == "parquet";
+}
+
+bool MftAnalyzer::supportsCompression(const std::string& exportFormat) {
+   return exportFormat == "csv" || exportFormat == "json" || exportFormat == "jsonl" || exportFormat == "xml" ||
+          exportFormat == "body" || exportFormat == "timeline";
+}
+
+bool MftAnalyzer::writeRecords(const std::vector<const MftRecord*>& records, const std::string& outputFile,
+                               const std::string& exportFormat, const ParsePlan* plan, unsigned threads,
+                               const OutputCompression& compression, MacbCollapse collapse, OutputDigest* digest,
+                               const CancellationToken* cancellation) {
+   std::vector<size_t> columns;
+   if (plan && plan->isProjected()) {
+       columns = plan->getColumns();
+   }
    
-   if (!writeRemainingRecords()) {
-       log("Failed to write remaining records during cleanup", 1);
+   if (exportFormat == "csv") {
+       CsvWriter writer;
+       writer.setColumns(columns);
+       writer.setThreads(threads);
+       writer.setCompression(compression);
+       writer.setDigest(digest);
+       writer.setCancellation(cancellation);
+       return writer.write(records, outputFile);
+   } else if (exportFormat == "parquet") {
+       ParquetWriter writer;
+       writer.setColumns(columns);
+       writer.setDigest(digest);
+       return writer.write(records, outputFile);
+   } else if (exportFormat == "json") {
+       JsonWriter writer;
+       writer.setColumns(columns);
+       writer.setThreads(threads);
+       writer.setCompression(compression);
+       writer.setDigest(digest);
+       writer.setCancellation(cancellation);
+       return writer.write(records, outputFile);
+   } else if (exportFormat == "jsonl") {
+       JsonlWriter writer;
+       writer.setColumns(columns);
+       writer.setThreads(threads);
+       writer.setCompression(compression);
+       writer.setDigest(digest);
+       writer.setCancellation(cancellation);
+       return writer.write(records, outputFile);
+   } else if (exportFormat == "xml") {
+       XmlWriter writer;
+       writer.setColumns(columns);
+       writer.setThreads(threads);
+       writer.setCompression(compression);
+       writer.setDigest(digest);
+       writer.setCancellation(cancellation);
+       return writer.write(records, outputFile);
+   } else if (exportFormat == "excel") {
+       ExcelWriter writer;
+       writer.setColumns(columns);
+       writer.setThreads(threads);
+       writer.setDigest(digest);
+       writer.setCancellation(cancellation);
+       return writer.write(records, outputFile);
+   } else if (exportFormat == "sqlite") {
+       SqliteWriter writer;
+       return writer.write(records, outputFile);
+   } else if (exportFormat == "body") {
+       BodyWriter writer;
+       writer.setCollapse(collapse);
+       writer.setCompression(compression);
+       writer.setDigest(digest);
+       writer.setCancellation(cancellation);
+       return writer.write(records, outputFile);
+   } else if (exportFormat == "timeline") {
+       TimelineWriter writer;
+       writer.setThreads(threads);
+       writer.setCollapse(collapse);
+       writer.setCompression(compression);
+       writer.setDigest(digest);
+       writer.setCancellation(cancellation);
+       return writer.write(records, outputFile);
    }
+   return false;
+}
+
+void MftAnalyzer::cleanup() {
+   log("Performing cleanup...", 1);
    
-   if (csvFile && csvFile->is_open()) {
-       csvFile->close();
+   for (auto& output : outputs) {
+       if (output.sink && output.sink->isOpen()) {
+           output.sink->close();
+       }
    }
    
    log("Cleanup complete.", 1);
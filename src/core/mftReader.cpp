@@ -0,0 +1,329 @@
+#include "mftReader.h"
+#include "batchAnalyzer.h"
+#include <algorithm>
+#include <cstring>
+
+// Below this many records per thread the handoff costs more than parallel parsing saves
+constexpr size_t MIN_RECORDS_PER_THREAD = 64;
+
+MftReader::BatchIterator::BatchIterator(MftReader* reader) : reader(reader) {
+    if (!reader->nextBatch(reader->currentBatch)) {
+        this->reader = nullptr;
+    }
+}
+
+MftReader::BatchIterator& MftReader::BatchIterator::operator++() {
+    if (reader && !reader->nextBatch(reader->currentBatch)) {
+        reader = nullptr;
+    }
+    return *this;
+}
+
+MftReader::MftReader()
+    : bufferOffset(0), opened(false), snapshotRow(SNAPSHOT_NONE), recordsRead(0), parseErrors(0),
+      readOffset(0), inputHashed(false) {
+}
+
+MftReader::BatchRange MftReader::batches(const MftReaderOptions& options) {
+    return BatchRange(open(options) ? this : nullptr);
+}
+
+bool MftReader::open(const MftReaderOptions& options) {
+    close();
+    this->options = options;
+    lastError.clear();
+
+    if (this->options.recordSize == 0) {
+        lastError = "Record size must be positive";
+        return false;
+    }
+    if (this->options.batchSize == 0) {
+        this->options.batchSize = 1024;
+    }
+    this->options.threads = std::max(1u, this->options.threads);
+
+    if (!this->options.buffer && Snapshot::isSnapshotFile(this->options.inputFile)) {
+        if (!snapshot.open(this->options.inputFile)) {
+            lastError = snapshot.getLastError();
+            return false;
+        }
+        if (this->options.keepRawRecords && snapshot.getRecordSize() != this->options.recordSize) {
+            lastError = "Snapshot record size " + std::to_string(snapshot.getRecordSize()) +
+                        " does not match " + std::to_string(this->options.recordSize);
+            snapshot.close();
+            return false;
+        }
+        // Paths were resolved when the snapshot was written
+        snapshotRow = 0;
+        opened = true;
+        return true;
+    }
+
+    if (!this->options.buffer) {
+        file.open(this->options.inputFile, std::ios::binary);
+        if (!file.is_open()) {
+            lastError = "Cannot open MFT file: " + this->options.inputFile;
+            return false;
+        }
+    }
+
+    parsePlan = this->options.plan ? *this->options.plan : ParsePlan();
+
+    opened = true;
+    if ((this->options.fields & READER_FIELD_PATHS) || needsPathFilter()) {
+        if (!indexPaths()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MftReader::close() {
+    if (file.is_open()) {
+        file.close();
+    }
+    file.clear();
+    snapshot.close();
+    snapshotRow = SNAPSHOT_NONE;
+    bufferOffset = 0;
+    readOffset = 0;
+    inputHash.reset();
+    inputHashed = false;
+    opened = false;
+    paths.clear();
+    currentBatch = RecordBatch();
+    recordsRead = 0;
+    parseErrors = 0;
+}
+
+void MftReader::rewind() {
+    bufferOffset = 0;
+    readOffset = 0;
+    if (!options.buffer) {
+        file.clear();
+        file.seekg(0);
+    }
+    recordsRead = 0;
+}
+
+size_t MftReader::readChunk(size_t maxRecords) {
+    size_t recordSize = options.recordSize;
+    chunk.resize(maxRecords * recordSize);
+
+    size_t bytes = 0;
+    if (options.buffer) {
+        size_t available = options.bufferSize > bufferOffset ? options.bufferSize - bufferOffset : 0;
+        bytes = std::min(chunk.size(), available - available % recordSize);
+        std::memcpy(chunk.data(), options.buffer + bufferOffset, bytes);
+        // The whole buffer is at hand, including any partial record at its end
+        hashRead(options.buffer + bufferOffset, bufferOffset, available, true);
+        bufferOffset += bytes;
+    } else {
+        if (options.ioThrottle) {
+            options.ioThrottle->acquire();
+        }
+        file.read(reinterpret_cast<char*>(chunk.data()), chunk.size());
+        bytes = static_cast<size_t>(file.gcount());
+        if (options.ioThrottle) {
+            options.ioThrottle->release();
+        }
+        if (file.bad()) {
+            // Not the end of the input: nextBatch() stops, and callers see the error
+            lastError = "Error reading MFT file: " + options.inputFile;
+        }
+        hashRead(chunk.data(), readOffset, bytes, bytes < chunk.size() && !file.bad());
+    }
+    readOffset += bytes;
+
+    // A trailing partial record is not parseable and is dropped
+    return bytes / recordSize;
+}
+
+// Extends the input hash with whatever part of a read it has not covered
+// yet; the path prepass reads the input first, the batches after it re-read
+// bytes that are already hashed
+void MftReader::hashRead(const uint8_t* data, uint64_t offset, size_t size, bool atEnd) {
+    uint64_t hashed = inputHash.size();
+    if (!options.hashInput || offset > hashed) {
+        return;
+    }
+    if (offset + size > hashed) {
+        inputHash.update(data + (hashed - offset), static_cast<size_t>(offset + size - hashed));
+    }
+    inputHashed = inputHashed || atEnd;
+}
+
+void MftReader::parseRange(size_t first, size_t last, std::vector<std::unique_ptr<MftRecord>>& parsed) const {
+    bool computeHashes = (options.fields & READER_FIELD_HASHES) != 0;
+    size_t recordSize = options.recordSize;
+
+    for (size_t i = first; i < last; ++i) {
+        auto begin = chunk.begin() + static_cast<std::ptrdiff_t>(i * recordSize);
+        try {
+            std::vector<uint8_t> raw(begin, begin + static_cast<std::ptrdiff_t>(recordSize));
+            parsed[i] = std::make_unique<MftRecord>(raw, computeHashes, options.debug, options.where.get(), &parsePlan);
+            if (options.sharedRecords) {
+                parsed[i]->decodeAll();
+            }
+        } catch (const std::exception& e) {
+            parsed[i].reset();
+        }
+    }
+}
+
+void MftReader::parseChunk(size_t count, std::vector<std::unique_ptr<MftRecord>>& parsed) {
+    parsed.clear();
+    parsed.resize(count);
+
+    unsigned threadCount = static_cast<unsigned>(std::min<size_t>(options.threads,
+                                                 std::max<size_t>(1, count / MIN_RECORDS_PER_THREAD)));
+    if (threadCount <= 1) {
+        parseRange(0, count, parsed);
+        return;
+    }
+
+    // Started on the first chunk that needs them and kept for every later one
+    if (!workers || workers->size() != options.threads - 1) {
+        workers = std::make_unique<WorkerPool>(options.threads - 1);
+    }
+    size_t perThread = (count + threadCount - 1) / threadCount;
+    workers->run(threadCount, [&](size_t slice) {
+        size_t first = std::min(count, slice * perThread);
+        parseRange(first, std::min(count, first + perThread), parsed);
+    });
+}
+
+bool MftReader::indexPaths() {
+    std::vector<std::unique_ptr<MftRecord>> parsed;
+    uint32_t savedFields = options.fields;
+    options.fields &= ~READER_FIELD_HASHES;
+    // Paths need every directory, including those the filter would drop
+    std::shared_ptr<const RecordFilter> savedWhere = std::move(options.where);
+    // and nothing but the attribute table; fileName() decodes the one attribute needed
+    ParsePlan savedPlan = std::move(parsePlan);
+    parsePlan = ParsePlan::attributesOnly(0);
+    bool savedShared = options.sharedRecords;
+    options.sharedRecords = false;
+
+    while (!isCancelled()) {
+        size_t count = readChunk(options.batchSize);
+        if (count == 0) {
+            break;
+        }
+        parseChunk(count, parsed);
+        for (const auto& record : parsed) {
+            if (record) {
+                paths.addRecord(*record);
+            }
+        }
+    }
+
+    options.fields = savedFields;
+    options.where = std::move(savedWhere);
+    parsePlan = std::move(savedPlan);
+    options.sharedRecords = savedShared;
+    if (!options.buffer && file.bad()) {
+        lastError = "Error reading MFT file: " + options.inputFile;
+        return false;
+    }
+    rewind();
+    return true;
+}
+
+bool MftReader::nextBatch(RecordBatch& batch) {
+    batch.records.clear();
+    if (!opened) {
+        return false;
+    }
+
+    batch.rawRecords.clear();
+    if (isSnapshot()) {
+        return nextSnapshotBatch(batch);
+    }
+
+    bool resolvePaths = (options.fields & READER_FIELD_PATHS) != 0;
+    bool filterPaths = needsPathFilter();
+    std::vector<std::unique_ptr<MftRecord>> parsed;
+
+    // Loop so a chunk rejected entirely by the filter does not end the range
+    while (batch.records.empty() && !isCancelled()) {
+        size_t count = readChunk(options.batchSize);
+        if (count == 0) {
+            return false;
+        }
+
+        batch.firstRecordIndex = recordsRead;
+        recordsRead += count;
+        parseChunk(count, parsed);
+
+        for (size_t i = 0; i < count; ++i) {
+            auto& record = parsed[i];
+            if (!record) {
+                parseErrors++;
+                continue;
+            }
+            if (record->isRejected()) {
+                continue;
+            }
+            if (resolvePaths || filterPaths) {
+                record->filepath = paths.resolve(record->recordnum);
+                if (filterPaths && !options.where->accepts(*record)) {
+                    continue;
+                }
+                if (!resolvePaths) {
+                    record->filepath.clear();
+                }
+            }
+            if (options.filter && !options.filter(*record)) {
+                continue;
+            }
+            if (options.keepRawRecords) {
+                auto raw = chunk.begin() + static_cast<std::ptrdiff_t>(i * options.recordSize);
+                batch.rawRecords.insert(batch.rawRecords.end(), raw,
+                                        raw + static_cast<std::ptrdiff_t>(options.recordSize));
+            }
+            batch.records.push_back(std::move(record));
+        }
+    }
+
+    return !batch.records.empty();
+}
+
+bool MftReader::nextSnapshotBatch(RecordBatch& batch) {
+    bool computeHashes = (options.fields & READER_FIELD_HASHES) != 0;
+    bool resolvePaths = (options.fields & READER_FIELD_PATHS) != 0;
+    size_t recordSize = snapshot.getRecordSize();
+
+    while (batch.records.empty() && !isCancelled() && snapshotRow < snapshot.size()) {
+        uint64_t last = std::min<uint64_t>(snapshot.size(), snapshotRow + options.batchSize);
+        batch.firstRecordIndex = snapshotRow;
+
+        for (; snapshotRow < last; ++snapshotRow) {
+            auto record = snapshot.loadRecord(snapshotRow, computeHashes);
+            if (options.where && !options.where->accepts(*record)) {
+                continue;
+            }
+            if (!resolvePaths) {
+                record->filepath.clear();
+            }
+            if (options.filter && !options.filter(*record)) {
+                continue;
+            }
+            if (options.sharedRecords) {
+                record->decodeAll();
+            }
+            if (options.keepRawRecords) {
+                const uint8_t* raw = snapshot.rawRecord(snapshotRow);
+                if (raw) {
+                    batch.rawRecords.insert(batch.rawRecords.end(), raw, raw + recordSize);
+                } else {
+                    batch.rawRecords.resize(batch.rawRecords.size() + recordSize, 0);
+                }
+            }
+            batch.records.push_back(std::move(record));
+        }
+        recordsRead = snapshotRow;
+    }
+
+    return !batch.records.empty();
+}
@@ -1,21 +1,40 @@
 #include "../../include/analyzeMFT/core/mftRecord.h"
 #include "../utils/hashCalc.h"
 #include "../utils/stringUtils.h"
+#include "recordFilter.h"
+#include "parsePlan.h"
+#include "columnSchema.h"
 #include <algorithm>
 #include <cstring>
 #include <iomanip>
 #include <sstream>
 #include <iostream>
 
-MftRecord::MftRecord(const std::vector<uint8_t>& rawRecord, bool computeHashes, int debugLevel)
-    : rawRecord(rawRecord), debugLevel(debugLevel), computeHashesFlag(computeHashes),
-      magic(0), updOff(0), updCnt(0), lsn(0), seq(0), link(0), attrOff(0), flags(0),
-      size(0), allocSizef(0), baseRef(0), nextAttrid(0), recordnum(0), filesize(0), parentRef(0) {
+MftRecord::MftRecord(const std::vector<uint8_t>& rawRecord, bool computeHashes, int debugLevel,
+                     const RecordFilter* filter, const ParsePlan* plan)
+    : magic(0), updOff(0), updCnt(0), lsn(0), seq(0), link(0), attrOff(0), flags(0),
+      size(0), allocSizef(0), baseRef(0), nextAttrid(0), recordnum(0), filesize(0), parentRef(0),
+      rawRecord(rawRecord), debugLevel(debugLevel), computeHashesFlag(computeHashes),
+      filter(filter), plan(plan), rejected(false),
+      attributeEntries(0), attributeOverflow(0), attributesIndexed(false), decoded(0) {
     
-    if (computeHashesFlag) {
-        computeHashes();
-    }
     parseRecord();
+    
+    // Records parseRecord() gave up on before indexing their attributes
+    if (filter && !rejected && !attributesIndexed && !passesFilter(FILTER_FIELDS_PARSED)) {
+        rejected = true;
+    }
+    // parseRecord() hashes before applying fixups; this covers records it gave up on earlier
+    if (computeHashesFlag && !rejected && md5.empty()) {
+        this->computeHashes();
+    }
+}
+
+MftRecord::MftRecord()
+    : magic(0), updOff(0), updCnt(0), lsn(0), seq(0), link(0), attrOff(0), flags(0),
+      size(0), allocSizef(0), baseRef(0), nextAttrid(0), recordnum(0), filesize(0), parentRef(0),
+      debugLevel(0), computeHashesFlag(false), filter(nullptr), plan(nullptr), rejected(false),
+      attributeEntries(0), attributeOverflow(0), attributesIndexed(false), decoded(0) {
 }
 
 template<typename T>
@@ -43,175 +62,6 @@ void MftRecord::log(const std::string& message, int level) const {
     }
 }
 
-bool MftRecord::parseSiAttributeWithValidation(size_t offset) {
-    validator->setRecordNumber(recordnum);
-    auto result = validator->validateStandardInformation(rawRecord, offset, 
-        siTimes.crtime, siTimes.mtime, siTimes.atime, siTimes.ctime);
-    
-    if (!result.isValid && debugLevel > 0) {
-        log("Standard Information validation failed: " + result.errorMessage, 1);
-    }
-    
-    return result.isValid;
-}
-
-bool MftRecord::parseFnAttributeWithValidation(size_t offset) {
-    validator->setRecordNumber(recordnum);
-    auto result = validator->validateFileName(rawRecord, offset, 
-        filename, fnTimes.crtime, fnTimes.mtime, fnTimes.atime, fnTimes.ctime, filesize, parentRef);
-    
-    if (!result.isValid && debugLevel > 0) {
-        log("File Name validation failed: " + result.errorMessage, 1);
-    }
-    
-    return result.isValid;
-}
-
-bool MftRecord::parseObjectIdAttributeWithValidation(size_t offset) {
-    validator->setRecordNumber(recordnum);
-    auto result = validator->validateObjectId(rawRecord, offset, 
-        objectId, birthVolumeId, birthObjectId, birthDomainId);
-    
-    if (!result.isValid && debugLevel > 0) {
-        log("Object ID validation failed: " + result.errorMessage, 1);
-    }
-    
-    return result.isValid;
-}
-
-bool MftRecord::parseAttributeListWithValidation(size_t offset) {
-    validator->setRecordNumber(recordnum);
-    auto result = validator->validateAttributeList(rawRecord, offset, attributeList);
-    
-    if (!result.isValid && debugLevel > 0) {
-        log("Attribute List validation failed: " + result.errorMessage, 1);
-    }
-    
-    return result.isValid;
-}
-
-bool MftRecord::parseSecurityDescriptorWithValidation(size_t offset) {
-    validator->setRecordNumber(recordnum);
-    auto result = validator->validateSecurityDescriptor(rawRecord, offset, securityDescriptor);
-    
-    if (!result.isValid && debugLevel > 0) {
-        log("Security Descriptor validation failed: " + result.errorMessage, 1);
-    }
-    
-    return result.isValid;
-}
-
-bool MftRecord::parseVolumeNameWithValidation(size_t offset) {
-    validator->setRecordNumber(recordnum);
-    auto result = validator->validateVolumeName(rawRecord, offset, volumeName);
-    
-    if (!result.isValid && debugLevel > 0) {
-        log("Volume Name validation failed: " + result.errorMessage, 1);
-    }
-    
-    return result.isValid;
-}
-
-bool MftRecord::parseVolumeInformationWithValidation(size_t offset) {
-    validator->setRecordNumber(recordnum);
-    auto result = validator->validateVolumeInformation(rawRecord, offset, volumeInfo);
-    
-    if (!result.isValid && debugLevel > 0) {
-        log("Volume Information validation failed: " + result.errorMessage, 1);
-    }
-    
-    return result.isValid;
-}
-
-bool MftRecord::parseDataWithValidation(size_t offset) {
-    validator->setRecordNumber(recordnum);
-    auto result = validator->validateData(rawRecord, offset, dataAttribute);
-    
-    if (!result.isValid && debugLevel > 0) {
-        log("Data validation failed: " + result.errorMessage, 1);
-    }
-    
-    return result.isValid;
-}
-
-bool MftRecord::parseIndexRootWithValidation(size_t offset) {
-    validator->setRecordNumber(recordnum);
-    auto result = validator->validateIndexRoot(rawRecord, offset, indexRoot);
-    
-    if (!result.isValid && debugLevel > 0) {
-        log("Index Root validation failed: " + result.errorMessage, 1);
-    }
-    
-    return result.isValid;
-}
-
-bool MftRecord::parseIndexAllocationWithValidation(size_t offset) {
-    validator->setRecordNumber(recordnum);
-    auto result = validator->validateIndexAllocation(rawRecord, offset, indexAllocation);
-    
-    if (!result.isValid && debugLevel > 0) {
-        log("Index Allocation validation failed: " + result.errorMessage, 1);
-    }
-    
-    return result.isValid;
-}
-
-bool MftRecord::parseBitmapWithValidation(size_t offset) {
-    validator->setRecordNumber(recordnum);
-    auto result = validator->validateBitmap(rawRecord, offset, bitmap);
-    
-    if (!result.isValid && debugLevel > 0) {
-        log("Bitmap validation failed: " + result.errorMessage, 1);
-    }
-    
-    return result.isValid;
-}
-
-bool MftRecord::parseReparsePointWithValidation(size_t offset) {
-    validator->setRecordNumber(recordnum);
-    auto result = validator->validateReparsePoint(rawRecord, offset, reparsePoint);
-    
-    if (!result.isValid && debugLevel > 0) {
-        log("Reparse Point validation failed: " + result.errorMessage, 1);
-    }
-    
-    return result.isValid;
-}
-
-bool MftRecord::parseEaInformationWithValidation(size_t offset) {
-    validator->setRecordNumber(recordnum);
-    auto result = validator->validateEaInformation(rawRecord, offset, eaInformation);
-    
-    if (!result.isValid && debugLevel > 0) {
-        log("EA Information validation failed: " + result.errorMessage, 1);
-    }
-    
-    return result.isValid;
-}
-
-bool MftRecord::parseEaWithValidation(size_t offset) {
-    validator->setRecordNumber(recordnum);
-    auto result = validator->validateEa(rawRecord, offset, ea);
-    
-    if (!result.isValid && debugLevel > 0) {
-        log("EA validation failed: " + result.errorMessage, 1);
-    }
-    
-    return result.isValid;
-}
-
-bool MftRecord::parseLoggedUtilityStreamWithValidation(size_t offset) {
-    validator->setRecordNumber(recordnum);
-    auto result = validator->validateLoggedUtilityStream(rawRecord, offset, loggedUtilityStream);
-    
-    if (!result.isValid && debugLevel > 0) {
-        log("Logged Utility Stream validation failed: " + result.errorMessage, 1);
-    }
-    
-    return result.isValid;
-}
-
-
 void MftRecord::parseRecord() {
     if (rawRecord.size() < MFT_RECORD_SIZE) {
         if (debugLevel > 0) {
@@ -271,12 +121,30 @@ void MftRecord::parseRecord() {
             attrOff = 56;
         }
         
+        if (filter && !passesFilter(FILTER_FIELD_HEADER)) {
+            rejected = true;
+            return;
+        }
+        
+        // Hash the record as read, before the fixups rewrite the sector ends
+        if (computeHashesFlag) {
+            computeHashes();
+        }
+        
         if (!applyFixupArray()) {
             if (debugLevel > 0) {
                 log("Fixup array validation failed for record " + std::to_string(recordnum), 1);
             }
         }
         
+        buildAttributeTable();
+        
+        // Whatever the filter reads is decoded on demand through the accessors
+        if (filter && !passesFilter(FILTER_FIELDS_PARSED)) {
+            rejected = true;
+            return;
+        }
+        
         parseAttributes();
         
     } catch (const std::exception& e) {
@@ -288,195 +156,363 @@ void MftRecord::parseRecord() {
 }
 
 void MftRecord::parseAttributes() {
-    size_t offset = attrOff;
-    uint32_t attributeCount = 0;
-    const uint32_t MAX_ATTRIBUTES = 100; // Safety limit
+    for (size_t index = 0; index < attributeEntries; ++index) {
+        const AttributeEntry& entry = attributeTable[index];
+        if (!plan || plan->decodes(entry.type)) {
+            decodeAttribute(entry.type, entry.offset);
+        }
+    }
     
-    while (offset < rawRecord.size() - 8 && attributeCount < MAX_ATTRIBUTES) {
-        try {
-            if (debugLevel > 2) {
-                log("Parsing attribute at offset " + std::to_string(offset) + 
-                    " for record " + std::to_string(recordnum), 3);
-            }
-            
-            uint32_t attrType = readLittleEndian<uint32_t>(offset);
-            uint32_t attrLen = readLittleEndian<uint32_t>(offset + 4);
-            
-            if (debugLevel > 2) {
-                log("Attribute type: 0x" + std::to_string(attrType) + 
-                    ", length: " + std::to_string(attrLen) + 
-                    " for record " + std::to_string(recordnum), 3);
-            }
+    // Records with more attributes than the table holds: walk the rest
+    size_t offset = attributeOverflow;
+    uint32_t attrType = 0;
+    uint32_t attrLen = 0;
+    for (uint32_t count = attributeEntries; offset != 0 && count < MAX_ATTRIBUTES; ++count) {
+        if (!readAttributeHeader(offset, attrType, attrLen)) {
+            break;
+        }
+        if (!plan || plan->decodes(attrType)) {
+            decodeAttribute(attrType, offset);
+        }
+        offset += attrLen;
+    }
+}
 
-            // Check for end of attributes
-            if (attrType == 0xffffffff || attrLen == 0) {
-                if (debugLevel > 2) {
-                    log("End of attributes reached for record " + std::to_string(recordnum), 3);
-                }
+void MftRecord::decodeAttribute(uint32_t attrType, size_t offset) {
+    if (debugLevel > 2) {
+        log("Parsing attribute type: 0x" + std::to_string(attrType) + 
+            " at offset " + std::to_string(offset) + 
+            " for record " + std::to_string(recordnum), 3);
+    }
+    
+    try {
+        // Parse specific attribute types with enhanced error handling
+        bool parseSuccess = false;
+        switch (attrType) {
+            case STANDARD_INFORMATION_ATTRIBUTE: {
+                const StandardInformation& info = standardInformation();
+                siTimes.crtime = info.crtime;
+                siTimes.mtime = info.mtime;
+                siTimes.atime = info.atime;
+                siTimes.ctime = info.ctime;
+                parseSuccess = info.present;
                 break;
             }
-            
-            // Validate attribute length
-            if (attrLen < 16 || attrLen > (rawRecord.size() - offset)) {
+            case FILE_NAME_ATTRIBUTE:
+                // The last $FILE_NAME wins, as it always has
+                if (const FileNameInfo* name = fileName()) {
+                    parentRef = name->parentRecordNumber();
+                    fnTimes.crtime = name->crtime;
+                    fnTimes.mtime = name->mtime;
+                    fnTimes.atime = name->atime;
+                    fnTimes.ctime = name->ctime;
+                    filesize = name->realSize;
+                    filename = name->name;
+                    parseSuccess = true;
+                }
+                break;
+            case ATTRIBUTE_LIST_ATTRIBUTE:
+                parseAttributeList(offset);
+                parseSuccess = true;
+                break;
+            case OBJECT_ID_ATTRIBUTE:
+                parseObjectIdAttribute(offset);
+                parseSuccess = true;
+                break;
+            case SECURITY_DESCRIPTOR_ATTRIBUTE:
+                parseSecurityDescriptor(offset);
+                parseSuccess = true;
+                break;
+            case VOLUME_NAME_ATTRIBUTE:
+                parseVolumeName(offset);
+                parseSuccess = true;
+                break;
+            case VOLUME_INFORMATION_ATTRIBUTE:
+                parseVolumeInformation(offset);
+                parseSuccess = true;
+                break;
+            case DATA_ATTRIBUTE:
+                parseData(offset);
+                parseSuccess = true;
+                break;
+            case INDEX_ROOT_ATTRIBUTE:
+                parseIndexRoot(offset);
+                parseSuccess = true;
+                break;
+            case INDEX_ALLOCATION_ATTRIBUTE:
+                parseIndexAllocation(offset);
+                parseSuccess = true;
+                break;
+            case BITMAP_ATTRIBUTE:
+                parseBitmap(offset);
+                parseSuccess = true;
+                break;
+            case REPARSE_POINT_ATTRIBUTE:
+                parseReparsePoint(offset);
+                parseSuccess = true;
+                break;
+            case EA_INFORMATION_ATTRIBUTE:
+                parseEaInformation(offset);
+                parseSuccess = true;
+                break;
+            case EA_ATTRIBUTE:
+                parseEa(offset);
+                parseSuccess = true;
+                break;
+            case LOGGED_UTILITY_STREAM_ATTRIBUTE:
+                parseLoggedUtilityStream(offset);
+                parseSuccess = true;
+                break;
+            default:
                 if (debugLevel > 1) {
-                    log("Invalid attribute length: " + std::to_string(attrLen) + 
+                    log("Unknown attribute type: 0x" + std::to_string(attrType) + 
                         " at offset " + std::to_string(offset) + 
                         " for record " + std::to_string(recordnum), 2);
                 }
+                parseSuccess = true; // Continue parsing
                 break;
-            }
-            
-            // Ensure attribute length is properly aligned
-            if (attrLen % 8 != 0) {
-                if (debugLevel > 2) {
-                    log("Attribute length not 8-byte aligned: " + std::to_string(attrLen) + 
-                        " for record " + std::to_string(recordnum), 3);
-                }
-            }
-            
-            attributeTypes.insert(attrType);
-            attributeCount++;
-
-            // Parse specific attribute types with enhanced error handling
-            bool parseSuccess = false;
-            switch (attrType) {
-                case STANDARD_INFORMATION_ATTRIBUTE:
-                    parseSuccess = parseSiAttributeWithValidation(offset);
-                    break;
-                case FILE_NAME_ATTRIBUTE:
-                    parseSuccess = parseFnAttributeWithValidation(offset);
-                    break;
-                case ATTRIBUTE_LIST_ATTRIBUTE:
-                    parseSuccess = parseAttributeListWithValidation(offset);
-                    break;
-                case OBJECT_ID_ATTRIBUTE:
-                    parseSuccess = parseObjectIdAttributeWithValidation(offset);
-                    break;
-                case SECURITY_DESCRIPTOR_ATTRIBUTE:
-                    parseSuccess = parseSecurityDescriptorWithValidation(offset);
-                    break;
-                case VOLUME_NAME_ATTRIBUTE:
-                    parseSuccess = parseVolumeNameWithValidation(offset);
-                    break;
-                case VOLUME_INFORMATION_ATTRIBUTE:
-                    parseSuccess = parseVolumeInformationWithValidation(offset);
-                    break;
-                case DATA_ATTRIBUTE:
-                    parseSuccess = parseDataWithValidation(offset);
-                    break;
-                case INDEX_ROOT_ATTRIBUTE:
-                    parseSuccess = parseIndexRootWithValidation(offset);
-                    break;
-                case INDEX_ALLOCATION_ATTRIBUTE:
-                    parseSuccess = parseIndexAllocationWithValidation(offset);
-                    break;
-                case BITMAP_ATTRIBUTE:
-                    parseSuccess = parseBitmapWithValidation(offset);
-                    break;
-                case REPARSE_POINT_ATTRIBUTE:
-                    parseSuccess = parseReparsePointWithValidation(offset);
-                    break;
-                case EA_INFORMATION_ATTRIBUTE:
-                    parseSuccess = parseEaInformationWithValidation(offset);
-                    break;
-                case EA_ATTRIBUTE:
-                    parseSuccess = parseEaWithValidation(offset);
-                    break;
-                case LOGGED_UTILITY_STREAM_ATTRIBUTE:
-                    parseSuccess = parseLoggedUtilityStreamWithValidation(offset);
-                    break;
-                default:
-                    if (debugLevel > 1) {
-                        log("Unknown attribute type: 0x" + std::to_string(attrType) + 
-                            " at offset " + std::to_string(offset) + 
-                            " for record " + std::to_string(recordnum), 2);
-                    }
-                    parseSuccess = true; // Continue parsing
-                    break;
-            }
-            
-            if (!parseSuccess && debugLevel > 1) {
-                log("Failed to parse attribute type 0x" + std::to_string(attrType) + 
-                    " for record " + std::to_string(recordnum), 2);
-            }
+        }
+        
+        if (!parseSuccess && debugLevel > 1) {
+            log("Failed to parse attribute type 0x" + std::to_string(attrType) + 
+                " for record " + std::to_string(recordnum), 2);
+        }
+    } catch (const std::exception& e) {
+        if (debugLevel >= 1) {
+            log("Exception processing attribute at offset " + std::to_string(offset) + 
+                " for record " + std::to_string(recordnum) + ": " + e.what(), 1);
+        }
+    }
+}
 
-            offset += attrLen;
+bool MftRecord::passesFilter(uint32_t knownFields) const {
+    return filter->evaluate(*this, knownFields) != RecordFilter::Result::False;
+}
 
-        } catch (const std::exception& e) {
-            if (debugLevel >= 1) {
-                log("Exception processing attribute at offset " + std::to_string(offset) + 
-                    " for record " + std::to_string(recordnum) + ": " + e.what(), 1);
-            }
-            offset += 16; // Skip minimal attribute header size
+bool MftRecord::readAttributeHeader(size_t offset, uint32_t& attrType, uint32_t& attrLen) const {
+    if (offset + 16 > rawRecord.size()) {
+        return false;
+    }
+    attrType = readLittleEndian<uint32_t>(offset);
+    attrLen = readLittleEndian<uint32_t>(offset + 4);
+    
+    // Check for end of attributes
+    if (attrType == 0xffffffff || attrLen == 0) {
+        if (debugLevel > 2) {
+            log("End of attributes reached for record " + std::to_string(recordnum), 3);
         }
+        return false;
     }
     
-    if (attributeCount >= MAX_ATTRIBUTES) {
-        if (debugLevel > 0) {
-            log("Maximum attribute limit reached for record " + std::to_string(recordnum), 1);
+    // Validate attribute length
+    if (attrLen < 16 || attrLen > (rawRecord.size() - offset)) {
+        if (debugLevel > 1) {
+            log("Invalid attribute length: " + std::to_string(attrLen) + 
+                " at offset " + std::to_string(offset) + 
+                " for record " + std::to_string(recordnum), 2);
         }
+        return false;
     }
+    return true;
 }
 
-void MftRecord::parseSiAttribute(size_t offset) {
-    if (offset + 72 > rawRecord.size()) return;
+// The one walk over the attribute headers: fills the offset table and the
+// attribute presence set; content is decoded later, on demand
+void MftRecord::buildAttributeTable() {
+    size_t offset = attrOff;
+    uint32_t attrType = 0;
+    uint32_t attrLen = 0;
+    uint32_t count = 0;
     
-    size_t dataOffset = offset + 24;
-    if (dataOffset + 32 <= rawRecord.size()) {
-        try {
-            uint32_t crLow = readLittleEndian<uint32_t>(dataOffset);
-            uint32_t crHigh = readLittleEndian<uint32_t>(dataOffset + 4);
-            uint32_t mLow = readLittleEndian<uint32_t>(dataOffset + 8);
-            uint32_t mHigh = readLittleEndian<uint32_t>(dataOffset + 12);
-            uint32_t cLow = readLittleEndian<uint32_t>(dataOffset + 16);
-            uint32_t cHigh = readLittleEndian<uint32_t>(dataOffset + 20);
-            uint32_t aLow = readLittleEndian<uint32_t>(dataOffset + 24);
-            uint32_t aHigh = readLittleEndian<uint32_t>(dataOffset + 28);
-            
-            siTimes.crtime = WindowsTime(crLow, crHigh);
-            siTimes.mtime = WindowsTime(mLow, mHigh);
-            siTimes.ctime = WindowsTime(cLow, cHigh);
-            siTimes.atime = WindowsTime(aLow, aHigh);
-        } catch (const std::exception& e) {
-            // Handle error
+    while (count < MAX_ATTRIBUTES && readAttributeHeader(offset, attrType, attrLen)) {
+        attributeTypes.insert(attrType);
+        
+        if (attributeEntries < MAX_INLINE_ATTRIBUTES) {
+            AttributeEntry& entry = attributeTable[attributeEntries++];
+            entry.type = attrType;
+            entry.length = attrLen;
+            entry.offset = static_cast<uint16_t>(offset);
+            entry.nonResident = rawRecord[offset + 8] != 0;
+            entry.nameLength = rawRecord[offset + 9];
+            entry.nameOffset = readLittleEndian<uint16_t>(offset + 10);
+        } else if (attributeOverflow == 0) {
+            attributeOverflow = offset;
+        }
+        
+        offset += attrLen;
+        count++;
+    }
+    attributesIndexed = true;
+    
+    if (count >= MAX_ATTRIBUTES && debugLevel > 0) {
+        log("Maximum attribute limit reached for record " + std::to_string(recordnum), 1);
+    }
+}
+
+bool MftRecord::residentContent(const AttributeEntry& entry, size_t minimumLength,
+                                size_t& contentOffset) const {
+    if (entry.nonResident || entry.length < 24) {
+        return false;
+    }
+    uint32_t contentLength = readLittleEndian<uint32_t>(entry.offset + 16);
+    contentOffset = entry.offset + readLittleEndian<uint16_t>(entry.offset + 20);
+    return contentLength >= minimumLength &&
+           contentOffset + minimumLength <= static_cast<size_t>(entry.offset) + entry.length;
+}
+
+bool MftRecord::decodeStandardInformation(const AttributeEntry& entry, StandardInformation& info) const {
+    size_t dataOffset = 0;
+    if (!residentContent(entry, 36, dataOffset)) {
+        return false;
+    }
+    info.crtime = WindowsTime(readLittleEndian<uint32_t>(dataOffset), readLittleEndian<uint32_t>(dataOffset + 4));
+    info.mtime = WindowsTime(readLittleEndian<uint32_t>(dataOffset + 8), readLittleEndian<uint32_t>(dataOffset + 12));
+    info.ctime = WindowsTime(readLittleEndian<uint32_t>(dataOffset + 16), readLittleEndian<uint32_t>(dataOffset + 20));
+    info.atime = WindowsTime(readLittleEndian<uint32_t>(dataOffset + 24), readLittleEndian<uint32_t>(dataOffset + 28));
+    info.fileAttributes = readLittleEndian<uint32_t>(dataOffset + 32);
+    
+    // NTFS 3.0 grew the attribute from 48 to 72 bytes
+    size_t extendedOffset = 0;
+    if (residentContent(entry, 72, extendedOffset)) {
+        info.ownerId = readLittleEndian<uint32_t>(dataOffset + 48);
+        info.securityId = readLittleEndian<uint32_t>(dataOffset + 52);
+        info.usn = readLittleEndian<uint64_t>(dataOffset + 64);
+        info.extended = true;
+    }
+    info.present = true;
+    return true;
+}
+
+bool MftRecord::decodeFileName(const AttributeEntry& entry, FileNameInfo& info) const {
+    size_t dataOffset = 0;
+    if (!residentContent(entry, 66, dataOffset)) {
+        return false;
+    }
+    info.parentRef = readLittleEndian<uint64_t>(dataOffset);
+    info.crtime = WindowsTime(readLittleEndian<uint32_t>(dataOffset + 8), readLittleEndian<uint32_t>(dataOffset + 12));
+    info.mtime = WindowsTime(readLittleEndian<uint32_t>(dataOffset + 16), readLittleEndian<uint32_t>(dataOffset + 20));
+    info.ctime = WindowsTime(readLittleEndian<uint32_t>(dataOffset + 24), readLittleEndian<uint32_t>(dataOffset + 28));
+    info.atime = WindowsTime(readLittleEndian<uint32_t>(dataOffset + 32), readLittleEndian<uint32_t>(dataOffset + 36));
+    info.allocatedSize = readLittleEndian<uint64_t>(dataOffset + 40);
+    info.realSize = readLittleEndian<uint64_t>(dataOffset + 48);
+    info.fileAttributes = readLittleEndian<uint32_t>(dataOffset + 56);
+    
+    uint8_t nameLen = rawRecord[dataOffset + 64];
+    info.nameSpace = rawRecord[dataOffset + 65];
+    if (dataOffset + 66 + nameLen * 2 <= static_cast<size_t>(entry.offset) + entry.length) {
+        info.name = readUtf16String(dataOffset + 66, nameLen);
+    }
+    return true;
+}
+
+DataStream MftRecord::decodeDataStream(const AttributeEntry& entry) const {
+    DataStream stream;
+    stream.nonResident = entry.nonResident;
+    if (entry.nameLength > 0 &&
+        entry.nameOffset + entry.nameLength * 2u <= entry.length) {
+        stream.name = readUtf16String(entry.offset + entry.nameOffset, entry.nameLength);
+    }
+    if (!entry.nonResident) {
+        stream.size = readLittleEndian<uint32_t>(entry.offset + 16);
+        stream.allocatedSize = stream.size;
+    } else if (entry.length >= 56) {
+        stream.allocatedSize = readLittleEndian<uint64_t>(entry.offset + 40);
+        stream.size = readLittleEndian<uint64_t>(entry.offset + 48);
+    }
+    return stream;
+}
+
+const StandardInformation& MftRecord::standardInformation() const {
+    if (!(decoded & DECODED_STANDARD_INFORMATION)) {
+        decoded |= DECODED_STANDARD_INFORMATION;
+        if (attributesIndexed) {
+            for (size_t index = 0; index < attributeEntries; ++index) {
+                if (attributeTable[index].type == STANDARD_INFORMATION_ATTRIBUTE &&
+                    decodeStandardInformation(attributeTable[index], standardInformationCache)) {
+                    break;
+                }
+            }
+        } else if (attributeTypes.count(STANDARD_INFORMATION_ATTRIBUTE)) {
+            standardInformationCache.crtime = siTimes.crtime;
+            standardInformationCache.mtime = siTimes.mtime;
+            standardInformationCache.atime = siTimes.atime;
+            standardInformationCache.ctime = siTimes.ctime;
+            standardInformationCache.present = true;
+        }
+    }
+    return standardInformationCache;
+}
+
+const std::vector<FileNameInfo>& MftRecord::fileNames() const {
+    if (!(decoded & DECODED_FILE_NAMES)) {
+        decoded |= DECODED_FILE_NAMES;
+        if (attributesIndexed) {
+            for (size_t index = 0; index < attributeEntries; ++index) {
+                FileNameInfo info;
+                if (attributeTable[index].type == FILE_NAME_ATTRIBUTE &&
+                    decodeFileName(attributeTable[index], info)) {
+                    fileNameCache.push_back(std::move(info));
+                }
+            }
+        } else if (attributeTypes.count(FILE_NAME_ATTRIBUTE) || !filename.empty()) {
+            FileNameInfo info;
+            info.parentRef = parentRef;
+            info.crtime = fnTimes.crtime;
+            info.mtime = fnTimes.mtime;
+            info.atime = fnTimes.atime;
+            info.ctime = fnTimes.ctime;
+            info.realSize = filesize;
+            info.name = filename;
+            fileNameCache.push_back(std::move(info));
         }
     }
+    return fileNameCache;
 }
 
-void MftRecord::parseFnAttribute(size_t offset) {
-    if (offset + 90 > rawRecord.size()) return;
+const FileNameInfo* MftRecord::fileName() const {
+    const std::vector<FileNameInfo>& names = fileNames();
+    return names.empty() ? nullptr : &names.back();
+}
+
+void MftRecord::decodeAll() const {
+    auto format = [](const WindowsTime& time) { time.getDateTimeString(); };
+    for (const WindowsTime* time : {&siTimes.crtime, &siTimes.mtime, &siTimes.atime, &siTimes.ctime,
+                                    &fnTimes.crtime, &fnTimes.mtime, &fnTimes.atime, &fnTimes.ctime}) {
+        format(*time);
+    }
     
-    size_t dataOffset = offset + 24;
-    if (dataOffset + 64 <= rawRecord.size()) {
-        try {
-            parentRef = readLittleEndian<uint64_t>(dataOffset) & 0x0000FFFFFFFFFFFF;
-            
-            uint32_t crLow = readLittleEndian<uint32_t>(dataOffset + 8);
-            uint32_t crHigh = readLittleEndian<uint32_t>(dataOffset + 12);
-            uint32_t mLow = readLittleEndian<uint32_t>(dataOffset + 16);
-            uint32_t mHigh = readLittleEndian<uint32_t>(dataOffset + 20);
-            uint32_t cLow = readLittleEndian<uint32_t>(dataOffset + 24);
-            uint32_t cHigh = readLittleEndian<uint32_t>(dataOffset + 28);
-            uint32_t aLow = readLittleEndian<uint32_t>(dataOffset + 32);
-            uint32_t aHigh = readLittleEndian<uint32_t>(dataOffset + 36);
-            
-            fnTimes.crtime = WindowsTime(crLow, crHigh);
-            fnTimes.mtime = WindowsTime(mLow, mHigh);
-            fnTimes.ctime = WindowsTime(cLow, cHigh);
-            fnTimes.atime = WindowsTime(aLow, aHigh);
-            
-            filesize = readLittleEndian<uint64_t>(dataOffset + 48);
-            
-            if (dataOffset + 64 < rawRecord.size()) {
-                uint8_t nameLen = rawRecord[dataOffset + 64];
-                if (dataOffset + 66 + nameLen * 2 <= rawRecord.size()) {
-                    filename = readUtf16String(dataOffset + 66, nameLen);
+    const StandardInformation& info = standardInformation();
+    format(info.crtime);
+    format(info.mtime);
+    format(info.atime);
+    format(info.ctime);
+    for (const auto& name : fileNames()) {
+        format(name.crtime);
+        format(name.mtime);
+        format(name.atime);
+        format(name.ctime);
+    }
+    dataStreams();
+}
+
+const std::vector<DataStream>& MftRecord::dataStreams() const {
+    if (!(decoded & DECODED_DATA_STREAMS)) {
+        decoded |= DECODED_DATA_STREAMS;
+        if (attributesIndexed) {
+            for (size_t index = 0; index < attributeEntries; ++index) {
+                if (attributeTable[index].type == DATA_ATTRIBUTE) {
+                    dataStreamCache.push_back(decodeDataStream(attributeTable[index]));
                 }
             }
-        } catch (const std::exception& e) {
-            // Handle error
+        } else if (dataAttribute) {
+            DataStream stream;
+            stream.name = dataAttribute->name;
+            stream.nonResident = dataAttribute->nonResident;
+            stream.size = dataAttribute->nonResident ? 0 : dataAttribute->contentSize;
+            dataStreamCache.push_back(std::move(stream));
         }
     }
+    return dataStreamCache;
 }
 
 void MftRecord::parseObjectIdAttribute(size_t offset) {
@@ -815,12 +851,6 @@ bool MftRecord::validateFixupArray() const {
     }
 }
 
-void MftRecord::log(const std::string& message, int level) const {
-    if (level <= debugLevel) {
-        std::cout << message << std::endl;
-    }
-}
-
 std::string MftRecord::readUtf16String(size_t offset, size_t length) const {
     if (offset + length * 2 > rawRecord.size()) {
         return "";
@@ -857,15 +887,7 @@ uint64_t MftRecord::getParentRecordNum() const {
 }
 
 std::string MftRecord::getFileType() const {
-    if (flags & FILE_RECORD_IS_DIRECTORY) {
-        return "Directory";
-    } else if (flags & FILE_RECORD_IS_EXTENSION) {
-        return "Extension";
-    } else if (flags & FILE_RECORD_HAS_SPECIAL_INDEX) {
-        return "Special Index";
-    } else {
-        return "File";
-    }
+    return fileTypeName(flags);
 }
 
 void MftRecord::computeHashes() {
@@ -880,72 +902,27 @@ void MftRecord::computeHashes() {
 
 std::vector<std::string> MftRecord::toCsv() const {
     std::vector<std::string> row;
-    
-    row.push_back(std::to_string(recordnum));
-    row.push_back((magic == MFT_RECORD_MAGIC) ? "Valid" : "Invalid");
-    row.push_back((flags & FILE_RECORD_IN_USE) ? "In Use" : "Not in Use");
-    row.push_back(getFileType());
-    row.push_back(std::to_string(seq));
-    row.push_back(std::to_string(getParentRecordNum()));
-    row.push_back(std::to_string(baseRef >> 48));
-    
-    row.push_back(filename);
-    row.push_back("");  // Filepath to be filled later
-    
-    row.push_back(siTimes.crtime.getDateTimeString());
-    row.push_back(siTimes.mtime.getDateTimeString());
-    row.push_back(siTimes.atime.getDateTimeString());
-    row.push_back(siTimes.ctime.getDateTimeString());
-    
-    row.push_back(fnTimes.crtime.getDateTimeString());
-    row.push_back(fnTimes.mtime.getDateTimeString());
-    row.push_back(fnTimes.atime.getDateTimeString());
-    row.push_back(fnTimes.ctime.getDateTimeString());
-    
-    row.push_back(objectId);
-    row.push_back(birthVolumeId);
-    row.push_back(birthObjectId);
-    row.push_back(birthDomainId);
-    
-    row.push_back(attributeTypes.count(STANDARD_INFORMATION_ATTRIBUTE) ? "True" : "False");
-    row.push_back(attributeTypes.count(ATTRIBUTE_LIST_ATTRIBUTE) ? "True" : "False");
-    row.push_back(attributeTypes.count(FILE_NAME_ATTRIBUTE) ? "True" : "False");
-    row.push_back(attributeTypes.count(VOLUME_NAME_ATTRIBUTE) ? "True" : "False");
-    row.push_back(attributeTypes.count(VOLUME_INFORMATION_ATTRIBUTE) ? "True" : "False");
-    row.push_back(attributeTypes.count(DATA_ATTRIBUTE) ? "True" : "False");
-    row.push_back(attributeTypes.count(INDEX_ROOT_ATTRIBUTE) ? "True" : "False");
-    row.push_back(attributeTypes.count(INDEX_ALLOCATION_ATTRIBUTE) ? "True" : "False");
-    row.push_back(attributeTypes.count(BITMAP_ATTRIBUTE) ? "True" : "False");
-    row.push_back(attributeTypes.count(REPARSE_POINT_ATTRIBUTE) ? "True" : "False");
-    row.push_back(attributeTypes.count(EA_INFORMATION_ATTRIBUTE) ? "True" : "False");
-    row.push_back(attributeTypes.count(EA_ATTRIBUTE) ? "True" : "False");
-    row.push_back(attributeTypes.count(LOGGED_UTILITY_STREAM_ATTRIBUTE) ? "True" : "False");
-    
-    // Add detailed attribute information (simplified for now)
-    row.push_back("");  // Attribute List Details
-    row.push_back(securityDescriptor ? "Present" : "");
-    row.push_back(volumeName);
-    row.push_back(volumeInfo ? "Present" : "");
-    row.push_back(dataAttribute ? "Present" : "");
-    row.push_back(indexRoot ? "Present" : "");
-    row.push_back(indexAllocation ? "Present" : "");
-    row.push_back(bitmap ? "Present" : "");
-    row.push_back(reparsePoint ? "Present" : "");
-    row.push_back(eaInformation ? "Present" : "");
-    row.push_back(ea ? "Present" : "");
-    row.push_back(loggedUtilityStream ? "Present" : "");
-    
-    if (computeHashesFlag) {
-        row.push_back(md5);
-        row.push_back(sha256);
-        row.push_back(sha512);
-        row.push_back(crc32);
-    } else {
-        row.push_back("");
-        row.push_back("");
-        row.push_back("");
-        row.push_back("");
+    row.reserve(CSV_COLUMN_COUNT);
+    for (size_t column = 0; column < CSV_COLUMN_COUNT; ++column) {
+        row.push_back(getColumn(column));
+    }
+    return row;
+}
+
+std::vector<std::string> MftRecord::toCsv(const std::vector<size_t>& columns) const {
+    std::vector<std::string> row;
+    row.reserve(columns.size());
+    for (size_t column : columns) {
+        row.push_back(getColumn(column));
     }
-    
     return row;
-}
\ No newline at end of file
+}
+
+std::string MftRecord::getColumn(size_t column) const {
+    if (column >= CSV_COLUMN_COUNT) {
+        return "";
+    }
+    char digits[20];
+    const ColumnDescriptor& descriptor = COLUMNS[column];
+    return std::string(columnText(descriptor.type, descriptor.get(*this), digits));
+}
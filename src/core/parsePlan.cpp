@@ -0,0 +1,83 @@
+#include "parsePlan.h"
+#include "columnSchema.h"
+#include "../utils/stringUtils.h"
+#include <algorithm>
+
+ParsePlan::ParsePlan()
+    : columnMask(0), attributes(PARSE_ALL_ATTRIBUTES), paths(true), hashes(true), projected(false) {
+    for (size_t column = 0; column < CSV_COLUMN_COUNT; ++column) {
+        columns.push_back(column);
+        columnMask |= 1ULL << column;
+    }
+}
+
+ParsePlan ParsePlan::attributesOnly(uint32_t attributes) {
+    ParsePlan plan;
+    plan.columns.clear();
+    plan.columnMask = 0;
+    plan.attributes = attributes;
+    plan.paths = false;
+    plan.hashes = false;
+    plan.projected = true;
+    return plan;
+}
+
+bool ParsePlan::selectColumns(const std::string& list, std::string& error) {
+    std::vector<size_t> selected;
+    uint64_t mask = 0;
+
+    for (const auto& item : StringUtils::split(list, ',')) {
+        std::string name = StringUtils::toLower(StringUtils::trim(item));
+        if (name.empty()) {
+            continue;
+        }
+        size_t column = 0;
+        while (column < CSV_COLUMN_COUNT && name != columnKey(column) &&
+               name != StringUtils::toLower(COLUMNS[column].header) &&
+               name != StringUtils::toLower(COLUMNS[column].key)) {
+            column++;
+        }
+        if (column == CSV_COLUMN_COUNT) {
+            error = "Unknown field '" + StringUtils::trim(item) + "'";
+            return false;
+        }
+        if (!(mask & (1ULL << column))) {
+            mask |= 1ULL << column;
+            selected.push_back(column);
+        }
+    }
+    if (selected.empty()) {
+        error = "No fields selected";
+        return false;
+    }
+
+    columns = std::move(selected);
+    columnMask = mask;
+    attributes = 0;
+    paths = false;
+    hashes = false;
+    projected = true;
+    for (size_t column : columns) {
+        attributes |= attributeBit(COLUMNS[column].attribute);
+        paths = paths || column == CSV_FILEPATH;
+        hashes = hashes || (column >= CSV_MD5 && column <= CSV_CRC32);
+    }
+    return true;
+}
+
+bool ParsePlan::selects(size_t column) const {
+    return column < CSV_COLUMN_COUNT && (columnMask & (1ULL << column)) != 0;
+}
+
+const std::string& ParsePlan::columnKey(size_t column) {
+    static const std::vector<std::string> keys = [] {
+        std::vector<std::string> result;
+        for (const auto& column : COLUMNS) {
+            std::string key = StringUtils::toLower(column.header);
+            std::replace(key.begin(), key.end(), ' ', '_');
+            result.push_back(key);
+        }
+        return result;
+    }();
+    return keys[column];
+}
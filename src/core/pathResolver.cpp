@@ -0,0 +1,90 @@
+#include "pathResolver.h"
+#include "mftRecord.h"
+#include <algorithm>
+
+PathResolver::PathResolver() : recordCount(0) {
+}
+
+void PathResolver::addRecord(uint32_t recordNumber, uint64_t parentRecordNumber, const std::string& name) {
+    if (recordNumber >= entries.size()) {
+        entries.resize(std::max<size_t>(recordNumber + 1, entries.size() * 2));
+    }
+
+    Entry& entry = entries[recordNumber];
+    if (!entry.present) {
+        recordCount++;
+    }
+    entry.parent = parentRecordNumber;
+    entry.name = name;
+    entry.present = true;
+}
+
+void PathResolver::addRecord(const MftRecord& record) {
+    const FileNameInfo* name = record.fileName();
+    addRecord(record.recordnum, name ? name->parentRecordNumber() : 0, name ? name->name : std::string());
+}
+
+bool PathResolver::contains(uint32_t recordNumber) const {
+    return recordNumber < entries.size() && entries[recordNumber].present;
+}
+
+void PathResolver::clear() {
+    entries.clear();
+    recordCount = 0;
+}
+
+std::string PathResolver::resolve(uint32_t recordNumber) const {
+    std::vector<const std::string*> parts;
+    std::vector<std::string> generated;
+    generated.reserve(MAX_PATH_DEPTH + 2);
+
+    uint64_t current = recordNumber;
+    int maxDepth = MAX_PATH_DEPTH;
+    bool rooted = false;
+
+    while (maxDepth > 0) {
+        if (current > UINT32_MAX || !contains(static_cast<uint32_t>(current))) {
+            generated.push_back("UnknownParent_" + std::to_string(current));
+            parts.push_back(&generated.back());
+            break;
+        }
+
+        const Entry& entry = entries[current];
+        if (current == ROOT_RECORD_NUMBER) {
+            rooted = true;
+            break;
+        } else if (!entry.name.empty()) {
+            parts.push_back(&entry.name);
+        } else {
+            generated.push_back("Unknown_" + std::to_string(current));
+            parts.push_back(&generated.back());
+        }
+
+        if (entry.parent == current) {
+            generated.push_back("OrphanedFiles");
+            parts.push_back(&generated.back());
+            break;
+        }
+
+        current = entry.parent;
+        maxDepth--;
+    }
+
+    if (maxDepth == 0) {
+        generated.push_back("DeepPath");
+        parts.push_back(&generated.back());
+    }
+
+    std::string result;
+    if (rooted) {
+        // The root directory contributes an empty leading component
+        result = parts.empty() ? "" : "\\";
+    }
+    for (auto it = parts.rbegin(); it != parts.rend(); ++it) {
+        result += **it;
+        if (it + 1 != parts.rend()) {
+            result += "\\";
+        }
+    }
+    return result;
+}
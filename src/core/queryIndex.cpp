@@ -0,0 +1,512 @@
+#include "queryIndex.h"
+#include "../utils/stringUtils.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+
+namespace {
+
+constexpr size_t SECTION_ALIGNMENT = 64;
+constexpr uint32_t TRIGRAM_SPACE = 1u << 24;
+
+// Same section-directory container as SnapshotWriter produces
+class SectionFileWriter {
+public:
+    bool open(const std::string& path) {
+        file.open(path, std::ios::binary | std::ios::trunc);
+        offset = 0;
+        return file.is_open();
+    }
+
+    bool write(const void* data, size_t length) {
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(length));
+        offset += length;
+        return file.good();
+    }
+
+    bool align() {
+        static const char padding[SECTION_ALIGNMENT] = {0};
+        size_t remainder = static_cast<size_t>(offset % SECTION_ALIGNMENT);
+        return remainder == 0 || write(padding, SECTION_ALIGNMENT - remainder);
+    }
+
+    bool beginSection(uint32_t id, uint32_t elementSize) {
+        if (!align()) {
+            return false;
+        }
+        sections.push_back({id, elementSize, offset, 0});
+        return true;
+    }
+
+    bool append(const void* data, size_t length) {
+        sections.back().length += length;
+        return length == 0 || write(data, length);
+    }
+
+    template<typename T>
+    bool section(uint32_t id, const std::vector<T>& values) {
+        return beginSection(id, sizeof(T)) && append(values.data(), values.size() * sizeof(T));
+    }
+
+    bool finish(QueryIndexHeader& header) {
+        if (!align()) {
+            return false;
+        }
+        header.directoryOffset = offset;
+        header.sectionCount = static_cast<uint32_t>(sections.size());
+        if (!write(sections.data(), sections.size() * sizeof(SnapshotSectionEntry))) {
+            return false;
+        }
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.close();
+        return !file.fail();
+    }
+
+private:
+    std::ofstream file;
+    uint64_t offset = 0;
+    std::vector<SnapshotSectionEntry> sections;
+};
+
+inline uint8_t lowerAscii(char c) {
+    uint8_t byte = static_cast<uint8_t>(c);
+    return (byte >= 'A' && byte <= 'Z') ? static_cast<uint8_t>(byte + 32) : byte;
+}
+
+inline uint32_t trigramKey(const char* text) {
+    return (static_cast<uint32_t>(lowerAscii(text[0])) << 16) |
+           (static_cast<uint32_t>(lowerAscii(text[1])) << 8) |
+           lowerAscii(text[2]);
+}
+
+void collectTrigrams(const char* text, size_t length, std::vector<uint32_t>& trigrams) {
+    trigrams.clear();
+    for (size_t i = 0; i + 3 <= length; ++i) {
+        trigrams.push_back(trigramKey(text + i));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+// Counting sort into per-trigram posting lists; rows come out ascending
+// because they are visited in order.
+void buildTrigramIndex(const Snapshot& snapshot, int column, std::vector<uint32_t>& keys,
+                       std::vector<uint64_t>& offsets, std::vector<uint32_t>& postings) {
+    std::vector<uint32_t> counts(TRIGRAM_SPACE, 0);
+    std::vector<uint32_t> trigrams;
+    size_t rows = static_cast<size_t>(snapshot.size());
+
+    for (size_t row = 0; row < rows; ++row) {
+        size_t length = 0;
+        const char* text = snapshot.stringData(column, row, length);
+        collectTrigrams(text, length, trigrams);
+        for (uint32_t trigram : trigrams) {
+            counts[trigram]++;
+        }
+    }
+
+    uint64_t total = 0;
+    for (uint32_t trigram = 0; trigram < TRIGRAM_SPACE; ++trigram) {
+        if (counts[trigram] == 0) {
+            continue;
+        }
+        uint32_t count = counts[trigram];
+        counts[trigram] = static_cast<uint32_t>(keys.size());
+        keys.push_back(trigram);
+        offsets.push_back(total);
+        total += count;
+    }
+    offsets.push_back(total);
+
+    postings.resize(total);
+    std::vector<uint64_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t row = 0; row < rows; ++row) {
+        size_t length = 0;
+        const char* text = snapshot.stringData(column, row, length);
+        collectTrigrams(text, length, trigrams);
+        for (uint32_t trigram : trigrams) {
+            postings[cursor[counts[trigram]]++] = static_cast<uint32_t>(row);
+        }
+    }
+}
+
+bool containsIgnoreCase(const char* text, size_t length, const std::string& lowerNeedle) {
+    if (lowerNeedle.size() > length) {
+        return false;
+    }
+    for (size_t i = 0; i + lowerNeedle.size() <= length; ++i) {
+        size_t j = 0;
+        while (j < lowerNeedle.size() && lowerAscii(text[i + j]) == static_cast<uint8_t>(lowerNeedle[j])) {
+            ++j;
+        }
+        if (j == lowerNeedle.size()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string toLowerAscii(const std::string& text) {
+    std::string lower(text);
+    for (char& c : lower) {
+        c = static_cast<char>(lowerAscii(c));
+    }
+    return lower;
+}
+
+bool splitRange(const std::string& spec, std::string& low, std::string& high) {
+    size_t dots = spec.find("..");
+    if (dots == std::string::npos) {
+        return false;
+    }
+    low = spec.substr(0, dots);
+    high = spec.substr(dots + 2);
+    return true;
+}
+
+}
+
+bool MftQuery::parseTimeFilter(const std::string& spec, TimeFilter& filter) {
+    static const char* const names[SNAPSHOT_TIME_COUNT] = {
+        "si-created", "si-modified", "si-accessed", "si-changed",
+        "fn-created", "fn-modified", "fn-accessed", "fn-changed"
+    };
+
+    size_t equals = spec.find('=');
+    if (equals == std::string::npos) {
+        return false;
+    }
+    std::string field = toLowerAscii(spec.substr(0, equals));
+    auto name = std::find(std::begin(names), std::end(names), field);
+    if (name == std::end(names)) {
+        return false;
+    }
+    filter.field = static_cast<int>(name - std::begin(names));
+
+    std::string low, high;
+    if (!splitRange(spec.substr(equals + 1), low, high)) {
+        return false;
+    }
+    filter.range = QueryRange();
+    uint64_t unused = 0;
+    return (low.empty() || WindowsTime::parseTimestamp(low, filter.range.min, unused)) &&
+           (high.empty() || WindowsTime::parseTimestamp(high, unused, filter.range.max));
+}
+
+bool MftQuery::parseSizeRange(const std::string& spec, QueryRange& range) {
+    std::string low, high;
+    if (!splitRange(spec, low, high)) {
+        return false;
+    }
+    range = QueryRange();
+    return (low.empty() || StringUtils::parseByteSize(low, range.min)) &&
+           (high.empty() || StringUtils::parseByteSize(high, range.max));
+}
+
+QueryIndex::QueryIndex()
+    : snapshot(nullptr), header(nullptr), timeOrders(nullptr), sizeOrder(nullptr) {
+}
+
+bool QueryIndex::build(const Snapshot& snapshot, const std::string& path, std::string& error) {
+    SectionFileWriter writer;
+    if (!writer.open(path)) {
+        error = "Cannot create index: " + path;
+        return false;
+    }
+
+    QueryIndexHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, QUERY_INDEX_MAGIC, sizeof(header.magic));
+    header.version = QUERY_INDEX_VERSION;
+    header.recordCount = snapshot.size();
+    header.snapshotCreated = snapshot.getStatistics().createdTime;
+
+    // Placeholder; finish() rewrites it with the directory offset
+    bool success = writer.write(&header, sizeof(header));
+
+    const struct { int column; uint32_t keysId; } trigramColumns[] = {
+        {SNAPSHOT_STRING_FILENAME, QUERY_SECTION_NAME_KEYS},
+        {SNAPSHOT_STRING_FILEPATH, QUERY_SECTION_PATH_KEYS}
+    };
+    for (const auto& column : trigramColumns) {
+        if (!success) {
+            break;
+        }
+        std::vector<uint32_t> keys;
+        std::vector<uint64_t> offsets;
+        std::vector<uint32_t> postings;
+        buildTrigramIndex(snapshot, column.column, keys, offsets, postings);
+        success = writer.section(column.keysId, keys) &&
+                  writer.section(column.keysId + 1, offsets) &&
+                  writer.section(column.keysId + 2, postings);
+    }
+
+    size_t rows = static_cast<size_t>(snapshot.size());
+    std::vector<uint32_t> order(rows);
+
+    success = success && writer.beginSection(QUERY_SECTION_TIME_ORDER, sizeof(uint32_t));
+    for (int field = 0; success && field < SNAPSHOT_TIME_COUNT; ++field) {
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&snapshot, field](uint32_t a, uint32_t b) {
+            return snapshot.time(a, field) < snapshot.time(b, field);
+        });
+        success = writer.append(order.data(), order.size() * sizeof(uint32_t));
+    }
+
+    if (success) {
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&snapshot](uint32_t a, uint32_t b) {
+            return snapshot.fileSize(a) < snapshot.fileSize(b);
+        });
+        success = writer.section(QUERY_SECTION_SIZE_ORDER, order) && writer.finish(header);
+    }
+
+    if (!success) {
+        error = "Error writing index: " + path;
+    }
+    return success;
+}
+
+const uint8_t* QueryIndex::findSection(uint32_t id, uint64_t elementSize, uint64_t& count) {
+    const auto* entries = reinterpret_cast<const SnapshotSectionEntry*>(file.data() + header->directoryOffset);
+    for (uint32_t i = 0; i < header->sectionCount; ++i) {
+        const SnapshotSectionEntry& entry = entries[i];
+        if (entry.id != id) {
+            continue;
+        }
+        if (entry.offset % SECTION_ALIGNMENT != 0 || entry.offset > file.size() ||
+            entry.length > file.size() - entry.offset || entry.length % elementSize != 0) {
+            lastError = "Corrupt index section " + std::to_string(id);
+            return nullptr;
+        }
+        count = entry.length / elementSize;
+        return file.data() + entry.offset;
+    }
+    lastError = "Index is missing section " + std::to_string(id);
+    return nullptr;
+}
+
+bool QueryIndex::open(const std::string& path, const Snapshot& snapshot) {
+    close();
+    lastError.clear();
+
+    if (!file.open(path)) {
+        lastError = "Cannot open index: " + path;
+        return false;
+    }
+    if (file.size() < sizeof(QueryIndexHeader) ||
+        std::memcmp(file.data(), QUERY_INDEX_MAGIC, sizeof(QUERY_INDEX_MAGIC)) != 0) {
+        lastError = "Not an analyzeMFT index: " + path;
+        close();
+        return false;
+    }
+
+    header = reinterpret_cast<const QueryIndexHeader*>(file.data());
+    if (header->version != QUERY_INDEX_VERSION ||
+        header->recordCount != snapshot.size() ||
+        header->snapshotCreated != snapshot.getStatistics().createdTime) {
+        lastError = "Index is out of date: " + path;
+        close();
+        return false;
+    }
+    if (header->directoryOffset > file.size() ||
+        header->sectionCount > (file.size() - header->directoryOffset) / sizeof(SnapshotSectionEntry)) {
+        lastError = "Corrupt index directory";
+        close();
+        return false;
+    }
+
+    uint64_t rows = header->recordCount;
+    uint64_t count = 0;
+    for (TrigramIndex* index : {&names, &paths}) {
+        uint32_t keysId = index == &names ? QUERY_SECTION_NAME_KEYS : QUERY_SECTION_PATH_KEYS;
+        uint64_t offsetCount = 0;
+        index->keys = reinterpret_cast<const uint32_t*>(findSection(keysId, 4, index->keyCount));
+        index->offsets = reinterpret_cast<const uint64_t*>(findSection(keysId + 1, 8, offsetCount));
+        index->postings = reinterpret_cast<const uint32_t*>(findSection(keysId + 2, 4, index->postingCount));
+        if (!index->keys || !index->offsets || !index->postings ||
+            offsetCount != index->keyCount + 1 || index->offsets[index->keyCount] != index->postingCount) {
+            if (lastError.empty()) {
+                lastError = "Corrupt trigram index";
+            }
+            close();
+            return false;
+        }
+    }
+
+    timeOrders = reinterpret_cast<const uint32_t*>(findSection(QUERY_SECTION_TIME_ORDER, 4, count));
+    if (!timeOrders || count != rows * SNAPSHOT_TIME_COUNT) {
+        lastError = lastError.empty() ? "Corrupt time index" : lastError;
+        close();
+        return false;
+    }
+    sizeOrder = reinterpret_cast<const uint32_t*>(findSection(QUERY_SECTION_SIZE_ORDER, 4, count));
+    if (!sizeOrder || count != rows) {
+        lastError = lastError.empty() ? "Corrupt size index" : lastError;
+        close();
+        return false;
+    }
+
+    this->snapshot = &snapshot;
+    return true;
+}
+
+void QueryIndex::close() {
+    file.close();
+    snapshot = nullptr;
+    header = nullptr;
+    names = TrigramIndex();
+    paths = TrigramIndex();
+    timeOrders = nullptr;
+    sizeOrder = nullptr;
+}
+
+bool QueryIndex::lookupTrigrams(const TrigramIndex& index, const std::string& needle, std::vector<Span>& spans) const {
+    std::vector<uint32_t> trigrams;
+    collectTrigrams(needle.data(), needle.size(), trigrams);
+
+    for (uint32_t trigram : trigrams) {
+        const uint32_t* end = index.keys + index.keyCount;
+        const uint32_t* key = std::lower_bound(index.keys, end, trigram);
+        if (key == end || *key != trigram) {
+            return false;
+        }
+        size_t slot = static_cast<size_t>(key - index.keys);
+        spans.push_back({index.postings + index.offsets[slot],
+                         static_cast<size_t>(index.offsets[slot + 1] - index.offsets[slot])});
+    }
+    return true;
+}
+
+QueryIndex::Span QueryIndex::timeSpan(const TimeFilter& filter) const {
+    size_t rows = static_cast<size_t>(header->recordCount);
+    const uint32_t* order = timeOrders + static_cast<size_t>(filter.field) * rows;
+    const Snapshot& data = *snapshot;
+    int field = filter.field;
+
+    const uint32_t* first = std::partition_point(order, order + rows, [&](uint32_t row) {
+        return data.time(row, field) < filter.range.min;
+    });
+    const uint32_t* last = std::partition_point(first, order + rows, [&](uint32_t row) {
+        return data.time(row, field) <= filter.range.max;
+    });
+    return {first, static_cast<size_t>(last - first)};
+}
+
+QueryIndex::Span QueryIndex::sizeSpan(const QueryRange& range) const {
+    size_t rows = static_cast<size_t>(header->recordCount);
+    const Snapshot& data = *snapshot;
+
+    const uint32_t* first = std::partition_point(sizeOrder, sizeOrder + rows, [&](uint32_t row) {
+        return data.fileSize(row) < range.min;
+    });
+    const uint32_t* last = std::partition_point(first, sizeOrder + rows, [&](uint32_t row) {
+        return data.fileSize(row) <= range.max;
+    });
+    return {first, static_cast<size_t>(last - first)};
+}
+
+bool QueryIndex::matches(const MftQuery& query, uint32_t row) const {
+    for (const TimeFilter& filter : query.times) {
+        uint64_t time = snapshot->time(row, filter.field);
+        if (time < filter.range.min || time > filter.range.max) {
+            return false;
+        }
+    }
+    if (query.filterSize) {
+        uint64_t size = snapshot->fileSize(row);
+        if (size < query.size.min || size > query.size.max) {
+            return false;
+        }
+    }
+
+    // Trigram hits are candidates only; confirm the substring itself.
+    // The needles are already lower-cased by search().
+    size_t length = 0;
+    if (!query.nameContains.empty()) {
+        const char* name = snapshot->stringData(SNAPSHOT_STRING_FILENAME, row, length);
+        if (!containsIgnoreCase(name, length, query.nameContains)) {
+            return false;
+        }
+    }
+    if (!query.pathContains.empty()) {
+        const char* path = snapshot->stringData(SNAPSHOT_STRING_FILEPATH, row, length);
+        if (!containsIgnoreCase(path, length, query.pathContains)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<uint32_t> QueryIndex::search(const MftQuery& query) const {
+    std::vector<uint32_t> result;
+    if (!header) {
+        return result;
+    }
+
+    std::vector<Span> postings;
+    if (!query.nameContains.empty() && !lookupTrigrams(names, query.nameContains, postings)) {
+        return result;
+    }
+    if (!query.pathContains.empty() && !lookupTrigrams(paths, query.pathContains, postings)) {
+        return result;
+    }
+
+    std::vector<Span> ranges;
+    for (const TimeFilter& filter : query.times) {
+        ranges.push_back(timeSpan(filter));
+    }
+    if (query.filterSize) {
+        ranges.push_back(sizeSpan(query.size));
+    }
+
+    auto bySize = [](const Span& a, const Span& b) { return a.count < b.count; };
+    std::sort(postings.begin(), postings.end(), bySize);
+    auto smallestRange = std::min_element(ranges.begin(), ranges.end(), bySize);
+
+    // Start from the most selective candidate set; range predicates other than
+    // the driver are cheaper to check per row than to materialize and sort.
+    std::vector<uint32_t> candidates;
+    size_t firstPosting = 0;
+    if (!postings.empty() && (ranges.empty() || postings.front().count <= smallestRange->count)) {
+        candidates.assign(postings.front().rows, postings.front().rows + postings.front().count);
+        firstPosting = 1;
+    } else if (!ranges.empty()) {
+        candidates.assign(smallestRange->rows, smallestRange->rows + smallestRange->count);
+        std::sort(candidates.begin(), candidates.end());
+    } else {
+        candidates.resize(static_cast<size_t>(header->recordCount));
+        std::iota(candidates.begin(), candidates.end(), 0u);
+    }
+
+    for (size_t i = firstPosting; i < postings.size() && !candidates.empty(); ++i) {
+        const uint32_t* position = postings[i].rows;
+        const uint32_t* end = postings[i].rows + postings[i].count;
+        size_t kept = 0;
+        for (uint32_t row : candidates) {
+            position = std::lower_bound(position, end, row);
+            if (position == end) {
+                break;
+            }
+            if (*position == row) {
+                candidates[kept++] = row;
+            }
+        }
+        candidates.resize(kept);
+    }
+
+    MftQuery lowered = query;
+    lowered.nameContains = toLowerAscii(query.nameContains);
+    lowered.pathContains = toLowerAscii(query.pathContains);
+    for (uint32_t row : candidates) {
+        if (matches(lowered, row)) {
+            result.push_back(row);
+            if (query.limit > 0 && result.size() >= query.limit) {
+                break;
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,508 @@
+#include "recordFilter.h"
+#include "mftRecord.h"
+#include "constants.h"
+#include "../utils/stringUtils.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+enum class ValueKind { Number, Size, Time, Text, Boolean };
+
+inline char lowerChar(char c) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+bool equalsIgnoreCase(const std::string& value, const std::string& lowerText) {
+    if (value.size() != lowerText.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (lowerChar(value[i]) != lowerText[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool matchesAt(const std::string& value, size_t offset, const std::string& lowerText) {
+    for (size_t i = 0; i < lowerText.size(); ++i) {
+        if (lowerChar(value[offset + i]) != lowerText[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool containsIgnoreCase(const std::string& value, const std::string& lowerText) {
+    if (lowerText.size() > value.size()) {
+        return false;
+    }
+    for (size_t offset = 0; offset + lowerText.size() <= value.size(); ++offset) {
+        if (matchesAt(value, offset, lowerText)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t filetime(const WindowsTime& time) {
+    return (static_cast<uint64_t>(time.high) << 32) | time.low;
+}
+
+std::string extensionOf(const std::string& filename) {
+    size_t dot = filename.find_last_of('.');
+    if (dot == std::string::npos || dot + 1 >= filename.size()) {
+        return std::string();
+    }
+    return filename.substr(dot + 1);
+}
+
+bool isOperatorChar(char c) {
+    return c == '=' || c == '!' || c == '<' || c == '>' || c == '&' || c == '|';
+}
+
+}
+
+RecordFilter::RecordFilter() : fields(0), position(0) {
+}
+
+bool RecordFilter::fail(const std::string& message) {
+    lastError = message;
+    return false;
+}
+
+bool RecordFilter::tokenize(const std::string& text) {
+    tokens.clear();
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (c == '(') {
+            tokens.push_back({Token::LParen, "("});
+            ++i;
+        } else if (c == ')') {
+            tokens.push_back({Token::RParen, ")"});
+            ++i;
+        } else if (c == ',') {
+            tokens.push_back({Token::Comma, ","});
+            ++i;
+        } else if (c == '\'' || c == '"') {
+            size_t end = text.find(c, i + 1);
+            if (end == std::string::npos) {
+                return fail("Unterminated string starting at offset " + std::to_string(i));
+            }
+            tokens.push_back({Token::String, text.substr(i + 1, end - i - 1)});
+            i = end + 1;
+        } else if (isOperatorChar(c)) {
+            size_t start = i;
+            while (i < text.size() && isOperatorChar(text[i])) {
+                ++i;
+            }
+            std::string op = text.substr(start, i - start);
+            if (op == "&&") {
+                tokens.push_back({Token::Word, "and"});
+            } else if (op == "||") {
+                tokens.push_back({Token::Word, "or"});
+            } else if (op == "!") {
+                tokens.push_back({Token::Word, "not"});
+            } else if (op == "=" || op == "==" || op == "!=" || op == "<" || op == "<=" || op == ">" || op == ">=") {
+                tokens.push_back({Token::Operator, op});
+            } else {
+                return fail("Unknown operator '" + op + "'");
+            }
+        } else {
+            size_t start = i;
+            while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i])) &&
+                   text[i] != '(' && text[i] != ')' && text[i] != ',' && !isOperatorChar(text[i])) {
+                ++i;
+            }
+            tokens.push_back({Token::Word, text.substr(start, i - start)});
+        }
+    }
+    tokens.push_back({Token::End, ""});
+    return true;
+}
+
+bool RecordFilter::acceptKeyword(const char* keyword) {
+    if (peek().kind == Token::Word && StringUtils::toLower(peek().text) == keyword) {
+        ++position;
+        return true;
+    }
+    return false;
+}
+
+bool RecordFilter::compile(const std::string& text) {
+    expression = text;
+    tests.clear();
+    program.clear();
+    fields = 0;
+    lastError.clear();
+    position = 0;
+
+    if (!tokenize(text)) {
+        return false;
+    }
+    if (peek().kind == Token::End) {
+        return fail("Empty filter expression");
+    }
+    if (!parseOr(0)) {
+        return false;
+    }
+    if (peek().kind != Token::End) {
+        return fail("Unexpected '" + peek().text + "'");
+    }
+
+    size_t depth = 0;
+    for (const Instruction& instruction : program) {
+        depth = instruction.kind == Instruction::Push ? depth + 1
+              : instruction.kind == Instruction::Not ? depth : depth - 1;
+        if (depth > MAX_STACK) {
+            return fail("Filter expression is too deeply nested");
+        }
+    }
+
+    tokens.clear();
+    return true;
+}
+
+bool RecordFilter::parseOr(size_t depth) {
+    if (!parseAnd(depth)) {
+        return false;
+    }
+    while (acceptKeyword("or")) {
+        if (!parseAnd(depth)) {
+            return false;
+        }
+        program.push_back({Instruction::Or, 0});
+    }
+    return true;
+}
+
+bool RecordFilter::parseAnd(size_t depth) {
+    if (!parseUnary(depth)) {
+        return false;
+    }
+    while (acceptKeyword("and")) {
+        if (!parseUnary(depth)) {
+            return false;
+        }
+        program.push_back({Instruction::And, 0});
+    }
+    return true;
+}
+
+// Rejected before recursing any further, so a run of '(' or 'not' cannot
+// exhaust the stack
+bool RecordFilter::parseUnary(size_t depth) {
+    if (depth > MAX_STACK) {
+        return fail("Filter expression is too deeply nested");
+    }
+    if (acceptKeyword("not")) {
+        if (!parseUnary(depth + 1)) {
+            return false;
+        }
+        program.push_back({Instruction::Not, 0});
+        return true;
+    }
+    return parsePrimary(depth);
+}
+
+bool RecordFilter::parsePrimary(size_t depth) {
+    struct FieldInfo {
+        const char* name;
+        Field field;
+        ValueKind kind;
+        uint32_t group;
+    };
+    static const FieldInfo fieldTable[] = {
+        {"record", Field::RecordNumber, ValueKind::Number, FILTER_FIELD_HEADER},
+        {"seq", Field::Sequence, ValueKind::Number, FILTER_FIELD_HEADER},
+        {"links", Field::LinkCount, ValueKind::Number, FILTER_FIELD_HEADER},
+        {"flags", Field::Flags, ValueKind::Number, FILTER_FIELD_HEADER},
+        {"inuse", Field::InUse, ValueKind::Boolean, FILTER_FIELD_HEADER},
+        {"deleted", Field::Deleted, ValueKind::Boolean, FILTER_FIELD_HEADER},
+        {"dir", Field::Directory, ValueKind::Boolean, FILTER_FIELD_HEADER},
+        {"file", Field::File, ValueKind::Boolean, FILTER_FIELD_HEADER},
+        {"name", Field::Name, ValueKind::Text, FILTER_FIELD_NAME},
+        {"ext", Field::Extension, ValueKind::Text, FILTER_FIELD_NAME},
+        {"parent", Field::Parent, ValueKind::Number, FILTER_FIELD_NAME},
+        {"size", Field::Size, ValueKind::Size, FILTER_FIELD_NAME},
+        {"si.created", Field::SiCreated, ValueKind::Time, FILTER_FIELD_SI_TIMES},
+        {"si.modified", Field::SiModified, ValueKind::Time, FILTER_FIELD_SI_TIMES},
+        {"si.accessed", Field::SiAccessed, ValueKind::Time, FILTER_FIELD_SI_TIMES},
+        {"si.changed", Field::SiChanged, ValueKind::Time, FILTER_FIELD_SI_TIMES},
+        {"fn.created", Field::FnCreated, ValueKind::Time, FILTER_FIELD_NAME},
+        {"fn.modified", Field::FnModified, ValueKind::Time, FILTER_FIELD_NAME},
+        {"fn.accessed", Field::FnAccessed, ValueKind::Time, FILTER_FIELD_NAME},
+        {"fn.changed", Field::FnChanged, ValueKind::Time, FILTER_FIELD_NAME},
+        {"path", Field::Path, ValueKind::Text, FILTER_FIELD_PATH}
+    };
+    static const struct { const char* name; uint32_t type; } attributeTable[] = {
+        {"si", STANDARD_INFORMATION_ATTRIBUTE}, {"attrlist", ATTRIBUTE_LIST_ATTRIBUTE},
+        {"fn", FILE_NAME_ATTRIBUTE}, {"objectid", OBJECT_ID_ATTRIBUTE},
+        {"secdesc", SECURITY_DESCRIPTOR_ATTRIBUTE}, {"volname", VOLUME_NAME_ATTRIBUTE},
+        {"volinfo", VOLUME_INFORMATION_ATTRIBUTE}, {"data", DATA_ATTRIBUTE},
+        {"indexroot", INDEX_ROOT_ATTRIBUTE}, {"indexalloc", INDEX_ALLOCATION_ATTRIBUTE},
+        {"bitmap", BITMAP_ATTRIBUTE}, {"reparse", REPARSE_POINT_ATTRIBUTE},
+        {"eainfo", EA_INFORMATION_ATTRIBUTE}, {"ea", EA_ATTRIBUTE},
+        {"logged", LOGGED_UTILITY_STREAM_ATTRIBUTE}
+    };
+
+    if (peek().kind == Token::LParen) {
+        ++position;
+        if (!parseOr(depth + 1)) {
+            return false;
+        }
+        if (peek().kind != Token::RParen) {
+            return fail("Expected ')'");
+        }
+        ++position;
+        return true;
+    }
+
+    if (peek().kind != Token::Word) {
+        return fail(peek().kind == Token::End ? "Unexpected end of filter expression"
+                                               : "Unexpected '" + peek().text + "'");
+    }
+    std::string name = StringUtils::toLower(peek().text);
+    ++position;
+
+    Test test;
+    if (name == "has") {
+        if (position + 3 >= tokens.size() || peek().kind != Token::LParen ||
+            tokens[position + 1].kind != Token::Word || tokens[position + 2].kind != Token::RParen) {
+            return fail("Expected has(<attribute>)");
+        }
+        std::string attribute = StringUtils::toLower(tokens[position + 1].text);
+        position += 3;
+        auto it = std::find_if(std::begin(attributeTable), std::end(attributeTable),
+                               [&attribute](const auto& entry) { return attribute == entry.name; });
+        if (it == std::end(attributeTable)) {
+            return fail("Unknown attribute '" + attribute + "'");
+        }
+        test.field = Field::HasAttribute;
+        test.op = Op::IsTrue;
+        test.group = FILTER_FIELD_ATTRIBUTES;
+        test.first = it->type;
+    } else {
+        auto info = std::find_if(std::begin(fieldTable), std::end(fieldTable),
+                                 [&name](const FieldInfo& entry) { return name == entry.name; });
+        if (info == std::end(fieldTable)) {
+            return fail("Unknown field '" + name + "'");
+        }
+        test.field = info->field;
+        test.group = info->group;
+
+        if (info->kind == ValueKind::Boolean) {
+            test.op = Op::IsTrue;
+        } else {
+            std::string op = peek().kind == Token::Operator || peek().kind == Token::Word
+                           ? StringUtils::toLower(peek().text) : std::string();
+            static const struct { const char* text; Op op; } operators[] = {
+                {"=", Op::Equal}, {"==", Op::Equal}, {"!=", Op::NotEqual}, {"<", Op::Less},
+                {"<=", Op::LessEqual}, {">", Op::Greater}, {">=", Op::GreaterEqual},
+                {"contains", Op::Contains}, {"startswith", Op::StartsWith},
+                {"endswith", Op::EndsWith}, {"in", Op::In}
+            };
+            auto match = std::find_if(std::begin(operators), std::end(operators),
+                                      [&op](const auto& entry) { return op == entry.text; });
+            if (match == std::end(operators)) {
+                return fail("Expected an operator after '" + name + "'");
+            }
+            test.op = match->op;
+            ++position;
+
+            bool textField = info->kind == ValueKind::Text;
+            bool ordered = test.op == Op::Less || test.op == Op::LessEqual ||
+                           test.op == Op::Greater || test.op == Op::GreaterEqual;
+            bool textual = test.op == Op::Contains || test.op == Op::StartsWith || test.op == Op::EndsWith;
+            if ((textField && ordered) || (!textField && textual) ||
+                (info->kind == ValueKind::Time && test.op == Op::In)) {
+                return fail("Operator '" + op + "' cannot be applied to '" + name + "'");
+            }
+
+            if (test.op == Op::In) {
+                if (peek().kind != Token::LParen) {
+                    return fail("Expected '(' after 'in'");
+                }
+                ++position;
+                while (true) {
+                    if (peek().kind != Token::Word && peek().kind != Token::String) {
+                        return fail("Expected a value in the list for '" + name + "'");
+                    }
+                    Test value;
+                    if (!parseValue(info->field, peek().text, value)) {
+                        return false;
+                    }
+                    ++position;
+                    if (textField) {
+                        test.strings.push_back(value.text);
+                    } else {
+                        test.numbers.push_back(value.first);
+                    }
+                    if (peek().kind != Token::Comma) {
+                        break;
+                    }
+                    ++position;
+                }
+                if (peek().kind != Token::RParen) {
+                    return fail("Expected ')' to close the list for '" + name + "'");
+                }
+                ++position;
+            } else {
+                if (peek().kind != Token::Word && peek().kind != Token::String) {
+                    return fail("Expected a value after '" + name + " " + op + "'");
+                }
+                if (!parseValue(info->field, peek().text, test)) {
+                    return false;
+                }
+                ++position;
+            }
+        }
+    }
+
+    fields |= test.group;
+    program.push_back({Instruction::Push, static_cast<uint32_t>(tests.size())});
+    tests.push_back(std::move(test));
+    return true;
+}
+
+bool RecordFilter::parseValue(Field field, const std::string& text, Test& test) {
+    switch (field) {
+        case Field::Name:
+        case Field::Extension:
+        case Field::Path:
+            test.text = StringUtils::toLower(text);
+            if (field == Field::Extension && !test.text.empty() && test.text[0] == '.') {
+                test.text.erase(0, 1);
+            }
+            return true;
+        case Field::Size:
+            if (!StringUtils::parseByteSize(text, test.first)) {
+                return fail("Invalid size '" + text + "'");
+            }
+            test.last = test.first;
+            return true;
+        case Field::SiCreated: case Field::SiModified: case Field::SiAccessed: case Field::SiChanged:
+        case Field::FnCreated: case Field::FnModified: case Field::FnAccessed: case Field::FnChanged:
+            if (!WindowsTime::parseTimestamp(text, test.first, test.last)) {
+                return fail("Invalid timestamp '" + text + "', expected YYYY-MM-DD[THH:MM:SS]");
+            }
+            return true;
+        default:
+            try {
+                size_t consumed = 0;
+                test.first = std::stoull(text, &consumed, 0);
+                if (consumed == text.size()) {
+                    test.last = test.first;
+                    return true;
+                }
+            } catch (const std::exception&) {
+            }
+            return fail("Invalid number '" + text + "'");
+    }
+}
+
+RecordFilter::Result RecordFilter::evaluateTest(const Test& test, const MftRecord& record) const {
+    auto toResult = [](bool value) { return value ? Result::True : Result::False; };
+
+    static const std::string empty;
+    const std::string* text = nullptr;
+    std::string extension;
+    uint64_t value = 0;
+    // Decoded on first use; tests on header fields never touch the attributes
+    const FileNameInfo* name = (test.group & FILTER_FIELD_NAME) ? record.fileName() : nullptr;
+
+    switch (test.field) {
+        case Field::InUse: return toResult((record.flags & FILE_RECORD_IN_USE) != 0);
+        case Field::Deleted: return toResult((record.flags & FILE_RECORD_IN_USE) == 0);
+        case Field::Directory: return toResult((record.flags & FILE_RECORD_IS_DIRECTORY) != 0);
+        case Field::File: return toResult((record.flags & FILE_RECORD_IS_DIRECTORY) == 0);
+        case Field::HasAttribute: return toResult(record.attributeTypes.count(static_cast<uint32_t>(test.first)) != 0);
+        case Field::Name: text = name ? &name->name : &empty; break;
+        case Field::Path: text = &record.filepath; break;
+        case Field::Extension: extension = extensionOf(name ? name->name : empty); text = &extension; break;
+        case Field::RecordNumber: value = record.recordnum; break;
+        case Field::Sequence: value = record.seq; break;
+        case Field::LinkCount: value = record.link; break;
+        case Field::Flags: value = record.flags; break;
+        case Field::Parent: value = name ? name->parentRecordNumber() : 0; break;
+        case Field::Size: value = name ? name->realSize : 0; break;
+        case Field::SiCreated: value = filetime(record.standardInformation().crtime); break;
+        case Field::SiModified: value = filetime(record.standardInformation().mtime); break;
+        case Field::SiAccessed: value = filetime(record.standardInformation().atime); break;
+        case Field::SiChanged: value = filetime(record.standardInformation().ctime); break;
+        case Field::FnCreated: value = name ? filetime(name->crtime) : 0; break;
+        case Field::FnModified: value = name ? filetime(name->mtime) : 0; break;
+        case Field::FnAccessed: value = name ? filetime(name->atime) : 0; break;
+        case Field::FnChanged: value = name ? filetime(name->ctime) : 0; break;
+    }
+
+    if (text) {
+        switch (test.op) {
+            case Op::Equal: return toResult(equalsIgnoreCase(*text, test.text));
+            case Op::NotEqual: return toResult(!equalsIgnoreCase(*text, test.text));
+            case Op::Contains: return toResult(containsIgnoreCase(*text, test.text));
+            case Op::StartsWith:
+                return toResult(text->size() >= test.text.size() && matchesAt(*text, 0, test.text));
+            case Op::EndsWith:
+                return toResult(text->size() >= test.text.size() &&
+                                matchesAt(*text, text->size() - test.text.size(), test.text));
+            case Op::In:
+                return toResult(std::any_of(test.strings.begin(), test.strings.end(),
+                                            [text](const std::string& s) { return equalsIgnoreCase(*text, s); }));
+            default: return Result::False;
+        }
+    }
+
+    switch (test.op) {
+        case Op::Equal: return toResult(value >= test.first && value <= test.last);
+        case Op::NotEqual: return toResult(value < test.first || value > test.last);
+        case Op::Less: return toResult(value < test.first);
+        case Op::LessEqual: return toResult(value <= test.last);
+        case Op::Greater: return toResult(value > test.last);
+        case Op::GreaterEqual: return toResult(value >= test.first);
+        case Op::In: return toResult(std::find(test.numbers.begin(), test.numbers.end(), value) != test.numbers.end());
+        default: return Result::False;
+    }
+}
+
+RecordFilter::Result RecordFilter::evaluate(const MftRecord& record, uint32_t knownFields) const {
+    Result stack[MAX_STACK];
+    size_t depth = 0;
+
+    for (const Instruction& instruction : program) {
+        switch (instruction.kind) {
+            case Instruction::Push: {
+                const Test& test = tests[instruction.test];
+                stack[depth++] = (knownFields & test.group) ? evaluateTest(test, record) : Result::Unknown;
+                break;
+            }
+            case Instruction::Not:
+                if (stack[depth - 1] != Result::Unknown) {
+                    stack[depth - 1] = stack[depth - 1] == Result::True ? Result::False : Result::True;
+                }
+                break;
+            case Instruction::And: {
+                Result right = stack[--depth];
+                Result left = stack[depth - 1];
+                stack[depth - 1] = (left == Result::False || right == Result::False) ? Result::False
+                                 : (left == Result::True && right == Result::True) ? Result::True
+                                 : Result::Unknown;
+                break;
+            }
+            case Instruction::Or: {
+                Result right = stack[--depth];
+                Result left = stack[depth - 1];
+                stack[depth - 1] = (left == Result::True || right == Result::True) ? Result::True
+                                 : (left == Result::False && right == Result::False) ? Result::False
+                                 : Result::Unknown;
+                break;
+            }
+        }
+    }
+
+    return depth == 0 ? Result::True : stack[0];
+}
@@ -0,0 +1,506 @@
+#include "snapshot.h"
+#include "../utils/hashCalc.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr size_t SECTION_ALIGNMENT = 64;
+
+// 100ns ticks between 1601-01-01 and 1970-01-01
+constexpr uint64_t FILETIME_UNIX_EPOCH = 116444736000000000ULL;
+
+enum DetailBit : uint16_t {
+    DETAIL_SECURITY_DESCRIPTOR = 0x0001,
+    DETAIL_VOLUME_INFO = 0x0002,
+    DETAIL_DATA = 0x0004,
+    DETAIL_INDEX_ROOT = 0x0008,
+    DETAIL_INDEX_ALLOCATION = 0x0010,
+    DETAIL_BITMAP = 0x0020,
+    DETAIL_REPARSE_POINT = 0x0040,
+    DETAIL_EA_INFORMATION = 0x0080,
+    DETAIL_EA = 0x0100,
+    DETAIL_LOGGED_UTILITY_STREAM = 0x0200
+};
+
+uint64_t toFiletime(const WindowsTime& time) {
+    return (static_cast<uint64_t>(time.high) << 32) | time.low;
+}
+
+WindowsTime fromFiletime(uint64_t filetime) {
+    return WindowsTime(static_cast<uint32_t>(filetime), static_cast<uint32_t>(filetime >> 32));
+}
+
+uint64_t currentFiletime() {
+    auto sinceEpoch = std::chrono::system_clock::now().time_since_epoch();
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(sinceEpoch).count();
+    return static_cast<uint64_t>(micros) * 10 + FILETIME_UNIX_EPOCH;
+}
+
+}
+
+SnapshotWriter::SnapshotWriter() : fileOffset(0), recordSize(0), rawSectionOffset(0) {
+    std::memset(&header, 0, sizeof(header));
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    if (file.is_open()) {
+        close();
+    }
+}
+
+bool SnapshotWriter::writeBytes(const void* data, size_t length) {
+    file.write(static_cast<const char*>(data), static_cast<std::streamsize>(length));
+    fileOffset += length;
+    if (!file.good()) {
+        lastError = "Error writing snapshot";
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotWriter::align() {
+    static const char padding[SECTION_ALIGNMENT] = {0};
+    size_t remainder = static_cast<size_t>(fileOffset % SECTION_ALIGNMENT);
+    return remainder == 0 || writeBytes(padding, SECTION_ALIGNMENT - remainder);
+}
+
+bool SnapshotWriter::writeSection(uint32_t id, uint32_t elementSize, const void* data, size_t length) {
+    if (!align()) {
+        return false;
+    }
+    sections.push_back({id, elementSize, fileOffset, length});
+    return length == 0 || writeBytes(data, length);
+}
+
+bool SnapshotWriter::open(const std::string& path, size_t recordSize, const std::string& sourcePath) {
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        lastError = "Cannot create snapshot: " + path;
+        return false;
+    }
+
+    this->recordSize = recordSize;
+    this->sourcePath = sourcePath;
+    fileOffset = 0;
+    sections.clear();
+
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.recordSize = static_cast<uint32_t>(recordSize);
+    header.stats.minSiCreation = std::numeric_limits<uint64_t>::max();
+    header.stats.minSiModification = std::numeric_limits<uint64_t>::max();
+
+    for (int i = 0; i < SNAPSHOT_STRING_COUNT; ++i) {
+        stringHeaps[i].clear();
+        stringOffsets[i].assign(1, 0);
+    }
+
+    // Placeholder; the real header is written once the directory offset is known
+    if (!writeBytes(&header, sizeof(header)) || !align()) {
+        return false;
+    }
+    rawSectionOffset = fileOffset;
+    return true;
+}
+
+bool SnapshotWriter::append(const MftRecord& record, const uint8_t* rawRecord) {
+    rawOffsets.push_back(fileOffset - rawSectionOffset);
+    if (rawRecord) {
+        if (!writeBytes(rawRecord, recordSize)) {
+            return false;
+        }
+    } else {
+        std::vector<uint8_t> empty(recordSize, 0);
+        if (!writeBytes(empty.data(), empty.size())) {
+            return false;
+        }
+    }
+
+    recordNumbers.push_back(record.recordnum);
+    sequences.push_back(record.seq);
+    flags.push_back(record.flags);
+    linkCounts.push_back(record.link);
+    magics.push_back(record.magic);
+    lsns.push_back(record.lsn);
+    baseReferences.push_back(record.baseRef);
+    parentReferences.push_back(record.parentRef);
+    fileSizes.push_back(record.filesize);
+
+    uint32_t attributeMask = 0;
+    for (uint32_t type : record.attributeTypes) {
+        if ((type >> 4) < 32) {
+            attributeMask |= 1u << (type >> 4);
+        }
+    }
+    attributeMasks.push_back(attributeMask);
+
+    uint16_t detailMask = 0;
+    if (record.securityDescriptor) detailMask |= DETAIL_SECURITY_DESCRIPTOR;
+    if (record.volumeInfo) detailMask |= DETAIL_VOLUME_INFO;
+    if (record.dataAttribute) detailMask |= DETAIL_DATA;
+    if (record.indexRoot) detailMask |= DETAIL_INDEX_ROOT;
+    if (record.indexAllocation) detailMask |= DETAIL_INDEX_ALLOCATION;
+    if (record.bitmap) detailMask |= DETAIL_BITMAP;
+    if (record.reparsePoint) detailMask |= DETAIL_REPARSE_POINT;
+    if (record.eaInformation) detailMask |= DETAIL_EA_INFORMATION;
+    if (record.ea) detailMask |= DETAIL_EA;
+    if (record.loggedUtilityStream) detailMask |= DETAIL_LOGGED_UTILITY_STREAM;
+    detailMasks.push_back(detailMask);
+
+    const WindowsTime* recordTimes[SNAPSHOT_TIME_COUNT] = {
+        &record.siTimes.crtime, &record.siTimes.mtime, &record.siTimes.atime, &record.siTimes.ctime,
+        &record.fnTimes.crtime, &record.fnTimes.mtime, &record.fnTimes.atime, &record.fnTimes.ctime
+    };
+    for (const WindowsTime* time : recordTimes) {
+        times.push_back(toFiletime(*time));
+    }
+
+    const std::string* strings[SNAPSHOT_STRING_COUNT] = {
+        &record.filename, &record.filepath, &record.volumeName, &record.objectId,
+        &record.birthVolumeId, &record.birthObjectId, &record.birthDomainId,
+        &record.md5, &record.sha256, &record.sha512, &record.crc32
+    };
+    for (int i = 0; i < SNAPSHOT_STRING_COUNT; ++i) {
+        stringHeaps[i].insert(stringHeaps[i].end(), strings[i]->begin(), strings[i]->end());
+        stringOffsets[i].push_back(stringHeaps[i].size());
+    }
+    if (!record.md5.empty()) {
+        header.flags |= SNAPSHOT_FLAG_HASHES;
+    }
+
+    SnapshotStatistics& stats = header.stats;
+    header.recordCount++;
+    if (record.flags & FILE_RECORD_IN_USE) {
+        stats.activeRecords++;
+    }
+    if (record.flags & FILE_RECORD_IS_DIRECTORY) {
+        stats.directories++;
+    } else {
+        stats.files++;
+    }
+    stats.totalFileSize += record.filesize;
+
+    uint64_t created = toFiletime(record.siTimes.crtime);
+    uint64_t modified = toFiletime(record.siTimes.mtime);
+    if (created != 0) {
+        stats.minSiCreation = std::min(stats.minSiCreation, created);
+        stats.maxSiCreation = std::max(stats.maxSiCreation, created);
+    }
+    if (modified != 0) {
+        stats.minSiModification = std::min(stats.minSiModification, modified);
+        stats.maxSiModification = std::max(stats.maxSiModification, modified);
+    }
+    return true;
+}
+
+bool SnapshotWriter::writeStringHeap(uint64_t length) {
+    if (!align()) {
+        return false;
+    }
+    sections.push_back({SNAPSHOT_SECTION_STRING_HEAP, 1, fileOffset, length});
+    for (const auto& heap : stringHeaps) {
+        if (!heap.empty() && !writeBytes(heap.data(), heap.size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<uint32_t> SnapshotWriter::sortByTime(int time) const {
+    std::vector<uint32_t> order(recordNumbers.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [this, time](uint32_t a, uint32_t b) {
+        return times[a * SNAPSHOT_TIME_COUNT + time] < times[b * SNAPSHOT_TIME_COUNT + time];
+    });
+    return order;
+}
+
+std::vector<uint32_t> SnapshotWriter::sortByPath() const {
+    const std::vector<char>& heap = stringHeaps[SNAPSHOT_STRING_FILEPATH];
+    const std::vector<uint64_t>& offsets = stringOffsets[SNAPSHOT_STRING_FILEPATH];
+    std::vector<uint32_t> order(recordNumbers.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&heap, &offsets](uint32_t a, uint32_t b) {
+        size_t lengthA = offsets[a + 1] - offsets[a];
+        size_t lengthB = offsets[b + 1] - offsets[b];
+        int result = std::memcmp(heap.data() + offsets[a], heap.data() + offsets[b],
+                                 std::min(lengthA, lengthB));
+        return result < 0 || (result == 0 && lengthA < lengthB);
+    });
+    return order;
+}
+
+bool SnapshotWriter::close() {
+    if (!file.is_open()) {
+        return false;
+    }
+
+    if (header.stats.minSiCreation == std::numeric_limits<uint64_t>::max()) {
+        header.stats.minSiCreation = 0;
+    }
+    if (header.stats.minSiModification == std::numeric_limits<uint64_t>::max()) {
+        header.stats.minSiModification = 0;
+    }
+    header.stats.createdTime = currentFiletime();
+
+    sections.push_back({SNAPSHOT_SECTION_RAW_RECORDS, static_cast<uint32_t>(recordSize),
+                        rawSectionOffset, header.recordCount * recordSize});
+
+    std::vector<uint64_t> allStringOffsets;
+    allStringOffsets.reserve(SNAPSHOT_STRING_COUNT * (header.recordCount + 1));
+    uint64_t heapSize = 0;
+    for (int i = 0; i < SNAPSHOT_STRING_COUNT; ++i) {
+        for (uint64_t offset : stringOffsets[i]) {
+            allStringOffsets.push_back(heapSize + offset);
+        }
+        heapSize += stringHeaps[i].size();
+    }
+
+    bool success = writeColumn(SNAPSHOT_SECTION_RAW_OFFSETS, rawOffsets) &&
+                   writeColumn(SNAPSHOT_SECTION_RECORD_NUMBER, recordNumbers) &&
+                   writeColumn(SNAPSHOT_SECTION_SEQUENCE, sequences) &&
+                   writeColumn(SNAPSHOT_SECTION_FLAGS, flags) &&
+                   writeColumn(SNAPSHOT_SECTION_LINK_COUNT, linkCounts) &&
+                   writeColumn(SNAPSHOT_SECTION_MAGIC, magics) &&
+                   writeColumn(SNAPSHOT_SECTION_LSN, lsns) &&
+                   writeColumn(SNAPSHOT_SECTION_BASE_REFERENCE, baseReferences) &&
+                   writeColumn(SNAPSHOT_SECTION_PARENT_REFERENCE, parentReferences) &&
+                   writeColumn(SNAPSHOT_SECTION_FILE_SIZE, fileSizes) &&
+                   writeColumn(SNAPSHOT_SECTION_ATTRIBUTE_MASK, attributeMasks) &&
+                   writeColumn(SNAPSHOT_SECTION_DETAIL_MASK, detailMasks) &&
+                   writeColumn(SNAPSHOT_SECTION_TIMES, times) &&
+                   writeStringHeap(heapSize) &&
+                   writeColumn(SNAPSHOT_SECTION_STRING_OFFSETS, allStringOffsets) &&
+                   writeColumn(SNAPSHOT_SECTION_ORDER_SI_CREATION, sortByTime(SNAPSHOT_TIME_SI_CREATION)) &&
+                   writeColumn(SNAPSHOT_SECTION_ORDER_SI_MODIFICATION, sortByTime(SNAPSHOT_TIME_SI_MODIFICATION)) &&
+                   writeColumn(SNAPSHOT_SECTION_ORDER_PATH, sortByPath()) &&
+                   writeSection(SNAPSHOT_SECTION_SOURCE_PATH, 1, sourcePath.data(), sourcePath.size()) &&
+                   align();
+
+    if (success) {
+        header.directoryOffset = fileOffset;
+        header.sectionCount = static_cast<uint32_t>(sections.size());
+        success = writeBytes(sections.data(), sections.size() * sizeof(SnapshotSectionEntry));
+    }
+
+    if (success) {
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        success = file.good();
+    }
+
+    file.close();
+    return success && !file.fail();
+}
+
+Snapshot::Snapshot()
+    : header(nullptr), rawRecords(nullptr), rawOffsets(nullptr), recordNumbers(nullptr), sequences(nullptr),
+      recordFlags(nullptr), linkCounts(nullptr), magics(nullptr), lsns(nullptr), baseReferences(nullptr),
+      parentReferences(nullptr), fileSizes(nullptr), attributeMasks(nullptr), detailMasks(nullptr),
+      times(nullptr), stringHeap(nullptr), stringHeapSize(0), stringOffsets(nullptr), orders{nullptr, nullptr, nullptr},
+      sourcePath(nullptr), sourcePathLength(0) {
+}
+
+bool Snapshot::isSnapshotFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(SNAPSHOT_MAGIC)] = {0};
+    file.read(magic, sizeof(magic));
+    return file.gcount() == static_cast<std::streamsize>(sizeof(magic)) &&
+           std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+}
+
+const uint8_t* Snapshot::findSection(uint32_t id, uint64_t expectedLength, uint64_t& actualLength) {
+    const auto* entries = reinterpret_cast<const SnapshotSectionEntry*>(file.data() + header->directoryOffset);
+    for (uint32_t i = 0; i < header->sectionCount; ++i) {
+        const SnapshotSectionEntry& entry = entries[i];
+        if (entry.id != id) {
+            continue;
+        }
+        if (entry.offset % SECTION_ALIGNMENT != 0 || entry.offset > file.size() ||
+            entry.length > file.size() - entry.offset ||
+            (expectedLength != UINT64_MAX && entry.length != expectedLength)) {
+            lastError = "Corrupt snapshot section " + std::to_string(id);
+            return nullptr;
+        }
+        actualLength = entry.length;
+        return file.data() + entry.offset;
+    }
+    lastError = "Snapshot is missing section " + std::to_string(id);
+    return nullptr;
+}
+
+bool Snapshot::open(const std::string& path) {
+    close();
+    lastError.clear();
+
+    if (!file.open(path)) {
+        lastError = "Cannot open snapshot: " + path;
+        return false;
+    }
+    if (file.size() < sizeof(SnapshotHeader) ||
+        std::memcmp(file.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        lastError = "Not an analyzeMFT snapshot: " + path;
+        close();
+        return false;
+    }
+
+    header = reinterpret_cast<const SnapshotHeader*>(file.data());
+    if (header->version != SNAPSHOT_VERSION || header->headerSize < sizeof(SnapshotHeader)) {
+        lastError = "Unsupported snapshot version " + std::to_string(header->version);
+        close();
+        return false;
+    }
+    if (header->directoryOffset > file.size() ||
+        header->sectionCount > (file.size() - header->directoryOffset) / sizeof(SnapshotSectionEntry)) {
+        lastError = "Corrupt snapshot directory";
+        close();
+        return false;
+    }
+
+    uint64_t count = header->recordCount;
+    uint64_t length = 0;
+    bool valid =
+        (rawRecords = findSection(SNAPSHOT_SECTION_RAW_RECORDS, count * header->recordSize, length)) != nullptr &&
+        (rawOffsets = reinterpret_cast<const uint64_t*>(findSection(SNAPSHOT_SECTION_RAW_OFFSETS, count * 8, length))) != nullptr &&
+        (recordNumbers = reinterpret_cast<const uint32_t*>(findSection(SNAPSHOT_SECTION_RECORD_NUMBER, count * 4, length))) != nullptr &&
+        (sequences = reinterpret_cast<const uint16_t*>(findSection(SNAPSHOT_SECTION_SEQUENCE, count * 2, length))) != nullptr &&
+        (recordFlags = reinterpret_cast<const uint16_t*>(findSection(SNAPSHOT_SECTION_FLAGS, count * 2, length))) != nullptr &&
+        (linkCounts = reinterpret_cast<const uint16_t*>(findSection(SNAPSHOT_SECTION_LINK_COUNT, count * 2, length))) != nullptr &&
+        (magics = reinterpret_cast<const uint32_t*>(findSection(SNAPSHOT_SECTION_MAGIC, count * 4, length))) != nullptr &&
+        (lsns = reinterpret_cast<const uint64_t*>(findSection(SNAPSHOT_SECTION_LSN, count * 8, length))) != nullptr &&
+        (baseReferences = reinterpret_cast<const uint64_t*>(findSection(SNAPSHOT_SECTION_BASE_REFERENCE, count * 8, length))) != nullptr &&
+        (parentReferences = reinterpret_cast<const uint64_t*>(findSection(SNAPSHOT_SECTION_PARENT_REFERENCE, count * 8, length))) != nullptr &&
+        (fileSizes = reinterpret_cast<const uint64_t*>(findSection(SNAPSHOT_SECTION_FILE_SIZE, count * 8, length))) != nullptr &&
+        (attributeMasks = reinterpret_cast<const uint32_t*>(findSection(SNAPSHOT_SECTION_ATTRIBUTE_MASK, count * 4, length))) != nullptr &&
+        (detailMasks = reinterpret_cast<const uint16_t*>(findSection(SNAPSHOT_SECTION_DETAIL_MASK, count * 2, length))) != nullptr &&
+        (times = reinterpret_cast<const uint64_t*>(findSection(SNAPSHOT_SECTION_TIMES, count * SNAPSHOT_TIME_COUNT * 8, length))) != nullptr &&
+        (stringHeap = reinterpret_cast<const char*>(findSection(SNAPSHOT_SECTION_STRING_HEAP, UINT64_MAX, stringHeapSize))) != nullptr &&
+        (stringOffsets = reinterpret_cast<const uint64_t*>(findSection(SNAPSHOT_SECTION_STRING_OFFSETS, (count + 1) * SNAPSHOT_STRING_COUNT * 8, length))) != nullptr &&
+        (orders[0] = reinterpret_cast<const uint32_t*>(findSection(SNAPSHOT_SECTION_ORDER_SI_CREATION, count * 4, length))) != nullptr &&
+        (orders[1] = reinterpret_cast<const uint32_t*>(findSection(SNAPSHOT_SECTION_ORDER_SI_MODIFICATION, count * 4, length))) != nullptr &&
+        (orders[2] = reinterpret_cast<const uint32_t*>(findSection(SNAPSHOT_SECTION_ORDER_PATH, count * 4, length))) != nullptr &&
+        (sourcePath = reinterpret_cast<const char*>(findSection(SNAPSHOT_SECTION_SOURCE_PATH, UINT64_MAX, sourcePathLength))) != nullptr;
+
+    if (!valid) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void Snapshot::close() {
+    file.close();
+    header = nullptr;
+}
+
+std::string Snapshot::getSourcePath() const {
+    return sourcePath ? std::string(sourcePath, static_cast<size_t>(sourcePathLength)) : std::string();
+}
+
+const char* Snapshot::stringData(int column, size_t row, size_t& length) const {
+    const uint64_t* offsets = stringOffsets + static_cast<size_t>(column) * (header->recordCount + 1);
+    uint64_t begin = offsets[row];
+    uint64_t end = offsets[row + 1];
+    if (begin > end || end > stringHeapSize) {
+        length = 0;
+        return stringHeap;
+    }
+    length = static_cast<size_t>(end - begin);
+    return stringHeap + begin;
+}
+
+std::string Snapshot::string(int column, size_t row) const {
+    size_t length = 0;
+    const char* data = stringData(column, row, length);
+    return std::string(data, length);
+}
+
+const uint8_t* Snapshot::rawRecord(size_t row) const {
+    uint64_t offset = rawOffsets[row];
+    if (offset > header->recordCount * header->recordSize - header->recordSize) {
+        return nullptr;
+    }
+    return rawRecords + offset;
+}
+
+const uint32_t* Snapshot::order(SnapshotOrder sortOrder) const {
+    return orders[static_cast<int>(sortOrder)];
+}
+
+std::unique_ptr<MftRecord> Snapshot::loadRecord(size_t row, bool computeHashes) const {
+    auto record = std::make_unique<MftRecord>();
+
+    record->magic = magics[row];
+    record->lsn = lsns[row];
+    record->seq = sequences[row];
+    record->link = linkCounts[row];
+    record->flags = recordFlags[row];
+    record->baseRef = baseReferences[row];
+    record->recordnum = recordNumbers[row];
+    record->parentRef = parentReferences[row];
+    record->filesize = fileSizes[row];
+
+    record->filename = string(SNAPSHOT_STRING_FILENAME, row);
+    record->filepath = string(SNAPSHOT_STRING_FILEPATH, row);
+    record->volumeName = string(SNAPSHOT_STRING_VOLUME_NAME, row);
+    record->objectId = string(SNAPSHOT_STRING_OBJECT_ID, row);
+    record->birthVolumeId = string(SNAPSHOT_STRING_BIRTH_VOLUME_ID, row);
+    record->birthObjectId = string(SNAPSHOT_STRING_BIRTH_OBJECT_ID, row);
+    record->birthDomainId = string(SNAPSHOT_STRING_BIRTH_DOMAIN_ID, row);
+
+    record->siTimes.crtime = fromFiletime(time(row, SNAPSHOT_TIME_SI_CREATION));
+    record->siTimes.mtime = fromFiletime(time(row, SNAPSHOT_TIME_SI_MODIFICATION));
+    record->siTimes.atime = fromFiletime(time(row, SNAPSHOT_TIME_SI_ACCESS));
+    record->siTimes.ctime = fromFiletime(time(row, SNAPSHOT_TIME_SI_ENTRY));
+    record->fnTimes.crtime = fromFiletime(time(row, SNAPSHOT_TIME_FN_CREATION));
+    record->fnTimes.mtime = fromFiletime(time(row, SNAPSHOT_TIME_FN_MODIFICATION));
+    record->fnTimes.atime = fromFiletime(time(row, SNAPSHOT_TIME_FN_ACCESS));
+    record->fnTimes.ctime = fromFiletime(time(row, SNAPSHOT_TIME_FN_ENTRY));
+
+    uint32_t mask = attributeMasks[row];
+    for (uint32_t bit = 0; bit < 32; ++bit) {
+        if (mask & (1u << bit)) {
+            record->attributeTypes.insert(bit << 4);
+        }
+    }
+
+    // Only presence is kept; the attribute contents remain in the raw record
+    uint16_t details = detailMasks[row];
+    if (details & DETAIL_SECURITY_DESCRIPTOR) record->securityDescriptor = std::make_unique<SecurityDescriptor>();
+    if (details & DETAIL_VOLUME_INFO) record->volumeInfo = std::make_unique<VolumeInfo>();
+    if (details & DETAIL_DATA) record->dataAttribute = std::make_unique<DataAttribute>();
+    if (details & DETAIL_INDEX_ROOT) record->indexRoot = std::make_unique<IndexRoot>();
+    if (details & DETAIL_INDEX_ALLOCATION) record->indexAllocation = std::make_unique<IndexAllocation>();
+    if (details & DETAIL_BITMAP) record->bitmap = std::make_unique<BitmapAttribute>();
+    if (details & DETAIL_REPARSE_POINT) record->reparsePoint = std::make_unique<ReparsePoint>();
+    if (details & DETAIL_EA_INFORMATION) record->eaInformation = std::make_unique<EaInformation>();
+    if (details & DETAIL_EA) record->ea = std::make_unique<ExtendedAttribute>();
+    if (details & DETAIL_LOGGED_UTILITY_STREAM) record->loggedUtilityStream = std::make_unique<LoggedUtilityStream>();
+
+    if (computeHashes) {
+        if (hasHashes()) {
+            record->md5 = string(SNAPSHOT_STRING_MD5, row);
+            record->sha256 = string(SNAPSHOT_STRING_SHA256, row);
+            record->sha512 = string(SNAPSHOT_STRING_SHA512, row);
+            record->crc32 = string(SNAPSHOT_STRING_CRC32, row);
+        } else if (const uint8_t* raw = rawRecord(row)) {
+            std::vector<uint8_t> bytes(raw, raw + header->recordSize);
+            HashCalculator calc;
+            record->md5 = calc.calculateMd5(bytes);
+            record->sha256 = calc.calculateSha256(bytes);
+            record->sha512 = calc.calculateSha512(bytes);
+            record->crc32 = calc.calculateCrc32(bytes);
+        }
+    }
+
+    return record;
+}
@@ -1,19 +1,76 @@
 #include "winTime.h"
+#include <cstdio>
 #include <ctime>
-#include <iomanip>
-#include <sstream>
 
 WindowsTime::WindowsTime(uint32_t low, uint32_t high) 
-    : low(low), high(high), unixTime(0), valid(false) {
+    : low(low), high(high), unixTime(0), valid(false), formatted(false) {
     if (low == 0 && high == 0) {
-        dtstr = "Not defined";
         return;
     }
     calculateUnixTime();
-    formatDateTime();
 }
 
-WindowsTime::WindowsTime() : low(0), high(0), unixTime(0), dtstr("Not defined"), valid(false) {
+WindowsTime::WindowsTime() : low(0), high(0), unixTime(0), valid(false), formatted(false) {
+}
+
+namespace {
+
+constexpr uint64_t TICKS_PER_SECOND = 10000000ULL;
+constexpr int64_t DAYS_1601_TO_1970 = 134774;
+
+// Days since 1970-01-01 of a proleptic Gregorian date
+int64_t daysFromCivil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<int64_t>(dayOfEra) - 719468;
+}
+
+// Inverse of daysFromCivil
+void civilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+    unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    year = static_cast<int64_t>(yearOfEra) + era * 400 + (month <= 2);
+}
+
+inline char* putTwoDigits(char* out, unsigned value) {
+    out[0] = static_cast<char>('0' + value / 10);
+    out[1] = static_cast<char>('0' + value % 10);
+    return out + 2;
+}
+
+}
+
+bool WindowsTime::parseTimestamp(const std::string& text, uint64_t& first, uint64_t& last) {
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    char separator = 0;
+    int fields = std::sscanf(text.c_str(), "%4d-%2d-%2d%c%2d:%2d:%2d", &year, &month, &day,
+                             &separator, &hour, &minute, &second);
+    if (fields != 3 && fields != 7) {
+        return false;
+    }
+    if (fields == 7 && separator != 'T' && separator != ' ') {
+        return false;
+    }
+    if (year < 1601 || month < 1 || month > 12 || day < 1 || day > 31 ||
+        hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+    
+    int64_t days = daysFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(day)) + DAYS_1601_TO_1970;
+    uint64_t seconds = static_cast<uint64_t>(days) * 86400 + static_cast<uint64_t>(hour) * 3600 +
+                       static_cast<uint64_t>(minute) * 60 + static_cast<uint64_t>(second);
+    first = seconds * TICKS_PER_SECOND;
+    last = first + (fields == 3 ? 86400 : 1) * TICKS_PER_SECOND - 1;
+    return true;
 }
 
 void WindowsTime::calculateUnixTime() {
@@ -22,25 +79,43 @@ void WindowsTime::calculateUnixTime() {
     valid = true;
 }
 
-void WindowsTime::formatDateTime() {
+void WindowsTime::formatDateTime() const {
+    formatted = true;
     if (!valid) {
-        dtstr = "Invalid timestamp";
+        dtstr = "Not defined";
         return;
     }
     
-    std::tm* utcTime = std::gmtime(&unixTime);
-    if (!utcTime) {
-        dtstr = "Invalid timestamp";
-        valid = false;
-        return;
-    }
+    // ISO 8601 in UTC, the same text as strftime's "%Y-%m-%dT%H:%M:%SZ"
+    // without a gmtime call and a stream per timestamp
+    int64_t seconds = static_cast<int64_t>(unixTime);
+    int64_t days = (seconds >= 0 ? seconds : seconds - 86399) / 86400;
+    unsigned secondOfDay = static_cast<unsigned>(seconds - days * 86400);
+    int64_t year = 0;
+    unsigned month = 0, day = 0;
+    civilFromDays(days, year, month, day);
     
-    std::ostringstream oss;
-    oss << std::put_time(utcTime, "%Y-%m-%dT%H:%M:%S") << "Z";
-    dtstr = oss.str();
+    char text[32];
+    int length = std::snprintf(text, sizeof(text), "%lld", static_cast<long long>(year));
+    char* out = text + length;
+    *out++ = '-';
+    out = putTwoDigits(out, month);
+    *out++ = '-';
+    out = putTwoDigits(out, day);
+    *out++ = 'T';
+    out = putTwoDigits(out, secondOfDay / 3600);
+    *out++ = ':';
+    out = putTwoDigits(out, secondOfDay / 60 % 60);
+    *out++ = ':';
+    out = putTwoDigits(out, secondOfDay % 60);
+    *out++ = 'Z';
+    dtstr.assign(text, out);
 }
 
-std::string WindowsTime::getDateTimeString() const {
+const std::string& WindowsTime::getDateTimeString() const {
+    if (!formatted) {
+        formatDateTime();
+    }
     return dtstr;
 }
 
@@ -0,0 +1,288 @@
+#include "externalSorter.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <queue>
+#include <thread>
+
+namespace {
+
+// Slices below this are not worth a thread
+constexpr size_t MIN_ITEMS_PER_THREAD = 1 << 16;
+// Sorted output is handed on in pieces of about this size
+constexpr size_t OUTPUT_PIECE = 1 << 20;
+constexpr size_t RUN_RECORD_HEADER = sizeof(uint64_t) + sizeof(uint32_t);
+
+template <typename Work>
+void forEachSlice(unsigned workers, size_t count, Work work) {
+    if (workers <= 1) {
+        work(0u, size_t(0), count);
+        return;
+    }
+    std::vector<std::thread> pool;
+    pool.reserve(workers);
+    for (unsigned w = 0; w < workers; ++w) {
+        pool.emplace_back(work, w, count * w / workers, count * (w + 1) / workers);
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+}
+
+// A spilled run, read back through a buffer
+struct ExternalSorter::Run {
+    std::ifstream file;
+    std::vector<char> buffer;
+    size_t position = 0;
+    size_t end = 0;
+    uint64_t key = 0;
+    const char* line = nullptr;
+    uint32_t size = 0;
+    bool truncated = false;         // the file ended inside a record
+
+    // Makes `bytes` bytes available at position, false at end of file
+    bool fill(size_t bytes) {
+        if (end - position >= bytes) {
+            return true;
+        }
+        std::memmove(buffer.data(), buffer.data() + position, end - position);
+        end -= position;
+        position = 0;
+        if (buffer.size() < bytes) {
+            buffer.resize(bytes);
+        }
+        file.read(buffer.data() + end, static_cast<std::streamsize>(buffer.size() - end));
+        end += static_cast<size_t>(file.gcount());
+        return end >= bytes;
+    }
+
+    bool next() {
+        if (!fill(RUN_RECORD_HEADER)) {
+            truncated = end > position;
+            return false;
+        }
+        std::memcpy(&key, buffer.data() + position, sizeof(key));
+        std::memcpy(&size, buffer.data() + position + sizeof(key), sizeof(size));
+        if (!fill(RUN_RECORD_HEADER + size)) {
+            truncated = true;
+            return false;
+        }
+        line = buffer.data() + position + RUN_RECORD_HEADER;
+        position += RUN_RECORD_HEADER + size;
+        return true;
+    }
+};
+
+ExternalSorter::ExternalSorter(size_t memoryLimit, unsigned threads)
+    : memoryLimit(memoryLimit > 0 ? memoryLimit : DEFAULT_MEMORY_LIMIT), threads(threads > 0 ? threads : 1),
+      runPrefix("analyzemft-sort") {
+}
+
+ExternalSorter::~ExternalSorter() {
+    removeRuns();
+}
+
+bool ExternalSorter::add(uint64_t key, const char* data, size_t size) {
+    // Offsets are 32-bit, so a run also ends at 4 GiB of text
+    if (!items.empty() && (bufferedBytes() + size >= memoryLimit || text.size() + size > UINT32_MAX)) {
+        if (!spill()) {
+            return false;
+        }
+    }
+    items.push_back({key, static_cast<uint32_t>(text.size()), static_cast<uint32_t>(size)});
+    text.append(data, size);
+    return true;
+}
+
+bool ExternalSorter::finish(const Output& output) {
+    if (!runFiles.empty()) {
+        bool ok = (items.empty() || spill()) && mergeRuns(output);
+        removeRuns();
+        return ok;
+    }
+
+    sortItems();
+    std::string piece;
+    for (const auto& item : items) {
+        piece.append(text, item.offset, item.size);
+        if (piece.size() >= OUTPUT_PIECE) {
+            if (!output(piece.data(), piece.size())) {
+                return fail("Cannot write sorted output");
+            }
+            piece.clear();
+        }
+    }
+    items.clear();
+    text.clear();
+    if (!piece.empty() && !output(piece.data(), piece.size())) {
+        return fail("Cannot write sorted output");
+    }
+    return true;
+}
+
+size_t ExternalSorter::bufferedBytes() const {
+    // The radix sort needs a second item array as large as the first
+    return text.size() + items.size() * 2 * sizeof(Item);
+}
+
+// LSD radix sort on the key, one byte a pass. Each pass counts digits per
+// slice, gives every (digit, slice) pair its output range in slice order
+// and scatters the slices in parallel, which keeps the sort stable. Bytes
+// that are the same in every key, such as the high bytes of FILETIMEs
+// from one volume, are skipped.
+void ExternalSorter::sortItems() {
+    size_t count = items.size();
+    if (count < 2) {
+        return;
+    }
+    scratch.resize(count);
+    unsigned workers = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, count / MIN_ITEMS_PER_THREAD)));
+
+    uint64_t anyBits = 0;
+    uint64_t allBits = ~uint64_t(0);
+    for (const auto& item : items) {
+        anyBits |= item.key;
+        allBits &= item.key;
+    }
+    uint64_t varying = anyBits ^ allBits;
+
+    std::vector<std::array<size_t, 256>> counts(workers);
+    for (unsigned shift = 0; shift < 64; shift += 8) {
+        if (((varying >> shift) & 0xFF) == 0) {
+            continue;
+        }
+
+        forEachSlice(workers, count, [&](unsigned w, size_t begin, size_t end) {
+            auto& histogram = counts[w];
+            histogram.fill(0);
+            for (size_t i = begin; i < end; ++i) {
+                histogram[(items[i].key >> shift) & 0xFF]++;
+            }
+        });
+
+        size_t offset = 0;
+        for (size_t digit = 0; digit < 256; ++digit) {
+            for (unsigned w = 0; w < workers; ++w) {
+                size_t slice = counts[w][digit];
+                counts[w][digit] = offset;
+                offset += slice;
+            }
+        }
+
+        forEachSlice(workers, count, [&](unsigned w, size_t begin, size_t end) {
+            auto& next = counts[w];
+            for (size_t i = begin; i < end; ++i) {
+                scratch[next[(items[i].key >> shift) & 0xFF]++] = items[i];
+            }
+        });
+        items.swap(scratch);
+    }
+}
+
+bool ExternalSorter::spill() {
+    sortItems();
+
+    std::string path = runPrefix + ".run" + std::to_string(runFiles.size()) + ".tmp";
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return fail("Cannot create sort run: " + path);
+    }
+    runFiles.push_back(path);
+
+    std::string block;
+    for (const auto& item : items) {
+        block.append(reinterpret_cast<const char*>(&item.key), sizeof(item.key));
+        block.append(reinterpret_cast<const char*>(&item.size), sizeof(item.size));
+        block.append(text, item.offset, item.size);
+        if (block.size() >= OUTPUT_PIECE) {
+            file.write(block.data(), static_cast<std::streamsize>(block.size()));
+            block.clear();
+        }
+    }
+    file.write(block.data(), static_cast<std::streamsize>(block.size()));
+    file.close();
+    if (!file) {
+        return fail("Cannot write sort run: " + path);
+    }
+
+    items.clear();
+    text.clear();
+    return true;
+}
+
+// k-way merge: a heap holds the head of every run, ties going to the
+// earlier run so equal keys keep their insertion order
+bool ExternalSorter::mergeRuns(const Output& output) {
+    // Read buffers share the memory budget
+    size_t bufferSize = std::max<size_t>(size_t(64) << 10, std::min<size_t>(size_t(4) << 20, memoryLimit / runFiles.size()));
+
+    std::vector<std::unique_ptr<Run>> runs;
+    using Head = std::pair<uint64_t, size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    // A run may only end between records; anything else lost lines
+    auto advance = [&](size_t index) {
+        Run& run = *runs[index];
+        if (run.next()) {
+            heads.push({run.key, index});
+            return true;
+        }
+        if (run.file.bad()) {
+            return fail("Cannot read sort run: " + runFiles[index]);
+        }
+        if (run.truncated) {
+            return fail("Sort run ends inside a record: " + runFiles[index]);
+        }
+        return true;
+    };
+    for (const auto& path : runFiles) {
+        auto run = std::make_unique<Run>();
+        run->file.open(path, std::ios::binary);
+        if (!run->file) {
+            return fail("Cannot open sort run: " + path);
+        }
+        run->buffer.resize(bufferSize);
+        runs.push_back(std::move(run));
+        if (!advance(runs.size() - 1)) {
+            return false;
+        }
+    }
+
+    std::string piece;
+    while (!heads.empty()) {
+        size_t index = heads.top().second;
+        heads.pop();
+        Run& run = *runs[index];
+        piece.append(run.line, run.size);
+        if (piece.size() >= OUTPUT_PIECE) {
+            if (!output(piece.data(), piece.size())) {
+                return fail("Cannot write sorted output");
+            }
+            piece.clear();
+        }
+        if (!advance(index)) {
+            return false;
+        }
+    }
+    if (!piece.empty() && !output(piece.data(), piece.size())) {
+        return fail("Cannot write sorted output");
+    }
+    return true;
+}
+
+void ExternalSorter::removeRuns() {
+    for (const auto& path : runFiles) {
+        std::remove(path.c_str());
+    }
+    runFiles.clear();
+}
+
+bool ExternalSorter::fail(const std::string& message) {
+    if (lastError.empty()) {
+        lastError = message;
+    }
+    return false;
+}
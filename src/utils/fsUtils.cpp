@@ -1,5 +1,7 @@
 #include "fsUtils.h"
 #include <sys/stat.h>
+#include <algorithm>
+#include <ctime>
 #include <fstream>
 #include <sstream>
 
@@ -16,6 +18,7 @@
 #else
 #include <unistd.h>
 #include <dirent.h>
+#include <glob.h>
 #include <sys/statvfs.h>
 #define PATH_SEPARATOR '/'
 #endif
@@ -155,6 +158,50 @@ std::vector<std::string> FileSystemUtils::listDirectory(const std::string& path)
     return files;
 }
 
+std::vector<std::string> FileSystemUtils::globFiles(const std::string& pattern) {
+    std::vector<std::string> files;
+    
+    if (isDirectory(pattern)) {
+        for (const auto& name : listDirectory(pattern)) {
+            std::string path = joinPath(pattern, name);
+            if (!isDirectory(path)) {
+                files.push_back(path);
+            }
+        }
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+    
+#ifdef _WIN32
+    WIN32_FIND_DATA findData;
+    std::string directory = getDirname(pattern);
+    HANDLE hFind = FindFirstFile(pattern.c_str(), &findData);
+    
+    if (hFind != INVALID_HANDLE_VALUE) {
+        do {
+            if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+                files.push_back(joinPath(directory, findData.cFileName));
+            }
+        } while (FindNextFile(hFind, &findData));
+        FindClose(hFind);
+    }
+#else
+    glob_t globResult;
+    if (glob(pattern.c_str(), 0, nullptr, &globResult) == 0) {
+        for (size_t i = 0; i < globResult.gl_pathc; ++i) {
+            std::string path = globResult.gl_pathv[i];
+            if (!isDirectory(path)) {
+                files.push_back(path);
+            }
+        }
+    }
+    globfree(&globResult);
+#endif
+    
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
 bool FileSystemUtils::copyFile(const std::string& source, const std::string& destination) {
     std::ifstream src(source, std::ios::binary);
     if (!src.is_open()) {
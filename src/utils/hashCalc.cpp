@@ -3,8 +3,11 @@
 #ifdef HAVE_OPENSSL
 #include <openssl/md5.h>
 #include <openssl/sha.h>
+#include <openssl/evp.h>
 #endif
 
+#include <fstream>
+#include <new>
 #include <iomanip>
 #include <sstream>
 
@@ -86,6 +89,21 @@ std::string HashCalculator::calculateSha256(const std::vector<uint8_t>& data) {
     return bytesToHex(hashVec);
 }
 
+std::string HashCalculator::calculateFileSha256(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return "";
+    
+    Sha256Stream hash;
+    std::vector<char> buffer(1 << 20);
+    while (file) {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        hash.update(buffer.data(), static_cast<size_t>(file.gcount()));
+    }
+    if (file.bad()) return "";
+    
+    return hash.hexDigest();
+}
+
 std::string HashCalculator::calculateSha512(const std::vector<uint8_t>& data) {
     if (data.empty()) return "";
     
@@ -149,4 +167,57 @@ std::string HashCalculator::bytesToHex(const std::vector<uint8_t>& bytes) {
         oss << std::setw(2) << static_cast<int>(byte);
     }
     return oss.str();
-}
\ No newline at end of file
+}
+
+// EVP rather than the SHA256_* calls, which OpenSSL 3 deprecates
+struct Sha256Stream::Context {
+    EVP_MD_CTX* state;
+
+    Context() : state(EVP_MD_CTX_new()) {
+        if (!state) {
+            throw std::bad_alloc();
+        }
+    }
+    ~Context() {
+        EVP_MD_CTX_free(state);
+    }
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+};
+
+Sha256Stream::Sha256Stream() : context(std::make_unique<Context>()), bytes(0) {
+    EVP_DigestInit_ex(context->state, EVP_sha256(), nullptr);
+}
+
+Sha256Stream::~Sha256Stream() = default;
+
+Sha256Stream::Sha256Stream(Sha256Stream&&) noexcept = default;
+
+Sha256Stream& Sha256Stream::operator=(Sha256Stream&&) noexcept = default;
+
+void Sha256Stream::reset() {
+    EVP_DigestInit_ex(context->state, EVP_sha256(), nullptr);
+    bytes = 0;
+}
+
+void Sha256Stream::update(const void* data, size_t size) {
+    EVP_DigestUpdate(context->state, data, size);
+    bytes += size;
+}
+
+std::string Sha256Stream::hexDigest() const {
+    // Finishes a copy, so the stream itself can keep going
+    Context copy;
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    if (!EVP_MD_CTX_copy_ex(copy.state, context->state) || !EVP_DigestFinal_ex(copy.state, hash, &length)) {
+        return "";
+    }
+
+    std::ostringstream oss;
+    oss << std::hex << std::uppercase << std::setfill('0');
+    for (unsigned int i = 0; i < length; ++i) {
+        oss << std::setw(2) << static_cast<int>(hash[i]);
+    }
+    return oss.str();
+}
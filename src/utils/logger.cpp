@@ -80,8 +80,15 @@ std::string Logger::getCurrentTimestamp() const {
     auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
         now.time_since_epoch()) % 1000;
     
+    std::tm localTime{};
+#ifdef _WIN32
+    localtime_s(&localTime, &time_t);
+#else
+    localtime_r(&time_t, &localTime);
+#endif
+    
     std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
+    ss << std::put_time(&localTime, "%Y-%m-%d %H:%M:%S");
     ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
     
     return ss.str();
@@ -0,0 +1,650 @@
+#include "outputSink.h"
+#include "hashCalc.h"
+#include "shmRing.h"
+#include "stringUtils.h"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <climits>
+#endif
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+
+struct OutputSink::Ring {
+    io_uring ring;
+};
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+bool OutputCompression::parse(const std::string& spec, std::string& error) {
+    std::string name = StringUtils::toLower(StringUtils::trim(spec));
+    std::string levelText;
+    size_t colon = name.find(':');
+    if (colon != std::string::npos) {
+        levelText = name.substr(colon + 1);
+        name = name.substr(0, colon);
+    }
+
+    int maxLevel = 0;
+    if (name == "zstd") {
+#ifndef HAVE_ZSTD
+        error = "zstd support is not available in this build";
+        return false;
+#endif
+        codec = Codec::Zstd;
+        maxLevel = 22;
+    } else if (name == "gzip" || name == "gz") {
+#ifndef HAVE_ZLIB
+        error = "gzip support is not available in this build";
+        return false;
+#endif
+        codec = Codec::Gzip;
+        maxLevel = 9;
+    } else {
+        error = "Unknown codec '" + name + "', expected zstd or gzip";
+        return false;
+    }
+
+    level = 0;
+    if (!levelText.empty()) {
+        size_t consumed = 0;
+        try {
+            level = std::stoi(levelText, &consumed);
+        } catch (const std::exception&) {
+            consumed = 0;
+        }
+        if (consumed != levelText.size() || level < 1 || level > maxLevel) {
+            error = "Level for " + name + " must be 1-" + std::to_string(maxLevel) + ", got '" + levelText + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* OutputCompression::extension() const {
+    switch (codec) {
+        case Codec::Zstd: return "zst";
+        case Codec::Gzip: return "gz";
+        default: return "";
+    }
+}
+
+bool OutputSplit::parse(const std::string& spec, std::string& error) {
+    records = 0;
+    bytes = 0;
+    bool count = !spec.empty() && spec.find_first_not_of("0123456789") == std::string::npos;
+    if (count ? !StringUtils::parseByteSize(spec, records) : !StringUtils::parseByteSize(spec, bytes)) {
+        error = "expected a record count or a size such as 512M, got '" + spec + "'";
+        return false;
+    }
+    if (!enabled()) {
+        error = "parts must hold at least one record or byte";
+        return false;
+    }
+    return true;
+}
+
+// Per-thread codec state, reused across buffers
+struct OutputSink::Compressor {
+#ifdef HAVE_ZSTD
+    ZSTD_CCtx* zstd = nullptr;
+#endif
+#ifdef HAVE_ZLIB
+    z_stream gzip;
+    bool gzipReady = false;
+#endif
+
+    ~Compressor() {
+#ifdef HAVE_ZSTD
+        ZSTD_freeCCtx(zstd);
+#endif
+#ifdef HAVE_ZLIB
+        if (gzipReady) {
+            deflateEnd(&gzip);
+        }
+#endif
+    }
+};
+
+OutputSink::OutputSink(size_t bufferSize, size_t bufferCount)
+    : bufferSize(bufferSize > 0 ? bufferSize : DEFAULT_BUFFER_SIZE),
+      bufferCount(std::max<size_t>(bufferCount, 2)), current(0), committed(0), fileOffset(0),
+      stopping(false), failed(false), opened(false)
+#ifdef _WIN32
+    , fileHandle(nullptr)
+#else
+    , fd(-1)
+#endif
+    , digest(nullptr), cancellation(nullptr)
+{
+}
+
+OutputSink::~OutputSink() {
+    close();
+}
+
+bool OutputSink::open(const std::string& path, uint64_t expectedSize) {
+    close();
+    lastError.clear();
+    failed = false;
+
+    if (ShmRingWriter::isRingPath(path)) {
+        sharedRing = std::make_unique<ShmRingWriter>();
+        uint32_t flags = compression.enabled() ? ShmRingHeader::FLAG_COMPRESSED : ShmRingHeader::FLAG_LINES;
+        sharedRing->setCancellation(cancellation);
+        if (!sharedRing->create(path, flags)) {
+            lastError = sharedRing->getLastError();
+            sharedRing.reset();
+            return false;
+        }
+    } else if (!openFile(path, expectedSize)) {
+        return false;
+    }
+    if (digest) {
+        *digest = OutputDigest();
+        hash = std::make_unique<Sha256Stream>();
+    } else {
+        hash.reset();
+    }
+
+    // Compression threads each need a buffer in hand, plus one being filled
+    // and one being written
+    unsigned workers = compression.enabled() ? std::max(1u, compression.threads) : 0;
+    size_t count = std::max<size_t>(bufferCount, workers + 2);
+
+#ifdef HAVE_LIBURING
+    if (!sharedRing) {
+        ring = std::make_unique<Ring>();
+        if (io_uring_queue_init(static_cast<unsigned>(count), &ring->ring, 0) < 0) {
+            ring.reset();
+        }
+    }
+#endif
+
+    buffers.resize(count);
+    for (auto& buffer : buffers) {
+        buffer.resize(bufferSize);
+    }
+    compressed.assign(workers > 0 ? count : 0, std::vector<char>());
+    compressedSize.assign(workers > 0 ? count : 0, 0);
+    freeBuffers.clear();
+    blocks.clear();
+    for (size_t i = 1; i < count; ++i) {
+        freeBuffers.push_back(i);
+    }
+    current = 0;
+    committed = 0;
+    fileOffset = 0;
+    setp(buffers[current].data(), buffers[current].data() + bufferSize);
+
+    stopping = false;
+    opened = true;
+    writer = std::thread(&OutputSink::runWriter, this);
+    for (unsigned i = 0; i < workers; ++i) {
+        compressors.emplace_back(&OutputSink::runCompressor, this);
+    }
+    return true;
+}
+
+bool OutputSink::append(const char* data, size_t size) {
+    return static_cast<size_t>(xsputn(data, static_cast<std::streamsize>(size))) == size;
+}
+
+bool OutputSink::close() {
+    if (!opened) {
+        return !failed;
+    }
+
+    size_t used = static_cast<size_t>(pptr() - pbase());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Compressed output always gets at least one frame, so that an
+        // empty export is still a valid .zst or .gz file
+        if (!failed && (used > 0 || (compression.enabled() && committed == 0))) {
+            blocks.push_back({current, used, false, !compression.enabled()});
+            committed += used;
+        }
+        stopping = true;
+    }
+    blockQueued.notify_all();
+    blockDone.notify_all();
+    for (auto& compressor : compressors) {
+        compressor.join();
+    }
+    compressors.clear();
+    writer.join();
+    setp(nullptr, nullptr);
+
+    if (sharedRing) {
+        // Waits for the consumer to read the rest; a failed export tells it
+        // the stream is incomplete instead
+        if (failed) {
+            sharedRing->abort();
+        } else if (!sharedRing->finish()) {
+            fail(sharedRing->getLastError());
+        }
+        sharedRing.reset();
+    } else {
+        closeFile();
+    }
+    if (hash && !failed) {
+        digest->sha256 = hash->hexDigest();
+        digest->bytes = hash->size();
+    }
+
+#ifdef HAVE_LIBURING
+    if (ring) {
+        io_uring_queue_exit(&ring->ring);
+        ring.reset();
+    }
+#endif
+
+    opened = false;
+    return !failed;
+}
+
+bool OutputSink::openFile(const std::string& path, uint64_t expectedSize) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        lastError = "Cannot create output file: " + path;
+        return false;
+    }
+    fileHandle = file;
+    if (expectedSize > 0 && !compression.enabled()) {
+        FILE_ALLOCATION_INFO allocation;
+        allocation.AllocationSize.QuadPart = static_cast<LONGLONG>(expectedSize);
+        SetFileInformationByHandle(file, FileAllocationInfo, &allocation, sizeof(allocation));
+    }
+#else
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        lastError = "Cannot create output file: " + path + ": " + std::strerror(errno);
+        return false;
+    }
+#ifdef __linux__
+    // Reserve the blocks without changing the file size; close() releases
+    // whatever the estimate overshot. Only a hint, so failures are ignored.
+    // The estimate is of uncompressed bytes, so it is no use when compressing.
+    if (expectedSize > 0 && !compression.enabled()) {
+        fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(expectedSize));
+    }
+#endif
+#endif
+    return true;
+}
+
+void OutputSink::closeFile() {
+#ifdef _WIN32
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+    fileHandle = nullptr;
+#else
+    // Drops any preallocated tail past the data
+    if (!failed && ftruncate(fd, static_cast<off_t>(fileOffset)) != 0) {
+        fail(std::string("Cannot truncate output file: ") + std::strerror(errno));
+    }
+    if (::close(fd) != 0 && !failed) {
+        fail(std::string("Cannot close output file: ") + std::strerror(errno));
+    }
+    fd = -1;
+#endif
+}
+
+OutputSink::int_type OutputSink::overflow(int_type ch) {
+    if (!opened || !handOff()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize OutputSink::xsputn(const char* data, std::streamsize size) {
+    std::streamsize written = 0;
+    while (written < size) {
+        std::streamsize space = epptr() - pptr();
+        if (space == 0) {
+            if (!opened || !handOff()) {
+                break;
+            }
+            continue;
+        }
+        std::streamsize chunk = std::min(space, size - written);
+        std::memcpy(pptr(), data + written, static_cast<size_t>(chunk));
+        pbump(static_cast<int>(chunk));
+        written += chunk;
+    }
+    return written;
+}
+
+// Queues the current buffer and continues in a free one
+bool OutputSink::handOff() {
+    size_t used = static_cast<size_t>(pptr() - pbase());
+    std::unique_lock<std::mutex> lock(mutex);
+    if (failed) {
+        setp(nullptr, nullptr);
+        return false;
+    }
+    if (used > 0) {
+        blocks.push_back({current, used, false, !compression.enabled()});
+        committed += used;
+        if (compression.enabled()) {
+            blockQueued.notify_one();
+        } else {
+            blockDone.notify_one();
+        }
+        bufferFree.wait(lock, [this] { return !freeBuffers.empty() || failed; });
+        if (failed) {
+            setp(nullptr, nullptr);
+            return false;
+        }
+        current = freeBuffers.front();
+        freeBuffers.pop_front();
+    }
+    setp(buffers[current].data(), buffers[current].data() + bufferSize);
+    return true;
+}
+
+// Writes finished blocks strictly in queue order
+void OutputSink::runWriter() {
+    std::vector<Block> batch;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            blockDone.wait(lock, [this] {
+                return failed || (!blocks.empty() && blocks.front().done) || (stopping && blocks.empty());
+            });
+            if (failed || blocks.empty()) {
+                return;
+            }
+            batch.clear();
+            while (!blocks.empty() && blocks.front().done) {
+                batch.push_back(blocks.front());
+                blocks.pop_front();
+            }
+        }
+
+        bool written = sharedRing ? publishBlocks(batch) : writeBlocks(batch);
+        if (written && hash) {
+            for (const Block& block : batch) {
+                hash->update(blockData(block), blockSize(block));
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const Block& block : batch) {
+                freeBuffers.push_back(block.buffer);
+            }
+        }
+        bufferFree.notify_one();
+    }
+}
+
+void OutputSink::runCompressor() {
+    Compressor state;
+    for (;;) {
+        size_t buffer = 0;
+        size_t size = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            Block* next = nullptr;
+            blockQueued.wait(lock, [&] {
+                next = nullptr;
+                for (Block& block : blocks) {
+                    if (!block.claimed && !block.done) {
+                        next = &block;
+                        break;
+                    }
+                }
+                return failed || next || stopping;
+            });
+            if (failed || !next) {
+                return;
+            }
+            next->claimed = true;
+            buffer = next->buffer;
+            size = next->size;
+        }
+
+        bool ok = compressBuffer(buffer, size, state);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (Block& block : blocks) {
+                if (block.buffer == buffer && block.claimed) {
+                    block.done = ok;
+                    break;
+                }
+            }
+        }
+        blockDone.notify_all();
+        if (!ok) {
+            return;
+        }
+    }
+}
+
+bool OutputSink::compressBuffer(size_t buffer, size_t size, Compressor& state) {
+    const char* input = buffers[buffer].data();
+    std::vector<char>& output = compressed[buffer];
+
+#ifdef HAVE_ZSTD
+    if (compression.codec == OutputCompression::Codec::Zstd) {
+        if (!state.zstd) {
+            state.zstd = ZSTD_createCCtx();
+            if (!state.zstd) {
+                fail("Cannot create zstd context");
+                return false;
+            }
+        }
+        output.resize(std::max(output.size(), ZSTD_compressBound(size)));
+        size_t result = ZSTD_compressCCtx(state.zstd, output.data(), output.size(), input, size,
+                                          compression.level > 0 ? compression.level : ZSTD_CLEVEL_DEFAULT);
+        if (ZSTD_isError(result)) {
+            fail(std::string("zstd compression failed: ") + ZSTD_getErrorName(result));
+            return false;
+        }
+        compressedSize[buffer] = result;
+        return true;
+    }
+#endif
+
+#ifdef HAVE_ZLIB
+    if (compression.codec == OutputCompression::Codec::Gzip) {
+        if (!state.gzipReady) {
+            std::memset(&state.gzip, 0, sizeof(state.gzip));
+            // windowBits 15 + 16 writes a gzip header and trailer around the deflate stream
+            if (deflateInit2(&state.gzip, compression.level > 0 ? compression.level : Z_DEFAULT_COMPRESSION,
+                             Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                fail("Cannot initialize gzip compression");
+                return false;
+            }
+            state.gzipReady = true;
+        } else {
+            deflateReset(&state.gzip);
+        }
+        output.resize(std::max<size_t>(output.size(), deflateBound(&state.gzip, static_cast<uLong>(size))));
+        state.gzip.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+        state.gzip.avail_in = static_cast<uInt>(size);
+        state.gzip.next_out = reinterpret_cast<Bytef*>(output.data());
+        state.gzip.avail_out = static_cast<uInt>(output.size());
+        if (deflate(&state.gzip, Z_FINISH) != Z_STREAM_END) {
+            fail("gzip compression failed");
+            return false;
+        }
+        compressedSize[buffer] = state.gzip.total_out;
+        return true;
+    }
+#endif
+
+    fail("Output compression is not available in this build");
+    return false;
+}
+
+const char* OutputSink::blockData(const Block& block) const {
+    return compression.enabled() ? compressed[block.buffer].data() : buffers[block.buffer].data();
+}
+
+size_t OutputSink::blockSize(const Block& block) const {
+    return compression.enabled() ? compressedSize[block.buffer] : block.size;
+}
+
+void OutputSink::fail(const std::string& message) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!failed) {
+            lastError = message;
+        }
+        failed = true;
+    }
+    bufferFree.notify_all();
+    blockQueued.notify_all();
+    blockDone.notify_all();
+}
+
+bool OutputSink::publishBlocks(const std::vector<Block>& batch) {
+    for (const Block& block : batch) {
+        if (!sharedRing->write(blockData(block), blockSize(block))) {
+            fail(sharedRing->getLastError());
+            return false;
+        }
+        fileOffset += blockSize(block);
+    }
+    return true;
+}
+
+#ifdef _WIN32
+
+bool OutputSink::writeBlocks(const std::vector<Block>& batch) {
+    HANDLE file = static_cast<HANDLE>(fileHandle);
+    for (const Block& block : batch) {
+        const char* data = blockData(block);
+        size_t size = blockSize(block);
+        size_t done = 0;
+        while (done < size) {
+            OVERLAPPED position = {};
+            position.Offset = static_cast<DWORD>(fileOffset);
+            position.OffsetHigh = static_cast<DWORD>(fileOffset >> 32);
+            DWORD written = 0;
+            if (!WriteFile(file, data + done, static_cast<DWORD>(size - done), &written, &position)) {
+                fail("Write to output file failed (error " + std::to_string(GetLastError()) + ")");
+                return false;
+            }
+            done += written;
+            fileOffset += written;
+        }
+    }
+    return true;
+}
+
+#else
+
+bool OutputSink::writeBlocks(const std::vector<Block>& batch) {
+    size_t total = 0;
+    for (const Block& block : batch) {
+        total += blockSize(block);
+    }
+
+#ifdef HAVE_LIBURING
+    if (ring) {
+        uint64_t offset = fileOffset;
+        for (const Block& block : batch) {
+            io_uring_sqe* sqe = io_uring_get_sqe(&ring->ring);
+            io_uring_prep_write(sqe, fd, blockData(block), static_cast<unsigned>(blockSize(block)), offset);
+            offset += blockSize(block);
+        }
+        int submitted = io_uring_submit_and_wait(&ring->ring, static_cast<unsigned>(batch.size()));
+        if (submitted < 0) {
+            fail(std::string("io_uring submit failed: ") + std::strerror(-submitted));
+            return false;
+        }
+
+        size_t written = 0;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            io_uring_cqe* cqe = nullptr;
+            int result = io_uring_wait_cqe(&ring->ring, &cqe);
+            if (result < 0) {
+                fail(std::string("io_uring wait failed: ") + std::strerror(-result));
+                return false;
+            }
+            int bytes = cqe->res;
+            io_uring_cqe_seen(&ring->ring, cqe);
+            if (bytes < 0) {
+                fail(std::string("Write to output file failed: ") + std::strerror(-bytes));
+                return false;
+            }
+            written += static_cast<size_t>(bytes);
+        }
+        if (written == total) {
+            fileOffset += total;
+            return true;
+        }
+        // A short write: rewrite the batch below, the offsets are fixed
+    }
+#endif
+
+    // Blocks are consecutive in the file; one pwritev covers all of them
+    std::vector<iovec> vectors;
+    vectors.reserve(batch.size());
+    for (const Block& block : batch) {
+        vectors.push_back({const_cast<char*>(blockData(block)), blockSize(block)});
+    }
+
+    uint64_t offset = fileOffset;
+    size_t index = 0;
+    while (index < vectors.size()) {
+        if (vectors[index].iov_len == 0) {
+            index++;
+            continue;
+        }
+        int count = static_cast<int>(std::min<size_t>(vectors.size() - index, IOV_MAX));
+        ssize_t written = count == 1
+            ? pwrite(fd, vectors[index].iov_base, vectors[index].iov_len, static_cast<off_t>(offset))
+            : pwritev(fd, &vectors[index], count, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fail(std::string("Write to output file failed: ") + std::strerror(errno));
+            return false;
+        }
+        if (written == 0) {
+            fail("Write to output file failed: no space written");
+            return false;
+        }
+
+        offset += static_cast<uint64_t>(written);
+        size_t remaining = static_cast<size_t>(written);
+        while (remaining > 0 && remaining >= vectors[index].iov_len) {
+            remaining -= vectors[index].iov_len;
+            index++;
+        }
+        if (remaining > 0) {
+            vectors[index].iov_base = static_cast<char*>(vectors[index].iov_base) + remaining;
+            vectors[index].iov_len -= remaining;
+        }
+    }
+    fileOffset = offset;
+    return true;
+}
+
+#endif
@@ -0,0 +1,464 @@
+#include "shmRing.h"
+#include "../core/cancellationToken.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <new>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char PREFIX[] = "shm:";
+constexpr size_t PREFIX_LENGTH = sizeof(PREFIX) - 1;
+constexpr uint64_t MIN_CAPACITY = 64 * 1024;
+
+uint64_t padded(uint64_t size) {
+    return (size + 7) & ~uint64_t(7);
+}
+
+// "shm:NAME" and "shm:/NAME" both name the object "/NAME"
+std::string objectName(const std::string& path) {
+    std::string name = path.substr(PREFIX_LENGTH);
+    return name[0] == '/' ? name : "/" + name;
+}
+
+// Spins briefly, then sleeps 50 us doubling up to 1 ms; a consumer keeping
+// up never sleeps, an idle one costs a wakeup per millisecond
+class Backoff {
+public:
+    // False once the wait has gone to sleep and should look at the peer
+    bool pause() {
+        if (spins < 64) {
+            spins++;
+            std::this_thread::yield();
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(delay));
+        delay = std::min(delay * 2, 1000u);
+        return false;
+    }
+
+private:
+    unsigned spins = 0;
+    unsigned delay = 50;
+};
+
+#ifndef _WIN32
+bool processAlive(int32_t pid) {
+    return pid <= 0 || kill(pid, 0) == 0 || errno != ESRCH;
+}
+#endif
+
+}
+
+bool ShmRingWriter::isRingPath(const std::string& path) {
+    if (path.compare(0, PREFIX_LENGTH, PREFIX) != 0) {
+        return false;
+    }
+    size_t start = path.size() > PREFIX_LENGTH && path[PREFIX_LENGTH] == '/' ? PREFIX_LENGTH + 1 : PREFIX_LENGTH;
+    return start < path.size() && path.find('/', start) == std::string::npos;
+}
+
+ShmRingWriter::ShmRingWriter()
+    : header(nullptr), data(nullptr), capacity(0), mappedSize(0), cancellation(nullptr) {
+}
+
+ShmRingWriter::~ShmRingWriter() {
+    abort();
+}
+
+ShmRingReader::ShmRingReader()
+    : header(nullptr), data(nullptr), capacity(0), mappedSize(0), position(0), failed(false) {
+}
+
+ShmRingReader::~ShmRingReader() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool ShmRingWriter::create(const std::string& path, uint32_t flags, uint64_t capacity) {
+    lastError = "Shared-memory output is not supported on Windows";
+    return false;
+}
+
+bool ShmRingWriter::write(const char* bytes, size_t size) {
+    return false;
+}
+
+bool ShmRingWriter::finish() {
+    return false;
+}
+
+void ShmRingWriter::abort() {
+}
+
+bool ShmRingReader::open(const std::string& path, unsigned timeoutMs) {
+    return fail("Shared-memory output is not supported on Windows");
+}
+
+bool ShmRingReader::next(std::string_view& message) {
+    return false;
+}
+
+void ShmRingReader::close() {
+}
+
+bool ShmRingReader::fail(const std::string& message) {
+    lastError = message;
+    failed = true;
+    return false;
+}
+
+#else
+
+bool ShmRingWriter::create(const std::string& path, uint32_t flags, uint64_t size) {
+    abort();
+    lastError.clear();
+    if (!isRingPath(path)) {
+        lastError = "Not a shared-memory path: " + path;
+        return false;
+    }
+    if (size < MIN_CAPACITY || (size & (size - 1)) != 0) {
+        lastError = "Ring capacity must be a power of two of at least 64 KiB";
+        return false;
+    }
+
+    // A name left behind by a producer that crashed would otherwise make
+    // O_EXCL fail; its consumer sees that producer gone either way
+    std::string objectPath = objectName(path);
+    shm_unlink(objectPath.c_str());
+    int fd = shm_open(objectPath.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        lastError = "Cannot create shared memory " + objectPath + ": " + std::strerror(errno);
+        return false;
+    }
+    size_t total = sizeof(ShmRingHeader) + size;
+    if (ftruncate(fd, static_cast<off_t>(total)) != 0) {
+        lastError = "Cannot size shared memory " + objectPath + ": " + std::strerror(errno);
+        ::close(fd);
+        shm_unlink(objectPath.c_str());
+        return false;
+    }
+    void* mapping = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        lastError = "Cannot map shared memory " + objectPath + ": " + std::strerror(errno);
+        shm_unlink(objectPath.c_str());
+        return false;
+    }
+
+    // The new object is zero-filled: every counter starts at 0 and the
+    // version stays 0 until the header is complete
+    header = new (mapping) ShmRingHeader;
+    std::memcpy(header->magic, ShmRingHeader::MAGIC, sizeof(header->magic));
+    header->flags = flags;
+    header->capacity = size;
+    header->producerPid = static_cast<int32_t>(getpid());
+    header->version.store(ShmRingHeader::VERSION, std::memory_order_release);
+
+    data = static_cast<char*>(mapping) + sizeof(ShmRingHeader);
+    capacity = size;
+    mappedSize = total;
+    name = objectPath;
+    carry.clear();
+    return true;
+}
+
+// With FLAG_LINES, sends everything up to the last line break and keeps
+// the rest for the next call; a line longer than half the ring is the only
+// thing ever split
+bool ShmRingWriter::write(const char* bytes, size_t size) {
+    if (!header) {
+        return false;
+    }
+    size_t maxPayload = static_cast<size_t>(capacity / 2);
+    if (!(header->flags & ShmRingHeader::FLAG_LINES)) {
+        while (size > 0) {
+            size_t chunk = std::min(size, maxPayload);
+            if (!publish(bytes, chunk, nullptr, 0)) {
+                return false;
+            }
+            bytes += chunk;
+            size -= chunk;
+        }
+        return true;
+    }
+
+    while (size > 0) {
+        if (carry.size() == maxPayload) {
+            if (!publish(carry.data(), carry.size(), nullptr, 0)) {
+                return false;
+            }
+            carry.clear();
+        }
+        size_t span = std::min(size, maxPayload - carry.size());
+        size_t lineBreak = std::string_view(bytes, span).rfind('\n');
+        if (lineBreak == std::string_view::npos) {
+            carry.append(bytes, span);
+            bytes += span;
+            size -= span;
+            continue;
+        }
+        if (!publish(carry.data(), carry.size(), bytes, lineBreak + 1)) {
+            return false;
+        }
+        carry.clear();
+        bytes += lineBreak + 1;
+        size -= lineBreak + 1;
+    }
+    return true;
+}
+
+bool ShmRingWriter::finish() {
+    if (!header) {
+        return lastError.empty();
+    }
+    if (!carry.empty()) {
+        if (!publish(carry.data(), carry.size(), nullptr, 0)) {
+            abort();
+            return false;
+        }
+        carry.clear();
+    }
+    header->state.store(ShmRingHeader::FINISHED, std::memory_order_release);
+
+    // Removing the name now would not take the mapping from an attached
+    // consumer, but one that has not attached yet would never find it
+    uint64_t end = header->head.load(std::memory_order_relaxed);
+    Backoff backoff;
+    while (header->tail.load(std::memory_order_acquire) != end) {
+        if (backoff.pause()) {
+            continue;
+        }
+        if (consumerGone()) {
+            if (header->tail.load(std::memory_order_acquire) == end) {
+                break;
+            }
+            lastError = "Consumer of " + name + " detached before reading the whole output";
+            release();
+            return false;
+        }
+        if (cancelled()) {
+            lastError = "Cancelled while waiting for the consumer of " + name;
+            abort();
+            return false;
+        }
+    }
+    release();
+    return true;
+}
+
+void ShmRingWriter::abort() {
+    if (header) {
+        header->state.store(ShmRingHeader::FAILED, std::memory_order_release);
+        release();
+    }
+}
+
+bool ShmRingWriter::publish(const char* first, size_t firstSize, const char* second, size_t secondSize) {
+    uint64_t payload = firstSize + secondSize;
+    uint64_t bytes = sizeof(ShmRingMessage) + padded(payload);
+    uint64_t position = 0;
+    if (!reserve(bytes, position)) {
+        return false;
+    }
+
+    char* target = data + (position & (capacity - 1));
+    ShmRingMessage message = {static_cast<uint32_t>(payload), ShmRingMessage::DATA};
+    std::memcpy(target, &message, sizeof(message));
+    if (firstSize > 0) {
+        std::memcpy(target + sizeof(message), first, firstSize);
+    }
+    if (secondSize > 0) {
+        std::memcpy(target + sizeof(message) + firstSize, second, secondSize);
+    }
+    header->head.store(position + bytes, std::memory_order_release);
+    return true;
+}
+
+// Waits until `bytes` fit contiguously at the head, wrapping first when
+// they would run past the end of the data area
+bool ShmRingWriter::reserve(uint64_t bytes, uint64_t& position) {
+    position = header->head.load(std::memory_order_relaxed);
+    uint64_t offset = position & (capacity - 1);
+    bool wrap = capacity - offset < bytes;
+    uint64_t needed = wrap ? capacity - offset : bytes;
+
+    Backoff backoff;
+    for (;;) {
+        while (position + needed - header->tail.load(std::memory_order_acquire) > capacity) {
+            if (backoff.pause()) {
+                continue;
+            }
+            if (consumerGone()) {
+                lastError = "Consumer of " + name + " detached before the output was complete";
+                return false;
+            }
+            if (cancelled()) {
+                lastError = "Cancelled while waiting for the consumer of " + name;
+                return false;
+            }
+        }
+        if (!wrap) {
+            return true;
+        }
+
+        ShmRingMessage marker = {static_cast<uint32_t>(capacity - offset - sizeof(ShmRingMessage)), ShmRingMessage::WRAP};
+        std::memcpy(data + offset, &marker, sizeof(marker));
+        position += capacity - offset;
+        header->head.store(position, std::memory_order_release);
+        wrap = false;
+        needed = bytes;
+    }
+}
+
+bool ShmRingWriter::consumerGone() const {
+    int32_t pid = header->consumerPid.load(std::memory_order_acquire);
+    return pid < 0 || !processAlive(pid);
+}
+
+bool ShmRingWriter::cancelled() const {
+    return cancellation && cancellation->isCancelled();
+}
+
+void ShmRingWriter::release() {
+    munmap(header, mappedSize);
+    shm_unlink(name.c_str());
+    header = nullptr;
+    data = nullptr;
+    capacity = 0;
+    mappedSize = 0;
+    carry.clear();
+}
+
+bool ShmRingReader::open(const std::string& path, unsigned timeoutMs) {
+    close();
+    failed = false;
+    lastError.clear();
+    if (!ShmRingWriter::isRingPath(path)) {
+        return fail("Not a shared-memory path: " + path);
+    }
+
+    // Until the producer has created, sized and described the ring, keep
+    // trying; it may start after us
+    std::string objectPath = objectName(path);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    void* mapping = MAP_FAILED;
+    size_t size = 0;
+    for (;;) {
+        int fd = shm_open(objectPath.c_str(), O_RDWR, 0);
+        if (fd >= 0) {
+            struct stat info;
+            if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) > sizeof(ShmRingHeader)) {
+                size = static_cast<size_t>(info.st_size);
+                mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            ::close(fd);
+        } else if (errno != ENOENT) {
+            return fail("Cannot open shared memory " + objectPath + ": " + std::strerror(errno));
+        }
+
+        if (mapping != MAP_FAILED) {
+            auto* candidate = static_cast<ShmRingHeader*>(mapping);
+            if (candidate->version.load(std::memory_order_acquire) != 0) {
+                header = candidate;
+                break;
+            }
+            munmap(mapping, size);
+            mapping = MAP_FAILED;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return fail("No producer for shared memory " + objectPath);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    mappedSize = size;
+
+    if (std::memcmp(header->magic, ShmRingHeader::MAGIC, sizeof(header->magic)) != 0 ||
+        header->version.load(std::memory_order_relaxed) != ShmRingHeader::VERSION ||
+        header->capacity + sizeof(ShmRingHeader) != size) {
+        close();
+        return fail(objectPath + " is not an analyzeMFT ring of this version");
+    }
+    int32_t unclaimed = 0;
+    if (!header->consumerPid.compare_exchange_strong(unclaimed, static_cast<int32_t>(getpid()))) {
+        munmap(header, mappedSize);
+        header = nullptr;
+        return fail(objectPath + " already has a consumer");
+    }
+
+    data = reinterpret_cast<const char*>(header) + sizeof(ShmRingHeader);
+    capacity = header->capacity;
+    position = header->tail.load(std::memory_order_acquire);
+    return true;
+}
+
+bool ShmRingReader::next(std::string_view& message) {
+    if (!header) {
+        return false;
+    }
+    // The previous message is done with; its space goes back to the producer
+    header->tail.store(position, std::memory_order_release);
+
+    Backoff backoff;
+    for (;;) {
+        uint32_t state = header->state.load(std::memory_order_acquire);
+        uint64_t head = header->head.load(std::memory_order_acquire);
+        if (position < head) {
+            ShmRingMessage entry;
+            const char* source = data + (position & (capacity - 1));
+            std::memcpy(&entry, source, sizeof(entry));
+            position += sizeof(entry) + padded(entry.size);
+            if (entry.kind == ShmRingMessage::WRAP) {
+                continue;
+            }
+            if (entry.kind != ShmRingMessage::DATA || position > head) {
+                return fail("Corrupt message in shared-memory ring");
+            }
+            message = std::string_view(source + sizeof(entry), entry.size);
+            return true;
+        }
+
+        // head was loaded after state, so a finished stream is fully visible
+        if (state == ShmRingHeader::FINISHED) {
+            header->tail.store(position, std::memory_order_release);
+            return false;
+        }
+        if (state == ShmRingHeader::FAILED) {
+            return fail("The producer failed; the output is incomplete");
+        }
+        if (!backoff.pause() && !processAlive(header->producerPid)) {
+            return fail("The producer exited without finishing the output");
+        }
+    }
+}
+
+void ShmRingReader::close() {
+    if (header) {
+        header->tail.store(position, std::memory_order_release);
+        header->consumerPid.store(-1, std::memory_order_release);
+        munmap(header, mappedSize);
+        header = nullptr;
+        data = nullptr;
+        capacity = 0;
+        mappedSize = 0;
+    }
+}
+
+bool ShmRingReader::fail(const std::string& message) {
+    lastError = message;
+    failed = true;
+    return false;
+}
+
+#endif
@@ -0,0 +1,126 @@
+#include "snappy.h"
+#include <cstring>
+
+namespace {
+
+// Copies may only reach back 64 KiB, so the input is compressed in independent blocks
+constexpr size_t BLOCK_SIZE = 1 << 16;
+constexpr int HASH_BITS = 14;
+constexpr size_t MIN_COMPRESSIBLE = 15;
+
+inline uint32_t load32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t hash32(uint32_t value) {
+    return (value * 0x1e35a7bdu) >> (32 - HASH_BITS);
+}
+
+}
+
+std::vector<uint8_t> Snappy::compress(const uint8_t* input, size_t length) {
+    std::vector<uint8_t> output;
+    output.reserve(length + length / 6 + 32);
+
+    size_t remaining = length;
+    while (remaining >= 0x80) {
+        output.push_back(static_cast<uint8_t>(remaining | 0x80));
+        remaining >>= 7;
+    }
+    output.push_back(static_cast<uint8_t>(remaining));
+
+    for (size_t start = 0; start < length; start += BLOCK_SIZE) {
+        size_t blockLength = length - start < BLOCK_SIZE ? length - start : BLOCK_SIZE;
+        compressBlock(input + start, blockLength, output);
+    }
+    return output;
+}
+
+void Snappy::compressBlock(const uint8_t* input, size_t length, std::vector<uint8_t>& output) {
+    if (length < MIN_COMPRESSIBLE) {
+        emitLiteral(input, length, output);
+        return;
+    }
+
+    uint16_t table[1 << HASH_BITS];
+    std::memset(table, 0, sizeof(table));
+
+    size_t literalStart = 0;
+    size_t position = 0;
+    size_t limit = length - 4;
+
+    while (position <= limit) {
+        uint32_t current = load32(input + position);
+        uint32_t hash = hash32(current);
+        size_t candidate = table[hash];
+        table[hash] = static_cast<uint16_t>(position);
+
+        if (candidate >= position || load32(input + candidate) != current) {
+            // Skip ahead faster through data that is not compressing
+            position += 1 + ((position - literalStart) >> 5);
+            continue;
+        }
+
+        if (position > literalStart) {
+            emitLiteral(input + literalStart, position - literalStart, output);
+        }
+
+        size_t matchLength = 4;
+        while (position + matchLength < length && input[candidate + matchLength] == input[position + matchLength]) {
+            matchLength++;
+        }
+        emitCopy(position - candidate, matchLength, output);
+
+        position += matchLength;
+        literalStart = position;
+        if (position - 1 <= limit) {
+            table[hash32(load32(input + position - 1))] = static_cast<uint16_t>(position - 1);
+        }
+    }
+
+    if (literalStart < length) {
+        emitLiteral(input + literalStart, length - literalStart, output);
+    }
+}
+
+void Snappy::emitLiteral(const uint8_t* literal, size_t length, std::vector<uint8_t>& output) {
+    size_t n = length - 1;
+    if (n < 60) {
+        output.push_back(static_cast<uint8_t>(n << 2));
+    } else if (n < 0x100) {
+        output.push_back(60 << 2);
+        output.push_back(static_cast<uint8_t>(n));
+    } else {
+        output.push_back(61 << 2);
+        output.push_back(static_cast<uint8_t>(n));
+        output.push_back(static_cast<uint8_t>(n >> 8));
+    }
+    output.insert(output.end(), literal, literal + length);
+}
+
+void Snappy::emitCopy(size_t offset, size_t length, std::vector<uint8_t>& output) {
+    auto emitCopy2 = [&output, offset](size_t copyLength) {
+        output.push_back(static_cast<uint8_t>(((copyLength - 1) << 2) | 2));
+        output.push_back(static_cast<uint8_t>(offset));
+        output.push_back(static_cast<uint8_t>(offset >> 8));
+    };
+
+    // Keep at least 4 bytes for the final copy
+    while (length >= 68) {
+        emitCopy2(64);
+        length -= 64;
+    }
+    if (length > 64) {
+        emitCopy2(60);
+        length -= 60;
+    }
+
+    if (length < 12 && offset < 2048) {
+        output.push_back(static_cast<uint8_t>(((offset >> 8) << 5) | ((length - 4) << 2) | 1));
+        output.push_back(static_cast<uint8_t>(offset));
+    } else {
+        emitCopy2(length);
+    }
+}
@@ -1,13 +1,22 @@
 #include "stringUtils.h"
+#include "../core/constants.h"
 #include <algorithm>
 #include <cctype>
 #include <sstream>
 
-std::wstring_convert<std::codecvt_utf8<wchar_t>> StringUtils::converter;
+#if defined(SIMD_OPTIMIZED) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// wstring_convert keeps conversion state, so each thread gets its own
+std::wstring_convert<std::codecvt_utf8<wchar_t>>& StringUtils::converter() {
+    thread_local std::wstring_convert<std::codecvt_utf8<wchar_t>> instance;
+    return instance;
+}
 
 std::string StringUtils::wstringToString(const std::wstring& wstr) {
     try {
-        return converter.to_bytes(wstr);
+        return converter().to_bytes(wstr);
     } catch (const std::exception&) {
         return "";
     }
@@ -15,7 +24,7 @@ std::string StringUtils::wstringToString(const std::wstring& wstr) {
 
 std::wstring StringUtils::stringToWstring(const std::string& str) {
     try {
-        return converter.from_bytes(str);
+        return converter().from_bytes(str);
     } catch (const std::exception&) {
         return L"";
     }
@@ -104,6 +113,95 @@ std::string StringUtils::escapeForCsv(const std::string& str) {
     return escaped;
 }
 
+namespace {
+
+inline unsigned lowestBit(uint32_t mask) {
+#ifdef __GNUC__
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+    unsigned bit = 0;
+    while ((mask & 1) == 0) {
+        mask >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+// Offset of the first byte JSON needs escaped: '"', '\\' or below 0x20.
+// Bytes from 0x80 up are UTF-8 and pass through unchanged.
+size_t findJsonEscape(const char* data, size_t size) {
+    size_t i = 0;
+#ifdef SIMD_OPTIMIZED
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    for (; i + 32 <= size; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        // Unsigned bytes <= 0x1F are the ones min() leaves unchanged
+        __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(bytes, quote), _mm256_cmpeq_epi8(bytes, backslash)),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, control), bytes));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+        if (mask != 0) {
+            return i + lowestBit(mask);
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    for (; i + 16 <= size; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(bytes, control), bytes));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+        if (mask != 0) {
+            return i + lowestBit(mask);
+        }
+    }
+#endif
+    for (; i < size; ++i) {
+        unsigned char c = static_cast<unsigned char>(data[i]);
+        if (c < 0x20 || c == '"' || c == '\\') {
+            return i;
+        }
+    }
+    return size;
+}
+
+}
+
+void StringUtils::appendJsonEscaped(std::string& out, const char* str, size_t size) {
+    static const char hex[] = "0123456789abcdef";
+    size_t pos = 0;
+    while (pos < size) {
+        size_t run = findJsonEscape(str + pos, size - pos);
+        out.append(str + pos, run);
+        pos += run;
+        if (pos == size) {
+            break;
+        }
+
+        unsigned char c = static_cast<unsigned char>(str[pos++]);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: {
+                char escape[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                out.append(escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+}
+
 std::string StringUtils::sanitizeFilename(const std::string& filename) {
     std::string sanitized = filename;
     const std::string invalidChars = "<>:\"/\\|?*";
@@ -115,4 +213,37 @@ std::string StringUtils::sanitizeFilename(const std::string& filename) {
     }
     
     return sanitized;
-}
\ No newline at end of file
+}
+
+bool StringUtils::parseByteSize(const std::string& str, uint64_t& bytes) {
+    if (str.empty() || !std::isdigit(static_cast<unsigned char>(str[0]))) {
+        return false;
+    }
+    
+    size_t consumed = 0;
+    uint64_t value = 0;
+    try {
+        value = std::stoull(str, &consumed);
+    } catch (const std::exception&) {
+        return false;
+    }
+    
+    std::string suffix = toLower(str.substr(consumed));
+    int shift = 0;
+    if (suffix == "k" || suffix == "kb") {
+        shift = 10;
+    } else if (suffix == "m" || suffix == "mb") {
+        shift = 20;
+    } else if (suffix == "g" || suffix == "gb") {
+        shift = 30;
+    } else if (suffix == "t" || suffix == "tb") {
+        shift = 40;
+    } else if (!suffix.empty()) {
+        return false;
+    }
+    if (shift > 0 && value > (UINT64_MAX >> shift)) {
+        return false;
+    }
+    bytes = value << shift;
+    return true;
+}
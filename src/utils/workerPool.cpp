@@ -0,0 +1,85 @@
+#include "workerPool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned threads) : stopping(false) {
+    this->threads.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        this->threads.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobAdded.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(size_t count, const std::function<void(size_t)>& task) {
+    if (threads.empty() || count <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->task = &task;
+    job->count = count;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(job);
+    }
+    jobAdded.notify_all();
+
+    work(*job);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    jobFinished.wait(lock, [&job] { return job->finished == job->count; });
+    // Usually gone already, taken off by a worker that found nothing left in it
+    auto queued = std::find(jobs.begin(), jobs.end(), job);
+    if (queued != jobs.end()) {
+        jobs.erase(queued);
+    }
+}
+
+void WorkerPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        jobAdded.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (stopping) {
+            return;
+        }
+
+        std::shared_ptr<Job> job = jobs.front();
+        if (job->next.load() >= job->count) {
+            jobs.pop_front();
+            continue;
+        }
+        lock.unlock();
+        work(*job);
+        lock.lock();
+    }
+}
+
+// Takes tasks until none are left; whoever finishes the last one wakes run()
+void WorkerPool::work(Job& job) {
+    size_t done = 0;
+    for (size_t i = job.next.fetch_add(1); i < job.count; i = job.next.fetch_add(1)) {
+        (*job.task)(i);
+        ++done;
+    }
+    if (done == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    job.finished += done;
+    if (job.finished == job.count) {
+        jobFinished.notify_all();
+    }
+}
@@ -0,0 +1,337 @@
+#include "zipWriter.h"
+#include <new>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+constexpr uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+constexpr uint32_t DATA_DESCRIPTOR_SIGNATURE = 0x08074b50;
+constexpr uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+constexpr uint32_t ZIP64_END_SIGNATURE = 0x06064b50;
+constexpr uint32_t ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+constexpr uint32_t END_SIGNATURE = 0x06054b50;
+
+constexpr uint16_t VERSION_DEFAULT = 20;
+constexpr uint16_t VERSION_ZIP64 = 45;
+constexpr uint16_t FLAG_DATA_DESCRIPTOR = 0x0008;
+constexpr uint16_t METHOD_STORED = 0;
+constexpr uint16_t METHOD_DEFLATED = 8;
+constexpr uint16_t ZIP64_EXTRA_ID = 0x0001;
+constexpr uint32_t MAX_32 = 0xFFFFFFFF;
+
+// Fixed 1980-01-01 00:00 timestamps keep the archive reproducible
+constexpr uint16_t DOS_TIME = 0;
+constexpr uint16_t DOS_DATE = (1 << 5) | 1;
+
+#ifdef HAVE_ZLIB
+// Sheet XML is highly repetitive: the fastest level is already within a
+// few percent of the default and several times quicker
+constexpr int COMPRESSION_LEVEL = Z_BEST_SPEED;
+#else
+uint32_t crc32Update(uint32_t crc, const char* data, size_t size) {
+    static const auto table = [] {
+        std::vector<uint32_t> entries(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) ? (value >> 1) ^ 0xEDB88320 : value >> 1;
+            }
+            entries[i] = value;
+        }
+        return entries;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+#endif
+
+void put16(std::string& out, uint16_t value) {
+    out += static_cast<char>(value & 0xFF);
+    out += static_cast<char>(value >> 8);
+}
+
+void put32(std::string& out, uint32_t value) {
+    put16(out, static_cast<uint16_t>(value & 0xFFFF));
+    put16(out, static_cast<uint16_t>(value >> 16));
+}
+
+void put64(std::string& out, uint64_t value) {
+    put32(out, static_cast<uint32_t>(value & MAX_32));
+    put32(out, static_cast<uint32_t>(value >> 32));
+}
+
+}
+
+ZipWriter::ZipWriter() : inEntry(false), offset(0) {
+}
+
+bool ZipWriter::open(const std::string& path) {
+    entries.clear();
+    inEntry = false;
+    offset = 0;
+    lastError.clear();
+
+    if (!sink.open(path)) {
+        return fail(sink.getLastError());
+    }
+    return true;
+}
+
+bool ZipWriter::beginEntry(const std::string& name, bool large) {
+    if (inEntry && !endEntry()) {
+        return false;
+    }
+
+    Entry entry;
+    entry.name = name;
+#ifdef HAVE_ZLIB
+    entry.method = METHOD_DEFLATED;
+#else
+    entry.method = METHOD_STORED;
+#endif
+    entry.zip64 = large;
+    entry.crc = 0;
+    entry.compressedSize = 0;
+    entry.size = 0;
+    entry.offset = offset;
+
+    // CRC and sizes are zero here and follow the data in a descriptor. The
+    // ZIP64 extra field is what tells readers that descriptor has 64-bit
+    // sizes; the 32-bit ones then say to look there.
+    std::string header;
+    put32(header, LOCAL_HEADER_SIGNATURE);
+    put16(header, large ? VERSION_ZIP64 : VERSION_DEFAULT);
+    put16(header, FLAG_DATA_DESCRIPTOR);
+    put16(header, entry.method);
+    put16(header, DOS_TIME);
+    put16(header, DOS_DATE);
+    put32(header, 0);
+    put32(header, large ? MAX_32 : 0);
+    put32(header, large ? MAX_32 : 0);
+    put16(header, static_cast<uint16_t>(name.size()));
+    put16(header, large ? 20 : 0);
+    header += name;
+    if (large) {
+        put16(header, ZIP64_EXTRA_ID);
+        put16(header, 16);
+        put64(header, 0);
+        put64(header, 0);
+    }
+
+    entries.push_back(std::move(entry));
+    inEntry = true;
+    return append(header);
+}
+
+bool ZipWriter::write(const char* data, size_t size) {
+    if (size == 0) {
+        return true;
+    }
+    piece.clear();
+    uint32_t crc = compress(data, size, piece);
+    return writeCompressed(piece.data(), piece.size(), crc, size);
+}
+
+bool ZipWriter::writeCompressed(const char* data, size_t size, uint32_t crc, uint64_t rawSize) {
+    if (!inEntry) {
+        return fail("ZIP data written outside an entry");
+    }
+
+    Entry& entry = entries.back();
+#ifdef HAVE_ZLIB
+    entry.crc = static_cast<uint32_t>(crc32_combine(entry.crc, crc, static_cast<z_off_t>(rawSize)));
+#else
+    // Stored data is the input itself
+    entry.crc = crc32Update(entry.crc, data, size);
+#endif
+    entry.compressedSize += size;
+    entry.size += rawSize;
+
+    if (!sink.append(data, size)) {
+        return fail(sink.getLastError());
+    }
+    offset += size;
+    return true;
+}
+
+bool ZipWriter::endEntry() {
+    if (!inEntry) {
+        return true;
+    }
+    inEntry = false;
+
+    Entry& entry = entries.back();
+    std::string descriptor;
+    if (entry.method == METHOD_DEFLATED) {
+        // Pieces end in sync flushes; an empty final fixed-Huffman block
+        // closes the stream
+        descriptor += '\x03';
+        descriptor += '\x00';
+        entry.compressedSize += 2;
+    }
+    put32(descriptor, DATA_DESCRIPTOR_SIGNATURE);
+    put32(descriptor, entry.crc);
+    if (entry.zip64) {
+        put64(descriptor, entry.compressedSize);
+        put64(descriptor, entry.size);
+    } else {
+        if (entry.compressedSize >= MAX_32 || entry.size >= MAX_32) {
+            return fail("ZIP entry too large: " + entry.name);
+        }
+        put32(descriptor, static_cast<uint32_t>(entry.compressedSize));
+        put32(descriptor, static_cast<uint32_t>(entry.size));
+    }
+    return append(descriptor);
+}
+
+bool ZipWriter::close() {
+    bool ok = lastError.empty() && endEntry() && writeCentralDirectory();
+    if (!sink.close() && ok) {
+        return fail(sink.getLastError());
+    }
+    return ok;
+}
+
+uint32_t ZipWriter::compress(const char* data, size_t size, std::string& out) {
+#ifdef HAVE_ZLIB
+    // One deflate state per thread, reset for each piece
+    struct Stream {
+        z_stream stream{};
+        bool ready = false;
+        ~Stream() {
+            if (ready) {
+                deflateEnd(&stream);
+            }
+        }
+    };
+    thread_local Stream state;
+
+    if (!state.ready) {
+        // Negative window bits: raw deflate, the framing is ZIP's
+        if (deflateInit2(&state.stream, COMPRESSION_LEVEL, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::bad_alloc();
+        }
+        state.ready = true;
+    } else {
+        deflateReset(&state.stream);
+    }
+
+    size_t start = out.size();
+    // A sync flush adds an empty stored block to the bound
+    out.resize(start + deflateBound(&state.stream, static_cast<uLong>(size)) + 8);
+    state.stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    state.stream.avail_in = static_cast<uInt>(size);
+    state.stream.next_out = reinterpret_cast<Bytef*>(&out[start]);
+    state.stream.avail_out = static_cast<uInt>(out.size() - start);
+    deflate(&state.stream, Z_SYNC_FLUSH);
+    out.resize(out.size() - state.stream.avail_out);
+
+    return static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(data), static_cast<uInt>(size)));
+#else
+    out.append(data, size);
+    return crc32Update(0, data, size);
+#endif
+}
+
+bool ZipWriter::append(const std::string& bytes) {
+    if (!sink.append(bytes)) {
+        return fail(sink.getLastError());
+    }
+    offset += bytes.size();
+    return true;
+}
+
+bool ZipWriter::writeCentralDirectory() {
+    uint64_t directoryOffset = offset;
+    std::string directory;
+
+    for (const auto& entry : entries) {
+        // Values that do not fit are 0xFFFFFFFF here and move to the ZIP64
+        // extra field, in this order
+        bool largeSize = entry.size >= MAX_32;
+        bool largeCompressed = entry.compressedSize >= MAX_32;
+        bool largeOffset = entry.offset >= MAX_32;
+        uint16_t extraSize = static_cast<uint16_t>(8 * (largeSize + largeCompressed + largeOffset));
+        uint16_t version = extraSize > 0 || entry.zip64 ? VERSION_ZIP64 : VERSION_DEFAULT;
+
+        put32(directory, CENTRAL_HEADER_SIGNATURE);
+        put16(directory, version);
+        put16(directory, version);
+        put16(directory, FLAG_DATA_DESCRIPTOR);
+        put16(directory, entry.method);
+        put16(directory, DOS_TIME);
+        put16(directory, DOS_DATE);
+        put32(directory, entry.crc);
+        put32(directory, largeCompressed ? MAX_32 : static_cast<uint32_t>(entry.compressedSize));
+        put32(directory, largeSize ? MAX_32 : static_cast<uint32_t>(entry.size));
+        put16(directory, static_cast<uint16_t>(entry.name.size()));
+        put16(directory, extraSize > 0 ? extraSize + 4 : 0);
+        put16(directory, 0);                        // comment
+        put16(directory, 0);                        // disk
+        put16(directory, 0);                        // internal attributes
+        put32(directory, 0);                        // external attributes
+        put32(directory, largeOffset ? MAX_32 : static_cast<uint32_t>(entry.offset));
+        directory += entry.name;
+        if (extraSize > 0) {
+            put16(directory, ZIP64_EXTRA_ID);
+            put16(directory, extraSize);
+            if (largeSize) {
+                put64(directory, entry.size);
+            }
+            if (largeCompressed) {
+                put64(directory, entry.compressedSize);
+            }
+            if (largeOffset) {
+                put64(directory, entry.offset);
+            }
+        }
+    }
+
+    uint64_t directorySize = directory.size();
+    uint64_t endOffset = directoryOffset + directorySize;
+    bool zip64 = directoryOffset >= MAX_32 || entries.size() >= 0xFFFF;
+
+    if (zip64) {
+        put32(directory, ZIP64_END_SIGNATURE);
+        put64(directory, 44);                       // size of the rest of this record
+        put16(directory, VERSION_ZIP64);
+        put16(directory, VERSION_ZIP64);
+        put32(directory, 0);
+        put32(directory, 0);
+        put64(directory, entries.size());
+        put64(directory, entries.size());
+        put64(directory, directorySize);
+        put64(directory, directoryOffset);
+
+        put32(directory, ZIP64_LOCATOR_SIGNATURE);
+        put32(directory, 0);
+        put64(directory, endOffset);
+        put32(directory, 1);
+    }
+
+    uint16_t count = zip64 ? 0xFFFF : static_cast<uint16_t>(entries.size());
+    put32(directory, END_SIGNATURE);
+    put16(directory, 0);
+    put16(directory, 0);
+    put16(directory, count);
+    put16(directory, count);
+    put32(directory, zip64 ? MAX_32 : static_cast<uint32_t>(directorySize));
+    put32(directory, zip64 ? MAX_32 : static_cast<uint32_t>(directoryOffset));
+    put16(directory, 0);
+
+    return append(directory);
+}
+
+bool ZipWriter::fail(const std::string& message) {
+    if (lastError.empty()) {
+        lastError = message;
+    }
+    return false;
+}
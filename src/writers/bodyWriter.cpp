@@ -1,14 +1,31 @@
 #include "bodyWriter.h"
-#include <fstream>
+#include "../utils/outputSink.h"
+
+namespace {
+
+bool sameTime(const WindowsTime& a, const WindowsTime& b) {
+    return a.low == b.low && a.high == b.high;
+}
+
+bool sameTimes(const StandardInformation& info, const FileNameInfo& name) {
+    return sameTime(info.atime, name.atime) && sameTime(info.mtime, name.mtime) &&
+           sameTime(info.ctime, name.ctime) && sameTime(info.crtime, name.crtime);
+}
+
+}
 
 BodyWriter::BodyWriter() {
 }
 
 bool BodyWriter::write(const std::vector<const MftRecord*>& records, const std::string& outputFile) {
-    std::ofstream file(outputFile);
-    if (!file.is_open()) {
+    OutputSink sink;
+    sink.setCompression(compression);
+    sink.setDigest(digest);
+    sink.setCancellation(cancellation);
+    if (!sink.open(outputFile)) {
         return false;
     }
+    std::ostream file(&sink);
     
     try {
         for (const auto* record : records) {
@@ -16,7 +33,7 @@ bool BodyWriter::write(const std::vector<const MftRecord*>& records, const std::
                 return false;
             }
         }
-        return true;
+        return sink.close();
     } catch (const std::exception& e) {
         return false;
     }
@@ -25,40 +42,49 @@ bool BodyWriter::write(const std::vector<const MftRecord*>& records, const std::
 bool BodyWriter::writeRecord(std::ostream& stream, const MftRecord* record) {
     if (!record) return false;
     
-    writeTimeEntry(stream, record, record->fnTimes.mtime, 'M');
-    writeTimeEntry(stream, record, record->fnTimes.atime, 'A');
-    writeTimeEntry(stream, record, record->fnTimes.ctime, 'C');
-    writeTimeEntry(stream, record, record->fnTimes.crtime, 'B');
+    const FileNameInfo* name = record->fileName();
+    if (!name) return stream.good();
+    
+    const StandardInformation& info = record->standardInformation();
+    if (info.present) {
+        stream << formatBodyEntry(record, name->name, name->realSize, info.atime, info.mtime, info.ctime, info.crtime)
+               << "\n";
+        if (collapse == MacbCollapse::All && sameTimes(info, *name)) {
+            return stream.good();
+        }
+    }
+    stream << formatBodyEntry(record, name->name + " ($FILE_NAME)", name->realSize,
+                              name->atime, name->mtime, name->ctime, name->crtime) << "\n";
     
     return stream.good();
 }
 
-void BodyWriter::writeTimeEntry(std::ostream& stream, const MftRecord* record, const WindowsTime& time, char macb) {
-    if (!time.isValid()) return;
+std::string BodyWriter::formatBodyEntry(const MftRecord* record, const std::string& name, uint64_t size,
+                                        const WindowsTime& atime, const WindowsTime& mtime,
+                                        const WindowsTime& ctime, const WindowsTime& crtime) const {
+    // Unset times are 0, which mactime ignores
+    auto unixTime = [](const WindowsTime& time) {
+        return std::to_string(time.isValid() ? time.getUnixTime() : 0);
+    };
     
-    std::string entry = formatBodyEntry(record, time, macb);
-    stream << entry << "\n";
-}
-
-std::string BodyWriter::formatBodyEntry(const MftRecord* record, const WindowsTime& time, char macb) const {
     std::string entry;
     entry += record->md5.empty() ? "0" : record->md5;
     entry += "|";
-    entry += record->filename;
+    entry += name;
     entry += "|";
     entry += std::to_string(record->recordnum);
     entry += "|";
     entry += std::to_string(record->flags);
     entry += "|0|0|";
-    entry += std::to_string(record->filesize);
+    entry += std::to_string(size);
     entry += "|";
-    entry += std::to_string(time.getUnixTime());
+    entry += unixTime(atime);
     entry += "|";
-    entry += std::to_string(time.getUnixTime());
+    entry += unixTime(mtime);
     entry += "|";
-    entry += std::to_string(time.getUnixTime());
+    entry += unixTime(ctime);
     entry += "|";
-    entry += std::to_string(time.getUnixTime());
+    entry += unixTime(crtime);
     
     return entry;
-}
\ No newline at end of file
+}
@@ -1,18 +1,21 @@
 #include "csvWriter.h"
-#include "../core/constants.h"
+#include "../core/columnSchema.h"
 #include "../utils/stringUtils.h"
-#include <fstream>
-#include <iostream>
+#include "../utils/outputSink.h"
 
 CsvWriter::CsvWriter(char delimiter, bool includeHeader) 
     : delimiter(delimiter), includeHeader(includeHeader) {
 }
 
 bool CsvWriter::write(const std::vector<const MftRecord*>& records, const std::string& outputFile) {
-    std::ofstream file(outputFile);
-    if (!file.is_open()) {
+    OutputSink sink;
+    sink.setCompression(compression);
+    sink.setDigest(digest);
+    sink.setCancellation(cancellation);
+    if (!sink.open(outputFile)) {
         return false;
     }
+    std::ostream file(&sink);
     
     try {
         if (includeHeader) {
@@ -21,64 +24,67 @@ bool CsvWriter::write(const std::vector<const MftRecord*>& records, const std::s
             }
         }
         
-        for (const auto* record : records) {
-            if (!writeRecord(file, record)) {
-                return false;
-            }
+        if (!writeRecords(file, records)) {
+            return false;
         }
         
-        return true;
+        return sink.close();
     } catch (const std::exception& e) {
         return false;
     }
 }
 
 bool CsvWriter::writeHeader(std::ostream& stream) {
-    for (size_t i = 0; i < CSV_HEADER.size(); ++i) {
-        writeField(stream, CSV_HEADER[i], i == CSV_HEADER.size() - 1);
-    }
-    stream << "\n";
+    line.clear();
+    appendHeader(line);
+    stream.write(line.data(), static_cast<std::streamsize>(line.size()));
     return stream.good();
 }
 
 bool CsvWriter::writeRecord(std::ostream& stream, const MftRecord* record) {
     if (!record) return false;
     
-    std::vector<std::string> csvRow = record->toCsv();
-    
-    for (size_t i = 0; i < csvRow.size(); ++i) {
-        writeField(stream, csvRow[i], i == csvRow.size() - 1);
-    }
-    stream << "\n";
-    
+    line.clear();
+    appendRecord(line, record);
+    stream.write(line.data(), static_cast<std::streamsize>(line.size()));
     return stream.good();
 }
 
-void CsvWriter::writeField(std::ostream& stream, const std::string& field, bool isLast) {
-    stream << escapeCsvField(field);
-    if (!isLast) {
-        stream << delimiter;
-    }
+std::unique_ptr<FileWriter> CsvWriter::chunkWriter(size_t) const {
+    return std::make_unique<CsvWriter>(*this);
 }
 
-std::string CsvWriter::escapeCsvField(const std::string& field) const {
-    if (field.find(delimiter) == std::string::npos && 
-        field.find('"') == std::string::npos && 
-        field.find('\n') == std::string::npos &&
-        field.find('\r') == std::string::npos) {
-        return field;
-    }
-    
-    std::string escaped = "\"";
-    for (char c : field) {
-        if (c == '"') {
-            escaped += "\"\"";
+void CsvWriter::appendHeader(std::string& out) const {
+    forEachColumn(selectedColumns, [&](const ColumnDescriptor& column) {
+        std::string_view header = column.header;
+        if (header.find(delimiter) == std::string_view::npos) {
+            out += header;
         } else {
-            escaped += c;
+            appendQuoted(out, header);
         }
+        out += delimiter;
+    });
+    out.back() = '\n';
+}
+
+void CsvWriter::appendRecord(std::string& out, const MftRecord* record) const {
+    char digits[20];
+    forEachColumn(selectedColumns, [&](const ColumnDescriptor& column) {
+        appendQuoted(out, columnText(column.type, column.get(*record), digits));
+        out += delimiter;
+    });
+    out.back() = '\n';
+}
+
+void CsvWriter::appendQuoted(std::string& out, std::string_view field) const {
+    out += '"';
+    for (size_t quote = field.find('"'); quote != std::string_view::npos; quote = field.find('"')) {
+        out.append(field.data(), quote + 1);
+        out += '"';
+        field.remove_prefix(quote + 1);
     }
-    escaped += "\"";
-    return escaped;
+    out += field;
+    out += '"';
 }
 
 void CsvWriter::setDelimiter(char delimiter) {
@@ -1,68 +1,446 @@
 #include "excelWriter.h"
-#include "../core/constants.h"
-#include <fstream>
+#include "parallelSerializer.h"
+#include "../core/columnSchema.h"
+#include <algorithm>
+#include <charconv>
+#include <unordered_map>
 
-struct ExcelWriter::ExcelImpl {
-    
-    //TO DO: REVIEW libxlsxwriter API
+namespace {
+
+const char* const XML_DECLARATION = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+const char* const SPREADSHEET_NS = "http://schemas.openxmlformats.org/spreadsheetml/2006/main";
+const char* const RELATIONSHIPS_NS = "http://schemas.openxmlformats.org/officeDocument/2006/relationships";
 
-    std::string outputFile;
-    bool initialized = false;
+// Longest text a cell holds
+constexpr size_t MAX_CELL_TEXT = 32767;
+
+// Values of the enumerated columns, shared after the column headers
+const char* const SHARED_VALUES[] = {
+    "Valid", "Invalid", "In Use", "Not in Use",
+    "Directory", "Extension", "Special Index", "File",
+    "True", "False", "Present"
 };
 
-ExcelWriter::ExcelWriter() : impl(std::make_unique<ExcelImpl>()) {
+const std::unordered_map<std::string_view, uint32_t>& sharedStringIndex() {
+    static const std::unordered_map<std::string_view, uint32_t> index = [] {
+        std::unordered_map<std::string_view, uint32_t> strings;
+        uint32_t next = static_cast<uint32_t>(COLUMNS.size());
+        for (const char* value : SHARED_VALUES) {
+            strings.emplace(value, next++);
+        }
+        return strings;
+    }();
+    return index;
+}
+
+template <size_t N>
+inline void appendLiteral(std::string& out, const char (&text)[N]) {
+    out.append(text, N - 1);
+}
+
+inline void appendNumber(std::string& out, uint64_t value) {
+    char digits[20];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+inline bool needsEscape(char c) {
+    return c == '&' || c == '<' || c == '>' || c == '_' || static_cast<unsigned char>(c) < 0x20;
+}
+
+// Cell text, XML-escaped. Characters XML cannot carry are written the way
+// Excel does, as _xHHHH_, which means a literal "_x" must be escaped too.
+void appendCellText(std::string& out, std::string_view text) {
+    size_t length = text.size();
+    if (length > MAX_CELL_TEXT) {
+        length = MAX_CELL_TEXT;
+        while (length > 0 && (static_cast<unsigned char>(text[length]) & 0xC0) == 0x80) {
+            --length;
+        }
+    }
+    
+    bool padded = length > 0 && (static_cast<unsigned char>(text[0]) <= ' ' ||
+                                 static_cast<unsigned char>(text[length - 1]) <= ' ');
+    if (padded) {
+        appendLiteral(out, "<t xml:space=\"preserve\">");
+    } else {
+        appendLiteral(out, "<t>");
+    }
+    
+    const char* data = text.data();
+    size_t start = 0;
+    for (size_t i = 0; i < length; ++i) {
+        char c = data[i];
+        if (!needsEscape(c)) {
+            continue;
+        }
+        if (c == '_' && (i + 1 >= length || data[i + 1] != 'x')) {
+            continue;
+        }
+        out.append(data + start, i - start);
+        start = i + 1;
+        switch (c) {
+            case '&': appendLiteral(out, "&amp;"); break;
+            case '<': appendLiteral(out, "&lt;"); break;
+            case '>': appendLiteral(out, "&gt;"); break;
+            case '\t': out += '\t'; break;
+            case '\n': out += '\n'; break;
+            default: {
+                static const char hex[] = "0123456789ABCDEF";
+                unsigned char value = static_cast<unsigned char>(c);
+                appendLiteral(out, "_x00");
+                out += hex[value >> 4];
+                out += hex[value & 0x0F];
+                out += '_';
+                break;
+            }
+        }
+    }
+    out.append(data + start, length - start);
+    appendLiteral(out, "</t>");
+}
+
+// "A", "B", ... "Z", "AA", ...
+std::string columnName(size_t index) {
+    std::string name;
+    for (size_t n = index + 1; n > 0; n = (n - 1) / 26) {
+        name.insert(name.begin(), static_cast<char>('A' + (n - 1) % 26));
+    }
+    return name;
+}
+
+bool isSharedColumn(size_t column) {
+    ColumnType type = COLUMNS[column].type;
+    return type == ColumnType::Flag || type == ColumnType::Presence ||
+           column == CSV_RECORD_STATUS || column == CSV_RECORD_TYPE || column == CSV_FILE_TYPE;
+}
+
+// Display width, in characters, for the long columns
+double columnWidth(size_t column) {
+    if (column == CSV_FILENAME) return 32;
+    if (column == CSV_FILEPATH) return 64;
+    if (column >= CSV_SI_CREATION_TIME && column <= CSV_FN_ENTRY_TIME) return 28;
+    return 0;
+}
+
+}
+
+ExcelWriter::ExcelWriter()
+    : nextRow(2), sheetCount(0), sheetRecords(0), recordCount(0), sheetOpen(false) {
 }
 
 ExcelWriter::~ExcelWriter() = default;
 
 bool ExcelWriter::write(const std::vector<const MftRecord*>& records, const std::string& outputFile) {
-    impl->outputFile = outputFile;
+    return open(outputFile) && writeBatch(records) && close();
+}
+
+bool ExcelWriter::open(const std::string& outputFile) {
+    try {
+        prepareColumns();
+        sheetCount = 0;
+        sheetRecords = 0;
+        recordCount = 0;
+        sheetOpen = false;
     
-    if (!initializeWorkbook()) {
+        zip.setDigest(digest);
+        if (!zip.open(outputFile)) {
+            zip.close();
+            return false;
+        }
+        return true;
+    } catch (const std::exception& e) {
+        zip.close();
         return false;
     }
-    
-    if (!writeExcelHeader()) {
+}
+
+bool ExcelWriter::writeBatch(const std::vector<const MftRecord*>& records) {
+    if (std::find(records.begin(), records.end(), nullptr) != records.end()) {
         return false;
     }
     
-    int row = 1;
-    for (const auto* record : records) {
-        if (!writeExcelRecord(record, row++)) {
-            return false;
+    try {
+        for (size_t first = 0; first < records.size();) {
+            if (!sheetOpen && !beginSheet()) {
+                return false;
+            }
+            size_t count = std::min(MAX_SHEET_ROWS - 1 - sheetRecords, records.size() - first);
+            if (!writeRows(records.data() + first, count)) {
+                return false;
+            }
+            first += count;
+            if (sheetRecords == MAX_SHEET_ROWS - 1 && !endSheet()) {
+                return false;
+            }
         }
+        return true;
+    } catch (const std::exception& e) {
+        return false;
     }
-    
-    return finalizeWorkbook();
 }
 
-bool ExcelWriter::writeRecord(std::ostream& stream, const MftRecord* record) {
-    return true;
+bool ExcelWriter::close() {
+    try {
+        // A workbook has at least one sheet, if only the header row
+        bool ok = (sheetOpen || sheetCount > 0 || beginSheet()) &&
+                  (!sheetOpen || endSheet()) &&
+                  writePackageParts();
+        return zip.close() && ok;
+    } catch (const std::exception& e) {
+        zip.close();
+        return false;
+    }
 }
 
-bool ExcelWriter::initializeWorkbook() {
-    impl->initialized = true;
-    return true;
+bool ExcelWriter::writeRecord(std::ostream& stream, const MftRecord* record) {
+    if (!record) return false;
+    
+    std::string row;
+    appendRow(row, record, nextRow++);
+    stream.write(row.data(), static_cast<std::streamsize>(row.size()));
+    return stream.good();
 }
 
-bool ExcelWriter::writeExcelHeader() {
-    return true;
+void ExcelWriter::prepareColumns() {
+    columns = selectedColumns;
+    if (columns.empty()) {
+        for (size_t column = 0; column < CSV_COLUMN_COUNT; ++column) {
+            columns.push_back(column);
+        }
+    }
+    
+    cellPrefixes.clear();
+    cellKinds.clear();
+    for (size_t i = 0; i < columns.size(); ++i) {
+        size_t column = columns[i];
+        cellPrefixes.push_back("<c r=\"" + columnName(i));
+        if (COLUMNS[column].type == ColumnType::Number) {
+            cellKinds.push_back(CellKind::Number);
+        } else if (isSharedColumn(column)) {
+            cellKinds.push_back(CellKind::Shared);
+        } else {
+            cellKinds.push_back(CellKind::Text);
+        }
+    }
+    nextRow = 2;
 }
 
-bool ExcelWriter::writeExcelRecord(const MftRecord* record, int row) {
-    return true;
+bool ExcelWriter::writePackageParts() {
+    std::string xml = XML_DECLARATION;
+    xml += "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+           "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+           "<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+           "<Override PartName=\"/xl/workbook.xml\" "
+           "ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+           "<Override PartName=\"/xl/styles.xml\" "
+           "ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>"
+           "<Override PartName=\"/xl/sharedStrings.xml\" "
+           "ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml\"/>";
+    for (size_t sheet = 0; sheet < sheetCount; ++sheet) {
+        xml += "<Override PartName=\"/xl/worksheets/sheet" + std::to_string(sheet + 1) + ".xml\" "
+               "ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>";
+    }
+    xml += "</Types>";
+    if (!zip.beginEntry("[Content_Types].xml") || !zip.write(xml)) {
+        return false;
+    }
+    
+    xml = XML_DECLARATION;
+    xml += "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+           "<Relationship Id=\"rId1\" Type=\"" + std::string(RELATIONSHIPS_NS) + "/officeDocument\" "
+           "Target=\"xl/workbook.xml\"/></Relationships>";
+    if (!zip.beginEntry("_rels/.rels") || !zip.write(xml)) {
+        return false;
+    }
+    
+    // Every sheet but the last is full
+    const size_t fullSheet = MAX_SHEET_ROWS - 1;
+    const std::string lastColumn = columnName(columns.size() - 1);
+    xml = XML_DECLARATION;
+    xml += "<workbook xmlns=\"" + std::string(SPREADSHEET_NS) + "\" xmlns:r=\"" + RELATIONSHIPS_NS + "\"><sheets>";
+    for (size_t sheet = 0; sheet < sheetCount; ++sheet) {
+        xml += "<sheet name=\"" + sheetName(sheet) + "\" sheetId=\"" + std::to_string(sheet + 1) +
+               "\" r:id=\"rId" + std::to_string(sheet + 1) + "\"/>";
+    }
+    xml += "</sheets><definedNames>";
+    for (size_t sheet = 0; sheet < sheetCount; ++sheet) {
+        size_t rows = 1 + std::min(fullSheet, recordCount - std::min(sheet * fullSheet, recordCount));
+        xml += "<definedName name=\"_xlnm._FilterDatabase\" localSheetId=\"" + std::to_string(sheet) +
+               "\" hidden=\"1\">'" + sheetName(sheet) + "'!$A$1:$" + lastColumn + "$" + std::to_string(rows) +
+               "</definedName>";
+    }
+    xml += "</definedNames></workbook>";
+    if (!zip.beginEntry("xl/workbook.xml") || !zip.write(xml)) {
+        return false;
+    }
+    
+    xml = XML_DECLARATION;
+    xml += "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">";
+    for (size_t sheet = 0; sheet < sheetCount; ++sheet) {
+        xml += "<Relationship Id=\"rId" + std::to_string(sheet + 1) + "\" Type=\"" + RELATIONSHIPS_NS +
+               "/worksheet\" Target=\"worksheets/sheet" + std::to_string(sheet + 1) + ".xml\"/>";
+    }
+    xml += "<Relationship Id=\"rId" + std::to_string(sheetCount + 1) + "\" Type=\"" + RELATIONSHIPS_NS +
+           "/styles\" Target=\"styles.xml\"/>";
+    xml += "<Relationship Id=\"rId" + std::to_string(sheetCount + 2) + "\" Type=\"" + RELATIONSHIPS_NS +
+           "/sharedStrings\" Target=\"sharedStrings.xml\"/>";
+    xml += "</Relationships>";
+    if (!zip.beginEntry("xl/_rels/workbook.xml.rels") || !zip.write(xml)) {
+        return false;
+    }
+    
+    // Style 1 is the bold header
+    xml = XML_DECLARATION;
+    xml += "<styleSheet xmlns=\"" + std::string(SPREADSHEET_NS) + "\">"
+           "<fonts count=\"2\"><font><sz val=\"11\"/><name val=\"Calibri\"/></font>"
+           "<font><b/><sz val=\"11\"/><name val=\"Calibri\"/></font></fonts>"
+           "<fills count=\"2\"><fill><patternFill patternType=\"none\"/></fill>"
+           "<fill><patternFill patternType=\"gray125\"/></fill></fills>"
+           "<borders count=\"1\"><border><left/><right/><top/><bottom/><diagonal/></border></borders>"
+           "<cellStyleXfs count=\"1\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\"/></cellStyleXfs>"
+           "<cellXfs count=\"2\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\"/>"
+           "<xf numFmtId=\"0\" fontId=\"1\" fillId=\"0\" borderId=\"0\" xfId=\"0\" applyFont=\"1\"/></cellXfs>"
+           "<cellStyles count=\"1\"><cellStyle name=\"Normal\" xfId=\"0\" builtinId=\"0\"/></cellStyles>"
+           "</styleSheet>";
+    if (!zip.beginEntry("xl/styles.xml") || !zip.write(xml)) {
+        return false;
+    }
+    
+    size_t sharedCount = COLUMNS.size() + sizeof(SHARED_VALUES) / sizeof(SHARED_VALUES[0]);
+    xml = XML_DECLARATION;
+    xml += "<sst xmlns=\"" + std::string(SPREADSHEET_NS) + "\" uniqueCount=\"" + std::to_string(sharedCount) + "\">";
+    for (const auto& column : COLUMNS) {
+        xml += "<si>";
+        appendCellText(xml, column.header);
+        xml += "</si>";
+    }
+    for (const char* value : SHARED_VALUES) {
+        xml += "<si>";
+        appendCellText(xml, value);
+        xml += "</si>";
+    }
+    xml += "</sst>";
+    return zip.beginEntry("xl/sharedStrings.xml") && zip.write(xml);
 }
 
-bool ExcelWriter::finalizeWorkbook() {
-    if (!impl->initialized) {
+bool ExcelWriter::beginSheet() {
+    if (!zip.beginEntry("xl/worksheets/sheet" + std::to_string(sheetCount + 1) + ".xml", true)) {
         return false;
     }
+    sheetCount++;
+    sheetRecords = 0;
+    sheetOpen = true;
     
-    std::ofstream file(impl->outputFile);
-    if (!file.is_open()) {
-        return false;
+    std::string xml = XML_DECLARATION;
+    xml += "<worksheet xmlns=\"" + std::string(SPREADSHEET_NS) + "\" xmlns:r=\"" + RELATIONSHIPS_NS + "\">"
+           "<sheetViews><sheetView workbookViewId=\"0\">"
+           "<pane ySplit=\"1\" topLeftCell=\"A2\" activePane=\"bottomLeft\" state=\"frozen\"/>"
+           "</sheetView></sheetViews>";
+    std::string widths;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (double width = columnWidth(columns[i])) {
+            widths += "<col min=\"" + std::to_string(i + 1) + "\" max=\"" + std::to_string(i + 1) +
+                      "\" width=\"" + std::to_string(static_cast<int>(width)) + "\" customWidth=\"1\"/>";
+        }
+    }
+    if (!widths.empty()) {
+        xml += "<cols>" + widths + "</cols>";
     }
     
-    file << "Excel export not fully implemented. Use CSV format instead." << std::endl;
+    xml += "<sheetData><row r=\"1\">";
+    for (size_t i = 0; i < columns.size(); ++i) {
+        xml += cellPrefixes[i] + "1\" t=\"s\" s=\"1\"><v>" + std::to_string(columns[i]) + "</v></c>";
+    }
+    xml += "</row>";
+    return zip.write(xml);
+}
+
+// Appends `count` records to the open sheet, which has room for them
+bool ExcelWriter::writeRows(const MftRecord* const* records, size_t count) {
+    // Chunks are deflated on the worker threads; the CRC and input size of
+    // each are needed, in order, when it is appended
+    struct Piece {
+        uint32_t crc = 0;
+        size_t size = 0;
+    };
+    const size_t chunkRows = ParallelSerializer::DEFAULT_CHUNK_RECORDS;
+    std::vector<Piece> pieces((count + chunkRows - 1) / chunkRows);
+    size_t nextPiece = 0;
+    size_t firstRow = sheetRecords + 2;
+    
+    ParallelSerializer serializer(threads, chunkRows);
+    bool ok = serializer.write(count, [&](std::string& out, size_t begin, size_t end) {
+        thread_local std::string rows;
+        rows.clear();
+        for (size_t i = begin; i < end; ++i) {
+            appendRow(rows, records[i], firstRow + i);
+        }
+        Piece& piece = pieces[begin / chunkRows];
+        piece.crc = ZipWriter::compress(rows.data(), rows.size(), out);
+        piece.size = rows.size();
+        return true;
+    }, [&](const std::string& compressed) {
+        const Piece& piece = pieces[nextPiece++];
+        return zip.writeCompressed(compressed.data(), compressed.size(), piece.crc, piece.size);
+    });
+    if (!ok) {
+        return false;
+    }
+    sheetRecords += count;
+    recordCount += count;
     return true;
-}
\ No newline at end of file
+}
+
+bool ExcelWriter::endSheet() {
+    sheetOpen = false;
+    std::string xml = "</sheetData><autoFilter ref=\"A1:" + columnName(columns.size() - 1) +
+                      std::to_string(sheetRecords + 1) + "\"/></worksheet>";
+    return zip.write(xml) && zip.endEntry();
+}
+
+void ExcelWriter::appendRow(std::string& out, const MftRecord* record, size_t row) const {
+    const auto& shared = sharedStringIndex();
+    char digits[20];
+    auto result = std::to_chars(digits, digits + sizeof(digits), row);
+    size_t rowLength = static_cast<size_t>(result.ptr - digits);
+    
+    appendLiteral(out, "<row r=\"");
+    out.append(digits, rowLength);
+    appendLiteral(out, "\">");
+    
+    char text[20];
+    for (size_t i = 0; i < columns.size(); ++i) {
+        const ColumnDescriptor& column = COLUMNS[columns[i]];
+        std::string_view value = columnText(column.type, column.get(*record), text);
+        if (value.empty()) {
+            continue;
+        }
+    
+        out += cellPrefixes[i];
+        out.append(digits, rowLength);
+        if (cellKinds[i] == CellKind::Number) {
+            appendLiteral(out, "\"><v>");
+            out += value;
+            appendLiteral(out, "</v></c>");
+            continue;
+        }
+        if (cellKinds[i] == CellKind::Shared) {
+            auto found = shared.find(value);
+            if (found != shared.end()) {
+                appendLiteral(out, "\" t=\"s\"><v>");
+                appendNumber(out, found->second);
+                appendLiteral(out, "</v></c>");
+                continue;
+            }
+        }
+        appendLiteral(out, "\" t=\"inlineStr\"><is>");
+        appendCellText(out, value);
+        appendLiteral(out, "</is></c>");
+    }
+    appendLiteral(out, "</row>");
+}
+
+std::string ExcelWriter::sheetName(size_t sheet) {
+    return sheet == 0 ? "MFT" : "MFT (" + std::to_string(sheet + 1) + ")";
+}
@@ -1,5 +1,7 @@
 #include "fileWriter.h"
+#include "parallelSerializer.h"
 #include <algorithm>
+#include <sstream>
 
 std::string FileWriter::escapeString(const std::string& str, const std::string& chars) const {
     std::string escaped = str;
@@ -15,6 +17,35 @@ std::string FileWriter::escapeString(const std::string& str, const std::string&
     return escaped;
 }
 
+bool FileWriter::isColumnSelected(size_t column) const {
+    return selectedColumns.empty() ||
+           std::find(selectedColumns.begin(), selectedColumns.end(), column) != selectedColumns.end();
+}
+
 std::string FileWriter::formatTimestamp(const WindowsTime& time) const {
     return time.getDateTimeString();
-}
\ No newline at end of file
+}
+
+bool FileWriter::writeRecords(std::ostream& stream, const std::vector<const MftRecord*>& records) {
+    if (threads <= 1 || !chunkWriter(0)) {
+        for (const auto* record : records) {
+            if (!writeRecord(stream, record)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    ParallelSerializer serializer(threads);
+    return serializer.write(stream, records.size(), [&](std::string& out, size_t begin, size_t end) {
+        std::unique_ptr<FileWriter> writer = chunkWriter(begin);
+        std::ostringstream chunk;
+        for (size_t i = begin; i < end; ++i) {
+            if (!writer->writeRecord(chunk, records[i])) {
+                return false;
+            }
+        }
+        out += chunk.str();
+        return true;
+    });
+}
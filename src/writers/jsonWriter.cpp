@@ -1,17 +1,21 @@
 #include "jsonWriter.h"
+#include "../core/columnSchema.h"
 #include "../utils/stringUtils.h"
-#include <fstream>
-#include <iomanip>
+#include "../utils/outputSink.h"
 
 JsonWriter::JsonWriter(bool prettyPrint) 
     : prettyPrint(prettyPrint), indentLevel(0), firstRecord(true) {
 }
 
 bool JsonWriter::write(const std::vector<const MftRecord*>& records, const std::string& outputFile) {
-    std::ofstream file(outputFile);
-    if (!file.is_open()) {
+    OutputSink sink;
+    sink.setCompression(compression);
+    sink.setDigest(digest);
+    sink.setCancellation(cancellation);
+    if (!sink.open(outputFile)) {
         return false;
     }
+    std::ostream file(&sink);
     
     try {
         firstRecord = true;
@@ -21,17 +25,15 @@ bool JsonWriter::write(const std::vector<const MftRecord*>& records, const std::
             return false;
         }
         
-        for (const auto* record : records) {
-            if (!writeRecord(file, record)) {
-                return false;
-            }
+        if (!writeRecords(file, records)) {
+            return false;
         }
         
         if (!writeFooter(file)) {
             return false;
         }
         
-        return true;
+        return sink.close();
     } catch (const std::exception& e) {
         return false;
     }
@@ -65,6 +67,13 @@ bool JsonWriter::writeRecord(std::ostream& stream, const MftRecord* record) {
     return stream.good();
 }
 
+std::unique_ptr<FileWriter> JsonWriter::chunkWriter(size_t firstIndex) const {
+    // Only the record separator depends on what came before
+    auto writer = std::make_unique<JsonWriter>(*this);
+    writer->firstRecord = firstIndex == 0;
+    return writer;
+}
+
 bool JsonWriter::writeFooter(std::ostream& stream) {
     if (prettyPrint) {
         stream << "\n";
@@ -76,91 +85,35 @@ bool JsonWriter::writeFooter(std::ostream& stream) {
 }
 
 void JsonWriter::writeJsonObject(std::ostream& stream, const MftRecord* record) {
-    stream << "{";
+    object.clear();
+    object += '{';
     if (prettyPrint) {
-        stream << "\n";
+        object += '\n';
         indentLevel++;
     }
     
-    bool first = true;
-    auto writeField = [&](const std::string& key, const std::string& value) {
-        if (!first) {
-            stream << ",";
-            if (prettyPrint) stream << "\n";
-        }
-        first = false;
-        
+    std::string indent = getIndent();
+    char digits[20];
+    forEachColumn(selectedColumns, [&](const ColumnDescriptor& column) {
         if (prettyPrint) {
-            stream << getIndent();
+            object += indent;
         }
-        writeJsonField(stream, key, value);
-    };
-    
-    writeField("recordNumber", std::to_string(record->recordnum));
-    writeField("filename", record->filename);
-    writeField("filesize", std::to_string(record->filesize));
-    writeField("sequenceNumber", std::to_string(record->seq));
-    writeField("parentRecordNumber", std::to_string(record->getParentRecordNum()));
-    writeField("flags", std::to_string(record->flags));
-    writeField("fileType", record->getFileType());
-    
-    writeField("siCreationTime", record->siTimes.crtime.getDateTimeString());
-    writeField("siModificationTime", record->siTimes.mtime.getDateTimeString());
-    writeField("siAccessTime", record->siTimes.atime.getDateTimeString());
-    writeField("siEntryTime", record->siTimes.ctime.getDateTimeString());
-    
-    writeField("fnCreationTime", record->fnTimes.crtime.getDateTimeString());
-    writeField("fnModificationTime", record->fnTimes.mtime.getDateTimeString());
-    writeField("fnAccessTime", record->fnTimes.atime.getDateTimeString());
-    writeField("fnEntryTime", record->fnTimes.ctime.getDateTimeString());
-    
-    if (!record->objectId.empty()) {
-        writeField("objectId", record->objectId);
-        writeField("birthVolumeId", record->birthVolumeId);
-        writeField("birthObjectId", record->birthObjectId);
-        writeField("birthDomainId", record->birthDomainId);
-    }
-    
-    if (!record->md5.empty()) {
-        writeField("md5", record->md5);
-        writeField("sha256", record->sha256);
-        writeField("sha512", record->sha512);
-        writeField("crc32", record->crc32, true);
-    }
+        object += '"';
+        object += column.key;
+        object += "\": \"";
+        std::string_view value = columnText(column.type, column.get(*record), digits);
+        StringUtils::appendJsonEscaped(object, value.data(), value.size());
+        object += prettyPrint ? "\",\n" : "\",";
+    });
+    // The last field takes no comma
+    object.erase(object.size() - (prettyPrint ? 2 : 1), 1);
     
     if (prettyPrint) {
-        stream << "\n";
         indentLevel--;
-        stream << getIndent();
-    }
-    stream << "}";
-}
-
-void JsonWriter::writeJsonField(std::ostream& stream, const std::string& key, const std::string& value, bool isLast) {
-    stream << "\"" << escapeJsonString(key) << "\": \"" << escapeJsonString(value) << "\"";
-}
-
-std::string JsonWriter::escapeJsonString(const std::string& str) const {
-    std::string escaped;
-    for (char c : str) {
-        switch (c) {
-            case '"': escaped += "\\\""; break;
-            case '\\': escaped += "\\\\"; break;
-            case '\b': escaped += "\\b"; break;
-            case '\f': escaped += "\\f"; break;
-            case '\n': escaped += "\\n"; break;
-            case '\r': escaped += "\\r"; break;
-            case '\t': escaped += "\\t"; break;
-            default:
-                if (c < 32) {
-                    escaped += "\\u" + StringUtils::toUpper(std::to_string(static_cast<int>(c)));
-                } else {
-                    escaped += c;
-                }
-                break;
-        }
+        object += getIndent();
     }
-    return escaped;
+    object += '}';
+    stream.write(object.data(), static_cast<std::streamsize>(object.size()));
 }
 
 std::string JsonWriter::getIndent() const {
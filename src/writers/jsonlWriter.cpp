@@ -0,0 +1,108 @@
+#include "jsonlWriter.h"
+#include "../core/columnSchema.h"
+#include "../utils/stringUtils.h"
+#include "../utils/outputSink.h"
+#include <array>
+#include <charconv>
+
+namespace {
+
+template <size_t N>
+inline void appendLiteral(std::string& out, const char (&text)[N]) {
+    out.append(text, N - 1);
+}
+
+inline void appendNumber(std::string& out, uint64_t value) {
+    char digits[20];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+inline void appendString(std::string& out, std::string_view value) {
+    StringUtils::appendJsonEscaped(out, value.data(), value.size());
+    out += '"';
+}
+
+// Timestamps are digits and punctuation only, nothing to escape
+inline void appendTime(std::string& out, const WindowsTime& time) {
+    out += time.getDateTimeString();
+    out += '"';
+}
+
+// What goes before each column's value: ,"key": for numbers and ,"key":"
+// for the rest, built once rather than per record
+const std::array<std::string, CSV_COLUMN_COUNT>& keyPrefixes() {
+    static const std::array<std::string, CSV_COLUMN_COUNT> prefixes = [] {
+        std::array<std::string, CSV_COLUMN_COUNT> table;
+        for (const auto& column : COLUMNS) {
+            table[column.id] = std::string(",\"") + column.key +
+                               (column.type == ColumnType::Number ? "\":" : "\":\"");
+        }
+        return table;
+    }();
+    return prefixes;
+}
+
+}
+
+JsonlWriter::JsonlWriter() {
+}
+
+bool JsonlWriter::write(const std::vector<const MftRecord*>& records, const std::string& outputFile) {
+    OutputSink sink;
+    sink.setCompression(compression);
+    sink.setDigest(digest);
+    sink.setCancellation(cancellation);
+    if (!sink.open(outputFile)) {
+        return false;
+    }
+    std::ostream file(&sink);
+    
+    try {
+        if (!writeRecords(file, records)) {
+            return false;
+        }
+        
+        return sink.close();
+    } catch (const std::exception& e) {
+        return false;
+    }
+}
+
+bool JsonlWriter::writeRecord(std::ostream& stream, const MftRecord* record) {
+    if (!record) return false;
+    
+    line.clear();
+    appendRecord(line, record);
+    
+    stream.write(line.data(), static_cast<std::streamsize>(line.size()));
+    return stream.good();
+}
+
+std::unique_ptr<FileWriter> JsonlWriter::chunkWriter(size_t) const {
+    // Lines are independent, so any copy can format any chunk
+    return std::make_unique<JsonlWriter>(*this);
+}
+
+void JsonlWriter::appendRecord(std::string& out, const MftRecord* record) const {
+    const auto& prefixes = keyPrefixes();
+    size_t start = out.size();
+    char digits[20];
+    forEachColumn(selectedColumns, [&](const ColumnDescriptor& column) {
+        out += prefixes[column.id];
+        ColumnValue value = column.get(*record);
+        switch (column.type) {
+            case ColumnType::Number:
+                appendNumber(out, value.number);
+                break;
+            case ColumnType::Time:
+                appendTime(out, *value.time);
+                break;
+            default:
+                appendString(out, columnText(column.type, value, digits));
+                break;
+        }
+    });
+    out[start] = '{';
+    appendLiteral(out, "}\n");
+}
@@ -0,0 +1,126 @@
+#include "parallelSerializer.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+ParallelSerializer::ParallelSerializer(unsigned threads, size_t chunkRecords)
+    : threads(threads > 0 ? threads : 1), chunkRecords(chunkRecords > 0 ? chunkRecords : DEFAULT_CHUNK_RECORDS) {
+}
+
+bool ParallelSerializer::write(std::ostream& stream, size_t count, const FormatRange& format) {
+    bool ok = write(count, format, [&](const std::string& text) {
+        stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+        return stream.good();
+    });
+    return ok && stream.good();
+}
+
+bool ParallelSerializer::write(size_t count, const FormatRange& format, const WriteChunk& writeChunk) {
+    size_t chunks = (count + chunkRecords - 1) / chunkRecords;
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(threads, chunks));
+
+    if (workers <= 1) {
+        std::string buffer;
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            buffer.clear();
+            if (!format(buffer, chunk * chunkRecords, std::min(count, (chunk + 1) * chunkRecords))) {
+                return false;
+            }
+            if (!writeChunk(buffer)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // A window of slots bounds the formatted-but-unwritten text in memory:
+    // chunk n uses slot n % window and waits until chunk n - window is written
+    const size_t window = workers * 2;
+    std::vector<std::string> slots(window);
+    std::vector<char> ready(window, 0);
+    std::mutex mutex;
+    std::condition_variable formatted;
+    std::condition_variable written;
+    size_t writtenChunks = 0;
+    std::atomic<size_t> nextChunk{0};
+    std::atomic<bool> failed{false};
+
+    auto work = [&]() {
+        std::string buffer;
+        for (;;) {
+            size_t chunk = nextChunk.fetch_add(1);
+            if (chunk >= chunks || failed) {
+                return;
+            }
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                written.wait(lock, [&] { return chunk < writtenChunks + window || failed; });
+                if (failed) {
+                    return;
+                }
+                buffer.swap(slots[chunk % window]);
+            }
+
+            buffer.clear();
+            bool ok = format(buffer, chunk * chunkRecords, std::min(count, (chunk + 1) * chunkRecords));
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                buffer.swap(slots[chunk % window]);
+                ready[chunk % window] = 1;
+                if (!ok) {
+                    failed = true;
+                }
+            }
+            formatted.notify_all();
+            written.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i) {
+        pool.emplace_back(work);
+    }
+
+    // The sequencer: write chunks strictly in order, releasing each slot
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        size_t slot = chunk % window;
+        std::unique_lock<std::mutex> lock(mutex);
+        formatted.wait(lock, [&] { return ready[slot] || failed; });
+        if (failed) {
+            break;
+        }
+        std::string text;
+        text.swap(slots[slot]);
+        lock.unlock();
+
+        bool ok = writeChunk(text);
+
+        lock.lock();
+        text.clear();
+        slots[slot].swap(text);         // hand the capacity back for reuse
+        ready[slot] = 0;
+        writtenChunks = chunk + 1;
+        if (!ok) {
+            failed = true;
+        }
+        lock.unlock();
+        written.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (writtenChunks < chunks) {
+            failed = true;
+        }
+    }
+    written.notify_all();
+    for (auto& worker : pool) {
+        worker.join();
+    }
+    return !failed;
+}
@@ -0,0 +1,789 @@
+#include "parquetWriter.h"
+#include "../core/columnSchema.h"
+#include "../core/constants.h"
+#include "../utils/fsUtils.h"
+#include "../utils/hashCalc.h"
+#include "../utils/snappy.h"
+#include "../utils/stringUtils.h"
+#include "../../include/version.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+
+// parquet.thrift enum values
+enum PhysicalType { TYPE_BOOLEAN = 0, TYPE_INT32 = 1, TYPE_INT64 = 2, TYPE_BYTE_ARRAY = 6 };
+enum ConvertedType { CONVERTED_NONE = -1, CONVERTED_UTF8 = 0, CONVERTED_TIMESTAMP_MICROS = 10,
+                     CONVERTED_UINT_16 = 12 };
+enum PageEncoding { ENCODING_PLAIN = 0, ENCODING_RLE = 3, ENCODING_DELTA_BINARY_PACKED = 5,
+                    ENCODING_RLE_DICTIONARY = 8 };
+enum PageType { PAGE_DATA = 0, PAGE_DICTIONARY = 2 };
+enum Codec { CODEC_UNCOMPRESSED = 0, CODEC_SNAPPY = 1 };
+enum Repetition { REPETITION_REQUIRED = 0, REPETITION_OPTIONAL = 1 };
+
+const char PARQUET_MAGIC[4] = {'P', 'A', 'R', '1'};
+
+// Parquet columns that stand for no single CSV column
+constexpr size_t LINK_COUNT_COLUMN = CSV_COLUMN_COUNT;          // only written without --fields
+constexpr size_t ATTRIBUTE_MASK_COLUMN = CSV_COLUMN_COUNT + 1;  // written with any Has column
+
+using Encoding = ParquetWriter::Encoding;
+
+struct ParquetColumn {
+    const char* name;
+    size_t column;              // CsvColumn it is selected with
+    bool derived;               // computed from the record, not that column's value
+    PhysicalType physicalType;
+    ConvertedType convertedType;
+    bool optional;
+    Encoding encoding;
+};
+
+// In the order appendRecord() produces the values
+constexpr ParquetColumn PARQUET_COLUMNS[] = {
+    {"record_number", CSV_RECORD_NUMBER, false, TYPE_INT64, CONVERTED_NONE, false, Encoding::Delta},
+    {"record_status", CSV_RECORD_STATUS, false, TYPE_BYTE_ARRAY, CONVERTED_UTF8, false, Encoding::Dictionary},
+    {"in_use", CSV_RECORD_TYPE, true, TYPE_BOOLEAN, CONVERTED_NONE, false, Encoding::Plain},
+    {"file_type", CSV_FILE_TYPE, false, TYPE_BYTE_ARRAY, CONVERTED_UTF8, false, Encoding::Dictionary},
+    {"sequence_number", CSV_SEQUENCE_NUMBER, false, TYPE_INT32, CONVERTED_UINT_16, false, Encoding::Plain},
+    {"parent_record_number", CSV_PARENT_RECORD_NUMBER, false, TYPE_INT64, CONVERTED_NONE, false, Encoding::Delta},
+    {"parent_sequence_number", CSV_PARENT_SEQUENCE_NUMBER, false, TYPE_INT32, CONVERTED_UINT_16, false, Encoding::Plain},
+    {"filename", CSV_FILENAME, false, TYPE_BYTE_ARRAY, CONVERTED_UTF8, true, Encoding::Plain},
+    {"extension", CSV_FILENAME, true, TYPE_BYTE_ARRAY, CONVERTED_UTF8, true, Encoding::Dictionary},
+    {"filepath", CSV_FILEPATH, false, TYPE_BYTE_ARRAY, CONVERTED_UTF8, true, Encoding::Plain},
+    {"si_creation_time", CSV_SI_CREATION_TIME, false, TYPE_INT64, CONVERTED_TIMESTAMP_MICROS, true, Encoding::Delta},
+    {"si_modification_time", CSV_SI_MODIFICATION_TIME, false, TYPE_INT64, CONVERTED_TIMESTAMP_MICROS, true, Encoding::Delta},
+    {"si_access_time", CSV_SI_ACCESS_TIME, false, TYPE_INT64, CONVERTED_TIMESTAMP_MICROS, true, Encoding::Delta},
+    {"si_entry_time", CSV_SI_ENTRY_TIME, false, TYPE_INT64, CONVERTED_TIMESTAMP_MICROS, true, Encoding::Delta},
+    {"fn_creation_time", CSV_FN_CREATION_TIME, false, TYPE_INT64, CONVERTED_TIMESTAMP_MICROS, true, Encoding::Delta},
+    {"fn_modification_time", CSV_FN_MODIFICATION_TIME, false, TYPE_INT64, CONVERTED_TIMESTAMP_MICROS, true, Encoding::Delta},
+    {"fn_access_time", CSV_FN_ACCESS_TIME, false, TYPE_INT64, CONVERTED_TIMESTAMP_MICROS, true, Encoding::Delta},
+    {"fn_entry_time", CSV_FN_ENTRY_TIME, false, TYPE_INT64, CONVERTED_TIMESTAMP_MICROS, true, Encoding::Delta},
+    {"file_size", CSV_FILE_SIZE, false, TYPE_INT64, CONVERTED_NONE, false, Encoding::Plain},
+    {"link_count", LINK_COUNT_COLUMN, true, TYPE_INT32, CONVERTED_UINT_16, false, Encoding::Plain},
+    {"attribute_mask", ATTRIBUTE_MASK_COLUMN, true, TYPE_INT32, CONVERTED_NONE, false, Encoding::Plain},
+    {"flags", CSV_FLAGS, false, TYPE_INT32, CONVERTED_UINT_16, false, Encoding::Plain},
+    {"object_id", CSV_OBJECT_ID, false, TYPE_BYTE_ARRAY, CONVERTED_UTF8, true, Encoding::Plain},
+    {"birth_volume_id", CSV_BIRTH_VOLUME_ID, false, TYPE_BYTE_ARRAY, CONVERTED_UTF8, true, Encoding::Plain},
+    {"birth_object_id", CSV_BIRTH_OBJECT_ID, false, TYPE_BYTE_ARRAY, CONVERTED_UTF8, true, Encoding::Plain},
+    {"birth_domain_id", CSV_BIRTH_DOMAIN_ID, false, TYPE_BYTE_ARRAY, CONVERTED_UTF8, true, Encoding::Plain},
+    {"md5", CSV_MD5, false, TYPE_BYTE_ARRAY, CONVERTED_UTF8, true, Encoding::Plain},
+    {"sha256", CSV_SHA256, false, TYPE_BYTE_ARRAY, CONVERTED_UTF8, true, Encoding::Plain},
+    {"sha512", CSV_SHA512, false, TYPE_BYTE_ARRAY, CONVERTED_UTF8, true, Encoding::Plain},
+    {"crc32", CSV_CRC32, false, TYPE_BYTE_ARRAY, CONVERTED_UTF8, true, Encoding::Plain},
+};
+
+// A column written from COLUMNS keeps the value's type
+constexpr bool parquetTypesMatchColumns() {
+    for (const auto& parquet : PARQUET_COLUMNS) {
+        if (parquet.derived) {
+            continue;
+        }
+        bool matches = false;
+        switch (COLUMNS[parquet.column].type) {
+            case ColumnType::Number:
+                matches = (parquet.physicalType == TYPE_INT32 || parquet.physicalType == TYPE_INT64) &&
+                          parquet.convertedType != CONVERTED_TIMESTAMP_MICROS;
+                break;
+            case ColumnType::Time:
+                matches = parquet.physicalType == TYPE_INT64 && parquet.convertedType == CONVERTED_TIMESTAMP_MICROS;
+                break;
+            case ColumnType::Text:
+                matches = parquet.physicalType == TYPE_BYTE_ARRAY && parquet.convertedType == CONVERTED_UTF8;
+                break;
+            case ColumnType::Flag:
+            case ColumnType::Presence:
+                matches = parquet.physicalType == TYPE_BOOLEAN;
+                break;
+        }
+        if (!matches) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Every column of the SQLite files table that COLUMNS names is in Parquet too
+constexpr bool parquetHasSqlColumns() {
+    for (const auto& column : COLUMNS) {
+        if (!column.sqlName) {
+            continue;
+        }
+        bool found = false;
+        for (const auto& parquet : PARQUET_COLUMNS) {
+            found = found || (!parquet.derived && parquet.column == column.id);
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(parquetTypesMatchColumns(), "a Parquet column's type disagrees with its COLUMNS entry");
+static_assert(parquetHasSqlColumns(), "a SQLite files column from COLUMNS is missing from Parquet");
+
+// 100ns ticks between 1601-01-01 and 1970-01-01
+constexpr uint64_t FILETIME_UNIX_EPOCH = 116444736000000000ULL;
+
+constexpr size_t DELTA_BLOCK_SIZE = 128;
+constexpr size_t DELTA_MINIBLOCKS = 4;
+constexpr size_t DELTA_MINIBLOCK_SIZE = DELTA_BLOCK_SIZE / DELTA_MINIBLOCKS;
+constexpr size_t MAX_BIT_PACKED_GROUPS = 63;
+
+void putVarint(std::vector<uint8_t>& output, uint64_t value) {
+    while (value >= 0x80) {
+        output.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    output.push_back(static_cast<uint8_t>(value));
+}
+
+void putZigzag(std::vector<uint8_t>& output, int64_t value) {
+    putVarint(output, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+template<typename T>
+void putLittleEndian(std::vector<uint8_t>& output, T value) {
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        output.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (i * 8)));
+    }
+}
+
+int bitWidth(uint64_t value) {
+    int width = 0;
+    while (value) {
+        width++;
+        value >>= 1;
+    }
+    return width;
+}
+
+// Packs count values of width bits each, least significant bit first
+void packBits(const uint64_t* values, size_t count, int width, std::vector<uint8_t>& output) {
+    size_t start = output.size();
+    output.resize(start + (count * width + 7) / 8, 0);
+
+    size_t bit = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t value = values[i];
+        for (int done = 0; done < width;) {
+            int shift = static_cast<int>(bit % 8);
+            int take = std::min(8 - shift, width - done);
+            output[start + bit / 8] |= static_cast<uint8_t>(((value >> done) & ((1u << take) - 1)) << shift);
+            done += take;
+            bit += static_cast<size_t>(take);
+        }
+    }
+}
+
+void encodePlainStrings(const std::vector<std::string>& values, std::vector<uint8_t>& output) {
+    for (const auto& value : values) {
+        putLittleEndian<uint32_t>(output, static_cast<uint32_t>(value.size()));
+        output.insert(output.end(), value.begin(), value.end());
+    }
+}
+
+// Minimal Thrift compact protocol encoder for the Parquet metadata structs
+class ThriftWriter {
+public:
+    enum Type { BOOL_TRUE = 1, BOOL_FALSE = 2, I32 = 5, I64 = 6, BINARY = 8, LIST = 9, STRUCT = 12 };
+
+    std::vector<uint8_t> buffer;
+
+    void i32(int16_t id, int32_t value) { header(id, I32); putZigzag(buffer, value); }
+    void i64(int16_t id, int64_t value) { header(id, I64); putZigzag(buffer, value); }
+    void boolean(int16_t id, bool value) { header(id, value ? BOOL_TRUE : BOOL_FALSE); }
+    void binary(int16_t id, const std::string& value) { header(id, BINARY); rawBinary(value); }
+
+    void beginStruct(int16_t id) { header(id, STRUCT); beginListStruct(); }
+    void beginListStruct() { fieldStack.push_back(lastField); lastField = 0; }
+    void endStruct() {
+        buffer.push_back(0);
+        lastField = fieldStack.back();
+        fieldStack.pop_back();
+    }
+
+    void beginList(int16_t id, Type elementType, size_t size) {
+        header(id, LIST);
+        if (size < 15) {
+            buffer.push_back(static_cast<uint8_t>((size << 4) | elementType));
+        } else {
+            buffer.push_back(static_cast<uint8_t>(0xF0 | elementType));
+            putVarint(buffer, size);
+        }
+    }
+    void rawI32(int32_t value) { putZigzag(buffer, value); }
+    void rawBinary(const std::string& value) {
+        putVarint(buffer, value.size());
+        buffer.insert(buffer.end(), value.begin(), value.end());
+    }
+
+    // Top-level structs are written without a field header
+    std::vector<uint8_t> finish() {
+        buffer.push_back(0);
+        return std::move(buffer);
+    }
+
+private:
+    int16_t lastField = 0;
+    std::vector<int16_t> fieldStack;
+
+    void header(int16_t id, Type type) {
+        int delta = id - lastField;
+        if (delta > 0 && delta <= 15) {
+            buffer.push_back(static_cast<uint8_t>((delta << 4) | type));
+        } else {
+            buffer.push_back(static_cast<uint8_t>(type));
+            putZigzag(buffer, id);
+        }
+        lastField = id;
+    }
+};
+
+std::string plainStatistic(int physicalType, int64_t value) {
+    std::vector<uint8_t> bytes;
+    if (physicalType == TYPE_INT32) {
+        putLittleEndian<int32_t>(bytes, static_cast<int32_t>(value));
+    } else {
+        putLittleEndian<int64_t>(bytes, value);
+    }
+    return std::string(bytes.begin(), bytes.end());
+}
+
+}
+
+// RLE / bit-packing hybrid used for definition levels and dictionary indices
+void ParquetWriter::encodeHybrid(const std::vector<uint64_t>& values, int width, std::vector<uint8_t>& output) {
+    size_t byteWidth = static_cast<size_t>(width + 7) / 8;
+    size_t count = values.size();
+    size_t literalStart = 0;
+    size_t position = 0;
+
+    auto flushLiterals = [&](size_t end) {
+        while (literalStart < end) {
+            size_t groups = std::min((end - literalStart) / 8, MAX_BIT_PACKED_GROUPS);
+            putVarint(output, (groups << 1) | 1);
+            packBits(values.data() + literalStart, groups * 8, width, output);
+            literalStart += groups * 8;
+        }
+    };
+    auto emitRun = [&](uint64_t value, size_t length) {
+        putVarint(output, static_cast<uint64_t>(length) << 1);
+        for (size_t i = 0; i < byteWidth; ++i) {
+            output.push_back(static_cast<uint8_t>(value >> (i * 8)));
+        }
+    };
+
+    // Bit-packed runs must hold whole groups of 8, so decide group by group
+    while (position + 8 <= count) {
+        size_t run = 1;
+        while (position + run < count && values[position + run] == values[position]) {
+            run++;
+        }
+        if (run >= 8) {
+            flushLiterals(position);
+            emitRun(values[position], run);
+            position += run;
+            literalStart = position;
+        } else {
+            position += 8;
+        }
+    }
+    flushLiterals(position);
+
+    while (position < count) {
+        size_t run = 1;
+        while (position + run < count && values[position + run] == values[position]) {
+            run++;
+        }
+        emitRun(values[position], run);
+        position += run;
+    }
+}
+
+void ParquetWriter::encodeDelta(const std::vector<int64_t>& values, std::vector<uint8_t>& output) {
+    putVarint(output, DELTA_BLOCK_SIZE);
+    putVarint(output, DELTA_MINIBLOCKS);
+    putVarint(output, values.size());
+    putZigzag(output, values.empty() ? 0 : values[0]);
+
+    std::vector<uint64_t> block(DELTA_BLOCK_SIZE);
+    for (size_t start = 1; start < values.size(); start += DELTA_BLOCK_SIZE) {
+        size_t length = std::min(DELTA_BLOCK_SIZE, values.size() - start);
+
+        int64_t minDelta = std::numeric_limits<int64_t>::max();
+        for (size_t i = 0; i < length; ++i) {
+            int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(values[start + i]) -
+                                                 static_cast<uint64_t>(values[start + i - 1]));
+            block[i] = static_cast<uint64_t>(delta);
+            minDelta = std::min(minDelta, delta);
+        }
+        std::fill(block.begin() + static_cast<std::ptrdiff_t>(length), block.end(), static_cast<uint64_t>(minDelta));
+        for (auto& delta : block) {
+            delta -= static_cast<uint64_t>(minDelta);
+        }
+        putZigzag(output, minDelta);
+
+        size_t usedMiniblocks = (length + DELTA_MINIBLOCK_SIZE - 1) / DELTA_MINIBLOCK_SIZE;
+        int widths[DELTA_MINIBLOCKS] = {0};
+        for (size_t m = 0; m < usedMiniblocks; ++m) {
+            uint64_t combined = 0;
+            for (size_t i = m * DELTA_MINIBLOCK_SIZE; i < (m + 1) * DELTA_MINIBLOCK_SIZE; ++i) {
+                combined |= block[i];
+            }
+            widths[m] = bitWidth(combined);
+        }
+        for (int width : widths) {
+            output.push_back(static_cast<uint8_t>(width));
+        }
+        for (size_t m = 0; m < usedMiniblocks; ++m) {
+            packBits(block.data() + m * DELTA_MINIBLOCK_SIZE, DELTA_MINIBLOCK_SIZE, widths[m], output);
+        }
+    }
+}
+
+ParquetWriter::ParquetWriter(size_t rowGroupSize, bool compress)
+    : rowGroupSize(std::max<size_t>(1, rowGroupSize)), compress(compress),
+      fileOffset(0), bufferedRows(0), totalRows(0) {
+    initializeColumns();
+}
+
+ParquetWriter::~ParquetWriter() {
+    if (file.is_open()) {
+        close();
+    }
+}
+
+void ParquetWriter::setRowGroupSize(size_t rows) {
+    rowGroupSize = std::max<size_t>(1, rows);
+}
+
+void ParquetWriter::setCompression(bool enabled) {
+    compress = enabled;
+}
+
+// With selected columns, each Parquet column is kept when the CSV column it
+// is written from is selected. link_count has no CSV counterpart and is only
+// written with the full schema; record_number is always kept so rows stay
+// addressable.
+void ParquetWriter::initializeColumns() {
+    bool attributes = false;
+    for (size_t column = CSV_HAS_STANDARD_INFORMATION; column <= CSV_HAS_LOGGED_UTILITY_STREAM; ++column) {
+        attributes = attributes || isColumnSelected(column);
+    }
+    auto selects = [&](const ParquetColumn& parquet) {
+        switch (parquet.column) {
+            case CSV_RECORD_NUMBER:     return true;
+            case LINK_COUNT_COLUMN:     return selectedColumns.empty();
+            case ATTRIBUTE_MASK_COLUMN: return attributes;
+            default:                    return isColumnSelected(parquet.column);
+        }
+    };
+
+    columns.clear();
+    slots.clear();
+    for (const auto& parquet : PARQUET_COLUMNS) {
+        slots.push_back(selects(parquet) ? static_cast<int>(columns.size()) : -1);
+        if (slots.back() < 0) {
+            continue;
+        }
+        Column column;
+        column.name = parquet.name;
+        column.physicalType = parquet.physicalType;
+        column.convertedType = parquet.convertedType;
+        column.optional = parquet.optional;
+        column.encoding = parquet.encoding;
+        columns.push_back(std::move(column));
+    }
+}
+
+bool ParquetWriter::write(const std::vector<const MftRecord*>& records, const std::string& outputFile) {
+    try {
+        return open(outputFile) && writeBatch(records) && close();
+    } catch (const std::exception& e) {
+        return false;
+    }
+}
+
+bool ParquetWriter::open(const std::string& outputFile) {
+    file.open(outputFile, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    fileOffset = 0;
+    bufferedRows = 0;
+    totalRows = 0;
+    rowGroups.clear();
+    if (digest) {
+        *digest = OutputDigest();
+        hash = std::make_unique<Sha256Stream>();
+    } else {
+        hash.reset();
+    }
+    initializeColumns();
+    return writeBytes(reinterpret_cast<const uint8_t*>(PARQUET_MAGIC), sizeof(PARQUET_MAGIC));
+}
+
+bool ParquetWriter::writeBatch(const std::vector<const MftRecord*>& records) {
+    for (const auto* record : records) {
+        if (!writeRecord(file, record)) {
+            return false;
+        }
+    }
+    return file.good();
+}
+
+bool ParquetWriter::writeRecord(std::ostream& stream, const MftRecord* record) {
+    if (!record) return false;
+
+    appendRecord(*record);
+    bufferedRows++;
+    if (bufferedRows >= rowGroupSize) {
+        return flushRowGroup();
+    }
+    return stream.good();
+}
+
+bool ParquetWriter::close() {
+    if (!file.is_open()) {
+        return false;
+    }
+
+    bool success = true;
+    if (bufferedRows > 0) {
+        success = flushRowGroup();
+    }
+
+    if (success) {
+        std::vector<uint8_t> footer = serializeFooter();
+        std::vector<uint8_t> trailer;
+        putLittleEndian<uint32_t>(trailer, static_cast<uint32_t>(footer.size()));
+        trailer.insert(trailer.end(), PARQUET_MAGIC, PARQUET_MAGIC + sizeof(PARQUET_MAGIC));
+        success = writeBytes(footer.data(), footer.size()) && writeBytes(trailer.data(), trailer.size());
+    }
+
+    file.close();
+    success = success && !file.fail();
+    if (success && hash) {
+        digest->sha256 = hash->hexDigest();
+        digest->bytes = hash->size();
+    }
+    hash.reset();
+    return success;
+}
+
+void ParquetWriter::appendRecord(const MftRecord& record) {
+    size_t index = 0;
+    auto addInt = [this, &index](int64_t value) {
+        int slot = slots[index++];
+        if (slot >= 0) {
+            columns[slot].ints.push_back(value);
+        }
+    };
+    auto addString = [this, &index](const std::string& value, bool required) {
+        int slot = slots[index++];
+        if (slot < 0) {
+            return;
+        }
+        Column& column = columns[slot];
+        bool present = required || !value.empty();
+        if (column.optional) {
+            column.definitionLevels.push_back(present ? 1 : 0);
+        }
+        if (present) {
+            column.strings.push_back(value);
+        } else {
+            column.nullCount++;
+        }
+    };
+    auto addTime = [this, &index](const WindowsTime& time) {
+        int slot = slots[index++];
+        if (slot < 0) {
+            return;
+        }
+        Column& column = columns[slot];
+        uint64_t filetime = (static_cast<uint64_t>(time.high) << 32) | time.low;
+        column.definitionLevels.push_back(filetime != 0 ? 1 : 0);
+        if (filetime != 0) {
+            column.ints.push_back(static_cast<int64_t>(filetime - FILETIME_UNIX_EPOCH) / 10);
+        } else {
+            column.nullCount++;
+        }
+    };
+
+    bool isDirectory = (record.flags & FILE_RECORD_IS_DIRECTORY) != 0;
+    std::string extension = isDirectory ? "" : StringUtils::toLower(FileSystemUtils::getFileExtension(record.filename));
+
+    addInt(record.recordnum);
+    addString(record.magic == MFT_RECORD_MAGIC ? "Valid" : "Invalid", true);
+    addInt((record.flags & FILE_RECORD_IN_USE) ? 1 : 0);
+    addString(record.getFileType(), true);
+    addInt(record.seq);
+    addInt(static_cast<int64_t>(record.getParentRecordNum()));
+    addInt(static_cast<int64_t>(record.baseRef >> 48));
+    addString(record.filename, false);
+    addString(extension, false);
+    addString(record.filepath, false);
+    addTime(record.siTimes.crtime);
+    addTime(record.siTimes.mtime);
+    addTime(record.siTimes.atime);
+    addTime(record.siTimes.ctime);
+    addTime(record.fnTimes.crtime);
+    addTime(record.fnTimes.mtime);
+    addTime(record.fnTimes.atime);
+    addTime(record.fnTimes.ctime);
+    addInt(static_cast<int64_t>(record.filesize));
+    addInt(record.link);
+
+    uint32_t attributeMask = 0;
+    for (uint32_t type : record.attributeTypes) {
+        if ((type >> 4) < 32) {
+            attributeMask |= 1u << (type >> 4);
+        }
+    }
+    addInt(static_cast<int32_t>(attributeMask));
+    addInt(record.flags);
+
+    addString(record.objectId, false);
+    addString(record.birthVolumeId, false);
+    addString(record.birthObjectId, false);
+    addString(record.birthDomainId, false);
+    addString(record.md5, false);
+    addString(record.sha256, false);
+    addString(record.sha512, false);
+    addString(record.crc32, false);
+}
+
+bool ParquetWriter::flushRowGroup() {
+    RowGroupInfo rowGroup;
+    rowGroup.rowCount = static_cast<int64_t>(bufferedRows);
+    rowGroup.fileOffset = fileOffset;
+    rowGroup.columns.resize(columns.size());
+
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (!writeColumnChunk(columns[i], rowGroup.columns[i])) {
+            return false;
+        }
+        rowGroup.totalByteSize += rowGroup.columns[i].uncompressedSize;
+
+        columns[i].ints.clear();
+        columns[i].strings.clear();
+        columns[i].definitionLevels.clear();
+        columns[i].nullCount = 0;
+    }
+
+    totalRows += rowGroup.rowCount;
+    rowGroups.push_back(std::move(rowGroup));
+    bufferedRows = 0;
+    return true;
+}
+
+bool ParquetWriter::writeColumnChunk(Column& column, ColumnChunkInfo& info) {
+    info.fileOffset = fileOffset;
+    info.valueCount = static_cast<int64_t>(bufferedRows);
+    info.nullCount = column.nullCount;
+
+    if (!column.ints.empty() && column.physicalType != TYPE_BOOLEAN) {
+        auto range = std::minmax_element(column.ints.begin(), column.ints.end());
+        info.hasMinMax = true;
+        info.minValue = *range.first;
+        info.maxValue = *range.second;
+    }
+
+    std::vector<uint8_t> body;
+    if (column.optional) {
+        std::vector<uint64_t> levels(column.definitionLevels.begin(), column.definitionLevels.end());
+        std::vector<uint8_t> encoded;
+        encodeHybrid(levels, 1, encoded);
+        putLittleEndian<uint32_t>(body, static_cast<uint32_t>(encoded.size()));
+        body.insert(body.end(), encoded.begin(), encoded.end());
+    }
+
+    int encoding = ENCODING_PLAIN;
+    if (column.encoding == Encoding::Dictionary) {
+        std::vector<std::string> dictionary;
+        std::unordered_map<std::string, uint64_t> lookup;
+        std::vector<uint64_t> indices;
+        indices.reserve(column.strings.size());
+        for (const auto& value : column.strings) {
+            auto inserted = lookup.emplace(value, dictionary.size());
+            if (inserted.second) {
+                dictionary.push_back(value);
+            }
+            indices.push_back(inserted.first->second);
+        }
+
+        std::vector<uint8_t> dictionaryPage;
+        encodePlainStrings(dictionary, dictionaryPage);
+        info.dictionaryPageOffset = fileOffset;
+        if (!writePage(PAGE_DICTIONARY, dictionaryPage, static_cast<int32_t>(dictionary.size()),
+                       ENCODING_PLAIN, info)) {
+            return false;
+        }
+
+        int width = std::max(1, bitWidth(dictionary.empty() ? 0 : dictionary.size() - 1));
+        body.push_back(static_cast<uint8_t>(width));
+        encodeHybrid(indices, width, body);
+        encoding = ENCODING_RLE_DICTIONARY;
+    } else if (column.encoding == Encoding::Delta) {
+        encodeDelta(column.ints, body);
+        encoding = ENCODING_DELTA_BINARY_PACKED;
+    } else {
+        encodeValues(column, body);
+    }
+
+    info.dataPageOffset = fileOffset;
+    return writePage(PAGE_DATA, body, static_cast<int32_t>(bufferedRows), encoding, info);
+}
+
+void ParquetWriter::encodeValues(const Column& column, std::vector<uint8_t>& output) const {
+    switch (column.physicalType) {
+        case TYPE_BOOLEAN: {
+            std::vector<uint64_t> bits(column.ints.begin(), column.ints.end());
+            packBits(bits.data(), bits.size(), 1, output);
+            break;
+        }
+        case TYPE_INT32:
+            for (int64_t value : column.ints) {
+                putLittleEndian<int32_t>(output, static_cast<int32_t>(value));
+            }
+            break;
+        case TYPE_INT64:
+            for (int64_t value : column.ints) {
+                putLittleEndian<int64_t>(output, value);
+            }
+            break;
+        default:
+            encodePlainStrings(column.strings, output);
+            break;
+    }
+}
+
+bool ParquetWriter::writePage(int pageType, const std::vector<uint8_t>& body, int32_t valueCount,
+                              int encoding, ColumnChunkInfo& info) {
+    std::vector<uint8_t> compressed;
+    const std::vector<uint8_t>* payload = &body;
+    if (compress) {
+        compressed = Snappy::compress(body);
+        payload = &compressed;
+    }
+
+    ThriftWriter header;
+    header.i32(1, pageType);
+    header.i32(2, static_cast<int32_t>(body.size()));
+    header.i32(3, static_cast<int32_t>(payload->size()));
+    if (pageType == PAGE_DATA) {
+        header.beginStruct(5);
+        header.i32(1, valueCount);
+        header.i32(2, encoding);
+        header.i32(3, ENCODING_RLE);
+        header.i32(4, ENCODING_RLE);
+        header.endStruct();
+    } else {
+        header.beginStruct(7);
+        header.i32(1, valueCount);
+        header.i32(2, encoding);
+        header.endStruct();
+    }
+    std::vector<uint8_t> headerBytes = header.finish();
+
+    info.uncompressedSize += static_cast<int64_t>(headerBytes.size() + body.size());
+    info.compressedSize += static_cast<int64_t>(headerBytes.size() + payload->size());
+    return writeBytes(headerBytes.data(), headerBytes.size()) && writeBytes(payload->data(), payload->size());
+}
+
+std::vector<uint8_t> ParquetWriter::serializeFooter() const {
+    ThriftWriter footer;
+    footer.i32(1, 1);
+
+    footer.beginList(2, ThriftWriter::STRUCT, columns.size() + 1);
+    footer.beginListStruct();
+    footer.binary(4, "schema");
+    footer.i32(5, static_cast<int32_t>(columns.size()));
+    footer.endStruct();
+    for (const auto& column : columns) {
+        footer.beginListStruct();
+        footer.i32(1, column.physicalType);
+        footer.i32(3, column.optional ? REPETITION_OPTIONAL : REPETITION_REQUIRED);
+        footer.binary(4, column.name);
+        if (column.convertedType != CONVERTED_NONE) {
+            footer.i32(6, column.convertedType);
+        }
+        footer.endStruct();
+    }
+
+    footer.i64(3, totalRows);
+
+    footer.beginList(4, ThriftWriter::STRUCT, rowGroups.size());
+    for (const auto& rowGroup : rowGroups) {
+        int64_t compressedTotal = 0;
+        footer.beginListStruct();
+        footer.beginList(1, ThriftWriter::STRUCT, rowGroup.columns.size());
+        for (size_t i = 0; i < rowGroup.columns.size(); ++i) {
+            const Column& column = columns[i];
+            const ColumnChunkInfo& chunk = rowGroup.columns[i];
+            compressedTotal += chunk.compressedSize;
+
+            footer.beginListStruct();
+            footer.i64(2, chunk.fileOffset);
+            footer.beginStruct(3);
+            footer.i32(1, column.physicalType);
+
+            std::vector<int32_t> encodings;
+            if (column.encoding == Encoding::Dictionary) {
+                encodings = {ENCODING_PLAIN, ENCODING_RLE, ENCODING_RLE_DICTIONARY};
+            } else if (column.encoding == Encoding::Delta) {
+                encodings = {ENCODING_RLE, ENCODING_DELTA_BINARY_PACKED};
+            } else {
+                encodings = {ENCODING_PLAIN, ENCODING_RLE};
+            }
+            footer.beginList(2, ThriftWriter::I32, encodings.size());
+            for (int32_t encoding : encodings) {
+                footer.rawI32(encoding);
+            }
+
+            footer.beginList(3, ThriftWriter::BINARY, 1);
+            footer.rawBinary(column.name);
+            footer.i32(4, compress ? CODEC_SNAPPY : CODEC_UNCOMPRESSED);
+            footer.i64(5, chunk.valueCount);
+            footer.i64(6, chunk.uncompressedSize);
+            footer.i64(7, chunk.compressedSize);
+            footer.i64(9, chunk.dataPageOffset);
+            if (chunk.dictionaryPageOffset >= 0) {
+                footer.i64(11, chunk.dictionaryPageOffset);
+            }
+
+            footer.beginStruct(12);
+            footer.i64(3, chunk.nullCount);
+            if (chunk.hasMinMax) {
+                footer.binary(5, plainStatistic(column.physicalType, chunk.maxValue));
+                footer.binary(6, plainStatistic(column.physicalType, chunk.minValue));
+            }
+            footer.endStruct();
+
+            footer.endStruct();
+            footer.endStruct();
+        }
+        footer.i64(2, rowGroup.totalByteSize);
+        footer.i64(3, rowGroup.rowCount);
+        footer.i64(5, rowGroup.fileOffset);
+        footer.i64(6, compressedTotal);
+        footer.endStruct();
+    }
+
+    footer.binary(6, std::string("analyzeMFT-cpp version ") + ANALYZEMFT_VERSION_STRING);
+    return footer.finish();
+}
+
+bool ParquetWriter::writeBytes(const uint8_t* data, size_t length) {
+    file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(length));
+    fileOffset += static_cast<int64_t>(length);
+    if (hash) {
+        hash->update(data, length);
+    }
+    return file.good();
+}
@@ -4,12 +4,102 @@
 #include <sqlite3.h>
 #endif
 
-#include "../core/constants.h"
+#include "../core/columnSchema.h"
 #include "../utils/fsUtils.h"
+#include "../utils/logger.h"
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <iterator>
 
-SqliteWriter::SqliteWriter() : database(nullptr), insertStatement(nullptr) {
+namespace {
+
+constexpr uint64_t RECORD_NUMBER_MASK = 0x0000FFFFFFFFFFFFULL;
+
+// The files columns only SQLite stores, bound by bindFile() after those
+// COLUMNS names
+constexpr const char* SQLITE_FILE_COLUMNS[] = {
+    "in_use", "is_directory", "base_record_number", "hard_link_count",
+    "file_attributes", "owner_id", "security_id", "usn", "attribute_mask"
+};
+static_assert(std::size(SQLITE_FILE_COLUMNS) == 9, "bindFile() binds nine SQLite-only columns");
+
+// Bit n set for attribute type n * 0x10 ($STANDARD_INFORMATION = bit 1)
+sqlite3_int64 attributeMask(const std::unordered_set<uint32_t>& types) {
+    sqlite3_int64 mask = 0;
+    for (uint32_t type : types) {
+        uint32_t bit = type >> 4;
+        if ((type & 0xF) == 0 && bit < 63) {
+            mask |= sqlite3_int64(1) << bit;
+        }
+    }
+    return mask;
+}
+
+void bindInt(sqlite3_stmt* statement, int parameter, uint64_t value) {
+    sqlite3_bind_int64(statement, parameter, static_cast<sqlite3_int64>(value));
+}
+
+void bindOptional(sqlite3_stmt* statement, int parameter, bool present, uint64_t value) {
+    if (present) {
+        bindInt(statement, parameter, value);
+    } else {
+        sqlite3_bind_null(statement, parameter);
+    }
+}
+
+void bindFileTime(sqlite3_stmt* statement, int parameter, const WindowsTime& time) {
+    uint64_t ticks = (static_cast<uint64_t>(time.high) << 32) | time.low;
+    bindOptional(statement, parameter, time.isValid(), ticks);
+}
+
+void bindText(sqlite3_stmt* statement, int parameter, std::string_view text) {
+    // The record outlives the sqlite3_step() that reads this
+    sqlite3_bind_text(statement, parameter, text.data(), static_cast<int>(text.size()), SQLITE_STATIC);
+}
+
+void bindFileName(sqlite3_stmt* statement, int first, uint32_t recordNumber, uint32_t index,
+                  const FileNameInfo& name) {
+    bindInt(statement, first, recordNumber);
+    bindInt(statement, first + 1, index);
+    bindInt(statement, first + 2, name.nameSpace);
+    bindText(statement, first + 3, name.name);
+    bindInt(statement, first + 4, name.parentRecordNumber());
+    bindInt(statement, first + 5, name.parentRef >> 48);
+    bindFileTime(statement, first + 6, name.crtime);
+    bindFileTime(statement, first + 7, name.mtime);
+    bindFileTime(statement, first + 8, name.atime);
+    bindFileTime(statement, first + 9, name.ctime);
+    bindInt(statement, first + 10, name.allocatedSize);
+    bindInt(statement, first + 11, name.realSize);
+    bindInt(statement, first + 12, name.fileAttributes);
+}
+
+void bindDataStream(sqlite3_stmt* statement, int first, uint32_t recordNumber, uint32_t index,
+                    const DataStream& stream) {
+    bindInt(statement, first, recordNumber);
+    bindInt(statement, first + 1, index);
+    bindText(statement, first + 2, stream.name);
+    bindInt(statement, first + 3, stream.nonResident ? 1 : 0);
+    bindInt(statement, first + 4, stream.size);
+    bindInt(statement, first + 5, stream.allocatedSize);
+}
+
+void bindAttributeListEntry(sqlite3_stmt* statement, int first, uint32_t recordNumber, uint32_t index,
+                            const AttributeListEntry& entry) {
+    bindInt(statement, first, recordNumber);
+    bindInt(statement, first + 1, index);
+    bindInt(statement, first + 2, entry.type);
+    bindText(statement, first + 3, entry.name);
+    bindInt(statement, first + 4, entry.vcn);
+    bindInt(statement, first + 5, entry.reference & RECORD_NUMBER_MASK);
+    bindInt(statement, first + 6, entry.reference >> 48);
+}
+
+}
+
+SqliteWriter::SqliteWriter() : database(nullptr), transactionRows(0) {
 }
 
 SqliteWriter::~SqliteWriter() {
@@ -17,10 +107,23 @@ SqliteWriter::~SqliteWriter() {
 }
 
 bool SqliteWriter::write(const std::vector<const MftRecord*>& records, const std::string& outputFile) {
+    return open(outputFile) && writeBatch(records) && close();
+}
+
+bool SqliteWriter::open(const std::string& outputFile) {
+    closeDatabase();
+    
+    // Bulk-load settings assume a fresh file
+    FileSystemUtils::deleteFile(outputFile);
+    
     if (!openDatabase(outputFile)) {
         return false;
     }
     
+    if (!beginBulkLoad()) {
+        return false;
+    }
+    
     if (!createTables()) {
         return false;
     }
@@ -29,16 +132,49 @@ bool SqliteWriter::write(const std::vector<const MftRecord*>& records, const std
         return false;
     }
     
-    sqlite3_exec(database, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+    transactionRows = 0;
+    return execute("BEGIN TRANSACTION");
+}
+
+// With journal_mode = OFF a failed insert cannot be rolled back; the
+// output is incomplete either way and the caller gives up on it
+bool SqliteWriter::writeBatch(const std::vector<const MftRecord*>& records) {
+    if (!database || std::find(records.begin(), records.end(), nullptr) != records.end()) {
+        return false;
+    }
     
-    for (const auto* record : records) {
-        if (!insertRecord(record)) {
-            sqlite3_exec(database, "ROLLBACK", nullptr, nullptr, nullptr);
+    for (size_t start = 0; start < records.size();) {
+        if (transactionRows == TRANSACTION_ROWS) {
+            if (!execute("COMMIT") || !execute("BEGIN TRANSACTION")) {
+                return false;
+            }
+            transactionRows = 0;
+        }
+        size_t count = std::min(TRANSACTION_ROWS - transactionRows, records.size() - start);
+        if (!insertRecords(records.data() + start, count)) {
+            Logger::getInstance().error(std::string("SQLite insert failed: ") + sqlite3_errmsg(database));
             return false;
         }
+        transactionRows += count;
+        start += count;
+    }
+    return true;
+}
+
+bool SqliteWriter::close() {
+    if (!database) {
+        return false;
+    }
+    
+    if (!execute("COMMIT")) {
+        return false;
     }
     
-    sqlite3_exec(database, "COMMIT", nullptr, nullptr, nullptr);
+    if (!createIndexes()) {
+        return false;
+    }
+    
+    closeDatabase();
     return true;
 }
 
@@ -54,108 +190,239 @@ bool SqliteWriter::openDatabase(const std::string& filename) {
     return true;
 }
 
+// The output is written from scratch in one pass; a crash mid-load leaves
+// a file to delete, not one to recover, so durability is switched off
+bool SqliteWriter::beginBulkLoad() {
+    return execute("PRAGMA page_size = 65536") &&
+           execute("PRAGMA journal_mode = OFF") &&
+           execute("PRAGMA synchronous = OFF") &&
+           execute("PRAGMA locking_mode = EXCLUSIVE") &&
+           execute("PRAGMA temp_store = MEMORY") &&
+           execute("PRAGMA cache_size = -262144");
+}
+
 bool SqliteWriter::createTables() {
-    if (!executeSqlScript("attributeTypes.sql")) {
-        return false;
+    return executeSqlScript("attributeTypes.sql") &&
+           executeSqlScript("fileRecordFlags.sql") &&
+           executeSqlScript("schema.sql") &&
+           checkFilesTable();
+}
+
+// schema.sql is read at run time, so the files table it creates is checked
+// against COLUMNS here: a column missing from either side is an error rather
+// than an insert that fails or a column left NULL
+bool SqliteWriter::checkFilesTable() {
+    std::vector<std::string> expected;
+    for (const auto& column : COLUMNS) {
+        if (column.sqlName) {
+            expected.push_back(column.sqlName);
+        }
     }
+    expected.insert(expected.end(), std::begin(SQLITE_FILE_COLUMNS), std::end(SQLITE_FILE_COLUMNS));
     
-    if (!executeSqlScript("fileRecordFlags.sql")) {
+    std::vector<std::string> actual;
+    sqlite3_stmt* statement = nullptr;
+    if (sqlite3_prepare_v2(database, "SELECT name FROM pragma_table_info('files')", -1, &statement, nullptr) != SQLITE_OK) {
+        Logger::getInstance().error(std::string("Cannot read the files table: ") + sqlite3_errmsg(database));
         return false;
     }
+    while (sqlite3_step(statement) == SQLITE_ROW) {
+        actual.push_back(reinterpret_cast<const char*>(sqlite3_column_text(statement, 0)));
+    }
+    sqlite3_finalize(statement);
     
-    if (!executeSqlScript("schema.sql")) {
-        return false;
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    std::vector<std::string> missing;
+    std::vector<std::string> unexpected;
+    std::set_difference(expected.begin(), expected.end(), actual.begin(), actual.end(), std::back_inserter(missing));
+    std::set_difference(actual.begin(), actual.end(), expected.begin(), expected.end(), std::back_inserter(unexpected));
+    for (const auto& name : missing) {
+        Logger::getInstance().error("schema.sql: files has no column " + name);
     }
+    for (const auto& name : unexpected) {
+        Logger::getInstance().error("schema.sql: files column " + name + " is not written");
+    }
+    return missing.empty() && unexpected.empty();
+}
+
+bool SqliteWriter::prepareStatements() {
+    // The files columns the record schema holds, then those only SQLite stores
+    std::string fileColumns;
+    int fileColumnCount = 0;
+    for (const auto& column : COLUMNS) {
+        if (column.sqlName) {
+            fileColumns += column.sqlName;
+            fileColumns += ", ";
+            fileColumnCount++;
+        }
+    }
+    for (const char* column : SQLITE_FILE_COLUMNS) {
+        fileColumns += column;
+        fileColumns += ", ";
+        fileColumnCount++;
+    }
+    fileColumns.resize(fileColumns.size() - 2);
     
-    const char* createMftRecords = R"(
-        CREATE TABLE IF NOT EXISTS mft_records (
-            record_number INTEGER PRIMARY KEY,
-            filename TEXT,
-            parent_record_number INTEGER,
-            file_size INTEGER,
-            is_directory INTEGER,
-            creation_time TEXT,
-            modification_time TEXT,
-            access_time TEXT,
-            entry_time TEXT,
-            attribute_types TEXT,
-            flags INTEGER,
-            sequence_number INTEGER,
-            object_id TEXT,
-            birth_volume_id TEXT,
-            birth_object_id TEXT,
-            birth_domain_id TEXT,
-            md5 TEXT,
-            sha256 TEXT,
-            sha512 TEXT,
-            crc32 TEXT
-        )
-    )";
+    return prepareTable(files, "INSERT INTO files (" + fileColumns + ") VALUES ", fileColumnCount) &&
+           prepareTable(fileNames, R"(
+        INSERT INTO file_names (
+            record_number, name_index, namespace, name,
+            parent_record_number, parent_sequence_number,
+            creation_time, modification_time, access_time, entry_time,
+            allocated_size, real_size, file_attributes
+        ) VALUES )", 13) &&
+           prepareTable(dataStreams, R"(
+        INSERT INTO data_streams (
+            record_number, stream_index, name, non_resident, size, allocated_size
+        ) VALUES )", 6) &&
+           prepareTable(attributeListEntries, R"(
+        INSERT INTO attribute_list_entries (
+            record_number, entry_index, attribute_type, name, start_vcn,
+            segment_record_number, segment_sequence_number
+        ) VALUES )", 7);
+}
+
+bool SqliteWriter::prepareTable(Table& table, const std::string& insertSql, int columns) {
+    std::string row = "(?";
+    for (int i = 1; i < columns; ++i) {
+        row += ",?";
+    }
+    row += ")";
     
-    char* errorMsg = nullptr;
-    int result = sqlite3_exec(database, createMftRecords, nullptr, nullptr, &errorMsg);
-    if (result != SQLITE_OK) {
-        if (errorMsg) {
-            sqlite3_free(errorMsg);
-        }
-        return false;
+    table.columns = columns;
+    table.batchRows = std::max<size_t>(1, std::min<size_t>(MAX_BATCH_ROWS, MAX_PARAMETERS / columns));
+    
+    std::string batchSql = insertSql + row;
+    for (size_t i = 1; i < table.batchRows; ++i) {
+        batchSql += ",";
+        batchSql += row;
     }
+    std::string singleSql = insertSql + row;
     
-    return true;
+    return sqlite3_prepare_v2(database, singleSql.c_str(), -1, &table.single, nullptr) == SQLITE_OK &&
+           sqlite3_prepare_v2(database, batchSql.c_str(), -1, &table.batch, nullptr) == SQLITE_OK;
 }
 
-bool SqliteWriter::prepareStatements() {
-    const char* insertSql = R"(
-        INSERT INTO mft_records (
-            record_number, filename, parent_record_number, file_size,
-            is_directory, creation_time, modification_time, access_time,
-            entry_time, attribute_types, flags, sequence_number,
-            object_id, birth_volume_id, birth_object_id, birth_domain_id,
-            md5, sha256, sha512, crc32
-        ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
-    )";
-    
-    int result = sqlite3_prepare_v2(database, insertSql, -1, &insertStatement, nullptr);
-    return result == SQLITE_OK;
+template <typename BindRow>
+bool SqliteWriter::insertRows(Table& table, size_t count, BindRow bindRow) {
+    size_t index = 0;
+    while (index < count) {
+        bool batch = count - index >= table.batchRows;
+        sqlite3_stmt* statement = batch ? table.batch : table.single;
+        size_t rows = batch ? table.batchRows : 1;
+    
+        sqlite3_reset(statement);
+        for (size_t i = 0; i < rows; ++i) {
+            bindRow(statement, static_cast<int>(i) * table.columns + 1, index + i);
+        }
+        if (sqlite3_step(statement) != SQLITE_DONE) {
+            return false;
+        }
+        index += rows;
+    }
+    return true;
 }
 
-bool SqliteWriter::insertRecord(const MftRecord* record) {
-    if (!insertStatement || !record) {
+bool SqliteWriter::insertRecords(const MftRecord* const* records, size_t count) {
+    if (!insertRows(files, count, [&](sqlite3_stmt* statement, int first, size_t row) {
+            bindFile(statement, first, records[row]);
+        })) {
         return false;
     }
     
-    sqlite3_reset(insertStatement);
-    
-    sqlite3_bind_int(insertStatement, 1, record->recordnum);
-    sqlite3_bind_text(insertStatement, 2, record->filename.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_int64(insertStatement, 3, record->getParentRecordNum());
-    sqlite3_bind_int64(insertStatement, 4, record->filesize);
-    sqlite3_bind_int(insertStatement, 5, (record->flags & FILE_RECORD_IS_DIRECTORY) ? 1 : 0);
-    sqlite3_bind_text(insertStatement, 6, record->fnTimes.crtime.getDateTimeString().c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(insertStatement, 7, record->fnTimes.mtime.getDateTimeString().c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(insertStatement, 8, record->fnTimes.atime.getDateTimeString().c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(insertStatement, 9, record->fnTimes.ctime.getDateTimeString().c_str(), -1, SQLITE_STATIC);
+    childRows.clear();
+    for (size_t i = 0; i < count; ++i) {
+        for (uint32_t j = 0; j < records[i]->fileNames().size(); ++j) {
+            childRows.push_back({records[i], j});
+        }
+    }
+    if (!insertRows(fileNames, childRows.size(), [&](sqlite3_stmt* statement, int first, size_t row) {
+            const ChildRow& child = childRows[row];
+            bindFileName(statement, first, child.record->recordnum, child.index,
+                         child.record->fileNames()[child.index]);
+        })) {
+        return false;
+    }
     
-    std::string attributeTypes;
-    for (auto attr : record->attributeTypes) {
-        if (!attributeTypes.empty()) attributeTypes += ",";
-        attributeTypes += std::to_string(attr);
+    childRows.clear();
+    for (size_t i = 0; i < count; ++i) {
+        for (uint32_t j = 0; j < records[i]->dataStreams().size(); ++j) {
+            childRows.push_back({records[i], j});
+        }
+    }
+    if (!insertRows(dataStreams, childRows.size(), [&](sqlite3_stmt* statement, int first, size_t row) {
+            const ChildRow& child = childRows[row];
+            bindDataStream(statement, first, child.record->recordnum, child.index,
+                           child.record->dataStreams()[child.index]);
+        })) {
+        return false;
     }
-    sqlite3_bind_text(insertStatement, 10, attributeTypes.c_str(), -1, SQLITE_STATIC);
     
-    sqlite3_bind_int(insertStatement, 11, record->flags);
-    sqlite3_bind_int(insertStatement, 12, record->seq);
-    sqlite3_bind_text(insertStatement, 13, record->objectId.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(insertStatement, 14, record->birthVolumeId.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(insertStatement, 15, record->birthObjectId.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(insertStatement, 16, record->birthDomainId.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(insertStatement, 17, record->md5.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(insertStatement, 18, record->sha256.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(insertStatement, 19, record->sha512.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(insertStatement, 20, record->crc32.c_str(), -1, SQLITE_STATIC);
+    childRows.clear();
+    for (size_t i = 0; i < count; ++i) {
+        for (uint32_t j = 0; j < records[i]->attributeList.size(); ++j) {
+            childRows.push_back({records[i], j});
+        }
+    }
+    return insertRows(attributeListEntries, childRows.size(), [&](sqlite3_stmt* statement, int first, size_t row) {
+        const ChildRow& child = childRows[row];
+        bindAttributeListEntry(statement, first, child.record->recordnum, child.index,
+                               child.record->attributeList[child.index]);
+    });
+}
+
+void SqliteWriter::bindFile(sqlite3_stmt* statement, int first, const MftRecord* record) const {
+    const StandardInformation& si = record->standardInformation();
+    uint64_t baseRecord = record->baseRef & RECORD_NUMBER_MASK;
     
-    int result = sqlite3_step(insertStatement);
-    return result == SQLITE_DONE;
+    int parameter = first;
+    forEachColumn([&](const ColumnDescriptor& column) {
+        if (!column.sqlName) {
+            return;
+        }
+        ColumnValue value = column.get(*record);
+        switch (column.type) {
+            case ColumnType::Number:   bindInt(statement, parameter, value.number); break;
+            case ColumnType::Time:     bindFileTime(statement, parameter, *value.time); break;
+            case ColumnType::Text:     bindText(statement, parameter, value.text); break;
+            case ColumnType::Flag:
+            case ColumnType::Presence: bindInt(statement, parameter, value.flag ? 1 : 0); break;
+        }
+        parameter++;
+    });
+    bindInt(statement, parameter, (record->flags & FILE_RECORD_IN_USE) ? 1 : 0);
+    bindInt(statement, parameter + 1, (record->flags & FILE_RECORD_IS_DIRECTORY) ? 1 : 0);
+    bindOptional(statement, parameter + 2, baseRecord != 0, baseRecord);
+    bindInt(statement, parameter + 3, record->link);
+    bindOptional(statement, parameter + 4, si.present, si.fileAttributes);
+    bindOptional(statement, parameter + 5, si.extended, si.ownerId);
+    bindOptional(statement, parameter + 6, si.extended, si.securityId);
+    bindOptional(statement, parameter + 7, si.extended, si.usn);
+    sqlite3_bind_int64(statement, parameter + 8, attributeMask(record->attributeTypes));
+}
+
+bool SqliteWriter::createIndexes() {
+    if (!executeSqlScript("indexes.sql")) {
+        return false;
+    }
+    // Name search is a bonus: SQLite builds without FTS5 still get a
+    // complete database, minus the half-created index
+    if (!executeSqlScript("fullText.sql")) {
+        execute("DROP TABLE IF EXISTS file_names_fts");
+        execute("DROP VIEW IF EXISTS file_name_paths");
+    }
+    return true;
+}
+
+bool SqliteWriter::execute(const char* sql) {
+    char* errorMsg = nullptr;
+    int result = sqlite3_exec(database, sql, nullptr, nullptr, &errorMsg);
+    if (errorMsg) {
+        Logger::getInstance().error(std::string("SQLite error: ") + errorMsg);
+        sqlite3_free(errorMsg);
+    }
+    return result == SQLITE_OK;
 }
 
 bool SqliteWriter::executeSqlScript(const std::string& scriptName) {
@@ -163,36 +430,53 @@ bool SqliteWriter::executeSqlScript(const std::string& scriptName) {
     
     std::ifstream file(scriptPath);
     if (!file.is_open()) {
-        return true;
+        Logger::getInstance().error("SQL script not found: " + scriptName +
+                                    " (set ANALYZEMFT_SQL_DIR to the data/sql directory)");
+        return false;
     }
     
     std::string sql((std::istreambuf_iterator<char>(file)),
                     std::istreambuf_iterator<char>());
     
-    char* errorMsg = nullptr;
-    int result = sqlite3_exec(database, sql.c_str(), nullptr, nullptr, &errorMsg);
-    if (result != SQLITE_OK) {
-        if (errorMsg) {
-            sqlite3_free(errorMsg);
-        }
-        return false;
-    }
-    
-    return true;
+    return execute(sql.c_str());
 }
 
+// The scripts are looked up in $ANALYZEMFT_SQL_DIR, then data/sql under the
+// working directory as in a source checkout, then the install location
 std::string SqliteWriter::getSqlScriptPath(const std::string& scriptName) const {
+    std::vector<std::string> directories;
+    if (const char* configured = std::getenv("ANALYZEMFT_SQL_DIR")) {
+        directories.push_back(configured);
+    }
+    directories.push_back("data/sql");
+#ifdef ANALYZEMFT_SQL_DIR
+    directories.push_back(ANALYZEMFT_SQL_DIR);
+#endif
+    
+    for (const auto& directory : directories) {
+        std::string path = FileSystemUtils::joinPath(directory, scriptName);
+        if (FileSystemUtils::fileExists(path)) {
+            return path;
+        }
+    }
     return FileSystemUtils::joinPath("data/sql", scriptName);
 }
 
+void SqliteWriter::finalizeTable(Table& table) {
+    sqlite3_finalize(table.single);
+    sqlite3_finalize(table.batch);
+    table.single = nullptr;
+    table.batch = nullptr;
+}
+
 void SqliteWriter::closeDatabase() {
-    if (insertStatement) {
-        sqlite3_finalize(insertStatement);
-        insertStatement = nullptr;
-    }
+    finalizeTable(files);
+    finalizeTable(fileNames);
+    finalizeTable(dataStreams);
+    finalizeTable(attributeListEntries);
     
     if (database) {
         sqlite3_close(database);
         database = nullptr;
     }
-}
\ No newline at end of file
+}
@@ -1,18 +1,52 @@
 #include "timelineWriter.h"
-#include <fstream>
+#include "../utils/outputSink.h"
+#include "../utils/shmRing.h"
+#include "../utils/fsUtils.h"
+#include <charconv>
 
-TimelineWriter::TimelineWriter() {
+namespace {
+
+uint64_t fileTime(const WindowsTime& time) {
+    return (static_cast<uint64_t>(time.high) << 32) | time.low;
+}
+
+}
+
+TimelineWriter::TimelineWriter() : memoryLimit(ExternalSorter::DEFAULT_MEMORY_LIMIT) {
 }
 
+TimelineWriter::~TimelineWriter() = default;
+
 bool TimelineWriter::write(const std::vector<const MftRecord*>& records, const std::string& outputFile) {
-    std::ofstream file(outputFile);
-    if (!file.is_open()) {
+    return open(outputFile) && writeBatch(records) && close();
+}
+
+bool TimelineWriter::open(const std::string& outputFile) {
+    this->outputFile = outputFile;
+    sorter = std::make_unique<ExternalSorter>(memoryLimit, threads);
+    std::string runPrefix = outputFile;
+    if (ShmRingWriter::isRingPath(outputFile)) {
+        // A ring has no directory to put the sort runs next to
+        runPrefix = FileSystemUtils::joinPath(FileSystemUtils::getTempDirectory(),
+                                              "analyzemft_" + outputFile.substr(outputFile.find_last_of(":/") + 1));
+    }
+    sorter->setRunPrefix(runPrefix);
+    return true;
+}
+
+bool TimelineWriter::writeBatch(const std::vector<const MftRecord*>& records) {
+    if (!sorter) {
         return false;
     }
     
     try {
+        bool ok = true;
         for (const auto* record : records) {
-            if (!writeRecord(file, record)) {
+            if (!record) continue;
+            formatEvents(record, [&](uint64_t time, const std::string& entry) {
+                ok = ok && sorter->add(time, entry.data(), entry.size());
+            });
+            if (!ok) {
                 return false;
             }
         }
@@ -22,34 +56,116 @@ bool TimelineWriter::write(const std::vector<const MftRecord*>& records, const s
     }
 }
 
+bool TimelineWriter::close() {
+    if (!sorter) {
+        return false;
+    }
+    std::unique_ptr<ExternalSorter> events = std::move(sorter);
+    
+    OutputSink sink;
+    sink.setCompression(compression);
+    sink.setDigest(digest);
+    sink.setCancellation(cancellation);
+    if (!sink.open(outputFile)) {
+        return false;
+    }
+    
+    try {
+        bool ok = events->finish([&](const char* data, size_t size) {
+            return sink.append(data, size);
+        });
+        return sink.close() && ok;
+    } catch (const std::exception& e) {
+        sink.close();
+        return false;
+    }
+}
+
 bool TimelineWriter::writeRecord(std::ostream& stream, const MftRecord* record) {
     if (!record) return false;
     
-    writeTimelineEvent(stream, record, record->fnTimes.crtime, "CREATE");
-    writeTimelineEvent(stream, record, record->fnTimes.mtime, "MODIFY");
-    writeTimelineEvent(stream, record, record->fnTimes.atime, "ACCESS");
-    writeTimelineEvent(stream, record, record->fnTimes.ctime, "CHANGE");
-    
+    formatEvents(record, [&](uint64_t, const std::string& entry) {
+        stream << entry;
+    });
     return stream.good();
 }
 
-void TimelineWriter::writeTimelineEvent(std::ostream& stream, const MftRecord* record, const WindowsTime& time, const std::string& eventType) {
-   if (!time.isValid()) return;
-   
-   std::string entry = formatTimelineEntry(record, time, eventType);
-   stream << entry << "\n";
-}
-
-std::string TimelineWriter::formatTimelineEntry(const MftRecord* record, const WindowsTime& time, const std::string& eventType) const {
-   std::string entry;
-   entry += std::to_string(time.getUnixTime());
-   entry += "|MFT|";
-   entry += eventType;
-   entry += "|||||";
-   entry += record->filename;
-   entry += "|";
-   entry += std::to_string(record->recordnum);
-   entry += "||||";
-   
-   return entry;
-}
\ No newline at end of file
+template <typename AddEvent>
+void TimelineWriter::formatEvents(const MftRecord* record, AddEvent addEvent) {
+    const FileNameInfo* name = record->fileName();
+    if (!name) return;
+    
+    enum : unsigned { SOURCE_SI = 1, SOURCE_FN = 2 };
+    enum : unsigned { MODIFY = 1, ACCESS = 2, CHANGE = 4, CREATE = 8 };
+    
+    struct Event {
+        const WindowsTime* time;
+        unsigned sources;
+        unsigned flags;
+    };
+    Event events[8];
+    size_t count = 0;
+    auto collect = [&](const WindowsTime& time, unsigned source, unsigned flag) {
+        if (!time.isValid()) return;
+        if (collapse != MacbCollapse::None) {
+            for (size_t i = 0; i < count; ++i) {
+                if (fileTime(*events[i].time) == fileTime(time) &&
+                    (collapse == MacbCollapse::All || events[i].sources == source)) {
+                    events[i].sources |= source;
+                    events[i].flags |= flag;
+                    return;
+                }
+            }
+        }
+        events[count++] = {&time, source, flag};
+    };
+    
+    const StandardInformation& info = record->standardInformation();
+    if (info.present) {
+        collect(info.crtime, SOURCE_SI, CREATE);
+        collect(info.mtime, SOURCE_SI, MODIFY);
+        collect(info.atime, SOURCE_SI, ACCESS);
+        collect(info.ctime, SOURCE_SI, CHANGE);
+    }
+    collect(name->crtime, SOURCE_FN, CREATE);
+    collect(name->mtime, SOURCE_FN, MODIFY);
+    collect(name->atime, SOURCE_FN, ACCESS);
+    collect(name->ctime, SOURCE_FN, CHANGE);
+    
+    for (size_t i = 0; i < count; ++i) {
+        const Event& event = events[i];
+        const char* source = event.sources == SOURCE_SI ? "$SI" : event.sources == SOURCE_FN ? "$FN" : "$SI+$FN";
+        char macb[5] = "....";
+        const char* eventType = macb;
+        if (collapse == MacbCollapse::None) {
+            eventType = event.flags == CREATE ? "CREATE" : event.flags == MODIFY ? "MODIFY" :
+                        event.flags == ACCESS ? "ACCESS" : "CHANGE";
+        } else {
+            for (unsigned bit = 0; bit < 4; ++bit) {
+                if (event.flags & (1u << bit)) {
+                    macb[bit] = "MACB"[bit];
+                }
+            }
+        }
+        line.clear();
+        formatTimelineEntry(line, record, name->name, *event.time, source, eventType);
+        addEvent(fileTime(*event.time), line);
+    }
+}
+
+void TimelineWriter::formatTimelineEntry(std::string& entry, const MftRecord* record, const std::string& name,
+                                         const WindowsTime& time, const char* source, const char* eventType) const {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), static_cast<int64_t>(time.getUnixTime()));
+    entry.append(digits, result.ptr);
+    entry += '|';
+    entry += source;
+    entry += '|';
+    entry += eventType;
+    entry += "|||||";
+    entry += name;
+    entry += '|';
+    result = std::to_chars(digits, digits + sizeof(digits), record->recordnum);
+    entry.append(digits, result.ptr);
+    entry += "||||\n";
+}
@@ -1,16 +1,21 @@
 #include "xmlWriter.h"
+#include "../core/columnSchema.h"
 #include "../utils/stringUtils.h"
-#include <fstream>
+#include "../utils/outputSink.h"
 
 XmlWriter::XmlWriter(bool prettyPrint) 
     : prettyPrint(prettyPrint), indentLevel(0) {
 }
 
 bool XmlWriter::write(const std::vector<const MftRecord*>& records, const std::string& outputFile) {
-    std::ofstream file(outputFile);
-    if (!file.is_open()) {
+    OutputSink sink;
+    sink.setCompression(compression);
+    sink.setDigest(digest);
+    sink.setCancellation(cancellation);
+    if (!sink.open(outputFile)) {
         return false;
     }
+    std::ostream file(&sink);
     
     try {
         indentLevel = 0;
@@ -19,17 +24,15 @@ bool XmlWriter::write(const std::vector<const MftRecord*>& records, const std::s
             return false;
         }
         
-        for (const auto* record : records) {
-            if (!writeRecord(file, record)) {
-                return false;
-            }
+        if (!writeRecords(file, records)) {
+            return false;
         }
         
         if (!writeFooter(file)) {
             return false;
         }
         
-        return true;
+        return sink.close();
     } catch (const std::exception& e) {
         return false;
     }
@@ -64,6 +67,10 @@ bool XmlWriter::writeRecord(std::ostream& stream, const MftRecord* record) {
     return stream.good();
 }
 
+std::unique_ptr<FileWriter> XmlWriter::chunkWriter(size_t) const {
+    return std::make_unique<XmlWriter>(*this);
+}
+
 bool XmlWriter::writeFooter(std::ostream& stream) {
     if (prettyPrint) {
         indentLevel--;
@@ -80,37 +87,10 @@ void XmlWriter::writeRecordElement(std::ostream& stream, const MftRecord* record
         indentLevel++;
     }
     
-    writeXmlElement(stream, "recordNumber", std::to_string(record->recordnum));
-    writeXmlElement(stream, "filename", record->filename);
-    writeXmlElement(stream, "filesize", std::to_string(record->filesize));
-    writeXmlElement(stream, "sequenceNumber", std::to_string(record->seq));
-    writeXmlElement(stream, "parentRecordNumber", std::to_string(record->getParentRecordNum()));
-    writeXmlElement(stream, "flags", std::to_string(record->flags));
-    writeXmlElement(stream, "fileType", record->getFileType());
-    
-    writeXmlElement(stream, "siCreationTime", record->siTimes.crtime.getDateTimeString());
-    writeXmlElement(stream, "siModificationTime", record->siTimes.mtime.getDateTimeString());
-    writeXmlElement(stream, "siAccessTime", record->siTimes.atime.getDateTimeString());
-    writeXmlElement(stream, "siEntryTime", record->siTimes.ctime.getDateTimeString());
-    
-    writeXmlElement(stream, "fnCreationTime", record->fnTimes.crtime.getDateTimeString());
-    writeXmlElement(stream, "fnModificationTime", record->fnTimes.mtime.getDateTimeString());
-    writeXmlElement(stream, "fnAccessTime", record->fnTimes.atime.getDateTimeString());
-    writeXmlElement(stream, "fnEntryTime", record->fnTimes.ctime.getDateTimeString());
-    
-    if (!record->objectId.empty()) {
-        writeXmlElement(stream, "objectId", record->objectId);
-        writeXmlElement(stream, "birthVolumeId", record->birthVolumeId);
-        writeXmlElement(stream, "birthObjectId", record->birthObjectId);
-        writeXmlElement(stream, "birthDomainId", record->birthDomainId);
-    }
-    
-    if (!record->md5.empty()) {
-        writeXmlElement(stream, "md5", record->md5);
-        writeXmlElement(stream, "sha256", record->sha256);
-        writeXmlElement(stream, "sha512", record->sha512);
-        writeXmlElement(stream, "crc32", record->crc32);
-    }
+    char digits[20];
+    forEachColumn(selectedColumns, [&](const ColumnDescriptor& column) {
+        writeXmlElement(stream, column.key, columnText(column.type, column.get(*record), digits));
+    });
     
     if (prettyPrint) {
         indentLevel--;
@@ -119,7 +99,7 @@ void XmlWriter::writeRecordElement(std::ostream& stream, const MftRecord* record
     stream << "</record>";
 }
 
-void XmlWriter::writeXmlElement(std::ostream& stream, const std::string& tag, const std::string& value) {
+void XmlWriter::writeXmlElement(std::ostream& stream, const char* tag, std::string_view value) {
     if (prettyPrint) {
         stream << getIndent();
     }
@@ -129,7 +109,7 @@ void XmlWriter::writeXmlElement(std::ostream& stream, const std::string& tag, co
     }
 }
 
-std::string XmlWriter::escapeXmlString(const std::string& str) const {
+std::string XmlWriter::escapeXmlString(std::string_view str) const {
     std::string escaped;
     for (char c : str) {
         switch (c) {
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "analyzeMFT/core/mftAnalyzer.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+class FullAnalysis : public ::testing::Test {
+protected:
+    std::filesystem::path directory;
+    std::string input;
+
+    void SetUp() override {
+        const ::testing::TestInfo* test = ::testing::UnitTest::GetInstance()->current_test_info();
+        directory = std::filesystem::path(::testing::TempDir()) / (std::string("analyzemft_") + test->name());
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+
+        // Blank records still come out as rows, which is all these tests need
+        input = (directory / "blank.mft").string();
+        std::vector<char> records(200 * 1024, 0);
+        std::ofstream(input, std::ios::binary).write(records.data(), static_cast<std::streamsize>(records.size()));
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory);
+    }
+
+    std::string path(const std::string& name) const {
+        return (directory / name).string();
+    }
+};
+
+}
+
+TEST_F(FullAnalysis, WritesSplitParts) {
+    MftAnalyzer analyzer(input, path("out.csv"), 0, 0, false, "csv");
+    OutputSplit split;
+    split.records = 50;
+    analyzer.setSplit(split);
+
+    ASSERT_TRUE(analyzer.analyze());
+    for (const char* part : {"out.00001.csv", "out.00002.csv", "out.00003.csv", "out.00004.csv"}) {
+        EXPECT_TRUE(std::filesystem::is_regular_file(path(part))) << part;
+    }
+    EXPECT_FALSE(std::filesystem::exists(path("out.00005.csv")));
+}
+
+// The input fits in one batch, so the reader has handed everything over
+// before the writer thread fails on the second part
+TEST_F(FullAnalysis, FailsWhenAPartCannotBeOpened) {
+    std::filesystem::create_directory(path("out.00002.csv"));
+    MftAnalyzer analyzer(input, path("out.csv"), 0, 0, false, "csv");
+    OutputSplit split;
+    split.records = 50;
+    analyzer.setSplit(split);
+
+    EXPECT_FALSE(analyzer.analyze());
+}
+
+TEST_F(FullAnalysis, FailsWhenOneOfSeveralOutputsCannotBeWritten) {
+    if (!std::filesystem::exists("/dev/full")) {
+        GTEST_SKIP() << "needs /dev/full";
+    }
+    MftAnalyzer analyzer(input, path("out.jsonl"), 0, 0, false, "jsonl");
+    analyzer.addOutput("csv", "/dev/full");
+
+    EXPECT_FALSE(analyzer.analyze());
+}
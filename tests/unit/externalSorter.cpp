@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include "analyzeMFT/utils/externalSorter.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Line {
+    uint64_t key;
+    std::string text;
+};
+
+// Keys from a fixed LCG, few enough distinct ones that most are repeated
+std::vector<Line> makeLines(size_t count, uint64_t distinctKeys) {
+    std::vector<Line> lines;
+    uint64_t state = 12345;
+    for (size_t i = 0; i < count; ++i) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t key = (state >> 33) % distinctKeys;
+        // Spread keys over every byte so each radix pass has work
+        key = key * 0x0101010101010101ULL;
+        lines.push_back({key, std::to_string(key) + "," + std::to_string(i) + "\n"});
+    }
+    return lines;
+}
+
+std::string expectedOutput(std::vector<Line> lines) {
+    std::stable_sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) { return a.key < b.key; });
+    std::string out;
+    for (const auto& line : lines) {
+        out += line.text;
+    }
+    return out;
+}
+
+std::string runPrefix(const std::string& name) {
+    return ::testing::TempDir() + "externalSorter_" + name;
+}
+
+}
+
+TEST(ExternalSorter, SortsInMemoryWithoutRuns) {
+    std::vector<Line> lines = makeLines(5000, 100);
+    ExternalSorter sorter;
+    sorter.setRunPrefix(runPrefix("memory"));
+    for (const auto& line : lines) {
+        ASSERT_TRUE(sorter.add(line.key, line.text.data(), line.text.size()));
+    }
+    EXPECT_EQ(sorter.getRunCount(), 0u);
+
+    std::string out;
+    ASSERT_TRUE(sorter.finish([&](const char* data, size_t size) {
+        out.append(data, size);
+        return true;
+    }));
+    EXPECT_EQ(out, expectedOutput(lines));
+}
+
+// Equal keys come out in insertion order across runs as well as within one
+TEST(ExternalSorter, MergesSeveralRunsStably) {
+    std::vector<Line> lines = makeLines(20000, 50);
+    ExternalSorter sorter(16 * 1024, 2);
+    sorter.setRunPrefix(runPrefix("runs"));
+    for (const auto& line : lines) {
+        ASSERT_TRUE(sorter.add(line.key, line.text.data(), line.text.size()));
+    }
+    EXPECT_GT(sorter.getRunCount(), 5u);
+
+    std::string out;
+    ASSERT_TRUE(sorter.finish([&](const char* data, size_t size) {
+        out.append(data, size);
+        return true;
+    })) << sorter.getLastError();
+    EXPECT_EQ(out, expectedOutput(lines));
+    EXPECT_EQ(sorter.getRunCount(), 0u);
+}
+
+TEST(ExternalSorter, TruncatedRunFailsTheMerge) {
+    std::vector<Line> lines = makeLines(2000, 50);
+    std::string prefix = runPrefix("truncated");
+    ExternalSorter sorter(4 * 1024);
+    sorter.setRunPrefix(prefix);
+    for (const auto& line : lines) {
+        ASSERT_TRUE(sorter.add(line.key, line.text.data(), line.text.size()));
+    }
+    ASSERT_GT(sorter.getRunCount(), 1u);
+
+    // Leave the first run with a record header and no payload
+    std::string path = prefix + ".run0.tmp";
+    std::string header;
+    {
+        std::ifstream run(path, std::ios::binary);
+        header.resize(sizeof(uint64_t) + sizeof(uint32_t));
+        run.read(&header[0], static_cast<std::streamsize>(header.size()));
+    }
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(header.data(), static_cast<std::streamsize>(header.size()));
+
+    EXPECT_FALSE(sorter.finish([](const char*, size_t) { return true; }));
+    EXPECT_NE(sorter.getLastError().find(path), std::string::npos);
+    EXPECT_FALSE(std::ifstream(path).good());
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include "analyzeMFT/utils/outputSink.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+}
+
+// Small buffers so the writer thread sees many blocks
+TEST(OutputSink, WritesEverythingInOrder) {
+    std::string path = ::testing::TempDir() + "outputSink_order.txt";
+    std::string expected;
+    OutputSink sink(4096, 2);
+    ASSERT_TRUE(sink.open(path, 1 << 20));
+    for (int i = 0; i < 20000; ++i) {
+        std::string line = std::to_string(i) + "\n";
+        expected += line;
+        ASSERT_TRUE(sink.append(line));
+    }
+    EXPECT_EQ(sink.bytesWritten(), expected.size());
+    ASSERT_TRUE(sink.close()) << sink.getLastError();
+
+    // The preallocation is trimmed back to what was written
+    EXPECT_EQ(readFile(path), expected);
+    std::remove(path.c_str());
+}
+
+TEST(OutputSink, ReportsAFailedWrite) {
+    if (!std::filesystem::exists("/dev/full")) {
+        GTEST_SKIP() << "needs /dev/full";
+    }
+    OutputSink sink(4096, 2);
+    ASSERT_TRUE(sink.open("/dev/full"));
+    std::string block(1000, 'x');
+    bool appended = true;
+    for (int i = 0; i < 100 && appended; ++i) {
+        appended = sink.append(block);
+    }
+    EXPECT_FALSE(sink.close());
+    EXPECT_TRUE(sink.hasFailed());
+    EXPECT_FALSE(sink.getLastError().empty());
+}
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include "analyzeMFT/writers/parquetWriter.h"
+#include "analyzeMFT/core/mftRecord.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct ByteReader {
+    const std::vector<uint8_t>& bytes;
+    size_t position = 0;
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0;; shift += 7) {
+            uint8_t byte = bytes.at(position++);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+    }
+    int64_t zigzag() {
+        uint64_t value = varint();
+        return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+    }
+    // count values of width bits, least significant bit first
+    std::vector<uint64_t> unpack(size_t count, int width) {
+        std::vector<uint64_t> values(count, 0);
+        size_t bit = position * 8;
+        for (auto& value : values) {
+            for (int i = 0; i < width; ++i, ++bit) {
+                value |= static_cast<uint64_t>((bytes.at(bit / 8) >> (bit % 8)) & 1) << i;
+            }
+        }
+        position += (count * static_cast<size_t>(width) + 7) / 8;
+        return values;
+    }
+};
+
+std::vector<uint64_t> decodeHybrid(const std::vector<uint8_t>& bytes, int width, size_t count) {
+    ByteReader reader{bytes};
+    std::vector<uint64_t> values;
+    while (values.size() < count) {
+        uint64_t header = reader.varint();
+        if (header & 1) {
+            for (uint64_t value : reader.unpack((header >> 1) * 8, width)) {
+                values.push_back(value);
+            }
+        } else {
+            uint64_t value = 0;
+            for (int i = 0; i < (width + 7) / 8; ++i) {
+                value |= static_cast<uint64_t>(bytes.at(reader.position++)) << (8 * i);
+            }
+            values.insert(values.end(), header >> 1, value);
+        }
+    }
+    EXPECT_EQ(reader.position, bytes.size());
+    values.resize(count);
+    return values;
+}
+
+std::vector<int64_t> decodeDelta(const std::vector<uint8_t>& bytes) {
+    ByteReader reader{bytes};
+    size_t blockSize = reader.varint();
+    size_t miniblocks = reader.varint();
+    size_t total = reader.varint();
+    std::vector<int64_t> values;
+    int64_t last = reader.zigzag();
+    if (total > 0) {
+        values.push_back(last);
+    }
+    while (values.size() < total) {
+        int64_t minDelta = reader.zigzag();
+        std::vector<int> widths;
+        for (size_t m = 0; m < miniblocks; ++m) {
+            widths.push_back(bytes.at(reader.position++));
+        }
+        for (size_t m = 0; m < miniblocks && values.size() < total; ++m) {
+            for (uint64_t delta : reader.unpack(blockSize / miniblocks, widths[m])) {
+                if (values.size() < total) {
+                    last = static_cast<int64_t>(static_cast<uint64_t>(last) + static_cast<uint64_t>(minDelta) + delta);
+                    values.push_back(last);
+                }
+            }
+        }
+    }
+    EXPECT_EQ(reader.position, bytes.size());
+    return values;
+}
+
+std::vector<uint8_t> hybrid(const std::vector<uint64_t>& values, int width) {
+    std::vector<uint8_t> out;
+    ParquetWriter::encodeHybrid(values, width, out);
+    return out;
+}
+
+std::vector<uint8_t> delta(const std::vector<int64_t>& values) {
+    std::vector<uint8_t> out;
+    ParquetWriter::encodeDelta(values, out);
+    return out;
+}
+
+std::vector<uint64_t> pseudoRandom(size_t count, uint64_t modulus) {
+    std::vector<uint64_t> values;
+    uint64_t state = 42;
+    for (size_t i = 0; i < count; ++i) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        values.push_back((state >> 29) % modulus);
+    }
+    return values;
+}
+
+}
+
+TEST(ParquetWriter, HybridKnownBytes) {
+    // One RLE run: header 10 << 1, then the value in one byte
+    EXPECT_EQ(hybrid(std::vector<uint64_t>(10, 1), 1), (std::vector<uint8_t>{0x14, 0x01}));
+    // One bit-packed group of 8: header 1 << 1 | 1, then 0b10101010
+    EXPECT_EQ(hybrid({0, 1, 0, 1, 0, 1, 0, 1}, 1), (std::vector<uint8_t>{0x03, 0xAA}));
+    // Run values take whole bytes of the width
+    EXPECT_EQ(hybrid(std::vector<uint64_t>(8, 0x1234), 13), (std::vector<uint8_t>{0x10, 0x34, 0x12}));
+}
+
+TEST(ParquetWriter, HybridRoundTrips) {
+    for (int width : {1, 2, 3, 8, 13, 20}) {
+        uint64_t modulus = 1ULL << width;
+        for (size_t count : {0, 1, 7, 8, 9, 63, 100, 1000}) {
+            std::vector<uint64_t> values = pseudoRandom(count, modulus);
+            ASSERT_EQ(decodeHybrid(hybrid(values, width), width, count), values) << width << " bits, " << count;
+        }
+        // Runs between literals, and more than 63 groups of literals
+        std::vector<uint64_t> values = pseudoRandom(700, modulus);
+        values.insert(values.begin() + 100, 50, modulus - 1);
+        values.insert(values.begin() + 13, 9, 0);
+        ASSERT_EQ(decodeHybrid(hybrid(values, width), width, values.size()), values) << width << " bits";
+    }
+}
+
+TEST(ParquetWriter, DeltaKnownBytes) {
+    // Block size 128, 4 miniblocks, 3 values, first 1; one block with
+    // minimum delta 1 and four zero-width miniblocks
+    EXPECT_EQ(delta({1, 2, 3}), (std::vector<uint8_t>{0x80, 0x01, 0x04, 0x03, 0x02, 0x02, 0, 0, 0, 0}));
+    EXPECT_EQ(delta({}), (std::vector<uint8_t>{0x80, 0x01, 0x04, 0x00, 0x00}));
+}
+
+TEST(ParquetWriter, DeltaRoundTrips) {
+    for (size_t count : {1, 2, 33, 128, 129, 257, 1000}) {
+        std::vector<int64_t> ascending;
+        std::vector<int64_t> mixed;
+        for (uint64_t value : pseudoRandom(count, 1000000)) {
+            ascending.push_back(static_cast<int64_t>(ascending.size()) * 3);
+            mixed.push_back(static_cast<int64_t>(value) - 500000);
+        }
+        ASSERT_EQ(decodeDelta(delta(ascending)), ascending) << count;
+        ASSERT_EQ(decodeDelta(delta(mixed)), mixed) << count;
+    }
+    // Deltas that overflow int64 wrap around
+    std::vector<int64_t> extremes = {0, std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min(),
+                                     -1, std::numeric_limits<int64_t>::max(), 0};
+    EXPECT_EQ(decodeDelta(delta(extremes)), extremes);
+}
+
+// Uncompressed, so the PLAIN filepath values are in the file as written
+TEST(ParquetWriter, WritesFramedFile) {
+    std::vector<MftRecord> records(250);
+    std::vector<const MftRecord*> pointers;
+    for (size_t i = 0; i < records.size(); ++i) {
+        records[i].recordnum = static_cast<uint32_t>(i);
+        records[i].filename = "file" + std::to_string(i) + ".txt";
+        records[i].filepath = "\\dir\\" + records[i].filename;
+        pointers.push_back(&records[i]);
+    }
+
+    std::string path = ::testing::TempDir() + "parquetWriter.parquet";
+    ParquetWriter writer(100, false);
+    ASSERT_TRUE(writer.write(pointers, path));
+
+    std::ifstream file(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::remove(path.c_str());
+    ASSERT_GT(bytes.size(), 12u);
+    EXPECT_EQ(bytes.substr(0, 4), "PAR1");
+    EXPECT_EQ(bytes.substr(bytes.size() - 4), "PAR1");
+
+    size_t footerSize = 0;
+    for (int i = 0; i < 4; ++i) {
+        footerSize |= static_cast<size_t>(static_cast<uint8_t>(bytes[bytes.size() - 8 + i])) << (8 * i);
+    }
+    ASSERT_LT(footerSize, bytes.size() - 12);
+    std::string footer = bytes.substr(bytes.size() - 8 - footerSize, footerSize);
+    for (const char* column : {"record_number", "filepath", "si_creation_time", "crc32"}) {
+        EXPECT_NE(footer.find(column), std::string::npos) << column;
+    }
+
+    for (const auto& record : records) {
+        std::string value(4, '\0');
+        for (int i = 0; i < 4; ++i) {
+            value[i] = static_cast<char>(record.filepath.size() >> (8 * i));
+        }
+        value += record.filepath;
+        EXPECT_NE(bytes.find(value), std::string::npos) << record.filepath;
+    }
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include "analyzeMFT/core/recordFilter.h"
+#include "analyzeMFT/core/mftRecord.h"
+#include "analyzeMFT/core/constants.h"
+#include <string>
+
+namespace {
+
+using Result = RecordFilter::Result;
+
+MftRecord makeRecord(uint32_t number, bool inUse, bool directory, const std::string& path) {
+    MftRecord record;
+    record.recordnum = number;
+    record.flags = static_cast<uint16_t>((inUse ? FILE_RECORD_IN_USE : 0) | (directory ? FILE_RECORD_IS_DIRECTORY : 0));
+    record.filepath = path;
+    record.attributeTypes.insert(STANDARD_INFORMATION_ATTRIBUTE);
+    return record;
+}
+
+Result evaluate(const std::string& expression, const MftRecord& record, uint32_t knownFields = FILTER_FIELDS_ALL) {
+    RecordFilter filter;
+    EXPECT_TRUE(filter.compile(expression)) << expression << ": " << filter.getLastError();
+    return filter.evaluate(record, knownFields);
+}
+
+std::string compileError(const std::string& expression) {
+    RecordFilter filter;
+    EXPECT_FALSE(filter.compile(expression)) << expression;
+    return filter.getLastError();
+}
+
+std::string repeat(const std::string& text, size_t count) {
+    std::string out;
+    for (size_t i = 0; i < count; ++i) {
+        out += text;
+    }
+    return out;
+}
+
+}
+
+TEST(RecordFilter, AndBindsTighterThanOr) {
+    MftRecord record = makeRecord(1, false, false, "\\a.txt");
+    EXPECT_EQ(evaluate("record = 1 or record = 2 and inuse", record), Result::True);
+    EXPECT_EQ(evaluate("(record = 1 or record = 2) and inuse", record), Result::False);
+    EXPECT_EQ(evaluate("record = 1 || record = 2 && inuse", record), Result::True);
+}
+
+TEST(RecordFilter, NotBindsTighterThanAnd) {
+    MftRecord record = makeRecord(5, false, true, "\\dir");
+    EXPECT_EQ(evaluate("not inuse and dir", record), Result::True);
+    EXPECT_EQ(evaluate("not (inuse or dir)", record), Result::False);
+    EXPECT_EQ(evaluate("! ! dir", record), Result::True);
+}
+
+TEST(RecordFilter, KeywordsAndTextAreCaseInsensitive) {
+    MftRecord record = makeRecord(7, true, false, "\\Windows\\System32\\cmd.exe");
+    EXPECT_EQ(evaluate("INUSE AND Path StartsWith '\\windows\\'", record), Result::True);
+    EXPECT_EQ(evaluate("path endswith .EXE and record in (3, 7)", record), Result::True);
+    EXPECT_EQ(evaluate("has(data) or has(si)", record), Result::True);
+    EXPECT_EQ(evaluate("has(data)", record), Result::False);
+}
+
+// Fields not parsed yet are Unknown: and/or settle without them when the
+// known side decides the result, and not leaves Unknown alone
+TEST(RecordFilter, UnknownFieldsFollowThreeValuedLogic) {
+    MftRecord live = makeRecord(1, true, false, "\\a");
+    MftRecord deleted = makeRecord(1, false, false, "\\a");
+    const uint32_t header = FILTER_FIELD_HEADER;
+
+    EXPECT_EQ(evaluate("path contains a or inuse", live, header), Result::True);
+    EXPECT_EQ(evaluate("path contains a or inuse", deleted, header), Result::Unknown);
+    EXPECT_EQ(evaluate("path contains a and inuse", deleted, header), Result::False);
+    EXPECT_EQ(evaluate("path contains a and inuse", live, header), Result::Unknown);
+    EXPECT_EQ(evaluate("not path contains a", live, header), Result::Unknown);
+    EXPECT_EQ(evaluate("not (path contains a and inuse)", deleted, header), Result::True);
+
+    // Once every field is known the same expressions are decided
+    EXPECT_EQ(evaluate("path contains a and inuse", live), Result::True);
+    EXPECT_EQ(evaluate("not path contains a", live), Result::False);
+}
+
+TEST(RecordFilter, ReportsFieldGroups) {
+    RecordFilter filter;
+    ASSERT_TRUE(filter.compile("inuse and path contains x"));
+    EXPECT_TRUE(filter.uses(FILTER_FIELD_HEADER));
+    EXPECT_TRUE(filter.uses(FILTER_FIELD_PATH));
+    EXPECT_FALSE(filter.uses(FILTER_FIELD_NAME));
+}
+
+TEST(RecordFilter, RejectsBadSyntax) {
+    EXPECT_EQ(compileError(""), "Empty filter expression");
+    EXPECT_EQ(compileError("inuse and"), "Unexpected end of filter expression");
+    EXPECT_EQ(compileError("(inuse"), "Expected ')'");
+    EXPECT_EQ(compileError("inuse)"), "Unexpected ')'");
+    EXPECT_EQ(compileError("bogus = 1"), "Unknown field 'bogus'");
+    EXPECT_EQ(compileError("record"), "Expected an operator after 'record'");
+    EXPECT_EQ(compileError("name < abc"), "Operator '<' cannot be applied to 'name'");
+    EXPECT_EQ(compileError("has(nothing)"), "Unknown attribute 'nothing'");
+    EXPECT_EQ(compileError("inuse & dir"), "Unknown operator '&'");
+    EXPECT_NE(compileError("path = 'abc").find("Unterminated string"), std::string::npos);
+    EXPECT_NE(compileError("record = abc").find("abc"), std::string::npos);
+}
+
+TEST(RecordFilter, AcceptsNestingUpToTheLimit) {
+    MftRecord record = makeRecord(1, true, false, "\\a");
+    EXPECT_EQ(evaluate(repeat("(", 40) + "inuse" + repeat(")", 40), record), Result::True);
+    EXPECT_EQ(evaluate(repeat("not ", 40) + "inuse", record), Result::True);
+}
+
+// Deep enough to overflow the stack if the parser recursed all the way down
+TEST(RecordFilter, RejectsDeepNestingWhileParsing) {
+    const size_t depth = 1000000;
+    EXPECT_EQ(compileError(repeat("(", depth) + "inuse" + repeat(")", depth)), "Filter expression is too deeply nested");
+    EXPECT_EQ(compileError(repeat("not ", depth) + "inuse"), "Filter expression is too deeply nested");
+    EXPECT_EQ(compileError(repeat("!(", depth) + "inuse"), "Filter expression is too deeply nested");
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include "analyzeMFT/utils/shmRing.h"
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#ifndef _WIN32
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t SMALL_RING = 64 * 1024;
+
+// Unique per test and per process, so parallel runs do not share a ring
+std::string ringPath() {
+    return "shm:analyzemft_test_" + std::to_string(getpid()) + "_" +
+           ::testing::UnitTest::GetInstance()->current_test_info()->name();
+}
+
+// Lines of varying length, some longer than half the small ring
+std::string makeLines(size_t count) {
+    std::string text;
+    for (size_t i = 0; i < count; ++i) {
+        size_t length = i % 97 == 0 ? 40000 : (i * 37) % 300;
+        text += std::to_string(i) + "," + std::string(length, static_cast<char>('a' + i % 26)) + "\n";
+    }
+    return text;
+}
+
+}
+
+TEST(ShmRing, RecognizesRingPaths) {
+    EXPECT_TRUE(ShmRingWriter::isRingPath("shm:mft"));
+    EXPECT_TRUE(ShmRingWriter::isRingPath("shm:/mft"));
+    EXPECT_FALSE(ShmRingWriter::isRingPath("mft.csv"));
+    EXPECT_FALSE(ShmRingWriter::isRingPath("/dev/shm/mft"));
+}
+
+// The text is many times the ring, so the writer waits on the reader and
+// wraps around the data area over and over
+TEST(ShmRing, LinesRoundTripThroughASmallRing) {
+    std::string path = ringPath();
+    std::string text = makeLines(20000);
+
+    ShmRingWriter writer;
+    ASSERT_TRUE(writer.create(path, ShmRingHeader::FLAG_LINES, SMALL_RING)) << writer.getLastError();
+    ShmRingReader reader;
+    ASSERT_TRUE(reader.open(path)) << reader.getLastError();
+    EXPECT_EQ(reader.getFlags(), ShmRingHeader::FLAG_LINES);
+
+    bool finished = false;
+    std::thread producer([&] {
+        // Odd-sized writes leave partial lines for the writer to carry
+        bool ok = true;
+        for (size_t start = 0; ok && start < text.size(); start += 1234) {
+            ok = writer.write(text.data() + start, std::min<size_t>(1234, text.size() - start));
+        }
+        finished = ok && writer.finish();
+    });
+
+    std::string received;
+    size_t splitLines = 0;
+    std::string_view message;
+    while (reader.next(message)) {
+        received.append(message.data(), message.size());
+        if (message.back() != '\n') {
+            // Only a line longer than half the ring may be cut
+            EXPECT_EQ(message.size(), SMALL_RING / 2);
+            splitLines++;
+        }
+    }
+    producer.join();
+
+    EXPECT_FALSE(reader.hasFailed()) << reader.getLastError();
+    EXPECT_TRUE(finished) << writer.getLastError();
+    EXPECT_EQ(received, text);
+    EXPECT_GT(splitLines, 0u);
+}
+
+TEST(ShmRing, BytesRoundTripWithoutLines) {
+    std::string path = ringPath();
+    std::string bytes;
+    for (size_t i = 0; i < 500000; ++i) {
+        bytes += static_cast<char>((i * 131) >> 3);
+    }
+
+    ShmRingWriter writer;
+    ASSERT_TRUE(writer.create(path, 0, SMALL_RING)) << writer.getLastError();
+    ShmRingReader reader;
+    ASSERT_TRUE(reader.open(path)) << reader.getLastError();
+
+    bool finished = false;
+    std::thread producer([&] {
+        finished = writer.write(bytes.data(), bytes.size()) && writer.finish();
+    });
+    std::string received;
+    std::string_view message;
+    while (reader.next(message)) {
+        EXPECT_LE(message.size(), SMALL_RING / 2);
+        received.append(message.data(), message.size());
+    }
+    producer.join();
+
+    EXPECT_FALSE(reader.hasFailed()) << reader.getLastError();
+    EXPECT_TRUE(finished) << writer.getLastError();
+    EXPECT_EQ(received, bytes);
+}
+
+TEST(ShmRing, ReaderSeesAnAbortedOutput) {
+    std::string path = ringPath();
+    ShmRingWriter writer;
+    ASSERT_TRUE(writer.create(path, ShmRingHeader::FLAG_LINES, SMALL_RING)) << writer.getLastError();
+    ShmRingReader reader;
+    ASSERT_TRUE(reader.open(path)) << reader.getLastError();
+
+    ASSERT_TRUE(writer.write("complete line\npartial", 21));
+    writer.abort();
+
+    std::string_view message;
+    ASSERT_TRUE(reader.next(message));
+    EXPECT_EQ(message, "complete line\n");
+    EXPECT_FALSE(reader.next(message));
+    EXPECT_TRUE(reader.hasFailed());
+}
+
+TEST(ShmRing, WriterFailsWhenTheReaderDetaches) {
+    std::string path = ringPath();
+    ShmRingWriter writer;
+    ASSERT_TRUE(writer.create(path, 0, SMALL_RING)) << writer.getLastError();
+    ShmRingReader reader;
+    ASSERT_TRUE(reader.open(path)) << reader.getLastError();
+    reader.close();
+
+    // More than the ring holds, so the writer has to wait for the reader
+    std::string block(SMALL_RING * 4, 'x');
+    EXPECT_FALSE(writer.write(block.data(), block.size()));
+    EXPECT_FALSE(writer.getLastError().empty());
+    writer.abort();
+}
+
+TEST(ShmRing, SecondReaderIsRefused) {
+    std::string path = ringPath();
+    ShmRingWriter writer;
+    ASSERT_TRUE(writer.create(path, 0, SMALL_RING)) << writer.getLastError();
+    ShmRingReader first;
+    ASSERT_TRUE(first.open(path)) << first.getLastError();
+    ShmRingReader second;
+    EXPECT_FALSE(second.open(path));
+    EXPECT_NE(second.getLastError().find("already has a consumer"), std::string::npos);
+    writer.abort();
+}
+
+TEST(ShmRing, OpenWithoutAProducerTimesOut) {
+    ShmRingReader reader;
+    EXPECT_FALSE(reader.open(ringPath(), 20));
+    EXPECT_FALSE(reader.open("not-a-ring"));
+}
+
+TEST(ShmRing, RejectsABadCapacity) {
+    ShmRingWriter writer;
+    EXPECT_FALSE(writer.create(ringPath(), 0, 100000));
+    EXPECT_FALSE(writer.getLastError().empty());
+}
+
+#endif
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include "analyzeMFT/core/snapshot.h"
+#include "analyzeMFT/core/mftRecord.h"
+#include "analyzeMFT/core/constants.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t RECORD_SIZE = 1024;
+constexpr size_t RECORD_COUNT = 300;
+
+WindowsTime fromFiletime(uint64_t filetime) {
+    return WindowsTime(static_cast<uint32_t>(filetime), static_cast<uint32_t>(filetime >> 32));
+}
+
+uint64_t toFiletime(const WindowsTime& time) {
+    return (static_cast<uint64_t>(time.high) << 32) | time.low;
+}
+
+// Fields vary by row so each column holds distinct values, in an order
+// that differs from both sort orders
+std::unique_ptr<MftRecord> makeRecord(size_t row) {
+    auto record = std::make_unique<MftRecord>();
+    uint32_t scrambled = static_cast<uint32_t>((row * 7919) % RECORD_COUNT);
+    record->magic = 0x454C4946;
+    record->recordnum = static_cast<uint32_t>(row);
+    record->seq = static_cast<uint16_t>(row % 7 + 1);
+    record->link = static_cast<uint16_t>(row % 3);
+    record->flags = static_cast<uint16_t>((row % 4 != 0 ? FILE_RECORD_IN_USE : 0) |
+                                          (row % 5 == 0 ? FILE_RECORD_IS_DIRECTORY : 0));
+    record->lsn = 1000000 + row;
+    record->baseRef = row % 11 == 0 ? 5 : 0;
+    record->parentRef = (static_cast<uint64_t>(record->seq) << 48) | (row / 10);
+    record->filesize = row * 4096;
+    record->filename = row % 9 == 0 ? std::string() : "file" + std::to_string(scrambled) + ".dat";
+    record->filepath = "\\data\\" + record->filename;
+    record->objectId = row % 2 ? "{" + std::to_string(row) + "}" : std::string();
+    record->siTimes.crtime = fromFiletime(130000000000000000ULL + scrambled * 10000000ULL);
+    record->siTimes.mtime = fromFiletime(130000000000000000ULL + (RECORD_COUNT - row) * 10000000ULL);
+    record->fnTimes.ctime = fromFiletime(130000000000000000ULL + row);
+    record->attributeTypes = {STANDARD_INFORMATION_ATTRIBUTE, FILE_NAME_ATTRIBUTE};
+    if (row % 3 == 0) {
+        record->attributeTypes.insert(DATA_ATTRIBUTE);
+        record->dataAttribute = std::make_unique<DataAttribute>();
+    }
+    return record;
+}
+
+std::vector<uint8_t> makeRaw(size_t row) {
+    std::vector<uint8_t> raw(RECORD_SIZE);
+    for (size_t i = 0; i < raw.size(); ++i) {
+        raw[i] = static_cast<uint8_t>(row * 31 + i);
+    }
+    return raw;
+}
+
+class SnapshotTest : public ::testing::Test {
+protected:
+    std::string path;
+    std::vector<std::unique_ptr<MftRecord>> records;
+
+    void SetUp() override {
+        path = ::testing::TempDir() + "snapshot_" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".amft";
+        SnapshotWriter writer;
+        ASSERT_TRUE(writer.open(path, RECORD_SIZE, "C:\\$MFT")) << writer.getLastError();
+        for (size_t row = 0; row < RECORD_COUNT; ++row) {
+            records.push_back(makeRecord(row));
+            std::vector<uint8_t> raw = makeRaw(row);
+            ASSERT_TRUE(writer.append(*records.back(), row == 1 ? nullptr : raw.data()));
+        }
+        ASSERT_TRUE(writer.close()) << writer.getLastError();
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+};
+
+}
+
+TEST_F(SnapshotTest, ReadsBackEveryColumn) {
+    Snapshot snapshot;
+    ASSERT_TRUE(Snapshot::isSnapshotFile(path));
+    ASSERT_TRUE(snapshot.open(path)) << snapshot.getLastError();
+    ASSERT_EQ(snapshot.size(), RECORD_COUNT);
+    EXPECT_EQ(snapshot.getRecordSize(), RECORD_SIZE);
+    EXPECT_EQ(snapshot.getSourcePath(), "C:\\$MFT");
+    EXPECT_FALSE(snapshot.hasHashes());
+
+    for (size_t row = 0; row < RECORD_COUNT; ++row) {
+        const MftRecord& expected = *records[row];
+        EXPECT_EQ(snapshot.recordNumber(row), expected.recordnum);
+        EXPECT_EQ(snapshot.flags(row), expected.flags);
+        EXPECT_EQ(snapshot.parentRecordNumber(row), row / 10);
+        EXPECT_EQ(snapshot.fileSize(row), expected.filesize);
+        EXPECT_EQ(snapshot.time(row, SNAPSHOT_TIME_SI_CREATION), toFiletime(expected.siTimes.crtime));
+        EXPECT_EQ(snapshot.string(SNAPSHOT_STRING_FILENAME, row), expected.filename);
+        EXPECT_EQ(snapshot.string(SNAPSHOT_STRING_FILEPATH, row), expected.filepath);
+        EXPECT_EQ(snapshot.string(SNAPSHOT_STRING_OBJECT_ID, row), expected.objectId);
+
+        // A record appended without raw bytes is stored zeroed
+        std::vector<uint8_t> raw = row == 1 ? std::vector<uint8_t>(RECORD_SIZE, 0) : makeRaw(row);
+        const uint8_t* stored = snapshot.rawRecord(row);
+        ASSERT_NE(stored, nullptr);
+        EXPECT_TRUE(std::equal(raw.begin(), raw.end(), stored)) << "raw record " << row;
+    }
+}
+
+TEST_F(SnapshotTest, LoadsRecordsAsWritten) {
+    Snapshot snapshot;
+    ASSERT_TRUE(snapshot.open(path)) << snapshot.getLastError();
+    for (size_t row = 0; row < RECORD_COUNT; ++row) {
+        const MftRecord& expected = *records[row];
+        std::unique_ptr<MftRecord> loaded = snapshot.loadRecord(row);
+        ASSERT_TRUE(loaded);
+        EXPECT_EQ(loaded->magic, expected.magic);
+        EXPECT_EQ(loaded->lsn, expected.lsn);
+        EXPECT_EQ(loaded->seq, expected.seq);
+        EXPECT_EQ(loaded->link, expected.link);
+        EXPECT_EQ(loaded->baseRef, expected.baseRef);
+        EXPECT_EQ(loaded->parentRef, expected.parentRef);
+        EXPECT_EQ(loaded->filename, expected.filename);
+        EXPECT_EQ(toFiletime(loaded->siTimes.mtime), toFiletime(expected.siTimes.mtime));
+        EXPECT_EQ(toFiletime(loaded->fnTimes.ctime), toFiletime(expected.fnTimes.ctime));
+        EXPECT_EQ(loaded->attributeTypes, expected.attributeTypes);
+        EXPECT_EQ(loaded->dataAttribute != nullptr, expected.dataAttribute != nullptr);
+        EXPECT_EQ(loaded->indexRoot, nullptr);
+    }
+}
+
+TEST_F(SnapshotTest, OrdersAndStatistics) {
+    Snapshot snapshot;
+    ASSERT_TRUE(snapshot.open(path)) << snapshot.getLastError();
+
+    const uint32_t* byCreation = snapshot.order(SnapshotOrder::SiCreation);
+    const uint32_t* byModification = snapshot.order(SnapshotOrder::SiModification);
+    const uint32_t* byPath = snapshot.order(SnapshotOrder::Path);
+    for (size_t i = 1; i < RECORD_COUNT; ++i) {
+        EXPECT_LE(snapshot.time(byCreation[i - 1], SNAPSHOT_TIME_SI_CREATION),
+                  snapshot.time(byCreation[i], SNAPSHOT_TIME_SI_CREATION));
+        EXPECT_LE(snapshot.time(byModification[i - 1], SNAPSHOT_TIME_SI_MODIFICATION),
+                  snapshot.time(byModification[i], SNAPSHOT_TIME_SI_MODIFICATION));
+        EXPECT_LE(snapshot.string(SNAPSHOT_STRING_FILEPATH, byPath[i - 1]),
+                  snapshot.string(SNAPSHOT_STRING_FILEPATH, byPath[i]));
+    }
+    std::vector<uint32_t> rows(byPath, byPath + RECORD_COUNT);
+    std::sort(rows.begin(), rows.end());
+    for (size_t i = 0; i < RECORD_COUNT; ++i) {
+        ASSERT_EQ(rows[i], i);
+    }
+
+    uint64_t active = 0;
+    uint64_t directories = 0;
+    uint64_t totalSize = 0;
+    for (const auto& record : records) {
+        active += (record->flags & FILE_RECORD_IN_USE) ? 1 : 0;
+        directories += (record->flags & FILE_RECORD_IS_DIRECTORY) ? 1 : 0;
+        totalSize += record->filesize;
+    }
+    const SnapshotStatistics& stats = snapshot.getStatistics();
+    EXPECT_EQ(stats.activeRecords, active);
+    EXPECT_EQ(stats.directories, directories);
+    EXPECT_EQ(stats.files, RECORD_COUNT - directories);
+    EXPECT_EQ(stats.totalFileSize, totalSize);
+    EXPECT_EQ(stats.minSiCreation, 130000000000000000ULL);
+    EXPECT_EQ(stats.maxSiCreation, 130000000000000000ULL + (RECORD_COUNT - 1) * 10000000ULL);
+}
+
+TEST_F(SnapshotTest, RejectsDamagedFiles) {
+    Snapshot snapshot;
+
+    // The section directory is at the end, so any truncation loses it
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 8);
+    EXPECT_FALSE(snapshot.open(path));
+    EXPECT_FALSE(snapshot.getLastError().empty());
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << "AMFTSNAP";
+    EXPECT_TRUE(Snapshot::isSnapshotFile(path));
+    EXPECT_FALSE(snapshot.open(path));
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << "not a snapshot at all";
+    EXPECT_FALSE(Snapshot::isSnapshotFile(path));
+    EXPECT_FALSE(snapshot.open(path));
+}
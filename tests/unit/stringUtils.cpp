@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include "analyzeMFT/utils/stringUtils.h"
+#include <cstdio>
+#include <string>
+
+namespace {
+
+// One byte at a time, as appendJsonEscaped() did before its vector scan
+std::string escapeBytewise(const std::string& text) {
+    std::string out;
+    for (unsigned char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char escape[8];
+                    std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+                    out += escape;
+                } else {
+                    out += static_cast<char>(c);
+                }
+                break;
+        }
+    }
+    return out;
+}
+
+std::string escape(const std::string& text) {
+    std::string out;
+    StringUtils::appendJsonEscaped(out, text);
+    return out;
+}
+
+}
+
+TEST(StringUtils, JsonEscapesSpecialCharacters) {
+    EXPECT_EQ(escape("plain"), "plain");
+    EXPECT_EQ(escape("a\"b\\c"), "a\\\"b\\\\c");
+    EXPECT_EQ(escape("tab\tline\n"), "tab\\tline\\n");
+    EXPECT_EQ(escape(std::string("\x00\x1f", 2)), "\\u0000\\u001f");
+    // DEL and UTF-8 bytes are valid inside JSON strings
+    EXPECT_EQ(escape("\x7f"), "\x7f");
+    EXPECT_EQ(escape("\xc3\xa9t\xc3\xa9"), "\xc3\xa9t\xc3\xa9");
+}
+
+TEST(StringUtils, JsonEscapeAppends) {
+    std::string out = "{\"name\":\"";
+    StringUtils::appendJsonEscaped(out, "a\"b");
+    EXPECT_EQ(out, "{\"name\":\"a\\\"b");
+}
+
+// The scan takes 16 or 32 bytes at a time; a byte to escape must be found
+// wherever it falls in or after a block, and 0x7F and bytes from 0x80 up
+// must not be mistaken for control characters
+TEST(StringUtils, JsonEscapeAtEveryOffsetAcrossVectorBlocks) {
+    const char specials[] = {'"', '\\', '\x1f', '\x7f', '\x00', '\x80', '\xff', ' '};
+    for (size_t length : {15, 16, 17, 31, 32, 33, 47, 63, 64, 65, 100}) {
+        for (char special : specials) {
+            for (size_t position = 0; position < length; ++position) {
+                std::string text(length, 'x');
+                text[position] = special;
+                ASSERT_EQ(escape(text), escapeBytewise(text))
+                    << "byte 0x" << std::hex << (static_cast<unsigned>(special) & 0xFF)
+                    << std::dec << " at " << position << " of " << length;
+            }
+        }
+    }
+}
+
+TEST(StringUtils, JsonEscapesEveryByteInOneString) {
+    std::string text;
+    for (int repeat = 0; repeat < 3; ++repeat) {
+        for (int c = 0; c < 256; ++c) {
+            text += static_cast<char>(c);
+        }
+    }
+    EXPECT_EQ(escape(text), escapeBytewise(text));
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include "analyzeMFT/core/winTime.h"
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+namespace {
+
+constexpr int64_t SECONDS_1601_TO_1970 = 11644473600LL;
+constexpr uint64_t TICKS_PER_SECOND = 10000000ULL;
+
+WindowsTime fromUnixSeconds(int64_t seconds) {
+    uint64_t ticks = static_cast<uint64_t>(seconds + SECONDS_1601_TO_1970) * TICKS_PER_SECOND;
+    return WindowsTime(static_cast<uint32_t>(ticks), static_cast<uint32_t>(ticks >> 32));
+}
+
+// What getDateTimeString() replaced: gmtime and strftime
+std::string gmtimeString(int64_t seconds) {
+    std::time_t time = static_cast<std::time_t>(seconds);
+    std::tm parts{};
+    gmtime_r(&time, &parts);
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &parts);
+    return text;
+}
+
+}
+
+TEST(WindowsTime, UnsetIsNotDefined) {
+    WindowsTime time(0, 0);
+    EXPECT_FALSE(time.isValid());
+    EXPECT_EQ(time.getDateTimeString(), "Not defined");
+}
+
+TEST(WindowsTime, UnixEpoch) {
+    EXPECT_EQ(fromUnixSeconds(0).getDateTimeString(), "1970-01-01T00:00:00Z");
+}
+
+TEST(WindowsTime, MatchesGmtime) {
+    const int64_t seconds[] = {
+        0,
+        1,
+        86399,
+        951782400,              // 2000-02-29, a leap day of a year divisible by 400
+        951868799,              // 2000-02-29T23:59:59
+        1709168461,             // 2024-02-29T01:01:01
+        4107456000,             // 2100-02-28, the year 2100 has no leap day
+        4107542400,             // 2100-03-01
+        253402300799,           // 9999-12-31T23:59:59
+        -1,                     // 1969-12-31T23:59:59
+        -86400,
+        -31536000,              // 1969-01-01
+        -2077747200,            // 1904-02-29
+        -2208988800,            // 1900-01-01
+        -5364662400,            // 1800-01-01
+        -SECONDS_1601_TO_1970 + 1,
+    };
+    for (int64_t value : seconds) {
+        EXPECT_EQ(fromUnixSeconds(value).getDateTimeString(), gmtimeString(value)) << "unix time " << value;
+    }
+}
+
+TEST(WindowsTime, EveryDayAroundTheEpochMatchesGmtime) {
+    for (int64_t day = -1500; day <= 1500; ++day) {
+        int64_t value = day * 86400 + 45296;
+        ASSERT_EQ(fromUnixSeconds(value).getDateTimeString(), gmtimeString(value)) << "unix time " << value;
+    }
+}
+
+TEST(WindowsTime, SubSecondTicksAreTruncated) {
+    uint64_t ticks = static_cast<uint64_t>(SECONDS_1601_TO_1970) * TICKS_PER_SECOND + TICKS_PER_SECOND - 1;
+    WindowsTime time(static_cast<uint32_t>(ticks), static_cast<uint32_t>(ticks >> 32));
+    EXPECT_EQ(time.getDateTimeString(), "1970-01-01T00:00:00Z");
+}
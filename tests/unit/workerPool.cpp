@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include "analyzeMFT/utils/workerPool.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(WorkerPool, RunsEveryTaskOnce) {
+    WorkerPool pool(3);
+    for (size_t count : {0, 1, 2, 7, 1000}) {
+        std::vector<std::atomic<int>> calls(count);
+        pool.run(count, [&](size_t i) { calls[i]++; });
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(calls[i].load(), 1) << "task " << i << " of " << count;
+        }
+    }
+}
+
+TEST(WorkerPool, RunsWithoutThreads) {
+    WorkerPool pool(0);
+    std::vector<int> calls(10, 0);
+    pool.run(calls.size(), [&](size_t i) { calls[i]++; });
+    EXPECT_EQ(calls, std::vector<int>(10, 1));
+}
+
+// Batch jobs parse at the same time, each from its own thread
+TEST(WorkerPool, SeveralCallersAtOnce) {
+    WorkerPool pool(2);
+    std::vector<std::atomic<int>> sums(4);
+    std::vector<std::thread> callers;
+    for (size_t c = 0; c < sums.size(); ++c) {
+        callers.emplace_back([&, c] {
+            for (int round = 0; round < 200; ++round) {
+                pool.run(5, [&](size_t i) { sums[c] += static_cast<int>(i); });
+            }
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    for (const auto& sum : sums) {
+        EXPECT_EQ(sum.load(), 200 * 10);
+    }
+}
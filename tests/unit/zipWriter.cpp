@@ -0,0 +1,310 @@
+#include <gtest/gtest.h>
+#include "analyzeMFT/utils/zipWriter.h"
+#include "analyzeMFT/writers/excelWriter.h"
+#include "analyzeMFT/core/mftRecord.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+uint64_t get(const std::string& bytes, size_t offset, int size) {
+    uint64_t value = 0;
+    for (int i = 0; i < size; ++i) {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(bytes.at(offset + i))) << (8 * i);
+    }
+    return value;
+}
+
+uint32_t crc32Of(const std::string& data) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (unsigned char c : data) {
+        crc ^= c;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+
+std::string inflateRaw(const std::string& data, uint64_t size) {
+#ifdef HAVE_ZLIB
+    std::string out(size, '\0');
+    z_stream stream{};
+    if (inflateInit2(&stream, -15) != Z_OK) {
+        return std::string();
+    }
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+    int result = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+    return result == Z_STREAM_END && stream.avail_out == 0 ? out : std::string("<inflate failed>");
+#else
+    (void)size;
+    return data;
+#endif
+}
+
+struct ZipEntry {
+    uint16_t version;
+    uint16_t method;
+    uint32_t crc;
+    uint64_t compressedSize;
+    uint64_t size;
+    uint64_t offset;
+    std::string data;           // uncompressed
+};
+
+// Reads an archive from the central directory the way unzip does,
+// following the ZIP64 end record and extra fields where the 32-bit fields
+// are saturated
+struct ZipArchive {
+    std::string bytes;
+    bool zip64 = false;
+    uint64_t entryCount = 0;
+    uint64_t directoryOffset = 0;
+    std::vector<std::string> names;
+    std::map<std::string, ZipEntry> entries;
+
+    explicit ZipArchive(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        bytes.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    ::testing::AssertionResult read() {
+        if (bytes.size() < 22) {
+            return ::testing::AssertionFailure() << "archive too short";
+        }
+        size_t end = bytes.size() - 22;
+        if (get(bytes, end, 4) != 0x06054b50) {
+            return ::testing::AssertionFailure() << "no end of central directory record";
+        }
+        entryCount = get(bytes, end + 10, 2);
+        uint64_t directorySize = get(bytes, end + 12, 4);
+        directoryOffset = get(bytes, end + 16, 4);
+        if (entryCount == 0xFFFF || directoryOffset == 0xFFFFFFFF) {
+            zip64 = true;
+            size_t locator = end - 20;
+            if (get(bytes, locator, 4) != 0x07064b50) {
+                return ::testing::AssertionFailure() << "no ZIP64 locator";
+            }
+            size_t record = static_cast<size_t>(get(bytes, locator + 8, 8));
+            if (get(bytes, record, 4) != 0x06064b50 || record != locator - 56) {
+                return ::testing::AssertionFailure() << "ZIP64 locator points at " << record;
+            }
+            entryCount = get(bytes, record + 32, 8);
+            directorySize = get(bytes, record + 40, 8);
+            directoryOffset = get(bytes, record + 48, 8);
+            if (record != directoryOffset + directorySize) {
+                return ::testing::AssertionFailure() << "ZIP64 directory size and offset disagree";
+            }
+        } else if (end != directoryOffset + directorySize) {
+            return ::testing::AssertionFailure() << "directory size and offset disagree";
+        }
+
+        size_t position = static_cast<size_t>(directoryOffset);
+        for (uint64_t i = 0; i < entryCount; ++i) {
+            if (get(bytes, position, 4) != 0x02014b50) {
+                return ::testing::AssertionFailure() << "central header " << i << " missing";
+            }
+            ZipEntry entry;
+            entry.version = static_cast<uint16_t>(get(bytes, position + 6, 2));
+            entry.method = static_cast<uint16_t>(get(bytes, position + 10, 2));
+            entry.crc = static_cast<uint32_t>(get(bytes, position + 16, 4));
+            entry.compressedSize = get(bytes, position + 20, 4);
+            entry.size = get(bytes, position + 24, 4);
+            size_t nameLength = static_cast<size_t>(get(bytes, position + 28, 2));
+            size_t extraLength = static_cast<size_t>(get(bytes, position + 30, 2));
+            entry.offset = get(bytes, position + 42, 4);
+            std::string name = bytes.substr(position + 46, nameLength);
+
+            size_t extra = position + 46 + nameLength;
+            if (extraLength > 0) {
+                if (get(bytes, extra, 2) != 0x0001) {
+                    return ::testing::AssertionFailure() << name << ": unknown extra field";
+                }
+                extra += 4;
+                for (uint64_t* field : {&entry.size, &entry.compressedSize, &entry.offset}) {
+                    if (*field == 0xFFFFFFFF) {
+                        *field = get(bytes, extra, 8);
+                        extra += 8;
+                    }
+                }
+            }
+            position += 46 + nameLength + extraLength;
+
+            size_t local = static_cast<size_t>(entry.offset);
+            if (get(bytes, local, 4) != 0x04034b50 ||
+                bytes.compare(local + 30, nameLength, name) != 0) {
+                return ::testing::AssertionFailure() << name << ": bad local header offset";
+            }
+            size_t data = local + 30 + nameLength + static_cast<size_t>(get(bytes, local + 28, 2));
+            std::string stored = bytes.substr(data, static_cast<size_t>(entry.compressedSize));
+            entry.data = entry.method == 8 ? inflateRaw(stored, entry.size) : stored;
+            if (entry.data.size() != entry.size || crc32Of(entry.data) != entry.crc) {
+                return ::testing::AssertionFailure() << name << ": size or CRC does not match the data";
+            }
+
+            // The data descriptor repeats CRC and sizes, 64-bit ones after a ZIP64 local header
+            size_t descriptor = data + static_cast<size_t>(entry.compressedSize);
+            bool large = get(bytes, local + 28, 2) > 0;
+            if (get(bytes, descriptor, 4) != 0x08074b50 || get(bytes, descriptor + 4, 4) != entry.crc ||
+                get(bytes, descriptor + 8, large ? 8 : 4) != entry.compressedSize ||
+                get(bytes, descriptor + (large ? 16 : 12), large ? 8 : 4) != entry.size) {
+                return ::testing::AssertionFailure() << name << ": bad data descriptor";
+            }
+            names.push_back(name);
+            entries[name] = std::move(entry);
+        }
+        if (position != directoryOffset + directorySize) {
+            return ::testing::AssertionFailure() << "central directory has trailing bytes";
+        }
+        return ::testing::AssertionSuccess();
+    }
+};
+
+std::string tempPath(const std::string& name) {
+    return ::testing::TempDir() + "zipWriter_" + name;
+}
+
+}
+
+TEST(ZipWriter, WritesReadableEntries) {
+    std::string path = tempPath("small.zip");
+    std::string text;
+    for (int i = 0; i < 5000; ++i) {
+        text += "<row r=\"" + std::to_string(i) + "\"/>";
+    }
+
+    ZipWriter zip;
+    ASSERT_TRUE(zip.open(path));
+    ASSERT_TRUE(zip.beginEntry("a.xml"));
+    ASSERT_TRUE(zip.write(text.substr(0, 1000)));
+    ASSERT_TRUE(zip.write(text.substr(1000)));
+    ASSERT_TRUE(zip.beginEntry("empty.txt"));
+    // Pieces compressed elsewhere are appended in order
+    ASSERT_TRUE(zip.beginEntry("dir/b.xml"));
+    for (size_t start = 0; start < text.size(); start += 4096) {
+        std::string piece;
+        std::string raw = text.substr(start, 4096);
+        uint32_t crc = ZipWriter::compress(raw.data(), raw.size(), piece);
+        EXPECT_EQ(crc, crc32Of(raw));
+        ASSERT_TRUE(zip.writeCompressed(piece.data(), piece.size(), crc, raw.size()));
+    }
+    ASSERT_TRUE(zip.close()) << zip.getLastError();
+
+    ZipArchive archive(path);
+    std::remove(path.c_str());
+    ASSERT_TRUE(archive.read());
+    EXPECT_FALSE(archive.zip64);
+    EXPECT_EQ(archive.names, (std::vector<std::string>{"a.xml", "empty.txt", "dir/b.xml"}));
+    EXPECT_EQ(archive.entries["a.xml"].data, text);
+    EXPECT_EQ(archive.entries["empty.txt"].data, "");
+    EXPECT_EQ(archive.entries["dir/b.xml"].data, text);
+    EXPECT_EQ(archive.entries["a.xml"].version, 20);
+}
+
+TEST(ZipWriter, LargeEntryHasZip64Sizes) {
+    std::string path = tempPath("large.zip");
+    ZipWriter zip;
+    ASSERT_TRUE(zip.open(path));
+    ASSERT_TRUE(zip.beginEntry("sheet.xml", true));
+    ASSERT_TRUE(zip.write("large entry"));
+    ASSERT_TRUE(zip.close()) << zip.getLastError();
+
+    ZipArchive archive(path);
+    std::remove(path.c_str());
+    ASSERT_TRUE(archive.read());
+    const ZipEntry& entry = archive.entries["sheet.xml"];
+    EXPECT_EQ(entry.data, "large entry");
+    EXPECT_EQ(entry.version, 45);
+    // Local header: sizes saturated, ZIP64 extra field of two zeroed sizes
+    EXPECT_EQ(get(archive.bytes, 18, 4), 0xFFFFFFFFu);
+    EXPECT_EQ(get(archive.bytes, 22, 4), 0xFFFFFFFFu);
+    EXPECT_EQ(get(archive.bytes, 28, 2), 20u);
+    EXPECT_EQ(get(archive.bytes, 30 + 9, 2), 0x0001u);
+    EXPECT_EQ(get(archive.bytes, 30 + 11, 2), 16u);
+}
+
+// 65535 entries do not fit the 16-bit counts, which moves the directory
+// to ZIP64 without writing 4 GiB
+TEST(ZipWriter, ManyEntriesUseZip64Directory) {
+    std::string path = tempPath("many.zip");
+    const size_t count = 0xFFFF + 10;
+    ZipWriter zip;
+    ASSERT_TRUE(zip.open(path));
+    for (size_t i = 0; i < count; ++i) {
+        ASSERT_TRUE(zip.beginEntry(std::to_string(i)));
+        ASSERT_TRUE(zip.write(std::to_string(i * 7)));
+    }
+    ASSERT_TRUE(zip.close()) << zip.getLastError();
+
+    ZipArchive archive(path);
+    std::remove(path.c_str());
+    ASSERT_TRUE(archive.read());
+    EXPECT_TRUE(archive.zip64);
+    EXPECT_EQ(archive.entryCount, count);
+    // The 32-bit fields of the end record are saturated
+    size_t end = archive.bytes.size() - 22;
+    EXPECT_EQ(get(archive.bytes, end + 8, 2), 0xFFFFu);
+    EXPECT_EQ(get(archive.bytes, end + 12, 4), 0xFFFFFFFFu);
+    EXPECT_EQ(get(archive.bytes, end + 16, 4), 0xFFFFFFFFu);
+    EXPECT_EQ(archive.entries["65540"].data, std::to_string(65540 * 7));
+}
+
+TEST(ZipWriter, FailsOnDataOutsideAnEntry) {
+    std::string path = tempPath("outside.zip");
+    ZipWriter zip;
+    ASSERT_TRUE(zip.open(path));
+    EXPECT_FALSE(zip.write("stray"));
+    EXPECT_FALSE(zip.close());
+    EXPECT_FALSE(zip.getLastError().empty());
+    std::remove(path.c_str());
+}
+
+TEST(ExcelWriter, WritesWorkbookPackage) {
+    std::vector<MftRecord> records(100);
+    std::vector<const MftRecord*> pointers;
+    for (size_t i = 0; i < records.size(); ++i) {
+        records[i].recordnum = static_cast<uint32_t>(i);
+        records[i].filename = "R&D <" + std::to_string(i) + ">.txt";
+        pointers.push_back(&records[i]);
+    }
+
+    std::string path = tempPath("workbook.xlsx");
+    ExcelWriter writer;
+    ASSERT_TRUE(writer.open(path));
+    ASSERT_TRUE(writer.writeBatch({pointers.begin(), pointers.begin() + 40}));
+    ASSERT_TRUE(writer.writeBatch({pointers.begin() + 40, pointers.end()}));
+    ASSERT_TRUE(writer.close());
+
+    ZipArchive archive(path);
+    std::remove(path.c_str());
+    ASSERT_TRUE(archive.read());
+    for (const char* part : {"[Content_Types].xml", "_rels/.rels", "xl/workbook.xml", "xl/_rels/workbook.xml.rels",
+                             "xl/styles.xml", "xl/sharedStrings.xml", "xl/worksheets/sheet1.xml"}) {
+        EXPECT_EQ(archive.entries.count(part), 1u) << part;
+    }
+    EXPECT_EQ(archive.entries.count("xl/worksheets/sheet2.xml"), 0u);
+    EXPECT_NE(archive.entries["[Content_Types].xml"].data.find("/xl/worksheets/sheet1.xml"), std::string::npos);
+
+    const std::string& sheet = archive.entries["xl/worksheets/sheet1.xml"].data;
+    size_t rows = 0;
+    for (size_t at = sheet.find("<row "); at != std::string::npos; at = sheet.find("<row ", at + 1)) {
+        rows++;
+    }
+    EXPECT_EQ(rows, records.size() + 1);
+    EXPECT_NE(sheet.find("R&amp;D &lt;99&gt;.txt"), std::string::npos);
+    EXPECT_EQ(sheet.find("R&D"), std::string::npos);
+    EXPECT_NE(archive.entries["xl/workbook.xml"].data.find("$101"), std::string::npos);
+}